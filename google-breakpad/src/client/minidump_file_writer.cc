@@ -48,7 +48,13 @@ namespace google_breakpad {
 
 const MDRVA MinidumpFileWriter::kInvalidMDRVA = static_cast<MDRVA>(-1);
 
-MinidumpFileWriter::MinidumpFileWriter() : file_(-1), position_(0), size_(0) {
+MinidumpFileWriter::MinidumpFileWriter()
+    : file_(-1),
+      position_(0),
+      size_(0),
+      buffer_size_(0),
+      buffer_(NULL),
+      buffer_start_(0) {
 }
 
 MinidumpFileWriter::~MinidumpFileWriter() {
@@ -63,20 +69,41 @@ bool MinidumpFileWriter::Open(const char *path) {
   file_ = open(path, O_WRONLY | O_CREAT | O_EXCL, 0600);
 #endif
 
+  if (file_ != -1 && buffer_size_ && !buffer_) {
+    // If no pages are available, fall back to writing each copy directly.
+    buffer_ = reinterpret_cast<u_int8_t*>(allocator_.Alloc(buffer_size_));
+    buffer_start_ = position_;
+  }
+
   return file_ != -1;
 }
 
+void MinidumpFileWriter::set_buffer_size(size_t buffer_size) {
+  assert(file_ == -1);
+  size_t page_size = getpagesize();
+  size_t rounded_size = (buffer_size + page_size - 1) & ~(page_size - 1);
+
+  // A buffer kept from an earlier Open() has the old size, so have the next
+  // Open() take a new one.  PageAllocator cannot free a single allocation;
+  // the old buffer's pages are released with the writer.
+  if (rounded_size != buffer_size_)
+    buffer_ = NULL;
+  buffer_size_ = rounded_size;
+}
+
 bool MinidumpFileWriter::Close() {
   bool result = true;
 
   if (file_ != -1) {
+    if (buffer_ && !FlushBuffer())
+      result = false;
     if (-1 == ftruncate(file_, position_)) {
        return false;
     }
 #if __linux__
-    result = (sys_close(file_) == 0);
+    result = (sys_close(file_) == 0) && result;
 #else
-    result = (close(file_) == 0);
+    result = (close(file_) == 0) && result;
 #endif
     file_ = -1;
   }
@@ -211,13 +238,40 @@ MDRVA MinidumpFileWriter::Allocate(size_t size) {
   assert(file_ != -1);
   size_t aligned_size = (size + 7) & ~7;  // 64-bit alignment
 
+  if (buffer_) {
+    // Start a new buffer if this allocation doesn't fit in the current one.
+    // An allocation larger than the whole buffer is left out of it; copies
+    // into it are written to the file directly.  The file only needs to
+    // reach position_ by the time it is closed, so nothing is truncated here.
+    if (position_ + aligned_size > buffer_start_ + buffer_size_) {
+      if (!FlushBuffer())
+        return kInvalidMDRVA;
+      if (aligned_size > buffer_size_)
+        buffer_start_ += static_cast<MDRVA>(aligned_size);
+      else
+        my_memset(buffer_, 0, aligned_size);
+    } else {
+      my_memset(buffer_ + (position_ - buffer_start_), 0, aligned_size);
+    }
+
+    MDRVA current_position = position_;
+    position_ += static_cast<MDRVA>(aligned_size);
+    size_ = position_;
+    return current_position;
+  }
+
   if (position_ + aligned_size > size_) {
     size_t growth = aligned_size;
     size_t minimal_growth = getpagesize();
 
-    // Ensure that the file grows by at least the size of a memory page
+    // Ensure that the file grows by at least the size of a memory page, and
+    // by at least its current size, so a dump with many small streams only
+    // extends the file a logarithmic number of times.  Close() truncates
+    // the file back to position_.
     if (growth < minimal_growth)
       growth = minimal_growth;
+    if (growth < size_)
+      growth = size_;
 
     size_t new_size = size_ + growth;
     if (ftruncate(file_, new_size) != 0)
@@ -241,19 +295,56 @@ bool MinidumpFileWriter::Copy(MDRVA position, const void *src, ssize_t size) {
   if (static_cast<size_t>(size + position) > size_)
     return false;
 
+  // Copy whatever falls in the buffer there, and write anything before it,
+  // which has already been flushed, to the file.
+  if (buffer_ && position + static_cast<size_t>(size) > buffer_start_) {
+    size_t flushed = position < buffer_start_ ? buffer_start_ - position : 0;
+    memcpy(buffer_ + (position + flushed - buffer_start_),
+           reinterpret_cast<const u_int8_t*>(src) + flushed,
+           size - flushed);
+    if (!flushed)
+      return true;
+    size = flushed;
+  }
+
+  return WriteToFile(position, src, size);
+}
+
+bool MinidumpFileWriter::WriteToFile(MDRVA position, const void *src,
+                                     size_t size) {
   // Seek and write the data
 #if __linux__
-  if (sys_lseek(file_, position, SEEK_SET) == static_cast<off_t>(position)) {
-    if (sys_write(file_, src, size) == size) {
+  if (sys_lseek(file_, position, SEEK_SET) != static_cast<off_t>(position))
+    return false;
 #else
-  if (lseek(file_, position, SEEK_SET) == static_cast<off_t>(position)) {
-    if (write(file_, src, size) == size) {
+  if (lseek(file_, position, SEEK_SET) != static_cast<off_t>(position))
+    return false;
 #endif
-      return true;
-    }
+
+  const char *data = reinterpret_cast<const char*>(src);
+  while (size) {
+#if __linux__
+    ssize_t written = sys_write(file_, data, size);
+#else
+    ssize_t written = write(file_, data, size);
+#endif
+    if (written <= 0)
+      return false;
+    data += written;
+    size -= written;
   }
 
-  return false;
+  return true;
+}
+
+bool MinidumpFileWriter::FlushBuffer() {
+  assert(buffer_);
+  if (position_ > buffer_start_ &&
+      !WriteToFile(buffer_start_, buffer_, position_ - buffer_start_)) {
+    return false;
+  }
+  buffer_start_ = position_;
+  return true;
 }
 
 bool UntypedMDRVA::Allocate(size_t size) {
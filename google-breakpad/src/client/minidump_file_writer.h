@@ -36,6 +36,7 @@
 
 #include <string>
 
+#include "common/memory.h"
 #include "google_breakpad/common/minidump_format.h"
 
 namespace google_breakpad {
@@ -55,6 +56,14 @@ template<typename MDType> class TypedMDRVA;
 // header->get()->signature = MD_HEADER_SIGNATURE;
 //  :
 // writer.Close();
+//
+// By default every Copy() is written to the file as soon as it is made.
+// Calling set_buffer_size() before Open() instead stages allocations in a
+// buffer taken from a PageAllocator, and writes each full buffer to the
+// file with a single call; the file is only grown by those writes, so no
+// ftruncate() is needed per allocation.  Copies into regions that have
+// already been written out, such as the header and stream directory, still
+// go straight to the file.
 class MinidumpFileWriter {
 public:
   // Invalid MDRVA (Minidump Relative Virtual Address)
@@ -69,6 +78,12 @@ public:
   // Return true on success, or false on failure
   bool Open(const char *path);
 
+  // Stage output in a buffer of |buffer_size| bytes, rounded up to a whole
+  // number of pages, instead of writing each copy to the file immediately.
+  // Must be called while no file is open.  A |buffer_size| of 0 disables
+  // buffering.
+  void set_buffer_size(size_t buffer_size);
+
   // Close the current file
   // Return true on success, or false on failure
   bool Close();
@@ -98,6 +113,10 @@ public:
   // Return the current position for writing to the minidump
   inline MDRVA position() const { return position_; }
 
+  // The default buffer size for callers that want buffering but have no
+  // better estimate of the dump's size.
+  static const size_t kDefaultBufferSize = 1 << 20;
+
  private:
   friend class UntypedMDRVA;
 
@@ -115,6 +134,26 @@ public:
   // Current allocated size
   size_t size_;
 
+  // Writes |size| bytes from |src| to the file at |position|.
+  bool WriteToFile(MDRVA position, const void *src, size_t size);
+
+  // Writes the buffered bytes, [buffer_start_, position_), to the file and
+  // starts a new, empty buffer at position_.
+  bool FlushBuffer();
+
+  // Provides the staging buffer, so no heap allocation is needed.
+  PageAllocator allocator_;
+
+  // The requested size of the staging buffer, or 0 if unbuffered.
+  size_t buffer_size_;
+
+  // The staging buffer, holding the file's contents from buffer_start_
+  // up to position_, or NULL if unbuffered.
+  u_int8_t *buffer_;
+
+  // The file offset of buffer_[0].
+  MDRVA buffer_start_;
+
   // Copy |length| characters from |str| to |mdstring|.  These are distinct
   // because the underlying MDString is a UTF-16 based string.  The wchar_t
   // variant may need to create a MDString that has more characters than the
@@ -0,0 +1,278 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_file_writer_benchmark.cc: Measures how quickly MinidumpFileWriter
+// writes a dump with many threads, with and without an output buffer.
+//
+// The benchmark writes a synthetic dump shaped like one from a large
+// process: a thread list whose threads each have an AMD64 context and a
+// few kilobytes of stack, a module list whose modules each have a name and
+// a CodeView record, and a memory list referring to the stacks.  Every
+// piece is allocated and copied through TypedMDRVA and UntypedMDRVA, just
+// as the client minidump writers do.  It writes the dump unbuffered and
+// then with a MinidumpFileWriter::kDefaultBufferSize buffer, checks that
+// both files are identical, and reports the time each took.
+//
+// Usage: minidump_file_writer_benchmark [thread-count [iterations]]
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "client/minidump_file_writer-inl.h"
+#include "google_breakpad/common/minidump_format.h"
+
+namespace {
+
+using google_breakpad::MinidumpFileWriter;
+using google_breakpad::TypedMDRVA;
+using google_breakpad::UntypedMDRVA;
+using std::string;
+using std::vector;
+
+const int kDefaultThreadCount = 500;
+const int kDefaultIterations = 20;
+const int kModuleCount = 200;
+const size_t kMaxStackSize = 16 * 1024;
+const int kStreamCount = 3;
+
+double Now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+bool WriteThreadList(MinidumpFileWriter *writer, int thread_count,
+                     const vector<u_int8_t> &stack,
+                     MDRawDirectory *dirent,
+                     vector<MDMemoryDescriptor> *memory) {
+  TypedMDRVA<MDRawThreadList> list(writer);
+  if (!list.AllocateObjectAndArray(thread_count, sizeof(MDRawThread)))
+    return false;
+  dirent->stream_type = MD_THREAD_LIST_STREAM;
+  dirent->location = list.location();
+  list.get()->number_of_threads = thread_count;
+
+  for (int i = 0; i < thread_count; ++i) {
+    MDRawThread thread;
+    memset(&thread, 0, sizeof(thread));
+    thread.thread_id = 1000 + i;
+
+    // Vary the stack sizes, so allocations don't all line up on pages.
+    size_t stack_size = 2048 + (i * 1544) % (kMaxStackSize - 2048);
+    if (!writer->WriteMemory(&stack[0], stack_size, &thread.stack))
+      return false;
+    thread.stack.start_of_memory_range = 0x7fff00000000ULL + i * 0x100000ULL;
+    memory->push_back(thread.stack);
+
+    TypedMDRVA<MDRawContextAMD64> context(writer);
+    if (!context.Allocate())
+      return false;
+    MDRawContextAMD64 *raw = context.get();
+    raw->context_flags = MD_CONTEXT_AMD64_FULL;
+    raw->rip = 0x400000 + i * 16;
+    raw->rsp = thread.stack.start_of_memory_range;
+    raw->rbp = raw->rsp + 64;
+    thread.thread_context = context.location();
+
+    if (!list.CopyIndexAfterObject(i, &thread, sizeof(thread)))
+      return false;
+  }
+  return true;
+}
+
+bool WriteModuleList(MinidumpFileWriter *writer, MDRawDirectory *dirent) {
+  TypedMDRVA<MDRawModuleList> list(writer);
+  if (!list.AllocateObjectAndArray(kModuleCount, MD_MODULE_SIZE))
+    return false;
+  dirent->stream_type = MD_MODULE_LIST_STREAM;
+  dirent->location = list.location();
+  list.get()->number_of_modules = kModuleCount;
+
+  for (int i = 0; i < kModuleCount; ++i) {
+    MDRawModule module;
+    memset(&module, 0, sizeof(module));
+    module.base_of_image = 0x7f0000000000ULL + i * 0x1000000ULL;
+    module.size_of_image = 0x200000;
+
+    char name[64];
+    snprintf(name, sizeof(name), "/usr/lib/libcomponent%d.so", i);
+    MDLocationDescriptor name_location;
+    if (!writer->WriteString(name, 0, &name_location))
+      return false;
+    module.module_name_rva = name_location.rva;
+
+    const char *file_name = strrchr(name, '/') + 1;
+    size_t file_name_size = strlen(file_name) + 1;
+    TypedMDRVA<MDCVInfoPDB70> cv(writer);
+    if (!cv.AllocateObjectAndArray(file_name_size, sizeof(u_int8_t)))
+      return false;
+    if (!cv.CopyIndexAfterObject(0, file_name, file_name_size))
+      return false;
+    cv.get()->cv_signature = MD_CVINFOPDB70_SIGNATURE;
+    cv.get()->signature.data1 = i;
+    module.cv_record = cv.location();
+
+    if (!list.CopyIndexAfterObject(i, &module, MD_MODULE_SIZE))
+      return false;
+  }
+  return true;
+}
+
+bool WriteMemoryList(MinidumpFileWriter *writer,
+                     const vector<MDMemoryDescriptor> &memory,
+                     MDRawDirectory *dirent) {
+  TypedMDRVA<MDRawMemoryList> list(writer);
+  if (!list.AllocateObjectAndArray(memory.size(), sizeof(MDMemoryDescriptor)))
+    return false;
+  dirent->stream_type = MD_MEMORY_LIST_STREAM;
+  dirent->location = list.location();
+  list.get()->number_of_memory_ranges = memory.size();
+  for (size_t i = 0; i < memory.size(); ++i) {
+    if (!list.CopyIndexAfterObject(i, &memory[i], sizeof(memory[i])))
+      return false;
+  }
+  return true;
+}
+
+bool WriteDump(const char *path, size_t buffer_size, int thread_count,
+               const vector<u_int8_t> &stack) {
+  MinidumpFileWriter writer;
+  writer.set_buffer_size(buffer_size);
+  if (!writer.Open(path))
+    return false;
+
+  {
+    TypedMDRVA<MDRawHeader> header(&writer);
+    TypedMDRVA<MDRawDirectory> dir(&writer);
+    if (!header.Allocate() || !dir.AllocateArray(kStreamCount))
+      return false;
+    header.get()->signature = MD_HEADER_SIGNATURE;
+    header.get()->version = MD_HEADER_VERSION;
+    header.get()->stream_count = kStreamCount;
+    header.get()->stream_directory_rva = dir.position();
+
+    MDRawDirectory dirent[kStreamCount];
+    vector<MDMemoryDescriptor> memory;
+    if (!WriteThreadList(&writer, thread_count, stack, &dirent[0], &memory) ||
+        !WriteModuleList(&writer, &dirent[1]) ||
+        !WriteMemoryList(&writer, memory, &dirent[2])) {
+      return false;
+    }
+    for (int i = 0; i < kStreamCount; ++i) {
+      if (!dir.CopyIndex(i, &dirent[i]))
+        return false;
+    }
+  }
+
+  return writer.Close();
+}
+
+string ReadFile(const char *path) {
+  string contents;
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return contents;
+  char buffer[65536];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    contents.append(buffer, count);
+  fclose(file);
+  return contents;
+}
+
+// Writes the dump |iterations| times to |path|, returning the average
+// time per dump in seconds, or a negative value on failure.
+double TimeWrites(const char *path, size_t buffer_size, int thread_count,
+                  int iterations, const vector<u_int8_t> &stack) {
+  double total = 0;
+  for (int i = 0; i < iterations; ++i) {
+    unlink(path);
+    double start = Now();
+    if (!WriteDump(path, buffer_size, thread_count, stack))
+      return -1;
+    total += Now() - start;
+  }
+  return total / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int thread_count = argc > 1 ? atoi(argv[1]) : kDefaultThreadCount;
+  int iterations = argc > 2 ? atoi(argv[2]) : kDefaultIterations;
+  if (thread_count <= 0 || iterations <= 0) {
+    fprintf(stderr, "usage: %s [thread-count [iterations]]\n", argv[0]);
+    return 1;
+  }
+
+  vector<u_int8_t> stack(kMaxStackSize);
+  for (size_t i = 0; i < stack.size(); ++i)
+    stack[i] = static_cast<u_int8_t>(i * 131 + 7);
+
+  char unbuffered_path[100], buffered_path[100];
+  snprintf(unbuffered_path, sizeof(unbuffered_path),
+           "/tmp/minidump_file_writer_benchmark.%d.unbuffered.dmp",
+           static_cast<int>(getpid()));
+  snprintf(buffered_path, sizeof(buffered_path),
+           "/tmp/minidump_file_writer_benchmark.%d.buffered.dmp",
+           static_cast<int>(getpid()));
+
+  double unbuffered = TimeWrites(unbuffered_path, 0, thread_count,
+                                 iterations, stack);
+  double buffered = TimeWrites(buffered_path,
+                               MinidumpFileWriter::kDefaultBufferSize,
+                               thread_count, iterations, stack);
+  string unbuffered_contents = ReadFile(unbuffered_path);
+  string buffered_contents = ReadFile(buffered_path);
+  unlink(unbuffered_path);
+  unlink(buffered_path);
+
+  if (unbuffered < 0 || buffered < 0) {
+    fprintf(stderr, "failed to write dump\n");
+    return 1;
+  }
+  if (unbuffered_contents != buffered_contents) {
+    fprintf(stderr, "buffered and unbuffered dumps differ\n");
+    return 1;
+  }
+
+  printf("%d threads, %d modules, %lu bytes per dump\n",
+         thread_count, kModuleCount,
+         static_cast<unsigned long>(buffered_contents.size()));
+  printf("unbuffered: %8.3f ms per dump\n", unbuffered * 1000);
+  printf("buffered:   %8.3f ms per dump\n", buffered * 1000);
+  return 0;
+}
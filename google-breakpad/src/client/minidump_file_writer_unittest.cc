@@ -70,8 +70,9 @@ typedef struct {
   ArrayStructure array[0];
 } ObjectAndArrayStructure;
 
-static bool WriteFile(const char *path) {
+static bool WriteFile(const char *path, size_t buffer_size) {
   MinidumpFileWriter writer;
+  writer.set_buffer_size(buffer_size);
   if (writer.Open(path)) {
     // Test a single structure
     google_breakpad::TypedMDRVA<StringStructure> strings(&writer);
@@ -166,11 +167,95 @@ static bool CompareFile(const char *path) {
   return true;
 }
 
+// Write enough data through a |buffer_size| buffer to make it flush, including
+// an allocation larger than the buffer and a copy that begins in data the
+// buffer has already flushed.  The content depends only on the offsets, so the
+// file must match one written without a buffer.
+static bool WriteFlushingFile(const char *path, size_t buffer_size) {
+  MinidumpFileWriter writer;
+  writer.set_buffer_size(buffer_size);
+  ASSERT_TRUE(writer.Open(path));
+
+  size_t page_size = getpagesize();
+  size_t pattern_size = 4 * page_size + 100;
+  unsigned char *pattern = reinterpret_cast<unsigned char *>(
+      malloc(pattern_size));
+  ASSERT_TRUE(pattern);
+  for (size_t i = 0; i < pattern_size; ++i)
+    pattern[i] = static_cast<unsigned char>(i * 7 + 3);
+
+  // Fill most of the first page.
+  google_breakpad::UntypedMDRVA head(&writer);
+  ASSERT_TRUE(head.Allocate(page_size - 100));
+  ASSERT_TRUE(head.Copy(pattern, head.size()));
+
+  // This allocation does not fit in what is left of the buffer.
+  google_breakpad::UntypedMDRVA next(&writer);
+  ASSERT_TRUE(next.Allocate(200));
+  ASSERT_TRUE(next.Copy(pattern, next.size()));
+
+  // Rewrite the end of |head|, which has been flushed, together with the
+  // start of |next|, which is still in the buffer.
+  ASSERT_TRUE(writer.Copy(head.position() + head.size() - 50, pattern + 1000,
+                          150));
+
+  // An allocation larger than the whole buffer.
+  google_breakpad::UntypedMDRVA large(&writer);
+  ASSERT_TRUE(large.Allocate(pattern_size));
+  ASSERT_TRUE(large.Copy(pattern, large.size()));
+
+  google_breakpad::UntypedMDRVA tail(&writer);
+  ASSERT_TRUE(tail.Allocate(300));
+  ASSERT_TRUE(tail.Copy(pattern + 2000, tail.size()));
+
+  free(pattern);
+  return writer.Close();
+}
+
+static bool CompareFiles(const char *path1, const char *path2) {
+  int fd1 = open(path1, O_RDONLY);
+  int fd2 = open(path2, O_RDONLY);
+  ASSERT_NE(fd1, -1);
+  ASSERT_NE(fd2, -1);
+  off_t size1 = lseek(fd1, 0, SEEK_END);
+  off_t size2 = lseek(fd2, 0, SEEK_END);
+  ASSERT_EQ(size1, size2);
+  ASSERT_TRUE(size1 > 0);
+  lseek(fd1, 0, SEEK_SET);
+  lseek(fd2, 0, SEEK_SET);
+
+  char *buffer1 = reinterpret_cast<char *>(malloc(size1));
+  char *buffer2 = reinterpret_cast<char *>(malloc(size2));
+  ASSERT_TRUE(buffer1 && buffer2);
+  ASSERT_EQ(read(fd1, buffer1, size1), size1);
+  ASSERT_EQ(read(fd2, buffer2, size2), size2);
+  close(fd1);
+  close(fd2);
+  bool same = memcmp(buffer1, buffer2, size1) == 0;
+  free(buffer1);
+  free(buffer2);
+  ASSERT_TRUE(same);
+  return true;
+}
+
 static bool RunTests() {
   const char *path = "/tmp/minidump_file_writer_unittest.dmp";
-  ASSERT_TRUE(WriteFile(path));
+  ASSERT_TRUE(WriteFile(path, 0));
   ASSERT_TRUE(CompareFile(path));
   unlink(path);
+
+  // The buffered writer must produce the same file.
+  ASSERT_TRUE(WriteFile(path, MinidumpFileWriter::kDefaultBufferSize));
+  ASSERT_TRUE(CompareFile(path));
+  unlink(path);
+
+  // A one-page buffer flushes, is bypassed, and is copied across.
+  const char *unbuffered_path = "/tmp/minidump_file_writer_unittest_0.dmp";
+  ASSERT_TRUE(WriteFlushingFile(unbuffered_path, 0));
+  ASSERT_TRUE(WriteFlushingFile(path, getpagesize()));
+  ASSERT_TRUE(CompareFiles(unbuffered_path, path));
+  unlink(unbuffered_path);
+  unlink(path);
   return true;
 }
 
@@ -183,4 +183,15 @@ void DIEDispatcher::ProcessAttributeString(uint64 offset,
   current.handler_->ProcessAttributeString(attr, form, data);
 }
 
+void DIEDispatcher::ProcessAttributeStringPointer(uint64 offset,
+                                                  enum DwarfAttribute attr,
+                                                  enum DwarfForm form,
+                                                  const char* data,
+                                                  uint64 length) {
+  HandlerStack &current = die_handlers_.top();
+  // This had better be an attribute of the DIE we were meant to handle.
+  assert(offset == current.offset_);
+  current.handler_->ProcessAttributeStringPointer(attr, form, data, length);
+}
+
 } // namespace dwarf2reader
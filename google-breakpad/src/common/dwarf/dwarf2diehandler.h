@@ -210,6 +210,17 @@ class DIEHandler {
                                       enum DwarfForm form,
                                       const string& data) { }
 
+  // Like ProcessAttributeString, but DATA points to the string's
+  // LENGTH characters in the section data, as for
+  // Dwarf2Handler::ProcessAttributeStringPointer. The default definition
+  // copies the string and calls ProcessAttributeString.
+  virtual void ProcessAttributeStringPointer(enum DwarfAttribute attr,
+                                             enum DwarfForm form,
+                                             const char* data,
+                                             uint64 length) {
+    ProcessAttributeString(attr, form, string(data, length));
+  }
+
   // Once we have reported all the DIE's attributes' values, we call
   // this member function.  If it returns false, we skip all the DIE's
   // children.  If it returns true, we call FindChildHandler on each
@@ -314,6 +325,11 @@ class DIEDispatcher: public Dwarf2Handler {
                               enum DwarfAttribute attr,
                               enum DwarfForm form,
                               const string &data);
+  void ProcessAttributeStringPointer(uint64 offset,
+                                     enum DwarfAttribute attr,
+                                     enum DwarfForm form,
+                                     const char* data,
+                                     uint64 length);
   void EndDIE(uint64 offset);
 
  private:
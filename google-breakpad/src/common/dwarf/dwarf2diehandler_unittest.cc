@@ -65,6 +65,8 @@ class MockDIEHandler: public DIEHandler {
                void(DwarfAttribute, DwarfForm, const char *, uint64));
   MOCK_METHOD3(ProcessAttributeString,
                void(DwarfAttribute, DwarfForm, const string &));
+  MOCK_METHOD4(ProcessAttributeStringPointer,
+               void(DwarfAttribute, DwarfForm, const char *, uint64));
   MOCK_METHOD0(EndAttributes, bool());
   MOCK_METHOD3(FindChildHandler, DIEHandler *(uint64, DwarfTag,
                                               const AttributeList &));
@@ -83,6 +85,8 @@ class MockRootDIEHandler: public RootDIEHandler {
                void(DwarfAttribute, DwarfForm, const char *, uint64));
   MOCK_METHOD3(ProcessAttributeString,
                void(DwarfAttribute, DwarfForm, const string &));
+  MOCK_METHOD4(ProcessAttributeStringPointer,
+               void(DwarfAttribute, DwarfForm, const char *, uint64));
   MOCK_METHOD0(EndAttributes, bool());
   MOCK_METHOD3(FindChildHandler, DIEHandler *(uint64, DwarfTag,
                                               const AttributeList &));
@@ -238,6 +242,11 @@ TEST(Dwarf2DIEHandler, PassAttributeValues) {
                                        (DwarfForm) 0x15762fec,
                                        StrEq(str)))
       .WillOnce(Return());
+    EXPECT_CALL(mock_root_handler,
+                ProcessAttributeStringPointer((DwarfAttribute) 0x6c2b1a4b,
+                                              (DwarfForm) 0x8b3d0f2e,
+                                              str.data(), str.size()))
+      .WillOnce(Return());
     EXPECT_CALL(mock_root_handler, EndAttributes())
       .WillOnce(Return(true));
     EXPECT_CALL(mock_root_handler, FindChildHandler(_, _, _))
@@ -279,6 +288,10 @@ TEST(Dwarf2DIEHandler, PassAttributeValues) {
                                         (DwarfAttribute) 0x310ed065,
                                         (DwarfForm) 0x15762fec,
                                         str);
+  die_dispatcher.ProcessAttributeStringPointer(0xe2222da01e29f2a9LL,
+                                               (DwarfAttribute) 0x6c2b1a4b,
+                                               (DwarfForm) 0x8b3d0f2e,
+                                               str.data(), str.size());
 
   // Finish the root DIE (and thus the CU).
   die_dispatcher.EndDIE(0xe2222da01e29f2a9LL);
@@ -52,7 +52,7 @@ CompilationUnit::CompilationUnit(const SectionMap& sections, uint64 offset,
                                  ByteReader* reader, Dwarf2Handler* handler)
     : offset_from_section_start_(offset), reader_(reader),
       sections_(sections), handler_(handler), abbrevs_(NULL),
-      string_buffer_(NULL), string_buffer_length_(0) {}
+      abbrev_cache_(NULL), string_buffer_(NULL), string_buffer_length_(0) {}
 
 // Read a DWARF2/3 abbreviation section.
 // Each abbrev consists of a abbreviation number, a tag, a byte
@@ -66,6 +66,12 @@ void CompilationUnit::ReadAbbrevs() {
   if (abbrevs_)
     return;
 
+  if (abbrev_cache_) {
+    abbrevs_ = abbrev_cache_->Find(header_.abbrev_offset);
+    if (abbrevs_)
+      return;
+  }
+
   // First get the debug_abbrev section.  ".debug_abbrev" is the name
   // recommended in the DWARF spec, and used on Linux;
   // "__debug_abbrev" is the name used in Mac OS X Mach-O files.
@@ -74,8 +80,8 @@ void CompilationUnit::ReadAbbrevs() {
     iter = sections_.find("__debug_abbrev");
   assert(iter != sections_.end());
 
-  abbrevs_ = new vector<Abbrev>;
-  abbrevs_->resize(1);
+  AbbrevTable* abbrevs = new AbbrevTable;
+  abbrevs->resize(1);
 
   // The only way to check whether we are reading over the end of the
   // buffer would be to first compute the size of the leb128 data by
@@ -123,9 +129,14 @@ void CompilationUnit::ReadAbbrevs() {
       const enum DwarfForm form = static_cast<enum DwarfForm>(formtemp);
       abbrev.attributes.push_back(make_pair(name, form));
     }
-    assert(abbrev.number == abbrevs_->size());
-    abbrevs_->push_back(abbrev);
+    assert(abbrev.number == abbrevs->size());
+    abbrevs->push_back(abbrev);
   }
+
+  if (abbrev_cache_)
+    abbrevs_ = abbrev_cache_->Add(header_.abbrev_offset, abbrevs);
+  else
+    abbrevs_ = abbrevs;
 }
 
 // Skips a single DIE's attributes.
@@ -351,9 +362,10 @@ const char* CompilationUnit::ProcessAttribute(
       break;
     case DW_FORM_string: {
       const char* str = start;
-      handler_->ProcessAttributeString(dieoffset, attr, form,
-                                       str);
-      return start + strlen(str) + 1;
+      const size_t str_length = strlen(str);
+      handler_->ProcessAttributeStringPointer(dieoffset, attr, form,
+                                              str, str_length);
+      return start + str_length + 1;
     }
       break;
     case DW_FORM_udata:
@@ -455,8 +467,8 @@ const char* CompilationUnit::ProcessAttribute(
       assert(string_buffer_ + offset < string_buffer_ + string_buffer_length_);
 
       const char* str = string_buffer_ + offset;
-      handler_->ProcessAttributeString(dieoffset, attr, form,
-                                       str);
+      handler_->ProcessAttributeStringPointer(dieoffset, attr, form,
+                                              str, strlen(str));
       return start + reader_->OffsetSize();
     }
       break;
@@ -532,6 +544,41 @@ void CompilationUnit::ProcessDIEs() {
   }
 }
 
+AbbrevTableCache::~AbbrevTableCache() {
+  for (TableMap::iterator it = tables_.begin(); it != tables_.end(); ++it)
+    delete it->second;
+  pthread_mutex_destroy(&mutex_);
+}
+
+const CompilationUnit::AbbrevTable* AbbrevTableCache::Find(uint64 offset) {
+  pthread_mutex_lock(&mutex_);
+  TableMap::const_iterator it = tables_.find(offset);
+  const CompilationUnit::AbbrevTable* table =
+      it == tables_.end() ? NULL : it->second;
+  pthread_mutex_unlock(&mutex_);
+  return table;
+}
+
+const CompilationUnit::AbbrevTable* AbbrevTableCache::Add(
+    uint64 offset, CompilationUnit::AbbrevTable* table) {
+  pthread_mutex_lock(&mutex_);
+  pair<TableMap::iterator, bool> inserted =
+      tables_.insert(make_pair(offset, table));
+  const CompilationUnit::AbbrevTable* cached = inserted.first->second;
+  pthread_mutex_unlock(&mutex_);
+  if (!inserted.second)
+    delete table;
+  return cached;
+}
+
+size_t AbbrevTableCache::size() {
+  pthread_mutex_lock(&mutex_);
+  size_t size = tables_.size();
+  pthread_mutex_unlock(&mutex_);
+  return size;
+}
+
+
 LineInfo::LineInfo(const char* buffer, uint64 buffer_length,
                    ByteReader* reader, LineInfoHandler* handler):
     handler_(handler), reader_(reader), buffer_(buffer),
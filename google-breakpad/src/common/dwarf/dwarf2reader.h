@@ -40,6 +40,8 @@
 #ifndef COMMON_DWARF_DWARF2READER_H__
 #define COMMON_DWARF_DWARF2READER_H__
 
+#include <pthread.h>
+
 #include <list>
 #include <map>
 #include <string>
@@ -54,6 +56,7 @@ using namespace std;
 
 namespace dwarf2reader {
 struct LineStateMachine;
+class AbbrevTableCache;
 class Dwarf2Handler;
 class LineInfoHandler;
 
@@ -224,9 +227,16 @@ class CompilationUnit {
   CompilationUnit(const SectionMap& sections, uint64 offset,
                   ByteReader* reader, Dwarf2Handler* handler);
   virtual ~CompilationUnit() {
-    if (abbrevs_) delete abbrevs_;
+    if (abbrevs_ && !abbrev_cache_) delete abbrevs_;
   }
 
+  // Take this compilation unit's abbreviation table from CACHE,
+  // decoding it and adding it to CACHE if no other unit has done so
+  // yet, instead of decoding a private copy. CACHE must outlive this
+  // CompilationUnit, and must only be shared by units whose SECTIONS
+  // have the same abbreviation section. Call this before Start.
+  void SetAbbrevTableCache(AbbrevTableCache* cache) { abbrev_cache_ = cache; }
+
   // Begin reading a Dwarf2 compilation unit, and calling the
   // callbacks in the Dwarf2Handler
 
@@ -236,8 +246,6 @@ class CompilationUnit {
   // start of the next compilation unit, if there is one.
   uint64 Start();
 
- private:
-
   // This struct represents a single DWARF2/3 abbreviation
   // The abbreviation tells how to read a DWARF2/3 DIE, and consist of a
   // tag and a list of attributes, as well as the data form of each attribute.
@@ -248,6 +256,12 @@ class CompilationUnit {
     AttributeList attributes;
   };
 
+  // A set of abbreviations, indexed by abbreviation number, which
+  // means that element zero is not valid.
+  typedef vector<Abbrev> AbbrevTable;
+
+ private:
+
   // A DWARF2/3 compilation unit header.  This is not the same size as
   // in the actual file, as the one in the file may have a 32 bit or
   // 64 bit length.
@@ -312,8 +326,11 @@ class CompilationUnit {
 
   // Set of DWARF2/3 abbreviations for this compilation unit.  Indexed
   // by abbreviation number, which means that abbrevs_[0] is not
-  // valid.
-  vector<Abbrev>* abbrevs_;
+  // valid. We own this table unless it came from abbrev_cache_.
+  const AbbrevTable* abbrevs_;
+
+  // The cache to share abbreviation tables through, or NULL.
+  AbbrevTableCache* abbrev_cache_;
 
   // String section buffer and length, if we have a string section.
   // This is here to avoid doing a section lookup for strings in
@@ -322,6 +339,44 @@ class CompilationUnit {
   uint64 string_buffer_length_;
 };
 
+// A cache of decoded abbreviation tables, keyed by their offset in the
+// abbreviation section, for sharing among the CompilationUnits that
+// read one set of sections. Compilation units usually share a handful
+// of tables, so this saves decoding the same table over and over.
+//
+// A cache may be used by CompilationUnits running on several threads
+// at once. Tables are decoded outside the cache's lock; if two units
+// decode the same table concurrently, the first one added wins, and
+// the other is discarded.
+class AbbrevTableCache {
+ public:
+  AbbrevTableCache() { pthread_mutex_init(&mutex_, NULL); }
+  ~AbbrevTableCache();
+
+  // Return the table at OFFSET, or NULL if it is not cached yet.
+  const CompilationUnit::AbbrevTable* Find(uint64 offset);
+
+  // Add TABLE, decoded from OFFSET, to the cache, taking ownership of
+  // it. Return the table now cached for OFFSET, which is an earlier
+  // table if another thread added one first; in that case, TABLE is
+  // deleted.
+  const CompilationUnit::AbbrevTable* Add(uint64 offset,
+                                          CompilationUnit::AbbrevTable* table);
+
+  // Return the number of distinct tables in the cache.
+  size_t size();
+
+ private:
+  typedef map<uint64, CompilationUnit::AbbrevTable*> TableMap;
+
+  TableMap tables_;
+  pthread_mutex_t mutex_;
+
+  // Disallow copy constructor and assignment operator.
+  AbbrevTableCache(const AbbrevTableCache&);
+  void operator=(const AbbrevTableCache&);
+};
+
 // This class is the main interface between the reader and the
 // client.  The virtual functions inside this get called for
 // interesting events that happen during DWARF2 reading.
@@ -394,6 +449,21 @@ class Dwarf2Handler {
                                       enum DwarfForm form,
                                       const string& data) { }
 
+  // Called when we have an attribute with string data to give to our
+  // handler, like ProcessAttributeString, but without copying the
+  // string. DATA points to the string's LENGTH characters in the
+  // .debug_info or .debug_str section, followed by a terminating '\0';
+  // it remains valid as long as the section data does. The default
+  // definition copies the string and calls ProcessAttributeString;
+  // handlers that can use the text in place should override this.
+  virtual void ProcessAttributeStringPointer(uint64 offset,
+                                             enum DwarfAttribute attr,
+                                             enum DwarfForm form,
+                                             const char* data,
+                                             uint64 length) {
+    ProcessAttributeString(offset, attr, form, string(data, length));
+  }
+
   // Called when finished processing the DIE at OFFSET.
   // Because DWARF2/3 specifies a tree of DIEs, you may get starts
   // before ends of the previous DIE, as we process children before
@@ -0,0 +1,316 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// dwarf2reader_die_unittest.cc: Unit tests for dwarf2reader::CompilationUnit
+// and dwarf2reader::AbbrevTableCache.
+
+#include <pthread.h>
+
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/dwarf/bytereader-inl.h"
+#include "common/dwarf/dwarf2reader.h"
+#include "common/test_assembler.h"
+
+using google_breakpad::test_assembler::Label;
+using google_breakpad::test_assembler::Section;
+using google_breakpad::test_assembler::kLittleEndian;
+
+using dwarf2reader::AbbrevTableCache;
+using dwarf2reader::AttributeList;
+using dwarf2reader::ByteReader;
+using dwarf2reader::CompilationUnit;
+using dwarf2reader::Dwarf2Handler;
+using dwarf2reader::DwarfAttribute;
+using dwarf2reader::DwarfForm;
+using dwarf2reader::DwarfTag;
+using dwarf2reader::ENDIANNESS_LITTLE;
+using dwarf2reader::SectionMap;
+
+using std::string;
+using testing::_;
+using testing::InSequence;
+using testing::Return;
+using testing::Test;
+
+class MockDwarf2Handler: public Dwarf2Handler {
+ public:
+  MOCK_METHOD5(StartCompilationUnit, bool(uint64 offset, uint8 address_size,
+                                          uint8 offset_size, uint64 cu_length,
+                                          uint8 dwarf_version));
+  MOCK_METHOD3(StartDIE, bool(uint64 offset, DwarfTag tag,
+                              const AttributeList& attrs));
+  MOCK_METHOD4(ProcessAttributeUnsigned, void(uint64 offset,
+                                              DwarfAttribute attr,
+                                              DwarfForm form,
+                                              uint64 data));
+  MOCK_METHOD4(ProcessAttributeString, void(uint64 offset,
+                                            DwarfAttribute attr,
+                                            DwarfForm form,
+                                            const string& data));
+  MOCK_METHOD1(EndDIE, void(uint64 offset));
+};
+
+// A handler that takes string attributes in place.
+class MockStringPointerHandler: public Dwarf2Handler {
+ public:
+  MOCK_METHOD5(StartCompilationUnit, bool(uint64 offset, uint8 address_size,
+                                          uint8 offset_size, uint64 cu_length,
+                                          uint8 dwarf_version));
+  MOCK_METHOD3(StartDIE, bool(uint64 offset, DwarfTag tag,
+                              const AttributeList& attrs));
+  MOCK_METHOD4(ProcessAttributeString, void(uint64 offset,
+                                            DwarfAttribute attr,
+                                            DwarfForm form,
+                                            const string& data));
+  MOCK_METHOD5(ProcessAttributeStringPointer, void(uint64 offset,
+                                                   DwarfAttribute attr,
+                                                   DwarfForm form,
+                                                   const char* data,
+                                                   uint64 length));
+};
+
+// A handler that counts the name attributes it sees, for use from
+// several threads at once.
+class CountingDwarf2Handler: public Dwarf2Handler {
+ public:
+  CountingDwarf2Handler() : names_(0) { }
+  bool StartCompilationUnit(uint64 offset, uint8 address_size,
+                            uint8 offset_size, uint64 cu_length,
+                            uint8 dwarf_version) { return true; }
+  bool StartDIE(uint64 offset, DwarfTag tag, const AttributeList& attrs) {
+    return true;
+  }
+  void ProcessAttributeString(uint64 offset, DwarfAttribute attr,
+                              DwarfForm form, const string& data) {
+    if (attr == dwarf2reader::DW_AT_name)
+      names_++;
+  }
+  int names() const { return names_; }
+
+ private:
+  int names_;
+};
+
+// Build .debug_abbrev and .debug_info sections holding compilation
+// units that refer to one of two abbreviation tables.
+class CompilationUnitTest: public Test {
+ public:
+  CompilationUnitTest() : abbrevs(kLittleEndian), info(kLittleEndian) {
+    // Table one: a childless compilation unit with a name.
+    abbrevs.Mark(&table_one)
+        .ULEB128(1)
+        .ULEB128(dwarf2reader::DW_TAG_compile_unit)
+        .D8(dwarf2reader::DW_children_no)
+        .ULEB128(dwarf2reader::DW_AT_name)
+        .ULEB128(dwarf2reader::DW_FORM_string)
+        .ULEB128(0).ULEB128(0)
+        .ULEB128(0);
+    // Table two: a childless compilation unit with a name and a language.
+    abbrevs.Mark(&table_two)
+        .ULEB128(1)
+        .ULEB128(dwarf2reader::DW_TAG_compile_unit)
+        .D8(dwarf2reader::DW_children_no)
+        .ULEB128(dwarf2reader::DW_AT_name)
+        .ULEB128(dwarf2reader::DW_FORM_string)
+        .ULEB128(dwarf2reader::DW_AT_language)
+        .ULEB128(dwarf2reader::DW_FORM_data1)
+        .ULEB128(0).ULEB128(0)
+        .ULEB128(0);
+    abbrevs.start() = 0;
+    info.start() = 0;
+  }
+
+  // Append a compilation unit named NAME that uses TABLE to the
+  // .debug_info section, and return its offset.
+  uint64 AddUnit(const Label &table, const string &name, bool language) {
+    uint64 offset = info.Size();
+    Label length, start;
+    info.D32(length)
+        .Mark(&start)
+        .D16(2)
+        .D32(table)
+        .D8(4)
+        .ULEB128(1)
+        .AppendCString(name);
+    if (language)
+      info.D8(dwarf2reader::DW_LANG_C_plus_plus);
+    info.D8(0);
+    length = info.Here() - start;
+    return offset;
+  }
+
+  // Fill in SECTION_MAP with the assembled sections.
+  void Finish() {
+    ASSERT_TRUE(abbrevs.GetContents(&abbrev_contents));
+    ASSERT_TRUE(info.GetContents(&info_contents));
+    section_map[".debug_abbrev"] = make_pair(abbrev_contents.data(),
+                                             abbrev_contents.size());
+    section_map[".debug_info"] = make_pair(info_contents.data(),
+                                           info_contents.size());
+  }
+
+  Label table_one, table_two;
+  Section abbrevs, info;
+  string abbrev_contents, info_contents;
+  SectionMap section_map;
+};
+
+TEST_F(CompilationUnitTest, SharedTables) {
+  uint64 first = AddUnit(table_one, "first", false);
+  uint64 second = AddUnit(table_two, "second", true);
+  uint64 third = AddUnit(table_one, "third", false);
+  Finish();
+
+  MockDwarf2Handler handler;
+  {
+    InSequence s;
+    EXPECT_CALL(handler, StartCompilationUnit(first, 4, 4, _, 2))
+        .WillOnce(Return(true));
+    EXPECT_CALL(handler, StartDIE(_, dwarf2reader::DW_TAG_compile_unit, _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(handler, ProcessAttributeString(_, dwarf2reader::DW_AT_name,
+                                                dwarf2reader::DW_FORM_string,
+                                                "first"));
+    EXPECT_CALL(handler, EndDIE(_));
+    EXPECT_CALL(handler, StartCompilationUnit(second, 4, 4, _, 2))
+        .WillOnce(Return(true));
+    EXPECT_CALL(handler, StartDIE(_, dwarf2reader::DW_TAG_compile_unit, _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(handler, ProcessAttributeString(_, dwarf2reader::DW_AT_name,
+                                                dwarf2reader::DW_FORM_string,
+                                                "second"));
+    EXPECT_CALL(handler, ProcessAttributeUnsigned(
+                    _, dwarf2reader::DW_AT_language,
+                    dwarf2reader::DW_FORM_data1,
+                    dwarf2reader::DW_LANG_C_plus_plus));
+    EXPECT_CALL(handler, EndDIE(_));
+    EXPECT_CALL(handler, StartCompilationUnit(third, 4, 4, _, 2))
+        .WillOnce(Return(true));
+    EXPECT_CALL(handler, StartDIE(_, dwarf2reader::DW_TAG_compile_unit, _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(handler, ProcessAttributeString(_, dwarf2reader::DW_AT_name,
+                                                dwarf2reader::DW_FORM_string,
+                                                "third"));
+    EXPECT_CALL(handler, EndDIE(_));
+  }
+
+  AbbrevTableCache cache;
+  ByteReader reader(ENDIANNESS_LITTLE);
+  for (uint64 offset = 0; offset < info_contents.size();) {
+    CompilationUnit unit(section_map, offset, &reader, &handler);
+    unit.SetAbbrevTableCache(&cache);
+    offset += unit.Start();
+  }
+  EXPECT_EQ(2U, cache.size());
+}
+
+// A unit the handler skips never decodes its abbreviations.
+TEST_F(CompilationUnitTest, SkippedUnit) {
+  AddUnit(table_two, "skipped", true);
+  Finish();
+
+  MockDwarf2Handler handler;
+  EXPECT_CALL(handler, StartCompilationUnit(0, 4, 4, _, 2))
+      .WillOnce(Return(false));
+
+  AbbrevTableCache cache;
+  ByteReader reader(ENDIANNESS_LITTLE);
+  CompilationUnit unit(section_map, 0, &reader, &handler);
+  unit.SetAbbrevTableCache(&cache);
+  EXPECT_EQ(info_contents.size(), unit.Start());
+  EXPECT_EQ(0U, cache.size());
+}
+
+// A handler that overrides ProcessAttributeStringPointer gets a pointer
+// to the string in the section data, and no copy.
+TEST_F(CompilationUnitTest, StringPointers) {
+  AddUnit(table_one, "in place", false);
+  Finish();
+  // The name follows the 11-byte unit header and the abbrev code.
+  const char *name = info_contents.data() + 12;
+  ASSERT_STREQ("in place", name);
+
+  MockStringPointerHandler handler;
+  EXPECT_CALL(handler, StartCompilationUnit(0, 4, 4, _, 2))
+      .WillOnce(Return(true));
+  EXPECT_CALL(handler, StartDIE(_, dwarf2reader::DW_TAG_compile_unit, _))
+      .WillOnce(Return(true));
+  EXPECT_CALL(handler, ProcessAttributeStringPointer(
+                  _, dwarf2reader::DW_AT_name, dwarf2reader::DW_FORM_string,
+                  name, 8));
+  EXPECT_CALL(handler, ProcessAttributeString(_, _, _, _)).Times(0);
+
+  ByteReader reader(ENDIANNESS_LITTLE);
+  CompilationUnit unit(section_map, 0, &reader, &handler);
+  EXPECT_EQ(info_contents.size(), unit.Start());
+}
+
+struct ThreadedUnitsJob {
+  const SectionMap *section_map;
+  uint64 info_size;
+  AbbrevTableCache *cache;
+  CountingDwarf2Handler handler;
+};
+
+static void *ParseAllUnits(void *arg) {
+  ThreadedUnitsJob *job = static_cast<ThreadedUnitsJob *>(arg);
+  ByteReader reader(ENDIANNESS_LITTLE);
+  for (uint64 offset = 0; offset < job->info_size;) {
+    CompilationUnit unit(*job->section_map, offset, &reader, &job->handler);
+    unit.SetAbbrevTableCache(job->cache);
+    offset += unit.Start();
+  }
+  return NULL;
+}
+
+// Units parsed on several threads at once can share a cache.
+TEST_F(CompilationUnitTest, ThreadedUnits) {
+  const int kUnits = 100;
+  for (int i = 0; i < kUnits; i++)
+    AddUnit(i % 2 ? table_one : table_two, "unit", i % 2 == 0);
+  Finish();
+
+  const int kThreads = 4;
+  AbbrevTableCache cache;
+  ThreadedUnitsJob jobs[kThreads];
+  pthread_t threads[kThreads];
+  for (int i = 0; i < kThreads; i++) {
+    jobs[i].section_map = &section_map;
+    jobs[i].info_size = info_contents.size();
+    jobs[i].cache = &cache;
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, ParseAllUnits, &jobs[i]));
+  }
+  for (int i = 0; i < kThreads; i++) {
+    pthread_join(threads[i], NULL);
+    EXPECT_EQ(kUnits, jobs[i].handler.names());
+  }
+  EXPECT_EQ(2U, cache.size());
+}
@@ -77,8 +77,9 @@ struct DwarfCUToModule::Specification {
   string enclosing_name;
 
   // The name for the specification DIE itself, without any enclosing
-  // name components.
-  string unqualified_name;
+  // name components. This points into the DWARF data, or into
+  // FilePrivate::common_strings.
+  const char *unqualified_name;
 };
 
 // An abstract origin -- base definition of an inline function.
@@ -94,15 +95,11 @@ typedef map<uint64, AbstractOrigin> AbstractOriginByOffset;
 // Data global to the DWARF-bearing file that is private to the
 // DWARF-to-Module process.
 struct DwarfCUToModule::FilePrivate {
-  // A set of strings used in this CU. Before storing a string in one of
-  // our data structures, insert it into this set, and then use the string
-  // from the set.
-  // 
-  // Because std::string uses reference counting internally, simply using
-  // strings from this set, even if passed by value, assigned, or held
-  // directly in structures and containers (map<string, ...>, for example),
-  // causes those strings to share a single instance of each distinct piece
-  // of text.
+  // A set of strings used in this file. Names normally reach us as
+  // pointers into the DWARF data, which we can hold on to for as long
+  // as we are parsing; but names passed to ProcessAttributeString are
+  // only good for the duration of the call. We keep a copy of each
+  // such name here, and refer to that instead.
   set<string> common_strings;
 
   // A map from offsets of DIEs within the .debug_info section to
@@ -183,7 +180,8 @@ class DwarfCUToModule::GenericDIEHandler: public dwarf2reader::DIEHandler {
         parent_context_(parent_context),
         offset_(offset),
         declaration_(false),
-        specification_(NULL) { }
+        specification_(NULL),
+        name_attribute_("") { }
 
   // Derived classes' ProcessAttributeUnsigned can defer to this to
   // handle DW_AT_declaration, or simply not override it.
@@ -197,21 +195,29 @@ class DwarfCUToModule::GenericDIEHandler: public dwarf2reader::DIEHandler {
                                  enum DwarfForm form,
                                  uint64 data);
 
-  // Derived classes' ProcessAttributeReference can defer to this to
-  // handle DW_AT_specification, or simply not override it.
+  // Derived classes' ProcessAttributeString can defer to this to
+  // handle DW_AT_name, or simply not override it.
   void ProcessAttributeString(enum DwarfAttribute attr,
                               enum DwarfForm form,
                               const string &data);
+  void ProcessAttributeStringPointer(enum DwarfAttribute attr,
+                                     enum DwarfForm form,
+                                     const char *data,
+                                     uint64 length);
 
  protected:
-  // Compute and return the fully-qualified name of the DIE. If this
-  // DIE is a declaration DIE, to be cited by other DIEs'
+  // If this DIE is a declaration DIE, to be cited by other DIEs'
   // DW_AT_specification attributes, record its enclosing name and
   // unqualified name in the specification table.
   //
   // Use this from EndAttributes member functions, not ProcessAttribute*
   // functions; only the former can be sure that all the DIE's attributes
   // have been seen.
+  void RecordSpecification();
+
+  // Compute and return the fully-qualified name of the DIE. Since this
+  // allocates the name, call it only for names that will be kept. The
+  // same restrictions apply as for RecordSpecification.
   string ComputeQualifiedName();
 
   CUContext *cu_context_;
@@ -228,8 +234,15 @@ class DwarfCUToModule::GenericDIEHandler: public dwarf2reader::DIEHandler {
   Specification *specification_;
 
   // The value of the DW_AT_name attribute, or the empty string if the
-  // DIE has no such attribute.
-  string name_attribute_;
+  // DIE has no such attribute. This points into the DWARF data, or into
+  // FilePrivate::common_strings.
+  const char *name_attribute_;
+
+ private:
+  // Set *UNQUALIFIED_NAME and *ENCLOSING_NAME to this DIE's name and
+  // the name of its enclosing scope, taking our specification into
+  // account.
+  void GetNames(const char **unqualified_name, const string **enclosing_name);
 };
 
 void DwarfCUToModule::GenericDIEHandler::ProcessAttributeUnsigned(
@@ -279,52 +292,71 @@ void DwarfCUToModule::GenericDIEHandler::ProcessAttributeString(
     const string &data) {
   switch (attr) {
     case dwarf2reader::DW_AT_name: {
-      // Place the name in our global set of strings, and then use the
-      // string from the set. Even though the assignment looks like a copy,
-      // all the major std::string implementations use reference counting
-      // internally, so the effect is to have all our data structures share
-      // copies of strings whenever possible.
+      // DATA won't outlive this call, so place the name in our global
+      // set of strings, and use the string from the set.
       pair<set<string>::iterator, bool> result =
           cu_context_->file_context->file_private->common_strings.insert(data);
-      name_attribute_ = *result.first; 
+      ProcessAttributeStringPointer(attr, form, result.first->c_str(),
+                                    result.first->size());
       break;
     }
     default: break;
   }
 }
 
-string DwarfCUToModule::GenericDIEHandler::ComputeQualifiedName() {
+void DwarfCUToModule::GenericDIEHandler::ProcessAttributeStringPointer(
+    enum DwarfAttribute attr,
+    enum DwarfForm form,
+    const char *data,
+    uint64 length) {
+  switch (attr) {
+    case dwarf2reader::DW_AT_name: name_attribute_ = data; break;
+    default: break;
+  }
+}
+
+void DwarfCUToModule::GenericDIEHandler::GetNames(
+    const char **unqualified_name,
+    const string **enclosing_name) {
   // Find our unqualified name. If the DIE has its own DW_AT_name
   // attribute, then use that; otherwise, check our specification.
-  const string *unqualified_name;
-  if (name_attribute_.empty() && specification_)
-    unqualified_name = &specification_->unqualified_name;
+  if (!*name_attribute_ && specification_)
+    *unqualified_name = specification_->unqualified_name;
   else
-    unqualified_name = &name_attribute_;
+    *unqualified_name = name_attribute_;
 
   // Find the name of our enclosing context. If we have a
   // specification, it's the specification's enclosing context that
   // counts; otherwise, use this DIE's context.
-  const string *enclosing_name;
   if (specification_)
-    enclosing_name = &specification_->enclosing_name;
+    *enclosing_name = &specification_->enclosing_name;
   else
-    enclosing_name = &parent_context_->name;
-
-  // If this DIE was marked as a declaration, record its names in the
-  // specification table.
-  if (declaration_) {
-    FileContext *file_context = cu_context_->file_context;
-    Specification spec;
-    spec.enclosing_name = *enclosing_name;
-    spec.unqualified_name = *unqualified_name;
-    file_context->file_private->specifications[offset_] = spec;
-  }
+    *enclosing_name = &parent_context_->name;
+}
+
+void DwarfCUToModule::GenericDIEHandler::RecordSpecification() {
+  if (!declaration_)
+    return;
+
+  const char *unqualified_name;
+  const string *enclosing_name;
+  GetNames(&unqualified_name, &enclosing_name);
+  FileContext *file_context = cu_context_->file_context;
+  Specification spec;
+  spec.enclosing_name = *enclosing_name;
+  spec.unqualified_name = unqualified_name;
+  file_context->file_private->specifications[offset_] = spec;
+}
+
+string DwarfCUToModule::GenericDIEHandler::ComputeQualifiedName() {
+  const char *unqualified_name;
+  const string *enclosing_name;
+  GetNames(&unqualified_name, &enclosing_name);
 
   // Combine the enclosing name and unqualified name to produce our
   // own fully-qualified name.
   return cu_context_->language->MakeQualifiedName(*enclosing_name,
-                                                  *unqualified_name);
+                                                  unqualified_name);
 }
 
 // A handler class for DW_TAG_subprogram DIEs.
@@ -348,9 +380,11 @@ class DwarfCUToModule::FuncHandler: public GenericDIEHandler {
   void Finish();
 
  private:
-  // The fully-qualified name, as derived from name_attribute_,
-  // specification_, parent_context_.  Computed in EndAttributes.
-  string name_;
+  // Compute and return the fully-qualified name of the function, from
+  // name_attribute_, specification_, parent_context_, or failing those,
+  // abstract_origin_.
+  string ComputeName();
+
   uint64 low_pc_, high_pc_; // DW_AT_low_pc, DW_AT_high_pc
   const AbstractOrigin* abstract_origin_;
   bool inline_;
@@ -412,14 +446,21 @@ void DwarfCUToModule::FuncHandler::ProcessAttributeReference(
 }
 
 bool DwarfCUToModule::FuncHandler::EndAttributes() {
-  // Compute our name, and record a specification, if appropriate.
-  name_ = ComputeQualifiedName();
-  if (name_.empty() && abstract_origin_) {
-    name_ = abstract_origin_->name;
-  }
+  // Record a specification, if appropriate. Most subprogram DIEs are
+  // declarations we never make a Module::Function for, so wait until
+  // Finish to compute our name.
+  RecordSpecification();
   return true;
 }
 
+string DwarfCUToModule::FuncHandler::ComputeName() {
+  string name = ComputeQualifiedName();
+  if (name.empty() && abstract_origin_) {
+    name = abstract_origin_->name;
+  }
+  return name;
+}
+
 void DwarfCUToModule::FuncHandler::Finish() {
   // Did we collect the information we need?  Not all DWARF function
   // entries have low and high addresses (for example, inlined
@@ -431,9 +472,8 @@ void DwarfCUToModule::FuncHandler::Finish() {
     Module::Function *func = new Module::Function;
     // Malformed DWARF may omit the name, but all Module::Functions must
     // have names.
-    if (!name_.empty()) {
-      func->name = name_;
-    } else {
+    func->name = ComputeName();
+    if (func->name.empty()) {
       cu_context_->reporter->UnnamedFunction(offset_);
       func->name = "<name omitted>";
     }
@@ -442,7 +482,7 @@ void DwarfCUToModule::FuncHandler::Finish() {
     func->parameter_size = 0;
     cu_context_->functions.push_back(func);
   } else if (inline_) {
-    AbstractOrigin origin(name_);
+    AbstractOrigin origin(ComputeName());
     cu_context_->file_context->file_private->origins[offset_] = origin;
   }
 }
@@ -463,6 +503,7 @@ class DwarfCUToModule::NamedScopeHandler: public GenericDIEHandler {
 };
 
 bool DwarfCUToModule::NamedScopeHandler::EndAttributes() {
+  RecordSpecification();
   child_context_.name = ComputeQualifiedName();
   return true;
 }
@@ -39,6 +39,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <link.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -62,6 +63,8 @@
 #include "common/module.h"
 #include "common/stabs_reader.h"
 #include "common/stabs_to_module.h"
+#include "processor/module_serializer.h"
+#include "processor/scoped_ptr.h"
 
 // This namespace contains helper functions.
 namespace {
@@ -235,9 +238,306 @@ class DumperLineToModule: public DwarfCUToModule::LineToModuleFunctor {
   dwarf2reader::ByteReader *byte_reader_;
 };
 
+// A WarningReporter that records warnings rather than printing them, so
+// that the warnings for compilation units parsed concurrently can be
+// printed afterwards in the order serial parsing would print them.  It
+// also notes when a DIE refers to a DIE outside its compilation unit that
+// hasn't been seen: parsing units separately cannot resolve such
+// references, whereas parsing them in order sometimes does.
+class RecordingWarningReporter: public DwarfCUToModule::WarningReporter {
+ public:
+  RecordingWarningReporter(const string &filename, uint64 cu_offset,
+                           uint64 cu_end)
+      : WarningReporter(filename, cu_offset), cu_end_(cu_end),
+        unresolved_external_reference_(false) { }
+
+  void SetCUName(const string &name) {
+    Record(SET_CU_NAME, 0, 0, name);
+  }
+  void UnknownSpecification(uint64 offset, uint64 target) {
+    NoteTarget(target);
+    Record(UNKNOWN_SPECIFICATION, offset, target);
+  }
+  void UnknownAbstractOrigin(uint64 offset, uint64 target) {
+    NoteTarget(target);
+    Record(UNKNOWN_ABSTRACT_ORIGIN, offset, target);
+  }
+  void MissingSection(const string &section_name) {
+    Record(MISSING_SECTION, 0, 0, section_name);
+  }
+  void BadLineInfoOffset(uint64 offset) {
+    Record(BAD_LINE_INFO_OFFSET, offset, 0);
+  }
+  void UncoveredFunction(const Module::Function &function) {
+    if (uncovered_warnings_enabled_)
+      Record(UNCOVERED_FUNCTION, function.address, function.size,
+             function.name);
+  }
+  void UncoveredLine(const Module::Line &line) {
+    if (uncovered_warnings_enabled_)
+      Record(UNCOVERED_LINE, line.address, line.size, line.file->name,
+             line.number);
+  }
+  void UnnamedFunction(uint64 offset) {
+    Record(UNNAMED_FUNCTION, offset, 0);
+  }
+
+  // True if this unit refers to a DIE elsewhere that it could not find.
+  bool unresolved_external_reference() const {
+    return unresolved_external_reference_;
+  }
+
+  // Print the recorded warnings, as a plain WarningReporter would have.
+  void Replay() const {
+    DwarfCUToModule::WarningReporter reporter(filename_, cu_offset_);
+    reporter.set_uncovered_warnings_enabled(uncovered_warnings_enabled_);
+    for (vector<Warning>::const_iterator it = warnings_.begin();
+         it != warnings_.end(); ++it) {
+      switch (it->kind) {
+        case SET_CU_NAME:
+          reporter.SetCUName(it->text);
+          break;
+        case UNKNOWN_SPECIFICATION:
+          reporter.UnknownSpecification(it->first, it->second);
+          break;
+        case UNKNOWN_ABSTRACT_ORIGIN:
+          reporter.UnknownAbstractOrigin(it->first, it->second);
+          break;
+        case MISSING_SECTION:
+          reporter.MissingSection(it->text);
+          break;
+        case BAD_LINE_INFO_OFFSET:
+          reporter.BadLineInfoOffset(it->first);
+          break;
+        case UNCOVERED_FUNCTION: {
+          Module::Function function;
+          function.name = it->text;
+          function.address = it->first;
+          function.size = it->second;
+          function.parameter_size = 0;
+          reporter.UncoveredFunction(function);
+          break;
+        }
+        case UNCOVERED_LINE: {
+          Module::File file;
+          file.name = it->text;
+          file.source_id = -1;
+          Module::Line line;
+          line.address = it->first;
+          line.size = it->second;
+          line.file = &file;
+          line.number = it->number;
+          reporter.UncoveredLine(line);
+          break;
+        }
+        case UNNAMED_FUNCTION:
+          reporter.UnnamedFunction(it->first);
+          break;
+      }
+    }
+  }
+
+ private:
+  enum WarningKind {
+    SET_CU_NAME,
+    UNKNOWN_SPECIFICATION,
+    UNKNOWN_ABSTRACT_ORIGIN,
+    MISSING_SECTION,
+    BAD_LINE_INFO_OFFSET,
+    UNCOVERED_FUNCTION,
+    UNCOVERED_LINE,
+    UNNAMED_FUNCTION
+  };
+
+  struct Warning {
+    WarningKind kind;
+    uint64 first, second;
+    string text;
+    int number;
+  };
+
+  void Record(WarningKind kind, uint64 first, uint64 second,
+              const string &text = string(), int number = 0) {
+    Warning warning;
+    warning.kind = kind;
+    warning.first = first;
+    warning.second = second;
+    warning.text = text;
+    warning.number = number;
+    warnings_.push_back(warning);
+  }
+
+  void NoteTarget(uint64 target) {
+    if (target < cu_offset_ || target >= cu_end_)
+      unresolved_external_reference_ = true;
+  }
+
+  uint64 cu_end_;
+  bool unresolved_external_reference_;
+  vector<Warning> warnings_;
+};
+
+// A compilation unit for a worker thread to parse into a Module of its
+// own.
+struct DwarfCUJob {
+  uint64 offset, end;
+  Module *module;
+  RecordingWarningReporter *reporter;
+};
+
+// The compilation units to parse, and the index of the next one that no
+// thread has started on.
+struct DwarfCUQueue {
+  const string *dwarf_filename;
+  const dwarf2reader::SectionMap *section_map;
+  dwarf2reader::Endianness endianness;
+  dwarf2reader::AbbrevTableCache *abbrev_cache;
+  vector<DwarfCUJob> *jobs;
+  size_t next;
+  pthread_mutex_t mutex;
+};
+
+static void ParseDwarfCU(const DwarfCUQueue *queue, DwarfCUJob *job) {
+  job->module = new Module(*queue->dwarf_filename, "", "", "");
+  job->reporter = new RecordingWarningReporter(*queue->dwarf_filename,
+                                               job->offset, job->end);
+  DwarfCUToModule::FileContext file_context(*queue->dwarf_filename,
+                                            job->module);
+  file_context.section_map = *queue->section_map;
+  dwarf2reader::ByteReader byte_reader(queue->endianness);
+  DumperLineToModule line_to_module(&byte_reader);
+  DwarfCUToModule root_handler(&file_context, &line_to_module, job->reporter);
+  dwarf2reader::DIEDispatcher die_dispatcher(&root_handler);
+  dwarf2reader::CompilationUnit reader(file_context.section_map,
+                                       job->offset,
+                                       &byte_reader,
+                                       &die_dispatcher);
+  reader.SetAbbrevTableCache(queue->abbrev_cache);
+  reader.Start();
+}
+
+static void *DwarfCUThreadMain(void *arg) {
+  DwarfCUQueue *queue = static_cast<DwarfCUQueue *>(arg);
+  while (true) {
+    pthread_mutex_lock(&queue->mutex);
+    if (queue->next == queue->jobs->size()) {
+      pthread_mutex_unlock(&queue->mutex);
+      return NULL;
+    }
+    DwarfCUJob *job = &(*queue->jobs)[queue->next++];
+    pthread_mutex_unlock(&queue->mutex);
+    ParseDwarfCU(queue, job);
+  }
+}
+
+// Add copies of SOURCE's functions to DEST, as if they had been added to
+// DEST directly, with their lines referring to DEST's files.
+static void MergeDwarfCUModule(Module *source, Module *dest) {
+  vector<Module::File *> files;
+  source->GetFiles(&files);
+  for (vector<Module::File *>::iterator it = files.begin();
+       it != files.end(); ++it)
+    dest->FindFile((*it)->name);
+
+  vector<Module::Function *> functions;
+  source->GetFunctions(&functions, functions.end());
+  for (vector<Module::Function *>::iterator it = functions.begin();
+       it != functions.end(); ++it) {
+    Module::Function *function = new Module::Function(**it);
+    for (vector<Module::Line>::iterator line = function->lines.begin();
+         line != function->lines.end(); ++line)
+      line->file = dest->FindFile(line->file->name);
+    dest->AddFunction(function);
+  }
+}
+
+// Parse the compilation units in the .debug_info section of
+// FILE_CONTEXT on up to THREAD_COUNT threads, each into a Module of its
+// own, and then merge those into FILE_CONTEXT's module in file order, so
+// that the result is the same as parsing them serially.  Return false,
+// leaving the module untouched, if the units cannot be parsed this way:
+// if there are fewer than two, if their headers are malformed, or if
+// one refers to a DIE in another.  The threads share ABBREV_CACHE.
+static bool LoadDwarfConcurrently(const string &dwarf_filename,
+                                  const DwarfCUToModule::FileContext
+                                      &file_context,
+                                  dwarf2reader::Endianness endianness,
+                                  dwarf2reader::AbbrevTableCache
+                                      *abbrev_cache,
+                                  int thread_count) {
+  dwarf2reader::SectionMap::const_iterator debug_info_section
+      = file_context.section_map.find(".debug_info");
+  const char *debug_info = debug_info_section->second.first;
+  uint64 debug_info_length = debug_info_section->second.second;
+
+  // Find each compilation unit's extent from its initial length field.
+  vector<DwarfCUJob> jobs;
+  dwarf2reader::ByteReader header_reader(endianness);
+  for (uint64 offset = 0; offset < debug_info_length;) {
+    // The initial length field takes up to twelve bytes; a unit too short
+    // to hold it is malformed.
+    if (debug_info_length - offset < 12)
+      return false;
+    size_t initial_length_size;
+    uint64 length = header_reader.ReadInitialLength(debug_info + offset,
+                                                    &initial_length_size);
+    if (length > debug_info_length - offset - initial_length_size)
+      return false;
+    DwarfCUJob job;
+    job.offset = offset;
+    job.end = offset + initial_length_size + length;
+    job.module = NULL;
+    job.reporter = NULL;
+    jobs.push_back(job);
+    offset = job.end;
+  }
+  if (jobs.size() < 2)
+    return false;
+
+  DwarfCUQueue queue;
+  queue.dwarf_filename = &dwarf_filename;
+  queue.section_map = &file_context.section_map;
+  queue.endianness = endianness;
+  queue.abbrev_cache = abbrev_cache;
+  queue.jobs = &jobs;
+  queue.next = 0;
+  pthread_mutex_init(&queue.mutex, NULL);
+
+  // This thread parses units too.
+  vector<pthread_t> threads;
+  for (int i = 1; i < thread_count && static_cast<size_t>(i) < jobs.size();
+       i++) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, DwarfCUThreadMain, &queue) != 0)
+      break;
+    threads.push_back(thread);
+  }
+  DwarfCUThreadMain(&queue);
+  for (size_t i = 0; i < threads.size(); i++)
+    pthread_join(threads[i], NULL);
+  pthread_mutex_destroy(&queue.mutex);
+
+  bool independent = true;
+  for (size_t i = 0; i < jobs.size(); i++) {
+    if (jobs[i].reporter->unresolved_external_reference())
+      independent = false;
+  }
+
+  for (size_t i = 0; i < jobs.size(); i++) {
+    if (independent) {
+      jobs[i].reporter->Replay();
+      MergeDwarfCUModule(jobs[i].module, file_context.module);
+    }
+    delete jobs[i].reporter;
+    delete jobs[i].module;
+  }
+  return independent;
+}
+
 static bool LoadDwarf(const string &dwarf_filename,
                       const ElfW(Ehdr) *elf_header,
                       const bool big_endian,
+                      int thread_count,
                       Module *module) {
   const dwarf2reader::Endianness endianness = big_endian ?
       dwarf2reader::ENDIANNESS_BIG : dwarf2reader::ENDIANNESS_LITTLE;
@@ -267,6 +567,13 @@ static bool LoadDwarf(const string &dwarf_filename,
   // We should never have been called if the file doesn't have a
   // .debug_info section.
   assert(debug_info_section.first);
+  // Compilation units often share abbreviation tables; decode each
+  // table only once.
+  dwarf2reader::AbbrevTableCache abbrev_cache;
+  if (thread_count > 1 &&
+      LoadDwarfConcurrently(dwarf_filename, file_context, endianness,
+                            &abbrev_cache, thread_count))
+    return true;
   uint64 debug_info_length = debug_info_section.second;
   for (uint64 offset = 0; offset < debug_info_length;) {
     // Make a handler for the root DIE that populates MODULE with the
@@ -280,6 +587,7 @@ static bool LoadDwarf(const string &dwarf_filename,
                                          offset,
                                          &byte_reader,
                                          &die_dispatcher);
+    reader.SetAbbrevTableCache(&abbrev_cache);
     // Process the entire compilation unit; get the offset of the next.
     offset += reader.Start();
   }
@@ -519,6 +827,7 @@ static bool LoadSymbols(const std::string &obj_file,
                         const bool big_endian,
                         ElfW(Ehdr) *elf_header,
                         const bool read_gnu_debug_link,
+                        int dwarf_thread_count,
                         LoadSymbolsInfo *info,
                         Module *module) {
   // Translate all offsets in section headers into address.
@@ -561,7 +870,8 @@ static bool LoadSymbols(const std::string &obj_file,
     found_debug_info_section = true;
     found_usable_info = true;
     info->LoadedSection(".debug_info");
-    if (!LoadDwarf(obj_file, elf_header, big_endian, module))
+    if (!LoadDwarf(obj_file, elf_header, big_endian, dwarf_thread_count,
+                   module))
       fprintf(stderr, "%s: \".debug_info\" section found, but failed to load "
               "DWARF debugging information\n", obj_file.c_str());
   }
@@ -725,10 +1035,14 @@ namespace google_breakpad {
 // Not explicitly exported, but not static so it can be used in unit tests.
 // Ideally obj_file would be const, but internally this code does write
 // to some ELF header fields to make its work simpler.
+// If SERIALIZED is true, write the module in the FastSourceLineResolver
+// serialized format rather than as a symbol file.
 bool WriteSymbolFileInternal(uint8_t* obj_file,
                              const std::string &obj_filename,
                              const std::string &debug_dir,
                              bool cfi,
+                             int dwarf_thread_count,
+                             bool serialized,
                              std::ostream &sym_stream) {
   ElfW(Ehdr) *elf_header = reinterpret_cast<ElfW(Ehdr) *>(obj_file);
 
@@ -764,7 +1078,7 @@ bool WriteSymbolFileInternal(uint8_t* obj_file,
   LoadSymbolsInfo info(debug_dir);
   Module module(name, os, architecture, id);
   if (!LoadSymbols(obj_filename, big_endian, elf_header, !debug_dir.empty(),
-                   &info, &module)) {
+                   dwarf_thread_count, &info, &module)) {
     const std::string debuglink_file = info.debuglink_file();
     if (debuglink_file.empty())
       return false;
@@ -800,27 +1114,84 @@ bool WriteSymbolFileInternal(uint8_t* obj_file,
     }
 
     if (!LoadSymbols(debuglink_file, debug_big_endian, debug_elf_header,
-                     false, &info, &module)) {
+                     false, dwarf_thread_count, &info, &module)) {
       return false;
     }
   }
+  if (serialized) {
+    ModuleSerializer serializer;
+    unsigned int size = 0;
+    scoped_array<char> data(
+        serializer.SerializeDumpedModule(&module, cfi, &size));
+    if (!data.get()) {
+      fprintf(stderr, "%s: unable to serialize symbols\n",
+              obj_filename.c_str());
+      return false;
+    }
+    sym_stream.write(data.get(), size);
+    return sym_stream.good();
+  }
+
   if (!module.Write(sym_stream, cfi))
     return false;
 
   return true;
 }
 
+bool WriteSymbolFileInternal(uint8_t* obj_file,
+                             const std::string &obj_filename,
+                             const std::string &debug_dir,
+                             bool cfi,
+                             int dwarf_thread_count,
+                             std::ostream &sym_stream) {
+  return WriteSymbolFileInternal(obj_file, obj_filename, debug_dir, cfi,
+                                 dwarf_thread_count, false, sym_stream);
+}
+
+bool WriteSymbolFileInternal(uint8_t* obj_file,
+                             const std::string &obj_filename,
+                             const std::string &debug_dir,
+                             bool cfi,
+                             std::ostream &sym_stream) {
+  return WriteSymbolFileInternal(obj_file, obj_filename, debug_dir, cfi, 1,
+                                 sym_stream);
+}
+
 bool WriteSymbolFile(const std::string &obj_file,
                      const std::string &debug_dir,
                      bool cfi,
                      std::ostream &sym_stream) {
+  return WriteSymbolFile(obj_file, debug_dir, cfi, 1, sym_stream);
+}
+
+bool WriteSymbolFile(const std::string &obj_file,
+                     const std::string &debug_dir,
+                     bool cfi,
+                     int dwarf_thread_count,
+                     std::ostream &sym_stream) {
+  MmapWrapper map_wrapper;
+  ElfW(Ehdr) *elf_header = NULL;
+  if (!LoadELF(obj_file, &map_wrapper, &elf_header))
+    return false;
+
+  return WriteSymbolFileInternal(reinterpret_cast<uint8_t*>(elf_header),
+                                 obj_file, debug_dir, cfi, dwarf_thread_count,
+                                 sym_stream);
+}
+
+bool WriteSerializedSymbolFile(const std::string &obj_file,
+                               const std::string &debug_dir,
+                               bool cfi,
+                               int dwarf_thread_count,
+                               std::ostream &serialized_stream) {
   MmapWrapper map_wrapper;
   ElfW(Ehdr) *elf_header = NULL;
   if (!LoadELF(obj_file, &map_wrapper, &elf_header))
     return false;
 
   return WriteSymbolFileInternal(reinterpret_cast<uint8_t*>(elf_header),
-                                 obj_file, debug_dir, cfi, sym_stream);
+                                 obj_file, debug_dir, cfi, dwarf_thread_count,
+                                 true, serialized_stream);
 }
 
 }  // namespace google_breakpad
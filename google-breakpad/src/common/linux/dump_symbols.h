@@ -51,6 +51,29 @@ bool WriteSymbolFile(const std::string &obj_file,
                      bool cfi,
                      std::ostream &sym_stream);
 
+// As above, but parse the DWARF compilation units in OBJ_FILE on up to
+// DWARF_THREAD_COUNT threads. The symbol file written is the same as
+// parsing them serially would produce; if the units refer to each other
+// in ways that parsing them separately cannot resolve, they are parsed
+// serially instead.
+bool WriteSymbolFile(const std::string &obj_file,
+                     const std::string &debug_dir,
+                     bool cfi,
+                     int dwarf_thread_count,
+                     std::ostream &sym_stream);
+
+// As above, but write the symbols to SERIALIZED_STREAM in the format
+// ModuleSerializer produces, which FastSourceLineResolver loads without
+// parsing. The data is the same as serializing the symbol file that
+// WriteSymbolFile writes would produce, but building the symbol file's
+// text and parsing it again is skipped. SERIALIZED_STREAM should be
+// opened in binary mode.
+bool WriteSerializedSymbolFile(const std::string &obj_file,
+                               const std::string &debug_dir,
+                               bool cfi,
+                               int dwarf_thread_count,
+                               std::ostream &serialized_stream);
+
 }  // namespace google_breakpad
 
 #endif  // COMMON_LINUX_DUMP_SYMBOLS_H__
@@ -41,6 +41,7 @@
 #include <vector>
 
 #include "breakpad_googletest_includes.h"
+#include "common/dwarf/dwarf2enums.h"
 #include "common/linux/synth_elf.h"
 
 namespace google_breakpad {
@@ -49,12 +50,19 @@ bool WriteSymbolFileInternal(uint8_t* obj_file,
                              const std::string &debug_dir,
                              bool cfi,
                              std::ostream &sym_stream);
+bool WriteSymbolFileInternal(uint8_t* obj_file,
+                             const std::string &obj_filename,
+                             const std::string &debug_dir,
+                             bool cfi,
+                             int dwarf_thread_count,
+                             std::ostream &sym_stream);
 }
 
 using google_breakpad::synth_elf::ELF;
 using google_breakpad::synth_elf::StringTable;
 using google_breakpad::synth_elf::SymbolTable;
 using google_breakpad::test_assembler::kLittleEndian;
+using google_breakpad::test_assembler::Label;
 using google_breakpad::test_assembler::Section;
 using google_breakpad::WriteSymbolFileInternal;
 using std::string;
@@ -164,3 +172,148 @@ TEST_F(DumpSymbols, SimplePublic64) {
             s.str());
 }
 #endif
+
+// Produce a little-endian 64-bit ELF file whose .debug_info section
+// holds UNIT_COUNT compilation units, each defining two functions.  If
+// CROSS_UNIT_SPECIFICATION is set, the last unit also defines a member
+// function of a class declared in the first.
+class DumpSymbolsDwarf : public DumpSymbols {
+ public:
+  enum {
+    kUnitAbbrev = 1,
+    kFunctionAbbrev,
+    kClassAbbrev,
+    kDeclarationAbbrev,
+    kDefinitionAbbrev
+  };
+
+  void MakeElf(int unit_count, bool cross_unit_specification) {
+    Section abbrevs(kLittleEndian);
+    abbrevs
+        .ULEB128(kUnitAbbrev).ULEB128(dwarf2reader::DW_TAG_compile_unit)
+        .D8(dwarf2reader::DW_children_yes)
+        .ULEB128(dwarf2reader::DW_AT_name)
+        .ULEB128(dwarf2reader::DW_FORM_string)
+        .ULEB128(0).ULEB128(0)
+        .ULEB128(kFunctionAbbrev).ULEB128(dwarf2reader::DW_TAG_subprogram)
+        .D8(dwarf2reader::DW_children_no)
+        .ULEB128(dwarf2reader::DW_AT_name)
+        .ULEB128(dwarf2reader::DW_FORM_string)
+        .ULEB128(dwarf2reader::DW_AT_low_pc)
+        .ULEB128(dwarf2reader::DW_FORM_addr)
+        .ULEB128(dwarf2reader::DW_AT_high_pc)
+        .ULEB128(dwarf2reader::DW_FORM_addr)
+        .ULEB128(0).ULEB128(0)
+        .ULEB128(kClassAbbrev).ULEB128(dwarf2reader::DW_TAG_class_type)
+        .D8(dwarf2reader::DW_children_yes)
+        .ULEB128(dwarf2reader::DW_AT_name)
+        .ULEB128(dwarf2reader::DW_FORM_string)
+        .ULEB128(0).ULEB128(0)
+        .ULEB128(kDeclarationAbbrev).ULEB128(dwarf2reader::DW_TAG_subprogram)
+        .D8(dwarf2reader::DW_children_no)
+        .ULEB128(dwarf2reader::DW_AT_name)
+        .ULEB128(dwarf2reader::DW_FORM_string)
+        .ULEB128(dwarf2reader::DW_AT_declaration)
+        .ULEB128(dwarf2reader::DW_FORM_flag)
+        .ULEB128(0).ULEB128(0)
+        .ULEB128(kDefinitionAbbrev).ULEB128(dwarf2reader::DW_TAG_subprogram)
+        .D8(dwarf2reader::DW_children_no)
+        .ULEB128(dwarf2reader::DW_AT_specification)
+        .ULEB128(dwarf2reader::DW_FORM_ref_addr)
+        .ULEB128(dwarf2reader::DW_AT_low_pc)
+        .ULEB128(dwarf2reader::DW_FORM_addr)
+        .ULEB128(dwarf2reader::DW_AT_high_pc)
+        .ULEB128(dwarf2reader::DW_FORM_addr)
+        .ULEB128(0).ULEB128(0)
+        .ULEB128(0);
+
+    Section info(kLittleEndian);
+    info.start() = 0;
+    Label declaration;
+    for (int i = 0; i < unit_count; i++) {
+      Label length, unit_start;
+      info
+          .D32(length)
+          .Mark(&unit_start)
+          .D16(2)                       // DWARF version
+          .D32(0)                       // .debug_abbrev offset
+          .D8(8)                        // address size
+          .ULEB128(kUnitAbbrev);
+      char name[20];
+      snprintf(name, sizeof(name), "unit%d.cc", i);
+      info.AppendCString(name);
+      for (int j = 0; j < 2; j++) {
+        uint64_t address = 0x1000 + i * 0x100 + j * 0x40;
+        snprintf(name, sizeof(name), "function_%d_%d", i, j);
+        info
+            .ULEB128(kFunctionAbbrev)
+            .AppendCString(name)
+            .D64(address)
+            .D64(address + 0x20);
+      }
+      if (cross_unit_specification && i == 0) {
+        info
+            .ULEB128(kClassAbbrev)
+            .AppendCString("Widget")
+            .Mark(&declaration)
+            .ULEB128(kDeclarationAbbrev)
+            .AppendCString("Frob")
+            .D8(1)
+            .D8(0);                     // end of class's children
+      }
+      if (cross_unit_specification && i == unit_count - 1) {
+        info
+            .ULEB128(kDefinitionAbbrev)
+            .D64(declaration)
+            .D64(0x3000)
+            .D64(0x3010);
+      }
+      info.D8(0);                       // end of unit's children
+      length = info.Here() - unit_start;
+    }
+
+    elf = new ELF(EM_X86_64, ELFCLASS64, kLittleEndian);
+    Section text(kLittleEndian);
+    text.Append(4096, 0);
+    elf->AddSection(".text", text, SHT_PROGBITS);
+    elf->AddSection(".debug_abbrev", abbrevs, SHT_PROGBITS);
+    elf->AddSection(".debug_info", info, SHT_PROGBITS);
+    elf->Finish();
+    GetElfContents(*elf);
+  }
+
+  // Return the symbol file for the ELF file most recently produced by
+  // MakeElf, parsing its compilation units on THREAD_COUNT threads.
+  string Dump(int thread_count) {
+    // WriteSymbolFileInternal modifies the file's headers, so work on a
+    // fresh copy each time.
+    vector<uint8_t> copy(elfdata_v);
+    stringstream s;
+    EXPECT_TRUE(WriteSymbolFileInternal(&copy[0], "foo", "", true,
+                                        thread_count, s));
+    return s.str();
+  }
+
+  DumpSymbolsDwarf() : elf(NULL) { }
+  ~DumpSymbolsDwarf() { delete elf; }
+
+  ELF *elf;
+};
+
+#if __ELF_NATIVE_CLASS == 64
+TEST_F(DumpSymbolsDwarf, ConcurrentUnits) {
+  MakeElf(6, false);
+  string serial = Dump(1);
+  EXPECT_EQ(serial, Dump(4));
+  EXPECT_EQ(serial, Dump(64));
+  EXPECT_NE(string::npos, serial.find("FUNC 1000 20 0 function_0_0\n"));
+  EXPECT_NE(string::npos, serial.find("FUNC 1540 20 0 function_5_1\n"));
+}
+
+TEST_F(DumpSymbolsDwarf, ConcurrentUnitsCrossReference) {
+  MakeElf(3, true);
+  string serial = Dump(1);
+  EXPECT_NE(string::npos, serial.find("FUNC 3000 10 0 Widget::Frob\n"));
+  EXPECT_EQ(serial, Dump(4));
+}
+#endif
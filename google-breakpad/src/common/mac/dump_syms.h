@@ -114,6 +114,13 @@ class DumpSymbols {
   // if an error occurs, report it and return false.
   bool WriteSymbolFile(std::ostream &stream, bool cfi);
 
+  // Read the selected object file's debugging information into a new
+  // Module, and set *|module| to point to it. The caller owns the Module.
+  // Return true on success; if an error occurs, report it and return false.
+  // This lets callers write the module in other formats, such as the one
+  // ModuleSerializer produces, without this class depending on them.
+  bool ReadSymbolData(Module **module);
+
  private:
   // Used internally.
   class DumperLineToModule;
@@ -54,6 +54,7 @@
 #include "common/module.h"
 #include "common/stabs_reader.h"
 #include "common/stabs_to_module.h"
+#include "processor/scoped_ptr.h"
 
 #ifndef CPU_TYPE_ARM
 #define CPU_TYPE_ARM (static_cast<cpu_type_t>(12))
@@ -69,6 +70,7 @@ using google_breakpad::mach_o::Segment;
 using google_breakpad::Module;
 using google_breakpad::StabsReader;
 using google_breakpad::StabsToModule;
+using google_breakpad::scoped_ptr;
 using std::make_pair;
 using std::pair;
 using std::string;
@@ -272,6 +274,10 @@ bool DumpSymbols::ReadDwarf(google_breakpad::Module *module,
   // Build a line-to-module loader for the root handler to use.
   DumperLineToModule line_to_module(&byte_reader);
 
+  // Compilation units often share abbreviation tables; decode each
+  // table only once.
+  dwarf2reader::AbbrevTableCache abbrev_cache;
+
   // Walk the __debug_info section, one compilation unit at a time.
   uint64 debug_info_length = debug_info_section.second;
   for (uint64 offset = 0; offset < debug_info_length;) {
@@ -287,6 +293,7 @@ bool DumpSymbols::ReadDwarf(google_breakpad::Module *module,
                                                offset,
                                                &byte_reader,
                                                &die_dispatcher);
+    dwarf_reader.SetAbbrevTableCache(&abbrev_cache);
     // Process the entire compilation unit; get the offset of the next.
     offset += dwarf_reader.Start();
   }
@@ -421,7 +428,7 @@ bool DumpSymbols::LoadCommandDumper::SymtabCommand(const ByteBuffer &entries,
   return true;
 }
 
-bool DumpSymbols::WriteSymbolFile(std::ostream &stream, bool cfi) {
+bool DumpSymbols::ReadSymbolData(Module **module) {
   // Select an object file, if SetArchitecture hasn't been called to set one
   // explicitly.
   if (!selected_object_file_) {
@@ -472,8 +479,8 @@ bool DumpSymbols::WriteSymbolFile(std::ostream &stream, bool cfi) {
   identifier += "0";
 
   // Create a module to hold the debugging information.
-  Module module([module_name UTF8String], "mac", selected_arch_name,
-                identifier);
+  scoped_ptr<Module> new_module(new Module([module_name UTF8String], "mac",
+                                           selected_arch_name, identifier));
 
   // Parse the selected object file.
   mach_o::Reader::Reporter reporter(selected_object_name_);
@@ -486,11 +493,20 @@ bool DumpSymbols::WriteSymbolFile(std::ostream &stream, bool cfi) {
     return false;
 
   // Walk its load commands, and deal with whatever is there.
-  LoadCommandDumper load_command_dumper(*this, &module, reader);
+  LoadCommandDumper load_command_dumper(*this, new_module.get(), reader);
   if (!reader.WalkLoadCommands(&load_command_dumper))
     return false;
 
-  return module.Write(stream, cfi);
+  *module = new_module.release();
+  return true;
+}
+
+bool DumpSymbols::WriteSymbolFile(std::ostream &stream, bool cfi) {
+  Module *module = NULL;
+  if (!ReadSymbolData(&module))
+    return false;
+  scoped_ptr<Module> module_deleter(module);
+  return module->Write(stream, cfi);
 }
 
 }  // namespace google_breakpad
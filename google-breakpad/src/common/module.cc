@@ -41,11 +41,9 @@
 #include <iostream>
 #include <utility>
 
-namespace google_breakpad {
+#include "common/record_writer.h"
 
-using std::dec;
-using std::endl;
-using std::hex;
+namespace google_breakpad {
 
 
 Module::Module(const string &name, const string &os,
@@ -194,21 +192,34 @@ bool Module::ReportError() {
   return false;
 }
 
-bool Module::WriteRuleMap(const RuleMap &rule_map, std::ostream &stream) {
+void Module::WriteRuleMap(const RuleMap &rule_map, RecordWriter *writer) {
   for (RuleMap::const_iterator it = rule_map.begin();
        it != rule_map.end(); ++it) {
     if (it != rule_map.begin())
-      stream << ' ';
-    stream << it->first << ": " << it->second;
+      writer->Write(' ');
+    writer->Write(it->first);
+    writer->Write(": ");
+    writer->Write(it->second);
   }
-  return stream.good();
 }
 
 bool Module::Write(std::ostream &stream, bool cfi) {
-  stream << "MODULE " << os_ << " " << architecture_ << " "
-         << id_ << " " << name_ << endl;
-  if (!stream.good())
-    return ReportError();
+  RecordWriter writer(&stream);
+  return Write(&writer, cfi);
+}
+
+bool Module::Write(RecordWriter *writer, bool cfi) {
+  // WRITER only reports errors when its buffer is written out, so check
+  // after each group of records and after the final flush.
+  writer->Write("MODULE ");
+  writer->Write(os_);
+  writer->Write(' ');
+  writer->Write(architecture_);
+  writer->Write(' ');
+  writer->Write(id_);
+  writer->Write(' ');
+  writer->Write(name_);
+  writer->Write('\n');
 
   AssignSourceIds();
 
@@ -217,47 +228,57 @@ bool Module::Write(std::ostream &stream, bool cfi) {
        file_it != files_.end(); ++file_it) {
     File *file = file_it->second;
     if (file->source_id >= 0) {
-      stream << "FILE " << file->source_id << " " <<  file->name << endl;
-      if (!stream.good())
-        return ReportError();
+      writer->Write("FILE ");
+      writer->WriteDecimal(file->source_id);
+      writer->Write(' ');
+      writer->Write(file->name);
+      writer->Write('\n');
     }
   }
+  if (!writer->good())
+    return ReportError();
 
   // Write out functions and their lines.
   for (FunctionSet::const_iterator func_it = functions_.begin();
        func_it != functions_.end(); ++func_it) {
     Function *func = *func_it;
-    stream << "FUNC " << hex
-           << (func->address - load_address_) << " "
-           << func->size << " "
-           << func->parameter_size << " "
-           << func->name << dec << endl;
+    writer->Write("FUNC ");
+    writer->WriteHex(func->address - load_address_);
+    writer->Write(' ');
+    writer->WriteHex(func->size);
+    writer->Write(' ');
+    writer->WriteHex(func->parameter_size);
+    writer->Write(' ');
+    writer->Write(func->name);
+    writer->Write('\n');
 
-    if (!stream.good())
-      return ReportError();
     for (vector<Line>::iterator line_it = func->lines.begin();
          line_it != func->lines.end(); ++line_it) {
-      stream << hex
-             << (line_it->address - load_address_) << " "
-             << line_it->size << " "
-             << dec
-             << line_it->number << " "
-             << line_it->file->source_id << endl;
-      if (!stream.good())
-        return ReportError();
+      writer->WriteHex(line_it->address - load_address_);
+      writer->Write(' ');
+      writer->WriteHex(line_it->size);
+      writer->Write(' ');
+      writer->WriteDecimal(line_it->number);
+      writer->Write(' ');
+      writer->WriteDecimal(line_it->file->source_id);
+      writer->Write('\n');
     }
+    if (!writer->good())
+      return ReportError();
   }
 
   // Write out 'PUBLIC' records.
   for (ExternSet::const_iterator extern_it = externs_.begin();
        extern_it != externs_.end(); ++extern_it) {
     Extern *ext = *extern_it;
-    stream << "PUBLIC " << hex
-           << (ext->address - load_address_) << " 0 "
-           << ext->name << dec << endl;
-    if (!stream.good())
-      return ReportError();
+    writer->Write("PUBLIC ");
+    writer->WriteHex(ext->address - load_address_);
+    writer->Write(" 0 ");
+    writer->Write(ext->name);
+    writer->Write('\n');
   }
+  if (!writer->good())
+    return ReportError();
 
   if (cfi) {
     // Write out 'STACK CFI INIT' and 'STACK CFI' records.
@@ -265,29 +286,31 @@ bool Module::Write(std::ostream &stream, bool cfi) {
     for (frame_it = stack_frame_entries_.begin();
          frame_it != stack_frame_entries_.end(); ++frame_it) {
       StackFrameEntry *entry = *frame_it;
-      stream << "STACK CFI INIT " << hex
-             << (entry->address - load_address_) << " "
-             << entry->size << " " << dec;
-      if (!stream.good()
-          || !WriteRuleMap(entry->initial_rules, stream))
-        return ReportError();
-
-      stream << endl;
+      writer->Write("STACK CFI INIT ");
+      writer->WriteHex(entry->address - load_address_);
+      writer->Write(' ');
+      writer->WriteHex(entry->size);
+      writer->Write(' ');
+      WriteRuleMap(entry->initial_rules, writer);
+      writer->Write('\n');
 
       // Write out this entry's delta rules as 'STACK CFI' records.
       for (RuleChangeMap::const_iterator delta_it = entry->rule_changes.begin();
            delta_it != entry->rule_changes.end(); ++delta_it) {
-        stream << "STACK CFI " << hex
-               << (delta_it->first - load_address_) << " " << dec;
-        if (!stream.good()
-            || !WriteRuleMap(delta_it->second, stream))
-          return ReportError();
-
-        stream << endl;
+        writer->Write("STACK CFI ");
+        writer->WriteHex(delta_it->first - load_address_);
+        writer->Write(' ');
+        WriteRuleMap(delta_it->second, writer);
+        writer->Write('\n');
       }
+      if (!writer->good())
+        return ReportError();
     }
   }
 
+  if (!writer->Flush())
+    return ReportError();
+
   return true;
 }
 
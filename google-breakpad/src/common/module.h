@@ -48,6 +48,8 @@
 
 namespace google_breakpad {
 
+class RecordWriter;
+
 using std::set;
 using std::string;
 using std::vector;
@@ -188,6 +190,9 @@ class Module {
   // Write is used.
   void SetLoadAddress(Address load_address);
 
+  // Return the load address given to SetLoadAddress, or zero.
+  Address load_address() const { return load_address_; }
+
   // Add FUNCTION to the module. FUNCTION's name must not be empty.
   // This module owns all Function objects added with this function:
   // destroying the module destroys them as well.
@@ -267,15 +272,19 @@ class Module {
   // established by SetLoadAddress.
   bool Write(std::ostream &stream, bool cfi);
 
+  // As above, but format the records into WRITER, which may write to a
+  // file descriptor or a string without going through a stream at all.
+  // The output is the same. WRITER is flushed before this returns.
+  bool Write(RecordWriter *writer, bool cfi);
+
  private:
   // Report an error that has occurred writing the symbol file, using
   // errno to find the appropriate cause.  Return false.
   static bool ReportError();
 
-  // Write RULE_MAP to STREAM, in the form appropriate for 'STACK CFI'
-  // records, without a final newline. Return true if all goes well;
-  // if an error occurs, return false, and leave errno set.
-  static bool WriteRuleMap(const RuleMap &rule_map, std::ostream &stream);
+  // Write RULE_MAP to WRITER, in the form appropriate for 'STACK CFI'
+  // records, without a final newline.
+  static void WriteRuleMap(const RuleMap &rule_map, RecordWriter *writer);
 
   // Module header entries.
   string name_, os_, architecture_, id_;
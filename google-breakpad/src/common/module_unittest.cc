@@ -42,8 +42,10 @@
 
 #include "breakpad_googletest_includes.h"
 #include "common/module.h"
+#include "common/record_writer.h"
 
 using google_breakpad::Module;
+using google_breakpad::RecordWriter;
 using std::string;
 using std::stringstream;
 using std::vector;
@@ -255,6 +257,53 @@ TEST(Write, NoCFI) {
                contents.c_str());
 }
 
+TEST(Write, RecordWriter) {
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+
+  Module::File *file = m.FindFile("filename.cc");
+  Module::Function *function = new(Module::Function);
+  function->name = "function_name";
+  function->address = 0x6ef14bc34df4d1ccLL;
+  function->size = 0x10;
+  function->parameter_size = 0;
+  Module::Line line = { 0x6ef14bc34df4d1ccLL, 0x10, file, 0x7fffffff };
+  function->lines.push_back(line);
+  m.AddFunction(function);
+
+  Module::Extern *ext = new Module::Extern;
+  ext->address = 0x6ef14bc34df4d1ccLL;
+  ext->name = "extern_name";
+  m.AddExtern(ext);
+
+  Module::StackFrameEntry *entry = new Module::StackFrameEntry();
+  entry->address = 0x6ef14bc34df4d1ccLL;
+  entry->size = 0x10;
+  entry->initial_rules[".cfa"] = "$esp 4 +";
+  entry->rule_changes[0x6ef14bc34df4d1cdLL][".cfa"] = "$esp 8 +";
+  m.AddStackFrameEntry(entry);
+
+  m.SetLoadAddress(0x6ef14bc34df40000LL);
+
+  string contents;
+  {
+    RecordWriter writer(&contents);
+    ASSERT_TRUE(m.Write(&writer, true));
+  }
+  EXPECT_STREQ("MODULE os-name architecture id-string name with spaces\n"
+               "FILE 0 filename.cc\n"
+               "FUNC d1cc 10 0 function_name\n"
+               "d1cc 10 2147483647 0\n"
+               "PUBLIC d1cc 0 extern_name\n"
+               "STACK CFI INIT d1cc 10 .cfa: $esp 4 +\n"
+               "STACK CFI d1cd .cfa: $esp 8 +\n",
+               contents.c_str());
+
+  // Writing through a stream produces the same text.
+  stringstream s;
+  ASSERT_TRUE(m.Write(s, true));
+  EXPECT_EQ(contents, s.str());
+}
+
 TEST(Construct, AddFunctions) {
   stringstream s;
   Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
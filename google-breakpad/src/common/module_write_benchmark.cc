@@ -0,0 +1,290 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// module_write_benchmark.cc: Measures how quickly Module::Write produces
+// a symbol file, compared with formatting the same records through an
+// ostream with hex and dec manipulators and std::endl, as Module::Write
+// used to.
+//
+// The benchmark builds a module shaped like a large library's: functions
+// with a dozen lines each, a public symbol for every tenth function, and
+// a STACK CFI INIT record with a few deltas for every function. It then
+// writes the module to a temporary file with the old formatting, with
+// Module::Write on an ofstream, and with Module::Write on a RecordWriter
+// for the file's descriptor, and finally into a string in memory. It
+// checks that every method produces the same bytes, and reports the time
+// each took.
+//
+// Usage: module_write_benchmark [function-count]
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/module.h"
+#include "common/record_writer.h"
+
+namespace {
+
+using google_breakpad::Module;
+using google_breakpad::RecordWriter;
+using std::endl;
+using std::string;
+using std::vector;
+
+const int kDefaultFunctionCount = 200000;
+const int kLinesPerFunction = 12;
+const int kFileCount = 500;
+const int kPublicSymbolInterval = 10;
+
+double Now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+void Populate(Module *module, int function_count) {
+  module->SetLoadAddress(0x400000);
+  vector<Module::File *> files;
+  for (int i = 0; i < kFileCount; ++i) {
+    char name[100];
+    snprintf(name, sizeof(name), "/build/src/component%d/source%d.cc",
+             i % 37, i);
+    files.push_back(module->FindFile(name));
+  }
+
+  Module::Address address = 0x401000;
+  for (int i = 0; i < function_count; ++i) {
+    Module::Function *function = new Module::Function;
+    char name[100];
+    snprintf(name, sizeof(name), "namespace%d::Class%d::Method%d(int, char*)",
+             i % 53, i % 1009, i);
+    function->name = name;
+    function->address = address;
+    function->parameter_size = 0;
+    Module::File *file = files[i % kFileCount];
+    for (int j = 0; j < kLinesPerFunction; ++j) {
+      Module::Address size = 3 + (i + j) % 29;
+      Module::Line line = { address, size, file, 10 + i % 4000 + j };
+      function->lines.push_back(line);
+      address += line.size;
+    }
+    function->size = address - function->address;
+    module->AddFunction(function);
+
+    if (i % kPublicSymbolInterval == 0) {
+      Module::Extern *ext = new Module::Extern;
+      ext->address = function->address;
+      ext->name = function->name;
+      module->AddExtern(ext);
+    }
+
+    Module::StackFrameEntry *entry = new Module::StackFrameEntry;
+    entry->address = function->address;
+    entry->size = function->size;
+    entry->initial_rules[".cfa"] = "$rsp 8 +";
+    entry->initial_rules[".ra"] = ".cfa -8 + ^";
+    entry->rule_changes[function->address + 1][".cfa"] = "$rsp 16 +";
+    entry->rule_changes[function->address + 1]["$rbp"] = ".cfa -16 + ^";
+    entry->rule_changes[function->address + 4][".cfa"] = "$rbp 16 +";
+    module->AddStackFrameEntry(entry);
+  }
+}
+
+// The formatting Module::Write used before it used RecordWriter.
+void WriteRuleMapWithStream(const Module::RuleMap &rule_map,
+                            std::ostream &stream) {
+  for (Module::RuleMap::const_iterator it = rule_map.begin();
+       it != rule_map.end(); ++it) {
+    if (it != rule_map.begin())
+      stream << ' ';
+    stream << it->first << ": " << it->second;
+  }
+}
+
+void WriteWithStream(Module *module, const string &header,
+                     std::ostream &stream) {
+  stream << header << endl;
+  module->AssignSourceIds();
+  Module::Address load_address = module->load_address();
+
+  vector<Module::File *> files;
+  module->GetFiles(&files);
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (files[i]->source_id >= 0)
+      stream << "FILE " << files[i]->source_id << " " << files[i]->name
+             << endl;
+  }
+
+  vector<Module::Function *> functions;
+  module->GetFunctions(&functions, functions.end());
+  for (size_t i = 0; i < functions.size(); ++i) {
+    Module::Function *func = functions[i];
+    stream << "FUNC " << std::hex
+           << (func->address - load_address) << " "
+           << func->size << " "
+           << func->parameter_size << " "
+           << func->name << std::dec << endl;
+    for (vector<Module::Line>::iterator line = func->lines.begin();
+         line != func->lines.end(); ++line) {
+      stream << std::hex
+             << (line->address - load_address) << " "
+             << line->size << " "
+             << std::dec
+             << line->number << " "
+             << line->file->source_id << endl;
+    }
+  }
+
+  vector<Module::Extern *> externs;
+  module->GetExterns(&externs, externs.end());
+  for (size_t i = 0; i < externs.size(); ++i) {
+    stream << "PUBLIC " << std::hex
+           << (externs[i]->address - load_address) << " 0 "
+           << externs[i]->name << std::dec << endl;
+  }
+
+  vector<Module::StackFrameEntry *> entries;
+  module->GetStackFrameEntries(&entries);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    Module::StackFrameEntry *entry = entries[i];
+    stream << "STACK CFI INIT " << std::hex
+           << (entry->address - load_address) << " "
+           << entry->size << " " << std::dec;
+    WriteRuleMapWithStream(entry->initial_rules, stream);
+    stream << endl;
+    for (Module::RuleChangeMap::const_iterator delta =
+             entry->rule_changes.begin();
+         delta != entry->rule_changes.end(); ++delta) {
+      stream << "STACK CFI " << std::hex
+             << (delta->first - load_address) << " " << std::dec;
+      WriteRuleMapWithStream(delta->second, stream);
+      stream << endl;
+    }
+  }
+}
+
+string ReadFile(const char *path) {
+  std::ifstream stream(path, std::ios::in | std::ios::binary);
+  std::ostringstream contents;
+  contents << stream.rdbuf();
+  return contents.str();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int function_count = kDefaultFunctionCount;
+  if (argc > 1)
+    function_count = atoi(argv[1]);
+  if (function_count <= 0) {
+    fprintf(stderr, "usage: %s [function-count]\n", argv[0]);
+    return 1;
+  }
+
+  Module module("libbenchmark.so", "Linux", "x86_64",
+                "000102030405060708090A0B0C0D0E0F0");
+  double start = Now();
+  Populate(&module, function_count);
+  printf("built %d functions, %d lines in %.3f s\n", function_count,
+         function_count * kLinesPerFunction, Now() - start);
+
+  char path[] = "/tmp/module_write_benchmark.XXXXXX";
+  int fd = mkstemp(path);
+  if (fd == -1) {
+    perror("mkstemp");
+    return 1;
+  }
+
+  // The old formatting, to an ofstream.
+  start = Now();
+  {
+    std::ofstream stream(path, std::ios::out | std::ios::trunc);
+    WriteWithStream(&module, "MODULE Linux x86_64 "
+                    "000102030405060708090A0B0C0D0E0F0 libbenchmark.so",
+                    stream);
+  }
+  double stream_time = Now() - start;
+  string expected = ReadFile(path);
+
+  // Module::Write to an ofstream.
+  start = Now();
+  bool ofstream_ok;
+  {
+    std::ofstream stream(path, std::ios::out | std::ios::trunc);
+    ofstream_ok = module.Write(stream, true);
+  }
+  double ofstream_time = Now() - start;
+  bool ofstream_same = ofstream_ok && ReadFile(path) == expected;
+
+  // Module::Write to the file descriptor.
+  if (ftruncate(fd, 0) == -1 || lseek(fd, 0, SEEK_SET) == -1) {
+    perror(path);
+    return 1;
+  }
+  start = Now();
+  bool fd_ok;
+  {
+    RecordWriter writer(fd);
+    fd_ok = module.Write(&writer, true);
+  }
+  double fd_time = Now() - start;
+  bool fd_same = fd_ok && ReadFile(path) == expected;
+
+  // Module::Write to memory.
+  string contents;
+  start = Now();
+  bool string_ok;
+  {
+    RecordWriter writer(&contents);
+    string_ok = module.Write(&writer, true);
+  }
+  double string_time = Now() - start;
+  bool string_same = string_ok && contents == expected;
+
+  close(fd);
+  unlink(path);
+
+  printf("wrote %lu bytes\n", static_cast<unsigned long>(expected.size()));
+  printf("ostream with endl:         %.3f s\n", stream_time);
+  printf("Module::Write to ofstream: %.3f s (%.1fx)%s\n", ofstream_time,
+         stream_time / ofstream_time, ofstream_same ? "" : " MISMATCH");
+  printf("Module::Write to fd:       %.3f s (%.1fx)%s\n", fd_time,
+         stream_time / fd_time, fd_same ? "" : " MISMATCH");
+  printf("Module::Write to string:   %.3f s (%.1fx)%s\n", string_time,
+         stream_time / string_time, string_same ? "" : " MISMATCH");
+  return ofstream_same && fd_same && string_same ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// record_writer.cc: Implement google_breakpad::RecordWriter.  See
+// record_writer.h.
+
+#include "common/record_writer.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace google_breakpad {
+
+RecordWriter::RecordWriter(int fd)
+    : fd_(fd), string_(NULL), stream_(NULL), buffer_(kBufferSize), used_(0),
+      good_(true) { }
+
+RecordWriter::RecordWriter(string *buffer)
+    : fd_(-1), string_(buffer), stream_(NULL), buffer_(kBufferSize),
+      used_(0), good_(true) { }
+
+RecordWriter::RecordWriter(std::ostream *stream)
+    : fd_(-1), string_(NULL), stream_(stream), buffer_(kBufferSize),
+      used_(0), good_(true) { }
+
+RecordWriter::~RecordWriter() {
+  Drain();
+}
+
+void RecordWriter::Write(const char *data, size_t size) {
+  while (size > 0) {
+    if (used_ == buffer_.size())
+      Drain();
+    size_t chunk = buffer_.size() - used_;
+    if (chunk > size)
+      chunk = size;
+    memcpy(&buffer_[used_], data, chunk);
+    used_ += chunk;
+    data += chunk;
+    size -= chunk;
+  }
+}
+
+void RecordWriter::WriteHex(u_int64_t value) {
+  static const char kDigits[] = "0123456789abcdef";
+  char digits[16];
+  char *start = digits + sizeof(digits);
+  do {
+    *--start = kDigits[value & 0xf];
+    value >>= 4;
+  } while (value);
+  Write(start, digits + sizeof(digits) - start);
+}
+
+void RecordWriter::WriteDecimal(int64_t value) {
+  // Twenty digits and a sign cover every int64_t.
+  char digits[21];
+  char *start = digits + sizeof(digits);
+  // Negate as unsigned, so that the most negative value works too.
+  u_int64_t magnitude = value < 0 ? 0 - static_cast<u_int64_t>(value)
+                                  : static_cast<u_int64_t>(value);
+  do {
+    *--start = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude);
+  if (value < 0)
+    *--start = '-';
+  Write(start, digits + sizeof(digits) - start);
+}
+
+bool RecordWriter::Flush() {
+  Drain();
+  if (good_ && stream_) {
+    stream_->flush();
+    good_ = stream_->good();
+  }
+  return good_;
+}
+
+void RecordWriter::Drain() {
+  if (used_ == 0)
+    return;
+  if (good_) {
+    if (string_) {
+      string_->append(&buffer_[0], used_);
+    } else if (stream_) {
+      stream_->write(&buffer_[0], used_);
+      good_ = stream_->good();
+    } else {
+      const char *data = &buffer_[0];
+      size_t remaining = used_;
+      while (remaining > 0) {
+        ssize_t written = write(fd_, data, remaining);
+        if (written < 0) {
+          if (errno == EINTR)
+            continue;
+          good_ = false;
+          break;
+        }
+        data += written;
+        remaining -= written;
+      }
+    }
+  }
+  // Once an error has occurred, discard everything else, as an ostream
+  // would.
+  used_ = 0;
+}
+
+}  // namespace google_breakpad
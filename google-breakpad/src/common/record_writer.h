@@ -0,0 +1,116 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// record_writer.h: Define google_breakpad::RecordWriter, which formats
+// symbol file records into a large buffer and writes the buffer out to a
+// file descriptor, a string, or a stream only when it fills.
+//
+// Symbol files for large modules have millions of records, nearly all of
+// them a few hex numbers and a name. Formatting those through an ostream,
+// switching between hex and dec for each field and flushing after each
+// line, spends most of its time in the stream machinery and in write
+// calls. RecordWriter formats numbers itself and leaves flushing to the
+// caller.
+
+#ifndef COMMON_RECORD_WRITER_H__
+#define COMMON_RECORD_WRITER_H__
+
+#include <stddef.h>
+#include <string.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "google_breakpad/common/breakpad_types.h"
+
+namespace google_breakpad {
+
+using std::string;
+
+class RecordWriter {
+ public:
+  // Write to the file descriptor FD, which the writer does not own.
+  explicit RecordWriter(int fd);
+
+  // Append to *BUFFER.
+  explicit RecordWriter(string *buffer);
+
+  // Write to *STREAM.
+  explicit RecordWriter(std::ostream *stream);
+
+  // Flush any buffered data. Errors are ignored here; call Flush
+  // first to find out whether everything was written.
+  ~RecordWriter();
+
+  // Append text to the buffer.
+  void Write(const string &text) { Write(text.data(), text.size()); }
+  void Write(const char *text) { Write(text, strlen(text)); }
+  void Write(char c) {
+    if (used_ == buffer_.size())
+      Drain();
+    buffer_[used_++] = c;
+  }
+  void Write(const char *data, size_t size);
+
+  // Append VALUE as lower-case hexadecimal digits, without a prefix.
+  void WriteHex(u_int64_t value);
+
+  // Append VALUE in decimal.
+  void WriteDecimal(int64_t value);
+
+  // Write out everything buffered so far. Return true if all data has
+  // been written successfully; if an error has occurred, now or at an
+  // earlier point when the buffer filled, return false, leaving errno set
+  // for write errors on file descriptors.
+  bool Flush();
+
+  // Return false if an error has occurred writing out the buffer.
+  bool good() const { return good_; }
+
+ private:
+  // How much the writer buffers before writing to its destination.
+  static const size_t kBufferSize = 1 << 16;
+
+  // Write out the buffer's contents and empty it, noting any error.
+  void Drain();
+
+  // Exactly one of these is the destination.
+  int fd_;
+  string *string_;
+  std::ostream *stream_;
+
+  std::vector<char> buffer_;
+  size_t used_;
+  bool good_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // COMMON_RECORD_WRITER_H__
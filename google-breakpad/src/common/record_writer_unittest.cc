@@ -0,0 +1,139 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// record_writer_unittest.cc: Unit tests for google_breakpad::RecordWriter.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <sstream>
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/record_writer.h"
+
+using google_breakpad::RecordWriter;
+using std::string;
+using std::stringstream;
+
+TEST(RecordWriter, Hex) {
+  string output;
+  RecordWriter writer(&output);
+  writer.WriteHex(0);
+  writer.Write(' ');
+  writer.WriteHex(0xa);
+  writer.Write(' ');
+  writer.WriteHex(0x1234abcd);
+  writer.Write(' ');
+  writer.WriteHex(0xffffffffffffffffULL);
+  ASSERT_TRUE(writer.Flush());
+  EXPECT_EQ("0 a 1234abcd ffffffffffffffff", output);
+}
+
+TEST(RecordWriter, Decimal) {
+  string output;
+  RecordWriter writer(&output);
+  writer.WriteDecimal(0);
+  writer.Write(' ');
+  writer.WriteDecimal(-1);
+  writer.Write(' ');
+  writer.WriteDecimal(1234567890);
+  writer.Write(' ');
+  writer.WriteDecimal(0x7fffffffffffffffLL);
+  writer.Write(' ');
+  writer.WriteDecimal(-0x7fffffffffffffffLL - 1);
+  ASSERT_TRUE(writer.Flush());
+  EXPECT_EQ("0 -1 1234567890 9223372036854775807 -9223372036854775808",
+            output);
+}
+
+// Text much larger than the buffer, written in pieces of every size,
+// arrives intact.
+TEST(RecordWriter, LargerThanBuffer) {
+  string expected;
+  string output;
+  {
+    RecordWriter writer(&output);
+    for (int i = 0; i < 20000; i++) {
+      string piece(i % 37, 'a' + i % 26);
+      writer.Write(piece);
+      writer.WriteHex(i);
+      writer.Write('\n');
+      stringstream formatted;
+      formatted << piece << std::hex << i << '\n';
+      expected += formatted.str();
+    }
+  }
+  EXPECT_EQ(expected, output);
+}
+
+TEST(RecordWriter, Stream) {
+  stringstream stream;
+  RecordWriter writer(&stream);
+  writer.Write("FUNC ");
+  writer.WriteHex(0x1000);
+  writer.Write('\n');
+  EXPECT_EQ("", stream.str());
+  ASSERT_TRUE(writer.Flush());
+  EXPECT_EQ("FUNC 1000\n", stream.str());
+}
+
+TEST(RecordWriter, FileDescriptor) {
+  FILE *file = tmpfile();
+  ASSERT_TRUE(file != NULL);
+  int fd = fileno(file);
+  {
+    RecordWriter writer(fd);
+    writer.Write("PUBLIC ");
+    writer.WriteHex(0xbeef);
+    writer.Write(" 0 name\n");
+    ASSERT_TRUE(writer.Flush());
+  }
+  ASSERT_EQ(0, lseek(fd, 0, SEEK_SET));
+  char buffer[100];
+  ssize_t size = read(fd, buffer, sizeof(buffer));
+  ASSERT_EQ(19, size);
+  EXPECT_EQ("PUBLIC beef 0 name\n", string(buffer, size));
+  fclose(file);
+}
+
+TEST(RecordWriter, FileDescriptorError) {
+  // A descriptor open only for reading can't be written to.
+  int fd = open("/dev/null", O_RDONLY);
+  ASSERT_NE(-1, fd);
+  RecordWriter writer(fd);
+  writer.Write("text");
+  EXPECT_TRUE(writer.good());
+  EXPECT_FALSE(writer.Flush());
+  EXPECT_EQ(EBADF, errno);
+  EXPECT_FALSE(writer.good());
+  close(fd);
+}
@@ -50,18 +50,45 @@ using std::map;
 class BasicSourceLineResolver : public SourceLineResolverBase {
  public:
   BasicSourceLineResolver();
+
+  // If parse_lazily is true, loading a symbol file only indexes it: each
+  // function's line records and each STACK CFI block are left as text, and
+  // parsed when a lookup first needs them.  (STACK CFI records that are out
+  // of order, or separated from their INIT record, are parsed at load time
+  // instead.)  This makes loading large symbol files much faster and their
+  // modules much smaller, in exchange for slower first lookups in each
+  // function.  The text must then stay available, so the resolver keeps
+  // the buffers it loads from, and ShouldDeleteMemoryBufferAfterLoadModule
+  // returns false.  ModuleSerializer cannot serialize lazily parsed
+  // modules.
+  explicit BasicSourceLineResolver(bool parse_lazily);
+
   virtual ~BasicSourceLineResolver() { }
 
   using SourceLineResolverBase::LoadModule;
   using SourceLineResolverBase::LoadModuleUsingMapBuffer;
   using SourceLineResolverBase::LoadModuleUsingMemoryBuffer;
-  using SourceLineResolverBase::ShouldDeleteMemoryBufferAfterLoadModule;
+  virtual bool ShouldDeleteMemoryBufferAfterLoadModule();
   using SourceLineResolverBase::UnloadModule;
   using SourceLineResolverBase::HasModule;
   using SourceLineResolverBase::FillSourceLineInfo;
   using SourceLineResolverBase::FindWindowsFrameInfo;
   using SourceLineResolverBase::FindCFIFrameInfo;
 
+  // Loads a symbol file that arrives in pieces, such as from a pipe, a
+  // decompression stream, or a network fetch, parsing each record as soon
+  // as it is complete rather than first collecting the whole file in one
+  // buffer.  If the resolver parses lazily, the module collects the pieces
+  // instead, since its index refers to the text, and indexes them when the
+  // load finishes.  Returns NULL if symbols for module are already loaded.
+  // Otherwise, the caller owns the returned ModuleLoader, and passes each
+  // piece of the symbol file to its Append method in turn, then calls
+  // Finish to make the module available.  Until then, lookups in the module
+  // and other attempts to load it wait, so the thread driving the load must
+  // not perform them itself.
+  class ModuleLoader;
+  ModuleLoader *StartModuleLoad(const CodeModule *module);
+
  private:
   // friend declarations:
   friend class BasicModuleFactory;
@@ -74,11 +101,51 @@ class BasicSourceLineResolver : public SourceLineResolverBase {
   // Module implements SourceLineResolverBase::Module interface.
   class Module;
 
+  // True if modules are indexed when loaded and parsed on demand.
+  bool parse_lazily_;
+
   // Disallow unwanted copy ctor and assignment operator
   BasicSourceLineResolver(const BasicSourceLineResolver&);
   void operator=(const BasicSourceLineResolver&);
 };
 
+class BasicSourceLineResolver::ModuleLoader {
+ public:
+  // Abandons the load, leaving the module unloaded, unless Finish has
+  // already been called.
+  ~ModuleLoader();
+
+  // Parses the next size bytes of the symbol file.  data need not end on a
+  // record boundary.  Returns false if the symbol file is malformed, in
+  // which case the load is abandoned and further calls fail.
+  bool Append(const char *data, size_t size);
+
+  // Parses the end of the symbol file and makes the module available for
+  // lookups.  Returns false if the symbol file is malformed or the load was
+  // already abandoned.
+  bool Finish();
+
+ private:
+  friend class BasicSourceLineResolver;
+
+  ModuleLoader(BasicSourceLineResolver *resolver, const string &code_file,
+               const string &debug_identifier, Module *module);
+
+  // Hands module_, or NULL if the load failed, back to resolver_.
+  void End(bool succeeded);
+
+  BasicSourceLineResolver *resolver_;
+  string code_file_;
+  string debug_identifier_;
+
+  // The module being loaded, or NULL once the load has ended.
+  Module *module_;
+
+  // Disallow unwanted copy ctor and assignment operator
+  ModuleLoader(const ModuleLoader&);
+  void operator=(const ModuleLoader&);
+};
+
 }  // namespace google_breakpad
 
 #endif  // GOOGLE_BREAKPAD_PROCESSOR_BASIC_SOURCE_LINE_RESOLVER_H__
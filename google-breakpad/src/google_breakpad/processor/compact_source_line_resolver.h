@@ -0,0 +1,85 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// compact_source_line_resolver.h: CompactSourceLineResolver is derived from
+// SourceLineResolverBase, and is a concrete implementation of
+// SourceLineResolverInterface.
+//
+// CompactSourceLineResolver is a sibling class of BasicSourceLineResolver.
+// It reads the same text symbol files, but stores each module's records in
+// flat, sorted arrays carved out of a per-module arena, with every name and
+// CFI rule string interned in one pool, instead of in std::maps of
+// individually allocated, reference-counted records.  A loaded module takes
+// a fraction of the memory a BasicSourceLineResolver module does, and
+// unloading it frees a few large blocks rather than one allocation per
+// record, so a process can keep many more modules resident.
+//
+// See "source_line_resolver_base.h" and
+// "google_breakpad/source_line_resolver_interface.h" for more reference.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_COMPACT_SOURCE_LINE_RESOLVER_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_COMPACT_SOURCE_LINE_RESOLVER_H__
+
+#include "google_breakpad/processor/source_line_resolver_base.h"
+
+namespace google_breakpad {
+
+class CompactSourceLineResolver : public SourceLineResolverBase {
+ public:
+  CompactSourceLineResolver();
+  virtual ~CompactSourceLineResolver() { }
+
+  using SourceLineResolverBase::FillSourceLineInfo;
+  using SourceLineResolverBase::FindCFIFrameInfo;
+  using SourceLineResolverBase::FindWindowsFrameInfo;
+  using SourceLineResolverBase::HasModule;
+  using SourceLineResolverBase::LoadModule;
+  using SourceLineResolverBase::LoadModuleUsingMapBuffer;
+  using SourceLineResolverBase::LoadModuleUsingMemoryBuffer;
+  using SourceLineResolverBase::UnloadModule;
+
+  // Modules copy what they keep of the symbol file, so the buffer can be
+  // freed as soon as it has been loaded.
+  virtual bool ShouldDeleteMemoryBufferAfterLoadModule();
+
+ private:
+  // Friend declarations.
+  friend class CompactModuleFactory;
+
+  // Module implements SourceLineResolverBase::Module interface.
+  class Module;
+
+  // Disallow unwanted copy ctor and assignment operator
+  CompactSourceLineResolver(const CompactSourceLineResolver&);
+  void operator=(const CompactSourceLineResolver&);
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_COMPACT_SOURCE_LINE_RESOLVER_H__
@@ -243,7 +243,8 @@ class MinidumpMemoryRegion : public MinidumpObject,
 
   // Returns a pointer to the base of the memory region.  Returns the
   // cached value if available, otherwise, reads the minidump file and
-  // caches the memory region.
+  // caches the memory region.  If the minidump is mapped, this points into
+  // the mapping, and nothing is copied.
   const u_int8_t* GetMemory() const;
 
   // The address of the base of the memory region.
@@ -279,15 +280,19 @@ class MinidumpMemoryRegion : public MinidumpObject,
                                                        T*        value) const;
 
   // The largest memory region that will be read from a minidump.  The
-  // default is 1MB.
+  // default is 1MB.  Mapped minidumps' regions are not copied, and so are
+  // not limited.
   static u_int32_t max_bytes_;
 
   // Base address and size of the memory region, and its position in the
   // minidump file.
   MDMemoryDescriptor* descriptor_;
 
-  // Cached memory.
+  // Cached memory, when copied out of the minidump.
   mutable vector<u_int8_t>* memory_;
+
+  // The memory region within a mapped minidump.
+  mutable const u_int8_t* mapped_memory_;
 };
 
 
@@ -453,6 +458,12 @@ class MinidumpModule : public MinidumpObject,
   // allow the CodeModule getters to be const methods.
   bool ReadAuxiliaryData();
 
+  // Reads the size-byte record at the minidump's current position, for
+  // GetCVRecord and GetMiscRecord.  Returns a pointer to the record, or NULL
+  // on failure.  If the record had to be copied, sets *copy to the copy,
+  // which the caller owns.
+  const u_int8_t* ReadRecord(u_int32_t size, vector<u_int8_t>** copy);
+
   // The largest number of bytes that will be read from a minidump for a
   // CodeView record or miscellaneous debugging record, respectively.  The
   // default for each is 1024.
@@ -479,18 +490,24 @@ class MinidumpModule : public MinidumpObject,
   // Cached CodeView record - this is MDCVInfoPDB20 or (likely)
   // MDCVInfoPDB70, or possibly something else entirely.  Stored as a u_int8_t
   // because the structure contains a variable-sized string and its exact
-  // size cannot be known until it is processed.
+  // size cannot be known until it is processed.  cv_record_data_ points to
+  // the record, which is either in cv_record_, or, if it can be used
+  // without byte-swapping, in the mapping of a mapped minidump.
   vector<u_int8_t>* cv_record_;
+  const u_int8_t*   cv_record_data_;
 
-  // If cv_record_ is present, cv_record_signature_ contains a copy of the
-  // CodeView record's first four bytes, for ease of determinining the
-  // type of structure that cv_record_ contains.
+  // If cv_record_data_ is present, cv_record_signature_ contains a copy of
+  // the CodeView record's first four bytes, for ease of determinining the
+  // type of structure that cv_record_data_ contains.
   u_int32_t cv_record_signature_;
 
   // Cached MDImageDebugMisc (usually not present), stored as u_int8_t
   // because the structure contains a variable-sized string and its exact
-  // size cannot be known until it is processed.
+  // size cannot be known until it is processed.  As with the CodeView
+  // record, misc_record_data_ points to the record, which is in
+  // misc_record_ or in the mapping of a mapped minidump.
   vector<u_int8_t>* misc_record_;
+  const u_int8_t*   misc_record_data_;
 };
 
 
@@ -569,7 +586,8 @@ class MinidumpMemoryList : public MinidumpStream {
   MinidumpMemoryRegion* GetMemoryRegionAtIndex(unsigned int index);
 
   // Random access to memory regions.  Returns the region encompassing
-  // the address identified by address.
+  // the address identified by address.  Regions are indexed once Read,
+  // so this is a binary search.
   MinidumpMemoryRegion* GetMemoryRegionForAddress(u_int64_t address);
 
   // Print a human-readable representation of the object to stdout.
@@ -577,6 +595,7 @@ class MinidumpMemoryList : public MinidumpStream {
 
  private:
   friend class Minidump;
+  friend class MinidumpProcessMemory;
 
   typedef vector<MDMemoryDescriptor>   MemoryDescriptors;
   typedef vector<MinidumpMemoryRegion> MemoryRegions;
@@ -591,7 +610,8 @@ class MinidumpMemoryList : public MinidumpStream {
   // The default is 256.
   static u_int32_t max_regions_;
 
-  // Access to memory regions using addresses as the key.
+  // Access to memory regions using addresses as the key.  Frozen once the
+  // list has been read.
   RangeMap<u_int64_t, unsigned int> *range_map_;
 
   // The list of descriptors.  This is maintained separately from the list
@@ -606,6 +626,44 @@ class MinidumpMemoryList : public MinidumpStream {
 };
 
 
+// MinidumpProcessMemory presents every region in a MinidumpMemoryList as a
+// single MemoryRegion, so that any address in the dumped process's memory
+// can be probed, as stackwalkers and exploitability checks may need to.
+// Each read is served by the region holding its address, and a read that
+// runs off the end of one region continues into the next if the two are
+// adjacent.  The memory list must outlive this object.
+class MinidumpProcessMemory : public MemoryRegion {
+ public:
+  explicit MinidumpProcessMemory(MinidumpMemoryList* memory_list);
+  virtual ~MinidumpProcessMemory() {}
+
+  // The lowest address in any region, and the distance from there to the
+  // end of the highest region, capped at the largest u_int32_t.  Addresses
+  // in the gaps between regions lie within these bounds, but can't be read.
+  virtual u_int64_t GetBase() const { return base_; }
+  virtual u_int32_t GetSize() const { return size_; }
+
+  virtual bool GetMemoryAtAddress(u_int64_t address, u_int8_t*  value) const;
+  virtual bool GetMemoryAtAddress(u_int64_t address, u_int16_t* value) const;
+  virtual bool GetMemoryAtAddress(u_int64_t address, u_int32_t* value) const;
+  virtual bool GetMemoryAtAddress(u_int64_t address, u_int64_t* value) const;
+
+  // Copies up to size bytes starting at address into buffer, continuing
+  // through adjacent regions, and returns the number of bytes copied.
+  // Returns 0 if no region holds address.  The bytes are not byte-swapped.
+  size_t GetBytesAtAddress(u_int64_t address, u_int8_t* buffer,
+                           size_t size) const;
+
+ private:
+  template<typename T> bool GetMemoryAtAddressInternal(u_int64_t address,
+                                                       T*        value) const;
+
+  MinidumpMemoryList* memory_list_;
+  u_int64_t base_;
+  u_int32_t size_;
+};
+
+
 // MinidumpException wraps MDRawExceptionStream, which contains information
 // about the exception that caused the minidump to be generated, if the
 // minidump was generated in an exception handler called as a result of
@@ -857,7 +915,8 @@ class MinidumpMemoryInfoList : public MinidumpStream {
 
   bool Read(u_int32_t expected_size);
 
-  // Access to memory info using addresses as the key.
+  // Access to memory info using addresses as the key.  Frozen once the
+  // list has been read.
   RangeMap<u_int64_t, unsigned int> *range_map_;
 
   MinidumpMemoryInfos* infos_;
@@ -871,6 +930,12 @@ class Minidump {
  public:
   // path is the pathname of a file containing the minidump.
   explicit Minidump(const string& path);
+  // As above, but if map_file is true, the file is mapped into memory
+  // instead of being read through a stream.  ReadBytes then copies out of
+  // the mapping, and memory regions, CodeView records and miscellaneous
+  // debugging records refer to it in place.  Where mapping is
+  // unavailable, this reads the file through a stream, as above.
+  Minidump(const string& path, bool map_file);
   // input is an istream wrapping minidump data. Minidump holds a
   // weak pointer to input, and the caller must ensure that the stream
   // is valid as long as the Minidump object is.
@@ -924,13 +989,21 @@ class Minidump {
   }
   const MDRawDirectory* GetDirectoryEntryAtIndex(unsigned int index) const;
 
-  // The next 2 methods are lower-level I/O routines.  They use fd_.
+  // The next 4 methods are lower-level I/O routines.  They use stream_,
+  // or the mapping of a mapped minidump.
 
   // Reads count bytes from the minidump at the current position into
   // the storage area pointed to by bytes.  bytes must be of sufficient
   // size.  After the read, the file position is advanced by count.
   bool ReadBytes(void* bytes, size_t count);
 
+  // For a mapped minidump, returns a pointer to the count bytes at the
+  // current position, and advances the position by count.  Returns NULL
+  // if the minidump is not mapped or the bytes run past its end.  The
+  // bytes are neither copied nor byte-swapped, may not be aligned, and
+  // remain valid as long as the Minidump does.
+  const u_int8_t* ReadBytesInPlace(size_t count);
+
   // Sets the position of the minidump file to offset.
   bool SeekSet(off_t offset);
 
@@ -960,6 +1033,9 @@ class Minidump {
 
   bool swap() const { return valid_ ? swap_ : false; }
 
+  // True if the minidump is mapped into memory.
+  bool mapped() const { return mapped_data_ != NULL; }
+
   // Print a human-readable representation of the object to stdout.
   void Print();
 
@@ -986,6 +1062,9 @@ class Minidump {
   // Opens the minidump file, or if already open, seeks to the beginning.
   bool Open();
 
+  // Maps the minidump file into memory, for Open.
+  bool MapFile();
+
   // The largest number of top-level streams that will be read from a minidump.
   // Note that streams are only read (and only consume memory) as needed,
   // when directed by the caller.  The default is 128.
@@ -1011,8 +1090,18 @@ class Minidump {
 
   // The stream for all file I/O.  Used by ReadBytes and SeekSet.
   // Set based on the path in Open, or directly in the constructor.
+  // NULL if the minidump is mapped.
   std::istream*             stream_;
 
+  // True if the file at path_ should be mapped rather than streamed.
+  bool                      map_file_;
+
+  // The mapping of a mapped minidump, its size, and the current position
+  // within it.
+  const u_int8_t*           mapped_data_;
+  size_t                    mapped_size_;
+  off_t                     mapped_position_;
+
   // swap_ is true if the minidump file should be byte-swapped.  If the
   // minidump was produced by a CPU that is other-endian than the CPU
   // processing the minidump, this will be true.  If the two CPUs are
@@ -38,6 +38,7 @@ namespace google_breakpad {
 
 using std::string;
 
+class CallStack;
 class Minidump;
 class ProcessState;
 class SourceLineResolverInterface;
@@ -88,6 +89,25 @@ enum ProcessResult {
                                               // fatal)
 };
 
+// An interface for receiving the stack of a minidump's requesting thread
+// (the one that crashed, or asked for the dump) as soon as it has been
+// walked, before any other thread.  See
+// MinidumpProcessor::set_requesting_thread_handler.
+class RequestingThreadHandler {
+ public:
+  virtual ~RequestingThreadHandler() {}
+
+  // Called with the requesting thread's stack.  process_state has
+  // everything but the threads filled in: the system info, the crash
+  // reason and address, the assertion and the modules.  stack belongs to
+  // the processor, and stays valid until process_state is cleared.
+  // Return true to go on to walk the minidump's other threads, or false
+  // to leave them unwalked: Process then returns a ProcessState holding
+  // only the requesting thread.
+  virtual bool RequestingThreadWalked(const ProcessState &process_state,
+                                      const CallStack &stack) = 0;
+};
+
 class MinidumpProcessor {
  public:
   // Initializes this MinidumpProcessor.  supplier should be an
@@ -104,7 +124,36 @@ class MinidumpProcessor {
 
   ~MinidumpProcessor();
 
+  // Walks the stacks of up to |count| of the minidump's threads at once,
+  // each on its own thread.  The default, 1, walks them one at a time on
+  // the calling thread.  The results are the same either way: threads
+  // appear in the ProcessState in minidump order.  The resolver must be
+  // safe to use from several threads, as SourceLineResolverBase is;
+  // calls to the SymbolSupplier are serialized.
+  void set_walker_thread_count(int count) { walker_thread_count_ = count; }
+  int walker_thread_count() const { return walker_thread_count_; }
+
+  // If collect is true, Process records the wall and CPU time spent in
+  // each phase of processing, and how each stack frame was recovered, in
+  // a ProcessStats available from ProcessState::stats().  See
+  // process_stats.h.  The default is false, which costs nothing.
+  void set_collect_stats(bool collect) { collect_stats_ = collect; }
+  bool collect_stats() const { return collect_stats_; }
+
+  // If handler is not NULL, Process walks the requesting thread's stack
+  // before any other thread's and passes it to handler, which decides
+  // whether the other threads are walked at all.  The threads still
+  // appear in the ProcessState in minidump order.  If the minidump names
+  // no requesting thread, or a thread that it holds none or several of,
+  // or the requesting thread's stack could not be walked completely,
+  // handler is not called and every thread is walked as usual.  The
+  // default, NULL, walks the threads in minidump order.
+  void set_requesting_thread_handler(RequestingThreadHandler *handler) {
+    requesting_thread_handler_ = handler;
+  }
+
   // Processes the minidump file and fills process_state with the result.
+  // The file is mapped into memory while it is processed, where possible.
   ProcessResult Process(const string &minidump_file,
                         ProcessState *process_state);
 
@@ -162,6 +211,16 @@ class MinidumpProcessor {
   // guess how likely it is that the crash represents an exploitable
   // memory corruption issue.
   bool enable_exploitability_;
+
+  // The number of threads to walk stacks on; see set_walker_thread_count.
+  int walker_thread_count_;
+
+  // Whether to fill in ProcessState::stats(); see set_collect_stats.
+  bool collect_stats_;
+
+  // The handler to give the requesting thread's stack to first, or NULL;
+  // see set_requesting_thread_handler.
+  RequestingThreadHandler *requesting_thread_handler_;
 };
 
 }  // namespace google_breakpad
@@ -47,6 +47,7 @@ using std::vector;
 
 class CallStack;
 class CodeModules;
+struct ProcessStats;
 
 enum ExploitabilityRating {
   EXPLOITABILITY_HIGH,                    // The crash likely represents
@@ -86,7 +87,7 @@ enum ExploitabilityRating {
 
 class ProcessState {
  public:
-  ProcessState() : modules_(NULL) { Clear(); }
+  ProcessState() : modules_(NULL), stats_(NULL) { Clear(); }
   ~ProcessState();
 
   // Resets the ProcessState to its default values
@@ -106,6 +107,7 @@ class ProcessState {
   const SystemInfo* system_info() const { return &system_info_; }
   const CodeModules* modules() const { return modules_; }
   ExploitabilityRating exploitability() const { return exploitability_; }
+  const ProcessStats* stats() const { return stats_; }
 
  private:
   // MinidumpProcessor is responsible for building ProcessState objects.
@@ -161,6 +163,10 @@ class ProcessState {
   // engine. When the exploitability engine is not enabled this
   // defaults to EXPLOITABILITY_NONE.
   ExploitabilityRating exploitability_;
+
+  // Where the time went while processing the minidump, or NULL if the
+  // MinidumpProcessor wasn't asked to collect statistics.
+  ProcessStats *stats_;
 };
 
 }  // namespace google_breakpad
@@ -0,0 +1,132 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_stats.h: Where the time went while processing a minidump.
+//
+// MinidumpProcessor fills in a ProcessStats, reachable through
+// ProcessState::stats(), when set_collect_stats(true) has been called.
+// Stackwalker fills in a StackwalkStats for each thread it walks.  Every
+// phase records both the elapsed wall time and the CPU time of the
+// thread that ran it.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_PROCESS_STATS_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_PROCESS_STATS_H__
+
+#include <vector>
+
+#include "google_breakpad/common/breakpad_types.h"
+
+namespace google_breakpad {
+
+using std::vector;
+
+struct ProcessingTime {
+  ProcessingTime() : wall_seconds(0), cpu_seconds(0) {}
+
+  void Add(const ProcessingTime &other) {
+    wall_seconds += other.wall_seconds;
+    cpu_seconds += other.cpu_seconds;
+  }
+
+  double wall_seconds;
+  double cpu_seconds;
+};
+
+struct StackwalkStats {
+  StackwalkStats()
+      : walk(), symbol_fetch(), symbol_parse(),
+        context_frames(0), cfi_frames(0), stack_win_frames(0),
+        frame_pointer_frames(0), cfi_scan_frames(0), scan_frames(0),
+        other_frames(0) {}
+
+  void Add(const StackwalkStats &other) {
+    walk.Add(other.walk);
+    symbol_fetch.Add(other.symbol_fetch);
+    symbol_parse.Add(other.symbol_parse);
+    context_frames += other.context_frames;
+    cfi_frames += other.cfi_frames;
+    stack_win_frames += other.stack_win_frames;
+    frame_pointer_frames += other.frame_pointer_frames;
+    cfi_scan_frames += other.cfi_scan_frames;
+    scan_frames += other.scan_frames;
+    other_frames += other.other_frames;
+  }
+
+  // The whole of Stackwalker::Walk, including the symbol fetching and
+  // parsing below.
+  ProcessingTime walk;
+
+  // Asking the SymbolSupplier for symbol data.
+  ProcessingTime symbol_fetch;
+
+  // Loading the symbol data into the SourceLineResolver.
+  ProcessingTime symbol_parse;
+
+  // The number of frames recovered by each strategy, according to
+  // StackFrame::trust.  STACK WIN records are Windows' form of call frame
+  // information, so frames recovered from them count towards both
+  // stack_win_frames and cfi_frames.  other_frames counts frames whose
+  // trust is FRAME_TRUST_NONE.
+  u_int32_t context_frames;
+  u_int32_t cfi_frames;
+  u_int32_t stack_win_frames;
+  u_int32_t frame_pointer_frames;
+  u_int32_t cfi_scan_frames;
+  u_int32_t scan_frames;
+  u_int32_t other_frames;
+};
+
+struct ProcessStats {
+  ProcessStats() : read(), module_copy(), stackwalk(), all_threads(),
+                   threads() {}
+
+  // Reading the minidump's header, directory and the streams that
+  // processing consults.  When MinidumpProcessor::Process is handed a
+  // Minidump that has already been Read, that part isn't included.
+  ProcessingTime read;
+
+  // Copying the module list into the ProcessState.
+  ProcessingTime module_copy;
+
+  // Setting up stackwalkers for all of the threads and walking them.
+  // The wall time is the elapsed time of the whole phase; the CPU time is
+  // the sum of the threads' walks, which may run concurrently.
+  ProcessingTime stackwalk;
+
+  // The sum of threads.
+  StackwalkStats all_threads;
+
+  // Statistics for each stack walked, in the order of
+  // ProcessState::threads().
+  vector<StackwalkStats> threads;
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_PROCESS_STATS_H__
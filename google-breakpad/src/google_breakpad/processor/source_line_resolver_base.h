@@ -42,18 +42,32 @@
 #define GOOGLE_BREAKPAD_PROCESSOR_SOURCE_LINE_RESOLVER_BASE_H__
 
 #include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "google_breakpad/processor/source_line_resolver_interface.h"
 
 namespace google_breakpad {
 
 using std::map;
+using std::set;
+using std::vector;
 
 // Forward declaration.
 // ModuleFactory is a simple factory interface for creating a Module instance
 // at run-time.
 class ModuleFactory;
+class ConditionVariable;
+class Mutex;
+
+// SourceLineResolverBase may be used from several threads at once: loading
+// a module and looking up addresses are safe to do concurrently, and a
+// module whose symbols several threads try to load at the same time is
+// only parsed once.  UnloadModule must not race with lookups in the module
+// being unloaded, and neither must UnloadLeastRecentlyUsedModules.  A
+// CFIFrameInfo returned by FindCFIFrameInfo uses rules cached in its
+// module, so delete it before unloading that module.
 
 class SourceLineResolverBase : public SourceLineResolverInterface {
  public:
@@ -64,6 +78,38 @@ class SourceLineResolverBase : public SourceLineResolverInterface {
   // ownership of the buffer, and should call delete [] to free the buffer.
   static bool ReadSymbolFile(char **symbol_data, const string &file_name);
 
+  // Returns the total size of the symbol data that the loaded modules were
+  // loaded from.  This is the size of the symbol text (or, for
+  // FastSourceLineResolver, the serialized data), not of the memory the
+  // modules occupy: a module's parsed tables can take several times as much.
+  size_t LoadedSymbolDataSize();
+
+  // Unloads the modules least recently loaded or looked up until the total
+  // that LoadedSymbolDataSize returns is no more than max_size.  This lets
+  // a long-running process that resolves many minidumps keep the symbols
+  // it uses most often loaded within a budget of symbol data.  If
+  // unloaded_code_files is not NULL, appends the code files of the
+  // unloaded modules to it, so that the caller can release any symbol data
+  // still held for them, as a SymbolSupplier does for a resolver that
+  // keeps using the memory buffers it loads.
+  void UnloadLeastRecentlyUsedModules(size_t max_size,
+                                      vector<string> *unloaded_code_files);
+
+  // FillSourceLineInfo remembers the results of recent lookups in each
+  // module, so that addresses that recur across threads and minidumps,
+  // such as thread entry points and lock primitives, are only searched
+  // for once.  Each module's cache holds at most about capacity results;
+  // zero disables caching.  The capacity applies to modules loaded after
+  // the call.  The default is kDefaultLookupCacheCapacity.
+  void set_lookup_cache_capacity(size_t capacity);
+
+  // Adds the number of FillSourceLineInfo calls answered from the lookup
+  // cache, and the number that had to search the module's symbols, to
+  // *hits and *misses.  Lookups in modules since unloaded are included.
+  void GetLookupCacheStats(u_int64_t *hits, u_int64_t *misses);
+
+  static const size_t kDefaultLookupCacheCapacity = 1024;
+
  protected:
   // Users are not allowed create SourceLineResolverBase instance directly.
   SourceLineResolverBase(ModuleFactory *module_factory);
@@ -83,14 +129,28 @@ class SourceLineResolverBase : public SourceLineResolverInterface {
   virtual CFIFrameInfo *FindCFIFrameInfo(const StackFrame *frame);
 
   // Nested structs and classes.
+  // Module is an interface for an in-memory symbol file.
+  class Module;
+
+  // Marks the module named by code_file as being loaded, first waiting for
+  // any other thread that is loading it to finish.  Until EndModuleLoad is
+  // called, lookups in the module and other attempts to load it wait.
+  // Returns false, without marking it, if the module is already loaded.
+  bool BeginModuleLoad(const string &code_file);
+
+  // Finishes a load begun with BeginModuleLoad.  If module is not NULL,
+  // takes ownership of it and makes it available for lookups, as the build
+  // of code_file identified by debug_identifier; otherwise, the load failed
+  // and the module remains unloaded.
+  void EndModuleLoad(const string &code_file, const string &debug_identifier,
+                     Module *module);
+
   struct Line;
   struct Function;
   struct PublicSymbol;
   struct CompareString {
     bool operator()(const string &s1, const string &s2) const;
   };
-  // Module is an interface for an in-memory symbol file.
-  class Module;
   class AutoFileCloser;
 
   // All of the modules that are loaded.
@@ -105,6 +165,35 @@ class SourceLineResolverBase : public SourceLineResolverInterface {
   ModuleFactory *module_factory_;
 
  private:
+  // Returns the loaded module named by CODE_FILE, or NULL.  If another
+  // thread is loading the module, waits for it to finish first.
+  Module *GetLoadedModule(const string &code_file);
+
+  // Unloads the module named by CODE_FILE, if any, and frees any memory
+  // buffer held for it.  The caller must hold modules_lock_.
+  void UnloadModuleLocked(const string &code_file);
+
+  // Guards modules_, memory_buffers_, loading_modules_, and the lookup
+  // cache settings and statistics below.
+  Mutex *modules_lock_;
+
+  // The code files of modules that some thread is currently parsing.
+  // Lookups and loads of those modules wait on module_loaded_ until the
+  // parse finishes, so that each module is loaded only once.
+  set<string> *loading_modules_;
+  ConditionVariable *module_loaded_;
+
+  // Incremented on each lookup, and recorded in the module looked up, so
+  // that UnloadLeastRecentlyUsedModules can tell which were used last.
+  u_int64_t use_count_;
+
+  // The lookup cache capacity given to modules as they are loaded.
+  size_t lookup_cache_capacity_;
+
+  // The lookup cache statistics of modules that have been unloaded.
+  u_int64_t unloaded_lookup_hits_;
+  u_int64_t unloaded_lookup_misses_;
+
   // ModuleFactory needs to have access to protected type Module.
   friend class ModuleFactory;
 
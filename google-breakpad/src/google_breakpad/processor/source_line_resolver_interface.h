@@ -80,7 +80,8 @@ class SourceLineResolverInterface {
   // A resolver may choose to ignore such a request.
   virtual void UnloadModule(const CodeModule *module) = 0;
 
-  // Returns true if the module has been loaded.
+  // Returns true if the module has been loaded.  A different build of the
+  // same code file, with another debug_identifier, does not count.
   virtual bool HasModule(const CodeModule *module) = 0;
 
   // Fills in the function_base, function_name, source_file_name,
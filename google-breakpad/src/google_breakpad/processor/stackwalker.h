@@ -41,27 +41,28 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_STACKWALKER_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_STACKWALKER_H__
 
-#include <set>
+#include <map>
 #include <string>
 #include "google_breakpad/common/breakpad_types.h"
 #include "google_breakpad/processor/code_modules.h"
 #include "google_breakpad/processor/memory_region.h"
+#include "google_breakpad/processor/symbol_supplier.h"
 
 namespace google_breakpad {
 
 class CallStack;
+class CodeAddressFilter;
 class MinidumpContext;
 class SourceLineResolverInterface;
 struct StackFrame;
-class SymbolSupplier;
+struct StackwalkStats;
+class SymbolLoadCoordinator;
 class SystemInfo;
 
-using std::set;
-
 
 class Stackwalker {
  public:
-  virtual ~Stackwalker() {}
+  virtual ~Stackwalker();
 
   // Populates the given CallStack by calling GetContextFrame and
   // GetCallerFrame.  The frames are further processed to fill all available
@@ -79,6 +80,19 @@ class Stackwalker {
                                         SymbolSupplier *supplier,
                                         SourceLineResolverInterface *resolver);
 
+  // Share symbol loading state with the other Stackwalkers using
+  // COORDINATOR, so that they may walk their stacks concurrently.  The
+  // caller retains ownership of COORDINATOR, which must outlive this
+  // Stackwalker.  See processor/symbol_load_coordinator.h.
+  void set_symbol_load_coordinator(SymbolLoadCoordinator *coordinator) {
+    coordinator_ = coordinator;
+  }
+
+  // If stats is not NULL, Walk adds the time it spends, and the number of
+  // frames it recovers by each strategy, to *stats.  The caller retains
+  // ownership of stats, which must outlive this Stackwalker.
+  void set_stats(StackwalkStats *stats) { stats_ = stats; }
+
   static void set_max_frames(u_int32_t max_frames) { max_frames_ = max_frames; }
   static u_int32_t max_frames() { return max_frames_; }
 
@@ -106,13 +120,28 @@ class Stackwalker {
   // * This address is within a loaded module for which we have symbols,
   //   and falls inside a function in that module.
   // Returns false otherwise.
+  //
+  // The answer for each address is remembered for the life of the
+  // Stackwalker, because successive scans revisit overlapping stack words.
   bool InstructionAddressSeemsValid(u_int64_t address);
 
+  // Sets in_code[i] to whether addresses[i] lies within any loaded module,
+  // for each i less than count, and returns the number that do.  This is a
+  // cheap pre-filter for InstructionAddressSeemsValid: it consults a
+  // CodeAddressFilter built from modules_ on first use, and never loads
+  // symbols.  If modules_ is NULL, no address is in code.
+  size_t FilterCodeAddresses(const u_int64_t *addresses, size_t count,
+                             bool *in_code);
+
   // Scan the stack starting at location_start, looking for an address
   // that looks like a valid instruction pointer. Addresses must
   // 1) be contained in the current stack memory
   // 2) pass the checks in InstructionAddressSeemsValid
   //
+  // The whole search window is read first and passed through
+  // FilterCodeAddresses, so that only words that fall inside a module
+  // reach the more expensive InstructionAddressSeemsValid.
+  //
   // Returns true if a valid-looking instruction pointer was found.
   // When returning true, sets location_found to the address at which
   // the value was found, and ip_found to the value contained at that
@@ -122,18 +151,26 @@ class Stackwalker {
                             InstructionType *location_found,
                             InstructionType *ip_found) {
     const int kRASearchWords = 30;
+    InstructionType words[kRASearchWords + 1];
+    u_int64_t addresses[kRASearchWords + 1];
+    int word_count = 0;
     for (InstructionType location = location_start;
-         location <= location_start + kRASearchWords * sizeof(InstructionType);
+         word_count <= kRASearchWords;
          location += sizeof(InstructionType)) {
-      InstructionType ip;
-      if (!memory_->GetMemoryAtAddress(location, &ip))
+      if (!memory_->GetMemoryAtAddress(location, &words[word_count]))
         break;
+      addresses[word_count] = words[word_count];
+      ++word_count;
+    }
 
-      if (modules_ && modules_->GetModuleForAddress(ip) &&
-          InstructionAddressSeemsValid(ip)) {
+    bool in_code[kRASearchWords + 1];
+    if (FilterCodeAddresses(addresses, word_count, in_code) == 0)
+      return false;
 
-        *ip_found = ip;
-        *location_found = location;
+    for (int index = 0; index < word_count; ++index) {
+      if (in_code[index] && InstructionAddressSeemsValid(words[index])) {
+        *ip_found = words[index];
+        *location_found = location_start + index * sizeof(InstructionType);
         return true;
       }
     }
@@ -157,6 +194,10 @@ class Stackwalker {
   // The SourceLineResolver implementation.
   SourceLineResolverInterface *resolver_;
 
+  // Where to record statistics, or NULL; see set_stats.  Subclasses
+  // record the strategies that StackFrame::trust doesn't distinguish.
+  StackwalkStats *stats_;
+
  private:
   // Obtains the context frame, the innermost called procedure in a stack
   // trace.  Returns NULL on failure.  GetContextFrame allocates a new
@@ -174,13 +215,45 @@ class Stackwalker {
   // the caller.
   virtual StackFrame* GetCallerFrame(const CallStack *stack) = 0;
 
+  // Fetches and loads the symbols for MODULE, unless they are already
+  // loaded or the supplier is known not to have them.  Returns false if
+  // the SymbolSupplier interrupted the load.
+  bool LoadSymbolsForModule(const CodeModule *module);
+
+  // Does the work of Walk, apart from keeping statistics.
+  bool WalkFrames(CallStack *stack);
+
+  // Asks supplier_ for MODULE's symbol data, holding the coordinator's
+  // supplier lock.  Parameters and result are as for
+  // SymbolSupplier::GetCStringSymbolData.
+  SymbolSupplier::SymbolResult FetchSymbols(const CodeModule *module,
+                                            string *symbol_file,
+                                            char **symbol_data);
+
+  // Loads SYMBOL_DATA into resolver_ as MODULE's symbols, returning the
+  // resolver's result.
+  bool ParseSymbols(const CodeModule *module, char *symbol_data);
+
+  // Does the work of InstructionAddressSeemsValid, without consulting or
+  // updating address_validity_.
+  bool InstructionAddressSeemsValidUncached(u_int64_t address);
+
   // The optional SymbolSupplier for resolving source line info.
   SymbolSupplier *supplier_;
 
-  // A list of modules that we haven't found symbols for.  We track
-  // this in order to avoid repeatedly looking them up again within
-  // one minidump.
-  set<std::string> no_symbol_modules_;
+  // Tracks the modules that we haven't found symbols for, in order to
+  // avoid repeatedly looking them up again within one minidump, and
+  // serializes symbol loading with other Stackwalkers.  This is either
+  // own_coordinator_ or one shared with other Stackwalkers.
+  SymbolLoadCoordinator *coordinator_;
+  SymbolLoadCoordinator *own_coordinator_;
+
+  // The ranges of modules_, flattened for stack scanning.  Built by
+  // FilterCodeAddresses on first use, and owned by this Stackwalker.
+  CodeAddressFilter *code_filter_;
+
+  // The results of InstructionAddressSeemsValid, by address.
+  std::map<u_int64_t, bool> address_validity_;
 
   // The maximum number of frames Stackwalker will walk through.
   // This defaults to 1024 to prevent infinite loops.
@@ -55,6 +55,7 @@ bool AddressMap<AddressType, EntryType>::Store(const AddressType &address,
     return false;
   }
 
+  frozen_.Clear();
   map_.insert(MapValue(address, entry));
   return true;
 }
@@ -66,6 +67,19 @@ bool AddressMap<AddressType, EntryType>::Retrieve(
   BPLOG_IF(ERROR, !entry) << "AddressMap::Retrieve requires |entry|";
   assert(entry);
 
+  if (!frozen_.empty()) {
+    size_t index = frozen_.UpperBound(address);
+    if (index == 0)
+      return false;
+    --index;
+
+    *entry = frozen_.ValueAtIndex(index);
+    if (entry_address)
+      *entry_address = frozen_.KeyAtIndex(index);
+
+    return true;
+  }
+
   // upper_bound gives the first element whose key is greater than address,
   // but we want the first element whose key is less than or equal to address.
   // Decrement the iterator to get there, but not if the upper_bound already
@@ -85,9 +99,15 @@ bool AddressMap<AddressType, EntryType>::Retrieve(
 
 template<typename AddressType, typename EntryType>
 void AddressMap<AddressType, EntryType>::Clear() {
+  frozen_.Clear();
   map_.clear();
 }
 
+template<typename AddressType, typename EntryType>
+void AddressMap<AddressType, EntryType>::Freeze() {
+  frozen_.Build(map_);
+}
+
 }  // namespace google_breakpad
 
 #endif  // PROCESSOR_ADDRESS_MAP_INL_H__
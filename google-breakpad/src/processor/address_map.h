@@ -40,6 +40,8 @@
 
 #include <map>
 
+#include "processor/frozen_address_index.h"
+
 namespace google_breakpad {
 
 // Forward declarations (for later friend declarations).
@@ -48,7 +50,7 @@ template<class, class> class AddressMapSerializer;
 template<typename AddressType, typename EntryType>
 class AddressMap {
  public:
-  AddressMap() : map_() {}
+  AddressMap() : map_(), frozen_() {}
 
   // Inserts an entry into the map.  Returns false without storing the entry
   // if an entry is already stored in the map at the same address as specified
@@ -67,6 +69,14 @@ class AddressMap {
   // initially created.
   void Clear();
 
+  // Builds a contiguous index of the stored entries that Retrieve searches
+  // instead of the underlying std::map.  Call this once all entries have
+  // been stored.  A subsequent Store or Clear discards the index.
+  void Freeze();
+
+  // Returns true if the map has been frozen and not modified since.
+  bool IsFrozen() const { return !frozen_.empty(); }
+
  private:
   friend class AddressMapSerializer<AddressType, EntryType>;
   friend class ModuleComparer;
@@ -78,6 +88,10 @@ class AddressMap {
 
   // Maps the address of each entry to an EntryType.
   AddressToEntryMap map_;
+
+  // A sorted index over map_, built by Freeze.  Empty while the map is
+  // being populated.
+  FrozenAddressIndex<AddressType, EntryType> frozen_;
 };
 
 }  // namespace google_breakpad
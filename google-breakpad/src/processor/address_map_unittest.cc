@@ -150,24 +150,33 @@ static bool DoAddressMapTest() {
                                          20, 20, 20, 20, 20,    // 20 - 24
                                          20, 20, 20, 20, 20 };  // 25 - 29
 
-  for (AddressType key = 5; key < 30; ++key) {
-    if (!test_map.Retrieve(key, &entry, &address)) {
-      fprintf(stderr,
-              "FAIL: retrieve %d expected true observed false @ %s:%d\n",
-              key, __FILE__, __LINE__);
-      return false;
+  // Run the retrieval tests twice: once against the map as stored, and
+  // once after freezing it, which must not change any result.
+  for (int pass = 0; pass < 2; ++pass) {
+    if (pass == 1) {
+      test_map.Freeze();
+      ASSERT_TRUE(test_map.IsFrozen());
     }
-    if (entry->id() != id_verify[key]) {
-      fprintf(stderr,
-              "FAIL: retrieve %d expected entry %d observed %d @ %s:%d\n",
-              key, id_verify[key], entry->id(), __FILE__, __LINE__);
-      return false;
-    }
-    if (address != address_verify[key]) {
-      fprintf(stderr,
-              "FAIL: retrieve %d expected address %d observed %d @ %s:%d\n",
-              key, address_verify[key], address, __FILE__, __LINE__);
-      return false;
+
+    for (AddressType key = 5; key < 30; ++key) {
+      if (!test_map.Retrieve(key, &entry, &address)) {
+        fprintf(stderr,
+                "FAIL: retrieve %d expected true observed false @ %s:%d\n",
+                key, __FILE__, __LINE__);
+        return false;
+      }
+      if (entry->id() != id_verify[key]) {
+        fprintf(stderr,
+                "FAIL: retrieve %d expected entry %d observed %d @ %s:%d\n",
+                key, id_verify[key], entry->id(), __FILE__, __LINE__);
+        return false;
+      }
+      if (address != address_verify[key]) {
+        fprintf(stderr,
+                "FAIL: retrieve %d expected address %d observed %d @ %s:%d\n",
+                key, address_verify[key], address, __FILE__, __LINE__);
+        return false;
+      }
     }
   }
 
@@ -0,0 +1,153 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// arena.cc: Implement google_breakpad::Arena and StringPool.  See arena.h.
+
+#include "processor/arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+
+namespace google_breakpad {
+
+// Allocations are aligned to this many bytes, enough for 64-bit integers
+// and pointers.
+static const size_t kAlignment = 8;
+
+Arena::Arena(size_t slab_size)
+    : slabs_(), next_(NULL), limit_(NULL), slab_size_(slab_size),
+      slab_bytes_(0) { }
+
+Arena::~Arena() {
+  for (size_t i = 0; i < slabs_.size(); ++i)
+    free(slabs_[i]);
+}
+
+void *Arena::Allocate(size_t size) {
+  // Pad the current slab so that the allocation starts aligned.  Slabs
+  // themselves come from malloc, which aligns them.
+  size_t misalignment = reinterpret_cast<size_t>(next_) % kAlignment;
+  if (misalignment && next_ < limit_) {
+    size_t padding = kAlignment - misalignment;
+    next_ = padding < static_cast<size_t>(limit_ - next_) ? next_ + padding
+                                                          : limit_;
+  }
+  return AllocateUnaligned(size);
+}
+
+const char *Arena::CopyString(const char *string, size_t length) {
+  char *copy = AllocateUnaligned(length + 1);
+  memcpy(copy, string, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+char *Arena::AllocateUnaligned(size_t size) {
+  if (size <= static_cast<size_t>(limit_ - next_)) {
+    char *result = next_;
+    next_ += size;
+    return result;
+  }
+
+  // Give allocations of more than a quarter of a slab their own, rather
+  // than abandoning the rest of the current slab.
+  if (size > slab_size_ / 4) {
+    char *slab = static_cast<char *>(malloc(size ? size : 1));
+    if (!slab)
+      throw std::bad_alloc();
+    slabs_.push_back(slab);
+    slab_bytes_ += size;
+    return slab;
+  }
+
+  char *slab = static_cast<char *>(malloc(slab_size_));
+  if (!slab)
+    throw std::bad_alloc();
+  slabs_.push_back(slab);
+  slab_bytes_ += slab_size_;
+  next_ = slab + size;
+  limit_ = slab + slab_size_;
+  return slab;
+}
+
+StringPool::StringPool(Arena *arena)
+    : arena_(arena), table_(), size_(0) { }
+
+// static
+u_int32_t StringPool::Hash(const char *string, size_t length) {
+  // FNV-1a.
+  u_int32_t hash = 2166136261U;
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= static_cast<unsigned char>(string[i]);
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+const char *StringPool::Intern(const char *string, size_t length) {
+  // Keep the table at most half full, so that probe sequences stay short.
+  if ((size_ + 1) * 2 > table_.size())
+    Grow();
+
+  u_int32_t hash = Hash(string, length);
+  size_t mask = table_.size() - 1;
+  for (size_t index = hash & mask; ; index = (index + 1) & mask) {
+    Entry &entry = table_[index];
+    if (!entry.string) {
+      entry.string = arena_->CopyString(string, length);
+      entry.hash = hash;
+      ++size_;
+      return entry.string;
+    }
+    if (entry.hash == hash && strncmp(entry.string, string, length) == 0 &&
+        entry.string[length] == '\0') {
+      return entry.string;
+    }
+  }
+}
+
+void StringPool::Grow() {
+  std::vector<Entry> old_table;
+  old_table.swap(table_);
+  Entry empty = { NULL, 0 };
+  table_.assign(old_table.empty() ? 64 : old_table.size() * 2, empty);
+  size_t mask = table_.size() - 1;
+  for (size_t i = 0; i < old_table.size(); ++i) {
+    if (!old_table[i].string)
+      continue;
+    size_t index = old_table[i].hash & mask;
+    while (table_[index].string)
+      index = (index + 1) & mask;
+    table_[index] = old_table[i];
+  }
+}
+
+}  // namespace google_breakpad
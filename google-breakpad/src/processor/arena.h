@@ -0,0 +1,134 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// arena.h: Bump allocation and string interning for data that is built
+// once and freed all at once.
+//
+// An Arena hands out memory from large slabs, moving a pointer forward
+// for each allocation.  Nothing is freed individually: destroying the
+// arena releases every slab, so freeing millions of small records costs
+// a handful of free calls.  The records must not need destructors.
+//
+// A StringPool stores strings in an arena, returning the same copy for
+// equal strings, so that names and rule strings that repeat throughout a
+// symbol file are stored once.
+
+#ifndef PROCESSOR_ARENA_H__
+#define PROCESSOR_ARENA_H__
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "google_breakpad/common/breakpad_types.h"
+
+namespace google_breakpad {
+
+class Arena {
+ public:
+  // Allocations come from slabs of slab_size bytes, except for those too
+  // large to share a slab, which get one of their own.
+  explicit Arena(size_t slab_size = kDefaultSlabSize);
+  ~Arena();
+
+  // Returns size bytes, aligned for any record type built of integers and
+  // pointers.  Never returns NULL; a request for zero bytes returns a
+  // pointer that must not be dereferenced.
+  void *Allocate(size_t size);
+
+  // Returns space for count objects of type T, which must be a plain
+  // struct with no constructor or destructor.
+  template<typename T>
+  T *AllocateArray(size_t count) {
+    return static_cast<T *>(Allocate(count * sizeof(T)));
+  }
+
+  // Returns a NUL-terminated copy of the length bytes at string.
+  const char *CopyString(const char *string, size_t length);
+
+  // Returns the number of bytes of slabs the arena holds.
+  size_t slab_bytes() const { return slab_bytes_; }
+
+  static const size_t kDefaultSlabSize = 1 << 16;
+
+ private:
+  // Returns size bytes, with no alignment, starting a new slab if the
+  // current one is too full.
+  char *AllocateUnaligned(size_t size);
+
+  std::vector<char *> slabs_;
+  char *next_;
+  char *limit_;
+  size_t slab_size_;
+  size_t slab_bytes_;
+
+  // Disallow copy ctor and assignment operator
+  Arena(const Arena&);
+  void operator=(const Arena&);
+};
+
+class StringPool {
+ public:
+  // Strings are stored in arena, which must outlive the strings'
+  // users, but not the pool.
+  explicit StringPool(Arena *arena);
+
+  // Returns a NUL-terminated copy of the length bytes at string, which
+  // must not contain NUL characters.  Interning an equal string again
+  // returns the same copy.
+  const char *Intern(const char *string, size_t length);
+
+  // Returns the number of distinct strings interned.
+  size_t size() const { return size_; }
+
+ private:
+  struct Entry {
+    const char *string;
+    u_int32_t hash;
+  };
+
+  static u_int32_t Hash(const char *string, size_t length);
+
+  // Doubles the size of table_, rehashing its entries.
+  void Grow();
+
+  Arena *arena_;
+
+  // An open-addressed hash table, whose size is a power of two.
+  std::vector<Entry> table_;
+  size_t size_;
+
+  // Disallow copy ctor and assignment operator
+  StringPool(const StringPool&);
+  void operator=(const StringPool&);
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_ARENA_H__
@@ -0,0 +1,120 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// arena_unittest.cc: Unit tests for google_breakpad::Arena and StringPool.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "processor/arena.h"
+
+namespace {
+
+using google_breakpad::Arena;
+using google_breakpad::StringPool;
+using std::string;
+using std::vector;
+
+TEST(ArenaTest, AllocationsAreAlignedAndDistinct) {
+  Arena arena(64);
+  vector<char *> blocks;
+  for (size_t size = 1; size < 40; ++size) {
+    char *block = static_cast<char *>(arena.Allocate(size));
+    EXPECT_EQ(0U, reinterpret_cast<size_t>(block) % 8);
+    memset(block, static_cast<int>(size), size);
+    blocks.push_back(block);
+  }
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    size_t size = i + 1;
+    for (size_t j = 0; j < size; ++j)
+      ASSERT_EQ(static_cast<char>(size), blocks[i][j]);
+  }
+}
+
+TEST(ArenaTest, LargeAllocationsGetTheirOwnSlab) {
+  Arena arena(1024);
+  arena.Allocate(16);
+  EXPECT_EQ(1024U, arena.slab_bytes());
+  u_int64_t *array = arena.AllocateArray<u_int64_t>(1000);
+  EXPECT_EQ(1024U + 8000U, arena.slab_bytes());
+  array[999] = 1;
+
+  // The current slab still has room for small allocations.
+  arena.Allocate(16);
+  EXPECT_EQ(1024U + 8000U, arena.slab_bytes());
+}
+
+TEST(ArenaTest, CopyString) {
+  Arena arena;
+  const char *copy = arena.CopyString("hello, world", 5);
+  EXPECT_STREQ("hello", copy);
+}
+
+TEST(StringPoolTest, InternsEqualStringsOnce) {
+  Arena arena;
+  StringPool pool(&arena);
+  const char *foo = pool.Intern("foo bar", 3);
+  const char *bar = pool.Intern("bar", 3);
+  EXPECT_STREQ("foo", foo);
+  EXPECT_STREQ("bar", bar);
+  EXPECT_EQ(foo, pool.Intern("foo", 3));
+  EXPECT_EQ(bar, pool.Intern("foo bar" + 4, 3));
+  EXPECT_NE(foo, pool.Intern("fo", 2));
+  EXPECT_NE(foo, pool.Intern("food", 4));
+  EXPECT_EQ(4U, pool.size());
+}
+
+TEST(StringPoolTest, SurvivesGrowth) {
+  Arena arena;
+  StringPool pool(&arena);
+  vector<const char *> interned;
+  for (int i = 0; i < 10000; ++i) {
+    char name[20];
+    snprintf(name, sizeof(name), "symbol%d", i);
+    interned.push_back(pool.Intern(name, strlen(name)));
+  }
+  EXPECT_EQ(10000U, pool.size());
+  for (int i = 0; i < 10000; ++i) {
+    char name[20];
+    snprintf(name, sizeof(name), "symbol%d", i);
+    ASSERT_EQ(interned[i], pool.Intern(name, strlen(name)));
+    ASSERT_STREQ(name, interned[i]);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
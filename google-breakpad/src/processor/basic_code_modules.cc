@@ -85,7 +85,8 @@ const CodeModule* BasicCodeModules::GetModuleForAddress(
     u_int64_t address) const {
   linked_ptr<const CodeModule> module;
   if (!map_->RetrieveRange(address, &module, NULL, NULL)) {
-    BPLOG(INFO) << "No module at " << HexString(address);
+    // Stack scanning asks about every word on the stack.
+    BPLOG_EVERY_N(INFO, 100) << "No module at " << HexString(address);
     return NULL;
   }
 
@@ -44,10 +44,10 @@
 #include <vector>
 
 #include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/code_module.h"
 #include "processor/basic_source_line_resolver_types.h"
 #include "processor/module_factory.h"
 
-#include "processor/tokenize.h"
 
 using std::map;
 using std::vector;
@@ -55,99 +55,513 @@ using std::make_pair;
 
 namespace google_breakpad {
 
-static const char *kWhitespace = " \r\n";
+// Returns true if record, which need not be NUL-terminated, is a line
+// record rather than one of the records introduced by a keyword.
+static bool IsLineRecord(const char *record) {
+  static const char *const kKeywords[] = {
+    "FILE ", "FUNC ", "PUBLIC ", "STACK ", "MODULE ", "INFO "
+  };
+  for (size_t i = 0; i < sizeof(kKeywords) / sizeof(kKeywords[0]); ++i) {
+    if (strncmp(record, kKeywords[i], strlen(kKeywords[i])) == 0)
+      return false;
+  }
+  return true;
+}
+
+// Parses the hexadecimal number at the start of field, which may be
+// preceded by spaces, into value, and sets field_end to the character after
+// it.  Returns false if there is no number before record_end.  Unlike the
+// Parse* methods, this works on the read-only text of a symbol file.
+static bool ParseHexField(const char *field, const char *record_end,
+                          u_int64_t *value, const char **field_end) {
+  field += strspn(field, " ");
+  if (field >= record_end)
+    return false;
+  char *end;
+  *value = strtoull(field, &end, 16);
+  if (end == field || end > record_end)
+    return false;
+  *field_end = end;
+  return true;
+}
+
+// Splits the record running from record to record_end into max_tokens
+// fields separated by spaces, placing a pointer to the start of each in
+// tokens.  The last field takes the rest of the record, up to record_end.
+// Returns false if there are fewer than max_tokens fields.  This is
+// Tokenize for the read-only text of a symbol file: no field is
+// NUL-terminated, but every field but the last ends at a space.
+static bool TokenizeRecord(const char *record, const char *record_end,
+                           int max_tokens, vector<const char *> *tokens) {
+  tokens->clear();
+  tokens->reserve(max_tokens);
+
+  const char *cursor = record;
+  while (static_cast<int>(tokens->size()) < max_tokens - 1) {
+    while (cursor < record_end && *cursor == ' ')
+      ++cursor;
+    if (cursor == record_end)
+      return false;
+    tokens->push_back(cursor);
+    while (cursor < record_end && *cursor != ' ')
+      ++cursor;
+    // Like strtok_r, consume the single separator ending the field.
+    if (cursor < record_end)
+      ++cursor;
+  }
+
+  if (cursor >= record_end)
+    return false;
+  tokens->push_back(cursor);
+  return true;
+}
 
 BasicSourceLineResolver::BasicSourceLineResolver() :
-    SourceLineResolverBase(new BasicModuleFactory) { }
+    SourceLineResolverBase(new BasicModuleFactory), parse_lazily_(false) { }
+
+BasicSourceLineResolver::BasicSourceLineResolver(bool parse_lazily) :
+    SourceLineResolverBase(new BasicModuleFactory(parse_lazily)),
+    parse_lazily_(parse_lazily) { }
+
+bool BasicSourceLineResolver::ShouldDeleteMemoryBufferAfterLoadModule() {
+  // Lazily parsed modules go on reading the symbol file text they were
+  // loaded from.
+  return !parse_lazily_;
+}
+
+BasicSourceLineResolver::ModuleLoader *
+BasicSourceLineResolver::StartModuleLoad(const CodeModule *module) {
+  if (!module)
+    return NULL;
+
+  if (!BeginModuleLoad(module->code_file()))
+    return NULL;
+
+  BPLOG(INFO) << "Loading symbols for module " << module->code_file()
+              << " incrementally";
+  // The factory creates modules that parse lazily if this resolver does.
+  Module *basic_module =
+      static_cast<Module *>(module_factory_->CreateModule(module->code_file()));
+  return new ModuleLoader(this, module->code_file(),
+                          module->debug_identifier(), basic_module);
+}
+
+BasicSourceLineResolver::ModuleLoader::ModuleLoader(
+    BasicSourceLineResolver *resolver, const string &code_file,
+    const string &debug_identifier, Module *module)
+    : resolver_(resolver), code_file_(code_file),
+      debug_identifier_(debug_identifier), module_(module) { }
+
+BasicSourceLineResolver::ModuleLoader::~ModuleLoader() {
+  if (module_)
+    End(false);
+}
+
+bool BasicSourceLineResolver::ModuleLoader::Append(const char *data,
+                                                   size_t size) {
+  if (!module_)
+    return false;
+
+  if (!module_->ParseChunk(data, size)) {
+    End(false);
+    return false;
+  }
+  return true;
+}
+
+bool BasicSourceLineResolver::ModuleLoader::Finish() {
+  if (!module_)
+    return false;
+
+  bool succeeded = module_->FinishParsing();
+  End(succeeded);
+  return succeeded;
+}
+
+void BasicSourceLineResolver::ModuleLoader::End(bool succeeded) {
+  if (!succeeded) {
+    delete module_;
+    module_ = NULL;
+  }
+  resolver_->EndModuleLoad(code_file_, debug_identifier_, module_);
+  module_ = NULL;
+}
 
 bool BasicSourceLineResolver::Module::LoadMapFromMemory(char *memory_buffer) {
-  linked_ptr<Function> cur_func;
-  int line_number = 0;
-  char *save_ptr;
-  size_t map_buffer_length = strlen(memory_buffer);
-
-  // If the length is 0, we can still pretend we have a symbol file. This is
-  // for scenarios that want to test symbol lookup, but don't necessarily care
-  // if certain modules do not have any information, like system libraries.
-  if (map_buffer_length == 0) {
+  // memory_buffer may be a read-only mapping of the symbol file (see
+  // SimpleSymbolSupplier::set_map_symbol_files), so it is never written to:
+  // each record is parsed where it lies, and only the names and rules the
+  // module keeps are copied out of it.
+  //
+  // If the buffer is empty, we can still pretend we have a symbol file. This
+  // is for scenarios that want to test symbol lookup, but don't necessarily
+  // care if certain modules do not have any information, like system
+  // libraries.
+  const char *cursor = memory_buffer;
+
+  while (*cursor != '\0') {
+    // Records are separated by runs of CR and LF characters.
+    size_t record_length = strcspn(cursor, "\r\n");
+    if (record_length == 0) {
+      ++cursor;
+      continue;
+    }
+    if (parse_lazily_ && IndexRecord(cursor, record_length)) {
+      cursor += record_length;
+      continue;
+    }
+    if (!ParseRecord(cursor, record_length))
+      return false;
+    cursor += record_length;
+  }
+  symbol_data_size_ = cursor - memory_buffer;
+
+  if (parse_lazily_ && !cfi_records_indexed_ &&
+      !ParseCFIRecords(memory_buffer)) {
+    return false;
+  }
+
+  FreezeMaps();
+  cur_func_.reset();
+  return true;
+}
+
+bool BasicSourceLineResolver::Module::ParseChunk(const char *data,
+                                                 size_t size) {
+  if (parse_lazily_) {
+    // The index refers to the text, so it can only be built once the text
+    // has all arrived; see FinishParsing.
+    text_.insert(text_.end(), data, data + size);
     return true;
   }
 
-  if (memory_buffer[map_buffer_length - 1] == '\n') {
-    memory_buffer[map_buffer_length - 1] = '\0';
+  const char *cursor = data;
+  const char *end = data + size;
+
+  while (cursor < end) {
+    // Records are separated by runs of CR and LF characters.  A record that
+    // runs to the end of the chunk may continue in the next one, so it is
+    // kept in partial_record_ until its terminator arrives.  Records that
+    // lie wholly within the chunk are parsed in place.
+    const char *terminator = cursor;
+    while (terminator < end && *terminator != '\r' && *terminator != '\n')
+      ++terminator;
+
+    if (terminator == end) {
+      partial_record_.insert(partial_record_.end(), cursor, terminator);
+      break;
+    }
+
+    bool result = true;
+    if (!partial_record_.empty()) {
+      partial_record_.insert(partial_record_.end(), cursor, terminator);
+      partial_record_.push_back('\0');
+      result = ParseRecord(&partial_record_[0], partial_record_.size() - 1);
+      partial_record_.clear();
+    } else if (terminator > cursor) {
+      result = ParseRecord(cursor, terminator - cursor);
+    }
+    if (!result)
+      return false;
+    cursor = terminator + 1;
   }
 
-  char *buffer;
-  buffer = strtok_r(memory_buffer, "\r\n", &save_ptr);
+  symbol_data_size_ += size;
+  return true;
+}
 
-  while (buffer != NULL) {
-    ++line_number;
+bool BasicSourceLineResolver::Module::FinishParsing() {
+  if (parse_lazily_) {
+    // Trim the collected text to size, so that the module holds no more
+    // than a buffer kept by the resolver would, and index it in place.
+    text_.push_back('\0');
+    vector<char>(text_).swap(text_);
+    return LoadMapFromMemory(&text_[0]);
+  }
 
-    if (strncmp(buffer, "FILE ", 5) == 0) {
-      if (!ParseFile(buffer)) {
-        BPLOG(ERROR) << "ParseFile on buffer failed at " <<
-            ":" << line_number;
-        return false;
-      }
-    } else if (strncmp(buffer, "STACK ", 6) == 0) {
-      if (!ParseStackInfo(buffer)) {
-        BPLOG(ERROR) << "ParseStackInfo failed at " <<
-            ":" << line_number;
-        return false;
-      }
-    } else if (strncmp(buffer, "FUNC ", 5) == 0) {
-      cur_func.reset(ParseFunction(buffer));
-      if (!cur_func.get()) {
-        BPLOG(ERROR) << "ParseFunction failed at " <<
-            ":" << line_number;
-        return false;
-      }
-      // StoreRange will fail if the function has an invalid address or size.
-      // We'll silently ignore this, the function and any corresponding lines
-      // will be destroyed when cur_func is released.
-      functions_.StoreRange(cur_func->address, cur_func->size, cur_func);
-    } else if (strncmp(buffer, "PUBLIC ", 7) == 0) {
-      // Clear cur_func: public symbols don't contain line number information.
-      cur_func.reset();
-
-      if (!ParsePublicSymbol(buffer)) {
-        BPLOG(ERROR) << "ParsePublicSymbol failed at " <<
-            ":" << line_number;
-        return false;
-      }
-    } else if (strncmp(buffer, "MODULE ", 7) == 0) {
-      // Ignore these.  They're not of any use to BasicSourceLineResolver,
-      // which is fed modules by a SymbolSupplier.  These lines are present to
-      // aid other tools in properly placing symbol files so that they can
-      // be accessed by a SymbolSupplier.
-      //
-      // MODULE <guid> <age> <filename>
-    } else if (strncmp(buffer, "INFO ", 5) == 0) {
-      // Ignore these as well, they're similarly just for housekeeping.
-      //
-      // INFO CODE_ID <code id> <filename>
+  if (!partial_record_.empty()) {
+    partial_record_.push_back('\0');
+    bool result = ParseRecord(&partial_record_[0],
+                              partial_record_.size() - 1);
+    vector<char>().swap(partial_record_);
+    if (!result)
+      return false;
+  }
+
+  FreezeMaps();
+  cur_func_.reset();
+  return true;
+}
+
+bool BasicSourceLineResolver::Module::ParseRecord(const char *buffer,
+                                                  size_t length) {
+  ++line_number_;
+  const char *buffer_end = buffer + length;
+
+  if (strncmp(buffer, "FILE ", 5) == 0) {
+    if (!ParseFile(buffer, buffer_end)) {
+      BPLOG(ERROR) << "ParseFile on buffer failed at " <<
+          ":" << line_number_;
+      return false;
+    }
+  } else if (strncmp(buffer, "STACK ", 6) == 0) {
+    if (!ParseStackInfo(buffer, buffer_end)) {
+      BPLOG(ERROR) << "ParseStackInfo failed at " <<
+          ":" << line_number_;
+      return false;
+    }
+  } else if (strncmp(buffer, "FUNC ", 5) == 0) {
+    cur_func_.reset(ParseFunction(buffer, buffer_end));
+    if (!cur_func_.get()) {
+      BPLOG(ERROR) << "ParseFunction failed at " <<
+          ":" << line_number_;
+      return false;
+    }
+    // StoreRange will fail if the function has an invalid address or size.
+    // We'll silently ignore this, the function and any corresponding lines
+    // will be destroyed when cur_func_ is released.
+    functions_.StoreRange(cur_func_->address, cur_func_->size, cur_func_);
+  } else if (strncmp(buffer, "PUBLIC ", 7) == 0) {
+    // Clear cur_func_: public symbols don't contain line number information.
+    cur_func_.reset();
+
+    if (!ParsePublicSymbol(buffer, buffer_end)) {
+      BPLOG(ERROR) << "ParsePublicSymbol failed at " <<
+          ":" << line_number_;
+      return false;
+    }
+  } else if (strncmp(buffer, "MODULE ", 7) == 0) {
+    // Ignore these.  They're not of any use to BasicSourceLineResolver,
+    // which is fed modules by a SymbolSupplier.  These lines are present to
+    // aid other tools in properly placing symbol files so that they can
+    // be accessed by a SymbolSupplier.
+    //
+    // MODULE <guid> <age> <filename>
+  } else if (strncmp(buffer, "INFO ", 5) == 0) {
+    // Ignore these as well, they're similarly just for housekeeping.
+    //
+    // INFO CODE_ID <code id> <filename>
+  } else {
+    if (!cur_func_.get()) {
+      BPLOG(ERROR) << "Found source line data without a function at " <<
+          ":" << line_number_;
+      return false;
+    }
+    Line *line = ParseLine(buffer, buffer_end);
+    if (!line) {
+      BPLOG(ERROR) << "ParseLine failed at " << line_number_ << " for " <<
+          string(buffer, buffer_end);
+      return false;
+    }
+    cur_func_->lines.StoreRange(line->address, line->size,
+                                linked_ptr<Line>(line));
+  }
+  return true;
+}
+
+void BasicSourceLineResolver::Module::FreezeMaps() {
+  // The module is never modified after loading, so trade the maps' tree
+  // lookups for searches over contiguous sorted indices.
+  functions_.Freeze();
+  for (int index = 0; index < functions_.GetCount(); ++index) {
+    linked_ptr<Function> function;
+    functions_.RetrieveRangeAtIndex(index, &function, NULL, NULL);
+    function->lines.Freeze();
+  }
+  public_symbols_.Freeze();
+  for (int type = 0; type < WindowsFrameInfo::STACK_INFO_LAST; ++type)
+    windows_frame_info_[type].Freeze();
+  cfi_initial_rules_.Freeze();
+  cfi_init_records_.Freeze();
+}
+
+bool BasicSourceLineResolver::Module::IndexRecord(const char *record,
+                                                  size_t length) {
+  if (strncmp(record, "STACK CFI ", 10) == 0) {
+    const char *record_end = record + length;
+    MemAddr address = 0, size = 0;
+    const char *rules;
+    if (strncmp(record, "STACK CFI INIT ", 15) == 0) {
+      // STACK CFI INIT <address> <size> <rules...>
+      cfi_index_open_ =
+          ParseHexField(record + 15, record_end, &address, &rules) &&
+          ParseHexField(rules, record_end, &size, &rules) &&
+          cfi_init_records_.StoreRange(address, size, record);
+      cfi_index_next_ = address;
+      cfi_index_end_ = address + size;
     } else {
-      if (!cur_func.get()) {
-        BPLOG(ERROR) << "Found source line data without a function at " <<
-            ":" << line_number;
-        return false;
+      // STACK CFI <address> <rules...>
+      //
+      // Delta records are found from the INIT record they follow when
+      // FindCFIFrameInfoInRecords needs them, so they are only checked here.
+      cfi_index_open_ =
+          cfi_index_open_ &&
+          ParseHexField(record + 10, record_end, &address, &rules) &&
+          address >= cfi_index_next_ && address < cfi_index_end_;
+      cfi_index_next_ = address + 1;
+    }
+
+    // If a record is malformed or out of place, leave LoadMapFromMemory to
+    // parse the STACK CFI records eagerly instead, which reports or
+    // ignores it just as an eagerly parsed module would.
+    if (!cfi_index_open_)
+      cfi_records_indexed_ = false;
+    ++line_number_;
+    return true;
+  }
+
+  // Any other record ends the delta records following the last INIT.
+  cfi_index_open_ = false;
+
+  if (cur_func_.get() && IsLineRecord(record)) {
+    if (!cur_func_->line_records)
+      cur_func_->line_records = record;
+    cur_func_->line_records_end = record + length;
+    ++line_number_;
+    return true;
+  }
+
+  return false;
+}
+
+bool BasicSourceLineResolver::Module::ParseCFIRecords(const char *buffer) {
+  cfi_init_records_.Clear();
+  cfi_records_indexed_ = false;
+
+  line_number_ = 0;
+  const char *cursor = buffer;
+  while (*cursor != '\0') {
+    size_t record_length = strcspn(cursor, "\r\n");
+    if (record_length == 0) {
+      ++cursor;
+      continue;
+    }
+    if (strncmp(cursor, "STACK CFI ", 10) != 0)
+      ++line_number_;
+    else if (!ParseRecord(cursor, record_length))
+      return false;
+    cursor += record_length;
+  }
+  return true;
+}
+
+bool BasicSourceLineResolver::Module::FindLine(Function *function,
+                                               MemAddr address,
+                                               Line *line) const {
+  if (!parse_lazily_) {
+    linked_ptr<Line> stored_line;
+    if (!function->lines.RetrieveRange(address, &stored_line, NULL, NULL))
+      return false;
+    *line = *stored_line;
+    return true;
+  }
+
+  // Parse the function's line records into its map the first time any of
+  // them is needed, and look lines up there from then on.  Lines are
+  // parsed here without being checked at load time, so skip any malformed
+  // ones rather than failing.
+  ScopedMutexLock lock(&cache_lock_);
+  if (function->line_records) {
+    const char *cursor = function->line_records;
+    const char *end = function->line_records_end;
+    while (cursor < end) {
+      size_t record_length = strcspn(cursor, "\r\n");
+      if (record_length == 0) {
+        ++cursor;
+        continue;
       }
-      Line *line = ParseLine(buffer);
-      if (!line) {
-        BPLOG(ERROR) << "ParseLine failed at " << line_number << " for " <<
-            buffer;
-        return false;
+      const char *record = cursor;
+      cursor += record_length;
+      if (!IsLineRecord(record))
+        continue;
+      Line *parsed_line = ParseLine(record, cursor);
+      if (parsed_line) {
+        function->lines.StoreRange(parsed_line->address, parsed_line->size,
+                                   linked_ptr<Line>(parsed_line));
       }
-      cur_func->lines.StoreRange(line->address, line->size,
-                                 linked_ptr<Line>(line));
     }
-    buffer = strtok_r(NULL, "\r\n", &save_ptr);
+    function->lines.Freeze();
+    function->line_records = function->line_records_end = NULL;
   }
+
+  linked_ptr<Line> stored_line;
+  if (!function->lines.RetrieveRange(address, &stored_line, NULL, NULL))
+    return false;
+  *line = *stored_line;
   return true;
 }
 
-void BasicSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
+CFIFrameInfo *BasicSourceLineResolver::Module::FindCFIFrameInfoInRecords(
+    MemAddr address) const {
+  const char *init_record;
+  MemAddr initial_base;
+  if (!cfi_init_records_.RetrieveRange(address, &init_record,
+                                       &initial_base, NULL)) {
+    return NULL;
+  }
+
+  // The delta records for the INIT record's range follow it, in order of
+  // increasing address.  Find the end of those that apply at address.
+  const char *init_end = init_record + strcspn(init_record, "\r\n");
+  const char *deltas_end = init_end;
+  MemAddr cache_key = initial_base;
+  const char *cursor = init_end;
+  while (true) {
+    cursor += strspn(cursor, "\r\n");
+    if (strncmp(cursor, "STACK CFI ", 10) != 0 ||
+        strncmp(cursor, "STACK CFI INIT ", 15) == 0) {
+      break;
+    }
+    const char *record_end = cursor + strcspn(cursor, "\r\n");
+    MemAddr delta_address;
+    const char *rules;
+    if (!ParseHexField(cursor + 10, record_end, &delta_address, &rules) ||
+        delta_address > address) {
+      break;
+    }
+    cache_key = delta_address;
+    deltas_end = cursor = record_end;
+  }
+
+  // If these rules have been assembled before, reuse them.
+  CFIFrameInfo *cached = FindCachedCFIFrameInfo(cache_key);
+  if (cached)
+    return cached;
+
+  // STACK CFI INIT <address> <size> <rules...>
+  MemAddr initial_size;
+  const char *initial_rules;
+  if (!ParseHexField(init_record + 15, init_end, &initial_base,
+                     &initial_rules) ||
+      !ParseHexField(initial_rules, init_end, &initial_size,
+                     &initial_rules)) {
+    return NULL;
+  }
+  initial_rules += strspn(initial_rules, " ");
+  scoped_ptr<CFIFrameInfo> rules(new CFIFrameInfo());
+  if (!ParseCFIRuleSet(string(initial_rules, init_end), rules.get()))
+    return NULL;
+
+  // STACK CFI <address> <rules...>
+  cursor = init_end;
+  while (cursor < deltas_end) {
+    cursor += strspn(cursor, "\r\n");
+    const char *record_end = cursor + strcspn(cursor, "\r\n");
+    MemAddr delta_address;
+    const char *delta_rules;
+    if (ParseHexField(cursor + 10, record_end, &delta_address, &delta_rules)) {
+      delta_rules += strspn(delta_rules, " ");
+      ParseCFIRuleSet(string(delta_rules, record_end), rules.get());
+    }
+    cursor = record_end;
+  }
+
+  return CacheCFIFrameInfo(cache_key, rules.release());
+}
+
+int BasicSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
   MemAddr address = frame->instruction - frame->module->base_address();
+  int filled = SourceLineLookupCache::FIELD_NONE;
 
   // First, look for a FUNC record that covers address. Use
   // RetrieveNearestRange instead of RetrieveRange so that, if there
@@ -165,23 +579,27 @@ void BasicSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
       address >= function_base && address - function_base < function_size) {
     frame->function_name = func->name;
     frame->function_base = frame->module->base_address() + function_base;
+    filled |= SourceLineLookupCache::FIELD_FUNCTION;
 
-    linked_ptr<Line> line;
-    MemAddr line_base;
-    if (func->lines.RetrieveRange(address, &line, &line_base, NULL)) {
-      FileMap::const_iterator it = files_.find(line->source_file_id);
+    Line line;
+    if (FindLine(func.get(), address, &line)) {
+      FileMap::const_iterator it = files_.find(line.source_file_id);
       if (it != files_.end()) {
-        frame->source_file_name = files_.find(line->source_file_id)->second;
+        frame->source_file_name = it->second;
+        filled |= SourceLineLookupCache::FIELD_SOURCE_FILE_NAME;
       }
-      frame->source_line = line->line;
-      frame->source_line_base = frame->module->base_address() + line_base;
+      frame->source_line = line.line;
+      frame->source_line_base = frame->module->base_address() + line.address;
+      filled |= SourceLineLookupCache::FIELD_SOURCE_LINE;
     }
   } else if (public_symbols_.Retrieve(address,
                                       &public_symbol, &public_address) &&
              (!func.get() || public_address > function_base)) {
     frame->function_name = public_symbol->name;
     frame->function_base = frame->module->base_address() + public_address;
+    filled |= SourceLineLookupCache::FIELD_FUNCTION;
   }
+  return filled;
 }
 
 WindowsFrameInfo *BasicSourceLineResolver::Module::FindWindowsFrameInfo(
@@ -200,6 +618,10 @@ WindowsFrameInfo *BasicSourceLineResolver::Module::FindWindowsFrameInfo(
        .RetrieveRange(address, &frame_info))
       || (windows_frame_info_[WindowsFrameInfo::STACK_INFO_FPO]
           .RetrieveRange(address, &frame_info))) {
+    // Compile the record's program string the first time it is used, so
+    // that the copy handed out carries the compiled form.
+    ScopedMutexLock lock(&cache_lock_);
+    frame_info->CompileProgramString();
     result->CopyFrom(*frame_info.get());
     return result.release();
   }
@@ -236,6 +658,9 @@ WindowsFrameInfo *BasicSourceLineResolver::Module::FindWindowsFrameInfo(
 CFIFrameInfo *BasicSourceLineResolver::Module::FindCFIFrameInfo(
     const StackFrame *frame) const {
   MemAddr address = frame->instruction - frame->module->base_address();
+  if (cfi_records_indexed_)
+    return FindCFIFrameInfoInRecords(address);
+
   MemAddr initial_base, initial_size;
   string initial_rules;
 
@@ -248,31 +673,44 @@ CFIFrameInfo *BasicSourceLineResolver::Module::FindCFIFrameInfo(
     return NULL;
   }
 
+  // Find the first delta rule that falls within the initial rule's range,
+  // and the end of the delta rules that apply at the frame's address.
+  map<MemAddr, string>::const_iterator first_delta =
+    cfi_delta_rules_.lower_bound(initial_base);
+  map<MemAddr, string>::const_iterator end_delta = first_delta;
+  MemAddr cache_key = initial_base;
+  while (end_delta != cfi_delta_rules_.end() && end_delta->first <= address) {
+    cache_key = end_delta->first;
+    end_delta++;
+  }
+
+  // If these rules have been assembled before, reuse them.
+  CFIFrameInfo *cached = FindCachedCFIFrameInfo(cache_key);
+  if (cached)
+    return cached;
+
   // Create a frame info structure, and populate it with the rules from
   // the STACK CFI INIT record.
   scoped_ptr<CFIFrameInfo> rules(new CFIFrameInfo());
   if (!ParseCFIRuleSet(initial_rules, rules.get()))
     return NULL;
 
-  // Find the first delta rule that falls within the initial rule's range.
-  map<MemAddr, string>::const_iterator delta =
-    cfi_delta_rules_.lower_bound(initial_base);
-
   // Apply delta rules up to and including the frame's address.
-  while (delta != cfi_delta_rules_.end() && delta->first <= address) {
+  for (map<MemAddr, string>::const_iterator delta = first_delta;
+       delta != end_delta; delta++) {
     ParseCFIRuleSet(delta->second, rules.get());
-    delta++;
   }
 
-  return rules.release();
+  return CacheCFIFrameInfo(cache_key, rules.release());
 }
 
-bool BasicSourceLineResolver::Module::ParseFile(char *file_line) {
+bool BasicSourceLineResolver::Module::ParseFile(const char *file_line,
+                                                const char *file_line_end) {
   // FILE <id> <filename>
   file_line += 5;  // skip prefix
 
-  vector<char*> tokens;
-  if (!Tokenize(file_line, kWhitespace, 2, &tokens)) {
+  vector<const char*> tokens;
+  if (!TokenizeRecord(file_line, file_line_end, 2, &tokens)) {
     return false;
   }
 
@@ -281,38 +719,34 @@ bool BasicSourceLineResolver::Module::ParseFile(char *file_line) {
     return false;
   }
 
-  char *filename = tokens[1];
-  if (!filename) {
-    return false;
-  }
-
-  files_.insert(make_pair(index, string(filename)));
+  files_.insert(make_pair(index, string(tokens[1], file_line_end)));
   return true;
 }
 
 BasicSourceLineResolver::Function*
-BasicSourceLineResolver::Module::ParseFunction(char *function_line) {
+BasicSourceLineResolver::Module::ParseFunction(const char *function_line,
+                                               const char *function_line_end) {
   // FUNC <address> <size> <stack_param_size> <name>
   function_line += 5;  // skip prefix
 
-  vector<char*> tokens;
-  if (!Tokenize(function_line, kWhitespace, 4, &tokens)) {
+  vector<const char*> tokens;
+  if (!TokenizeRecord(function_line, function_line_end, 4, &tokens)) {
     return NULL;
   }
 
   u_int64_t address    = strtoull(tokens[0], NULL, 16);
   u_int64_t size       = strtoull(tokens[1], NULL, 16);
   int stack_param_size = strtoull(tokens[2], NULL, 16);
-  char *name           = tokens[3];
+  string name(tokens[3], function_line_end);
 
   return new Function(name, address, size, stack_param_size);
 }
 
 BasicSourceLineResolver::Line* BasicSourceLineResolver::Module::ParseLine(
-    char *line_line) {
+    const char *line_line, const char *line_line_end) const {
   // <address> <line number> <source file id>
-  vector<char*> tokens;
-  if (!Tokenize(line_line, kWhitespace, 4, &tokens)) {
+  vector<const char*> tokens;
+  if (!TokenizeRecord(line_line, line_line_end, 4, &tokens)) {
     return NULL;
   }
 
@@ -327,20 +761,21 @@ BasicSourceLineResolver::Line* BasicSourceLineResolver::Module::ParseLine(
   return new Line(address, size, source_file, line_number);
 }
 
-bool BasicSourceLineResolver::Module::ParsePublicSymbol(char *public_line) {
+bool BasicSourceLineResolver::Module::ParsePublicSymbol(
+    const char *public_line, const char *public_line_end) {
   // PUBLIC <address> <stack_param_size> <name>
 
   // Skip "PUBLIC " prefix.
   public_line += 7;
 
-  vector<char*> tokens;
-  if (!Tokenize(public_line, kWhitespace, 3, &tokens)) {
+  vector<const char*> tokens;
+  if (!TokenizeRecord(public_line, public_line_end, 3, &tokens)) {
     return false;
   }
 
   u_int64_t address    = strtoull(tokens[0], NULL, 16);
   int stack_param_size = strtoull(tokens[1], NULL, 16);
-  char *name           = tokens[2];
+  string name(tokens[2], public_line_end);
 
   // A few public symbols show up with an address of 0.  This has been seen
   // in the dumped output of ntdll.pdb for symbols such as _CIlog, _CIpow,
@@ -357,28 +792,29 @@ bool BasicSourceLineResolver::Module::ParsePublicSymbol(char *public_line) {
   return public_symbols_.Store(address, symbol);
 }
 
-bool BasicSourceLineResolver::Module::ParseStackInfo(char *stack_info_line) {
+bool BasicSourceLineResolver::Module::ParseStackInfo(
+    const char *stack_info_line, const char *stack_info_line_end) {
   // Skip "STACK " prefix.
   stack_info_line += 6;
 
   // Find the token indicating what sort of stack frame walking
   // information this is.
-  while (*stack_info_line == ' ')
-    stack_info_line++;
-  const char *platform = stack_info_line;
-  while (!strchr(kWhitespace, *stack_info_line))
-    stack_info_line++;
-  *stack_info_line++ = '\0';
+  vector<const char*> tokens;
+  if (!TokenizeRecord(stack_info_line, stack_info_line_end, 2, &tokens))
+    return false;
+  const char *platform = tokens[0];
+  const char *platform_end = tokens[1];
+  while (platform_end > platform && platform_end[-1] == ' ')
+    --platform_end;
+  string platform_name(platform, platform_end);
 
   // MSVC stack frame info.
-  if (strcmp(platform, "WIN") == 0) {
+  if (platform_name == "WIN") {
     int type = 0;
     u_int64_t rva, code_size;
     linked_ptr<WindowsFrameInfo>
-      stack_frame_info(WindowsFrameInfo::ParseFromString(stack_info_line,
-                                                         type,
-                                                         rva,
-                                                         code_size));
+      stack_frame_info(WindowsFrameInfo::ParseFromString(
+          string(tokens[1], stack_info_line_end), type, rva, code_size));
     if (stack_frame_info == NULL)
       return false;
 
@@ -404,9 +840,9 @@ bool BasicSourceLineResolver::Module::ParseStackInfo(char *stack_info_line) {
 
     windows_frame_info_[type].StoreRange(rva, code_size, stack_frame_info);
     return true;
-  } else if (strcmp(platform, "CFI") == 0) {
+  } else if (platform_name == "CFI") {
     // DWARF CFI stack frame info
-    return ParseCFIFrameInfo(stack_info_line);
+    return ParseCFIFrameInfo(tokens[1], stack_info_line_end);
   } else {
     // Something unrecognized.
     return false;
@@ -414,37 +850,28 @@ bool BasicSourceLineResolver::Module::ParseStackInfo(char *stack_info_line) {
 }
 
 bool BasicSourceLineResolver::Module::ParseCFIFrameInfo(
-    char *stack_info_line) {
-  char *cursor;
-
+    const char *stack_info_line, const char *stack_info_line_end) {
   // Is this an INIT record or a delta record?
-  char *init_or_address = strtok_r(stack_info_line, " \r\n", &cursor);
-  if (!init_or_address)
+  vector<const char*> tokens;
+  if (!TokenizeRecord(stack_info_line, stack_info_line_end, 2, &tokens))
     return false;
 
-  if (strcmp(init_or_address, "INIT") == 0) {
+  if (strncmp(tokens[0], "INIT ", 5) == 0) {
     // This record has the form "STACK INIT <address> <size> <rules...>".
-    char *address_field = strtok_r(NULL, " \r\n", &cursor);
-    if (!address_field) return false;
-
-    char *size_field = strtok_r(NULL, " \r\n", &cursor);
-    if (!size_field) return false;
-
-    char *initial_rules = strtok_r(NULL, "\r\n", &cursor);
-    if (!initial_rules) return false;
+    const char *init_fields = tokens[1];
+    if (!TokenizeRecord(init_fields, stack_info_line_end, 3, &tokens))
+      return false;
 
-    MemAddr address = strtoul(address_field, NULL, 16);
-    MemAddr size    = strtoul(size_field,    NULL, 16);
-    cfi_initial_rules_.StoreRange(address, size, initial_rules);
+    MemAddr address = strtoul(tokens[0], NULL, 16);
+    MemAddr size    = strtoul(tokens[1], NULL, 16);
+    cfi_initial_rules_.StoreRange(address, size,
+                                  string(tokens[2], stack_info_line_end));
     return true;
   }
 
   // This record has the form "STACK <address> <rules...>".
-  char *address_field = init_or_address;
-  char *delta_rules = strtok_r(NULL, "\r\n", &cursor);
-  if (!delta_rules) return false;
-  MemAddr address = strtoul(address_field, NULL, 16);
-  cfi_delta_rules_[address] = delta_rules;
+  MemAddr address = strtoul(tokens[0], NULL, 16);
+  cfi_delta_rules_[address] = string(tokens[1], stack_info_line_end);
   return true;
 }
 
@@ -39,6 +39,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "google_breakpad/processor/basic_source_line_resolver.h"
 #include "processor/source_line_resolver_base_types.h"
@@ -64,8 +65,18 @@ BasicSourceLineResolver::Function : public SourceLineResolverBase::Function {
                                           function_address,
                                           code_size,
                                           set_parameter_size),
-                                     lines() { }
+                                     lines(),
+                                     line_records(NULL),
+                                     line_records_end(NULL) { }
   RangeMap< MemAddr, linked_ptr<Line> > lines;
+
+  // In a lazily parsed module, lines stays empty until FindLine first
+  // needs it.  Until then, these delimit the text of the function's line
+  // records in the symbol file; they are NULL once the records have been
+  // parsed into lines, or if there are none.  Both are only touched while
+  // holding the module's cache_lock_.
+  const char *line_records;
+  const char *line_records_end;
  private:
   typedef SourceLineResolverBase::Function Base;
 };
@@ -73,16 +84,38 @@ BasicSourceLineResolver::Function : public SourceLineResolverBase::Function {
 
 class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
  public:
-  explicit Module(const string &name) : name_(name) { }
+  // If parse_lazily is true, LoadMapFromMemory only indexes the symbol
+  // file, and lookups parse the parts of it they need; see
+  // BasicSourceLineResolver.
+  explicit Module(const string &name, bool parse_lazily = false)
+      : name_(name), symbol_data_size_(0), cur_func_(), line_number_(0),
+        partial_record_(), parse_lazily_(parse_lazily), text_(),
+        cfi_records_indexed_(parse_lazily), cfi_index_open_(false),
+        cfi_index_next_(0), cfi_index_end_(0) { }
   virtual ~Module() { }
 
   // Loads a map from the given buffer in char* type.
-  // Does NOT have ownership of memory_buffer.
+  // Does NOT have ownership of memory_buffer, and does not modify it, so
+  // memory_buffer may be a read-only mapping.  A lazily parsed module
+  // refers to memory_buffer for as long as it exists.
   virtual bool LoadMapFromMemory(char *memory_buffer);
 
+  // Incremental loading.  ParseChunk parses each complete record in the
+  // size bytes at data, and holds on to any incomplete record at the end
+  // until the next call supplies the rest of it.  FinishParsing parses that
+  // final record, if any, and prepares the module for lookups.  Calling
+  // ParseChunk on successive pieces of a symbol file and then FinishParsing
+  // loads the same module as LoadMapFromMemory does on the whole file.
+  // Both return false if a record is malformed, after which the module
+  // should be discarded.  A lazily parsed module instead collects the
+  // pieces in text_, which FinishParsing indexes as LoadMapFromMemory
+  // would, so malformed records are only reported then.
+  bool ParseChunk(const char *data, size_t size);
+  bool FinishParsing();
+
   // Looks up the given relative address, and fills the StackFrame struct
   // with the result.
-  virtual void LookupAddress(StackFrame *frame) const;
+  virtual int LookupAddress(StackFrame *frame) const;
 
   // If Windows stack walking information is available covering ADDRESS,
   // return a WindowsFrameInfo structure describing it. If the information
@@ -97,6 +130,8 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   // returned CFIFrameInfo object.
   virtual CFIFrameInfo *FindCFIFrameInfo(const StackFrame *frame) const;
 
+  virtual size_t SymbolDataSize() const { return symbol_data_size_; }
+
  private:
   // Friend declarations.
   friend class BasicSourceLineResolver;
@@ -105,25 +140,62 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
 
   typedef std::map<int, string> FileMap;
 
+  // Parses the length-byte record at record, of any type, without
+  // modifying it.  The record need not be NUL-terminated, but must be
+  // followed by a CR, LF or NUL.  Line records are added to cur_func_.
+  bool ParseRecord(const char *record, size_t length);
+
+  // In a lazily parsed module, notes where the length-byte record at record
+  // is, if it is a line record or a STACK CFI record, and returns true.
+  // Returns false for records that must be parsed right away.  Clears
+  // cfi_records_indexed_ if the STACK CFI records aren't laid out as
+  // FindCFIFrameInfoInRecords expects.
+  bool IndexRecord(const char *record, size_t length);
+
+  // Parses every STACK CFI record in the NUL-terminated symbol file text at
+  // buffer, as an eagerly parsed module does.  Used in place of the index
+  // when cfi_records_indexed_ is false.
+  bool ParseCFIRecords(const char *buffer);
+
+  // Sets line to the line record covering address within function, and
+  // returns true, or returns false if there is none.  In a lazily parsed
+  // module, parses function's line records first if that hasn't been done.
+  bool FindLine(Function *function, MemAddr address, Line *line) const;
+
+  // FindCFIFrameInfo for lazily parsed modules, which parses the STACK CFI
+  // records covering address from the symbol file text.
+  CFIFrameInfo *FindCFIFrameInfoInRecords(MemAddr address) const;
+
+  // Builds the lookup indices of the module's maps once parsing is done.
+  void FreezeMaps();
+
+  // The record parsers below each take a record, as ParseRecord does, and
+  // the end of its text.
+
   // Parses a file declaration
-  bool ParseFile(char *file_line);
+  bool ParseFile(const char *file_line, const char *file_line_end);
 
   // Parses a function declaration, returning a new Function object.
-  Function* ParseFunction(char *function_line);
+  Function* ParseFunction(const char *function_line,
+                          const char *function_line_end);
 
   // Parses a line declaration, returning a new Line object.
-  Line* ParseLine(char *line_line);
+  Line* ParseLine(const char *line_line, const char *line_line_end) const;
 
   // Parses a PUBLIC symbol declaration, storing it in public_symbols_.
   // Returns false if an error occurs.
-  bool ParsePublicSymbol(char *public_line);
+  bool ParsePublicSymbol(const char *public_line,
+                         const char *public_line_end);
 
   // Parses a STACK WIN or STACK CFI frame info declaration, storing
   // it in the appropriate table.
-  bool ParseStackInfo(char *stack_info_line);
+  bool ParseStackInfo(const char *stack_info_line,
+                      const char *stack_info_line_end);
 
-  // Parses a STACK CFI record, storing it in cfi_frame_info_.
-  bool ParseCFIFrameInfo(char *stack_info_line);
+  // Parses a STACK CFI record, following the "STACK CFI " prefix,
+  // storing it in cfi_frame_info_.
+  bool ParseCFIFrameInfo(const char *stack_info_line,
+                         const char *stack_info_line_end);
 
   string name_;
   FileMap files_;
@@ -154,6 +226,41 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   // this map, or the end of the range as given by the cfi_initial_rules_
   // entry (which FindCFIFrameInfo looks up first).
   std::map<MemAddr, string> cfi_delta_rules_;
+
+  // In a lazily parsed module, cfi_initial_rules_ and cfi_delta_rules_
+  // stay empty.  Instead, this maps each STACK CFI INIT record's range to
+  // the record's text, which its delta records follow.
+  RangeMap<MemAddr, const char *> cfi_init_records_;
+
+  // The length of the text LoadMapFromMemory or ParseChunk parsed.
+  size_t symbol_data_size_;
+
+  // Parsing state.  cur_func_ is the function that the line records being
+  // parsed belong to, line_number_ counts the records parsed so far, for
+  // error messages, and partial_record_ holds the incomplete record at the
+  // end of the last chunk passed to ParseChunk.
+  linked_ptr<Function> cur_func_;
+  int line_number_;
+  std::vector<char> partial_record_;
+
+  // True if LoadMapFromMemory only indexes the symbol file.
+  bool parse_lazily_;
+
+  // The symbol file text that a lazily parsed module loaded by ParseChunk
+  // refers to, NUL-terminated once FinishParsing has been called.
+  std::vector<char> text_;
+
+  // FindCFIFrameInfoInRecords expects each STACK CFI INIT record to be
+  // followed directly by its delta records, in increasing address order and
+  // within the INIT record's range.  cfi_records_indexed_ is true if
+  // cfi_init_records_ is in use, and stays so while the records indexed so
+  // far meet that expectation.  cfi_index_open_ is true if the last record
+  // indexed was an INIT record or one of its deltas, in which case the next
+  // delta record must fall in [cfi_index_next_, cfi_index_end_).
+  bool cfi_records_indexed_;
+  bool cfi_index_open_;
+  MemAddr cfi_index_next_;
+  MemAddr cfi_index_end_;
 };
 
 }  // namespace google_breakpad
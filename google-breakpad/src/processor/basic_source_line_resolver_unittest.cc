@@ -27,9 +27,16 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <pthread.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "breakpad_googletest_includes.h"
 #include "google_breakpad/processor/basic_source_line_resolver.h"
@@ -39,27 +46,32 @@
 #include "processor/linked_ptr.h"
 #include "processor/logging.h"
 #include "processor/scoped_ptr.h"
+#include "processor/source_line_lookup_cache.h"
 #include "processor/windows_frame_info.h"
 #include "processor/cfi_frame_info.h"
 
 namespace {
 
 using std::string;
+using std::vector;
 using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::CFIFrameInfo;
 using google_breakpad::CodeModule;
 using google_breakpad::MemoryRegion;
+using google_breakpad::SourceLineLookupCache;
 using google_breakpad::StackFrame;
 using google_breakpad::WindowsFrameInfo;
 using google_breakpad::linked_ptr;
+using google_breakpad::scoped_array;
 using google_breakpad::scoped_ptr;
 
 class TestCodeModule : public CodeModule {
  public:
-  TestCodeModule(string code_file) : code_file_(code_file) {}
+  TestCodeModule(string code_file, u_int64_t base_address = 0)
+      : code_file_(code_file), base_address_(base_address) {}
   virtual ~TestCodeModule() {}
 
-  virtual u_int64_t base_address() const { return 0; }
+  virtual u_int64_t base_address() const { return base_address_; }
   virtual u_int64_t size() const { return 0xb000; }
   virtual string code_file() const { return code_file_; }
   virtual string code_identifier() const { return ""; }
@@ -67,11 +79,12 @@ class TestCodeModule : public CodeModule {
   virtual string debug_identifier() const { return ""; }
   virtual string version() const { return ""; }
   virtual const CodeModule* Copy() const {
-    return new TestCodeModule(code_file_);
+    return new TestCodeModule(code_file_, base_address_);
   }
 
  private:
   string code_file_;
+  u_int64_t base_address_;
 };
 
 // A mock memory region object, for use by the STACK CFI tests.
@@ -399,6 +412,475 @@ TEST_F(TestBasicSourceLineResolver, TestUnload)
   ASSERT_TRUE(resolver.HasModule(&module1));
 }
 
+TEST_F(TestBasicSourceLineResolver, TestUnloadLeastRecentlyUsed)
+{
+  struct stat sb;
+  ASSERT_EQ(0, stat((testdata_dir + "/module1.out").c_str(), &sb));
+  size_t module1_size = sb.st_size;
+  ASSERT_EQ(0, stat((testdata_dir + "/module2.out").c_str(), &sb));
+  size_t module2_size = sb.st_size;
+
+  TestCodeModule module1("module1");
+  TestCodeModule module2("module2");
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  ASSERT_TRUE(resolver.LoadModule(&module2, testdata_dir + "/module2.out"));
+  ASSERT_EQ(module1_size + module2_size, resolver.LoadedSymbolDataSize());
+
+  // Looking up an address in module1 makes module2 the least recently used.
+  StackFrame frame;
+  frame.instruction = 0x1000;
+  frame.module = &module1;
+  resolver.FillSourceLineInfo(&frame);
+
+  vector<string> unloaded;
+  resolver.UnloadLeastRecentlyUsedModules(module1_size + module2_size,
+                                          &unloaded);
+  ASSERT_TRUE(unloaded.empty());
+  resolver.UnloadLeastRecentlyUsedModules(module1_size, &unloaded);
+  ASSERT_EQ(1U, unloaded.size());
+  ASSERT_EQ("module2", unloaded[0]);
+  ASSERT_TRUE(resolver.HasModule(&module1));
+  ASSERT_FALSE(resolver.HasModule(&module2));
+  ASSERT_EQ(module1_size, resolver.LoadedSymbolDataSize());
+
+  resolver.UnloadLeastRecentlyUsedModules(0, NULL);
+  ASSERT_FALSE(resolver.HasModule(&module1));
+  ASSERT_EQ(0U, resolver.LoadedSymbolDataSize());
+}
+
+TEST_F(TestBasicSourceLineResolver, TestLookupCache)
+{
+  BasicSourceLineResolver uncached;
+  uncached.set_lookup_cache_capacity(0);
+  // A small cache, so that results are replaced as well as reused.
+  resolver.set_lookup_cache_capacity(16);
+
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  ASSERT_TRUE(uncached.LoadModule(&module1, testdata_dir + "/module1.out"));
+  // The same module, loaded elsewhere in another process.
+  TestCodeModule relocated("module1", 0x40000000);
+
+  u_int64_t lookups = 0;
+  for (int pass = 0; pass < 2; ++pass) {
+    for (u_int64_t offset = 0; offset < 0xb000; offset += 0x40) {
+      for (int relocate = 0; relocate < 2; ++relocate) {
+        const CodeModule *module = relocate ? &relocated : &module1;
+        StackFrame expected;
+        expected.instruction = module->base_address() + offset;
+        expected.module = module;
+        uncached.FillSourceLineInfo(&expected);
+        StackFrame actual;
+        actual.instruction = expected.instruction;
+        actual.module = module;
+        resolver.FillSourceLineInfo(&actual);
+        ++lookups;
+
+        ASSERT_EQ(expected.function_name, actual.function_name);
+        ASSERT_EQ(expected.function_base, actual.function_base);
+        ASSERT_EQ(expected.source_file_name, actual.source_file_name);
+        ASSERT_EQ(expected.source_line, actual.source_line);
+        ASSERT_EQ(expected.source_line_base, actual.source_line_base);
+      }
+    }
+  }
+
+  u_int64_t hits = 0, misses = 0;
+  resolver.GetLookupCacheStats(&hits, &misses);
+  ASSERT_EQ(lookups, hits + misses);
+  u_int64_t uncached_hits = 0, uncached_misses = 0;
+  uncached.GetLookupCacheStats(&uncached_hits, &uncached_misses);
+  ASSERT_EQ(0U, uncached_hits + uncached_misses);
+
+  // Looking the same address up twice hits the second time.
+  StackFrame frame;
+  frame.instruction = 0x1000;
+  frame.module = &module1;
+  resolver.FillSourceLineInfo(&frame);
+  frame = StackFrame();
+  frame.instruction = 0x1000;
+  frame.module = &module1;
+  resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ("Function1_1", frame.function_name);
+  ASSERT_EQ(44, frame.source_line);
+  u_int64_t new_hits = 0, new_misses = 0;
+  resolver.GetLookupCacheStats(&new_hits, &new_misses);
+  ASSERT_EQ(hits + misses + 2, new_hits + new_misses);
+  ASSERT_LT(hits, new_hits);
+
+  // Statistics survive unloading the module.
+  resolver.UnloadModule(&module1);
+  u_int64_t unloaded_hits = 0, unloaded_misses = 0;
+  resolver.GetLookupCacheStats(&unloaded_hits, &unloaded_misses);
+  ASSERT_EQ(new_hits, unloaded_hits);
+  ASSERT_EQ(new_misses, unloaded_misses);
+}
+
+// A function at the very start of a module loaded at address zero has a
+// base of zero, which the cache must still relocate for other processes.
+TEST_F(TestBasicSourceLineResolver, TestLookupCacheZeroBase)
+{
+  string symbol_data("FILE 0 zero.cc\n"
+                     "FUNC 0 10 0 AtZero\n"
+                     "0 10 7 0\n");
+  TestCodeModule module("zero");
+  ASSERT_TRUE(resolver.LoadModuleUsingMemoryBuffer(&module, &symbol_data[0]));
+  TestCodeModule relocated("zero", 0x40000000);
+
+  StackFrame frame;
+  frame.instruction = 0x4;
+  frame.module = &module;
+  resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ("AtZero", frame.function_name);
+  ASSERT_EQ(0U, frame.function_base);
+  ASSERT_EQ(0U, frame.source_line_base);
+
+  frame = StackFrame();
+  frame.instruction = 0x40000004;
+  frame.module = &relocated;
+  resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ("AtZero", frame.function_name);
+  ASSERT_EQ(0x40000000U, frame.function_base);
+  ASSERT_EQ("zero.cc", frame.source_file_name);
+  ASSERT_EQ(7, frame.source_line);
+  ASSERT_EQ(0x40000000U, frame.source_line_base);
+
+  u_int64_t hits = 0, misses = 0;
+  resolver.GetLookupCacheStats(&hits, &misses);
+  ASSERT_EQ(1U, hits);
+}
+
+// Names of results that have been replaced must not pile up.
+TEST_F(TestBasicSourceLineResolver, TestLookupCacheNameStorage)
+{
+  SourceLineLookupCache cache(16);
+  TestCodeModule module("names");
+  for (int index = 0; index < 100000; ++index) {
+    StackFrame frame;
+    frame.instruction = index;
+    frame.module = &module;
+    char name[100];
+    snprintf(name, sizeof(name), "Function%064d", index);
+    frame.function_name = name;
+    frame.source_file_name = string(name) + ".cc";
+    cache.Store(frame, SourceLineLookupCache::FIELD_FUNCTION |
+                       SourceLineLookupCache::FIELD_SOURCE_FILE_NAME);
+  }
+  ASSERT_GT(64U * 1024, cache.name_bytes());
+
+  // The most recently stored results are still intact.
+  StackFrame frame;
+  frame.instruction = 99999;
+  frame.module = &module;
+  ASSERT_TRUE(cache.Lookup(&frame));
+  char name[100];
+  snprintf(name, sizeof(name), "Function%064d", 99999);
+  ASSERT_EQ(name, frame.function_name);
+  ASSERT_EQ(string(name) + ".cc", frame.source_file_name);
+  ASSERT_EQ(0, frame.source_line);
+}
+
+// Loading from a read-only buffer, as SimpleSymbolSupplier hands out when
+// set_map_symbol_files(true) is in effect, must not write to it.
+TEST_F(TestBasicSourceLineResolver, TestLoadFromReadOnlyBuffer)
+{
+  char *symbol_data;
+  ASSERT_TRUE(BasicSourceLineResolver::ReadSymbolFile(
+      &symbol_data, testdata_dir + "/module1.out"));
+  size_t data_size = strlen(symbol_data) + 1;
+  size_t page_size = getpagesize();
+  size_t buffer_size = (data_size + page_size - 1) & ~(page_size - 1);
+  void *buffer = mmap(NULL, buffer_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANON, -1, 0);
+  ASSERT_NE(MAP_FAILED, buffer);
+  memcpy(buffer, symbol_data, data_size);
+  delete [] symbol_data;
+  ASSERT_EQ(0, mprotect(buffer, buffer_size, PROT_READ));
+
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(resolver.LoadModuleUsingMemoryBuffer(
+      &module1, static_cast<char *>(buffer)));
+  ASSERT_TRUE(resolver.ShouldDeleteMemoryBufferAfterLoadModule());
+  munmap(buffer, buffer_size);
+
+  StackFrame frame;
+  frame.instruction = 0x1000;
+  frame.module = &module1;
+  resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ(frame.function_name, "Function1_1");
+  ASSERT_EQ(frame.source_file_name, "file1_1.cc");
+  ASSERT_EQ(frame.source_line, 44);
+}
+
+// Check that every address below limit in module resolves identically in
+// expected_resolver and resolver.
+static void ExpectSameLookups(BasicSourceLineResolver *expected_resolver,
+                              BasicSourceLineResolver *resolver,
+                              const CodeModule *module, u_int64_t limit) {
+  for (u_int64_t address = 0; address < limit; address++) {
+    StackFrame expected;
+    expected.instruction = module->base_address() + address;
+    expected.module = module;
+    expected_resolver->FillSourceLineInfo(&expected);
+    scoped_ptr<CFIFrameInfo> expected_cfi(
+        expected_resolver->FindCFIFrameInfo(&expected));
+    scoped_ptr<WindowsFrameInfo> expected_windows(
+        expected_resolver->FindWindowsFrameInfo(&expected));
+
+    StackFrame frame;
+    frame.instruction = module->base_address() + address;
+    frame.module = module;
+    resolver->FillSourceLineInfo(&frame);
+    scoped_ptr<CFIFrameInfo> cfi(resolver->FindCFIFrameInfo(&frame));
+    scoped_ptr<WindowsFrameInfo> windows(resolver->FindWindowsFrameInfo(&frame));
+
+    ASSERT_EQ(expected.function_name, frame.function_name);
+    ASSERT_EQ(expected.function_base, frame.function_base);
+    ASSERT_EQ(expected.source_file_name, frame.source_file_name);
+    ASSERT_EQ(expected.source_line, frame.source_line);
+    ASSERT_EQ(expected.source_line_base, frame.source_line_base);
+    ASSERT_EQ(expected_cfi.get() != NULL, cfi.get() != NULL);
+    if (cfi.get()) {
+      ASSERT_EQ(expected_cfi->Serialize(), cfi->Serialize());
+    }
+    ASSERT_EQ(expected_windows.get() != NULL, windows.get() != NULL);
+    if (windows.get()) {
+      ASSERT_EQ(expected_windows->parameter_size, windows->parameter_size);
+    }
+  }
+}
+
+// Loading a symbol file piece by piece must produce the same module as
+// loading it in one go, however the pieces split its records.
+TEST_F(TestBasicSourceLineResolver, TestIncrementalLoad)
+{
+  char *symbol_data;
+  ASSERT_TRUE(BasicSourceLineResolver::ReadSymbolFile(
+      &symbol_data, testdata_dir + "/module1.out"));
+  scoped_array<char> symbol_data_owner(symbol_data);
+  size_t symbol_size = strlen(symbol_data);
+
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+
+  const size_t kChunkSizes[] = { 1, 7, 100, symbol_size };
+  for (size_t i = 0; i < sizeof(kChunkSizes) / sizeof(kChunkSizes[0]); i++) {
+    BasicSourceLineResolver incremental;
+    scoped_ptr<BasicSourceLineResolver::ModuleLoader> loader(
+        incremental.StartModuleLoad(&module1));
+    ASSERT_TRUE(loader.get());
+    for (size_t offset = 0; offset < symbol_size; offset += kChunkSizes[i]) {
+      size_t size = std::min(kChunkSizes[i], symbol_size - offset);
+      ASSERT_TRUE(loader->Append(symbol_data + offset, size));
+    }
+    ASSERT_TRUE(loader->Finish());
+    ASSERT_TRUE(incremental.HasModule(&module1));
+    ASSERT_EQ(resolver.LoadedSymbolDataSize(),
+              incremental.LoadedSymbolDataSize());
+    ASSERT_FALSE(incremental.StartModuleLoad(&module1));
+
+    ExpectSameLookups(&resolver, &incremental, &module1, 0x4000);
+  }
+}
+
+// A lazily parsing resolver loads a module piece by piece into the same
+// state as it loads it in one go, and keeps the text it indexes.
+TEST_F(TestBasicSourceLineResolver, TestIncrementalLazyLoad)
+{
+  char *symbol_data;
+  ASSERT_TRUE(BasicSourceLineResolver::ReadSymbolFile(
+      &symbol_data, testdata_dir + "/module1.out"));
+  size_t symbol_size = strlen(symbol_data);
+
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+
+  BasicSourceLineResolver lazy(true);
+  scoped_ptr<BasicSourceLineResolver::ModuleLoader> loader(
+      lazy.StartModuleLoad(&module1));
+  ASSERT_TRUE(loader.get());
+  for (size_t offset = 0; offset < symbol_size; offset += 7) {
+    size_t size = std::min(static_cast<size_t>(7), symbol_size - offset);
+    ASSERT_TRUE(loader->Append(symbol_data + offset, size));
+  }
+  // The module must not refer to the caller's pieces once loaded.
+  memset(symbol_data, 0, symbol_size);
+  delete [] symbol_data;
+  ASSERT_TRUE(loader->Finish());
+  ASSERT_TRUE(lazy.HasModule(&module1));
+  ASSERT_EQ(resolver.LoadedSymbolDataSize(), lazy.LoadedSymbolDataSize());
+
+  ExpectSameLookups(&resolver, &lazy, &module1, 0x4000);
+
+  // Malformed symbol files are rejected when the load finishes.
+  TestCodeModule module3("module3");
+  ASSERT_TRUE(BasicSourceLineResolver::ReadSymbolFile(
+      &symbol_data, testdata_dir + "/module3_bad.out"));
+  scoped_array<char> bad_data_owner(symbol_data);
+  loader.reset(lazy.StartModuleLoad(&module3));
+  ASSERT_TRUE(loader.get());
+  ASSERT_TRUE(loader->Append(symbol_data, strlen(symbol_data)));
+  ASSERT_FALSE(loader->Finish());
+  ASSERT_FALSE(lazy.HasModule(&module3));
+}
+
+TEST_F(TestBasicSourceLineResolver, TestIncrementalLoadFailures)
+{
+  TestCodeModule module3("module3");
+  char *symbol_data;
+  ASSERT_TRUE(BasicSourceLineResolver::ReadSymbolFile(
+      &symbol_data, testdata_dir + "/module3_bad.out"));
+  scoped_array<char> symbol_data_owner(symbol_data);
+
+  // A malformed record fails the load, whether it is detected while
+  // appending or while finishing.
+  scoped_ptr<BasicSourceLineResolver::ModuleLoader> loader(
+      resolver.StartModuleLoad(&module3));
+  ASSERT_TRUE(loader.get());
+  bool appended = loader->Append(symbol_data, strlen(symbol_data));
+  ASSERT_FALSE(appended && loader->Finish());
+  ASSERT_FALSE(loader->Finish());
+  ASSERT_FALSE(resolver.HasModule(&module3));
+
+  // Deleting an unfinished loader abandons the load, after which the module
+  // can be loaded afresh.
+  TestCodeModule module1("module1");
+  loader.reset(resolver.StartModuleLoad(&module1));
+  ASSERT_TRUE(loader.get());
+  ASSERT_TRUE(loader->Append("FILE 1 file1_1.cc\n", 18));
+  loader.reset();
+  ASSERT_FALSE(resolver.HasModule(&module1));
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+}
+
+// A lazily parsed module must resolve every address as a fully parsed one
+// does.
+TEST_F(TestBasicSourceLineResolver, TestLazyParsing)
+{
+  BasicSourceLineResolver lazy(true);
+  ASSERT_FALSE(lazy.ShouldDeleteMemoryBufferAfterLoadModule());
+
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  ASSERT_TRUE(lazy.LoadModule(&module1, testdata_dir + "/module1.out"));
+  ExpectSameLookups(&resolver, &lazy, &module1, 0x4000);
+
+  TestCodeModule module2("module2");
+  ASSERT_TRUE(resolver.LoadModule(&module2, testdata_dir + "/module2.out"));
+  ASSERT_TRUE(lazy.LoadModule(&module2, testdata_dir + "/module2.out"));
+  ExpectSameLookups(&resolver, &lazy, &module2, 0x4000);
+
+  // Malformed symbol files are still rejected.
+  TestCodeModule module3("module3");
+  ASSERT_FALSE(lazy.LoadModule(&module3, testdata_dir + "/module3_bad.out"));
+}
+
+// STACK CFI delta records that don't directly follow their INIT record in
+// address order can't be found from it, so a lazily parsed module must
+// parse them as a fully parsed one would.
+TEST_F(TestBasicSourceLineResolver, TestLazyParsingScatteredCFI)
+{
+  const char kSymbols[] =
+      "FILE 0 scattered.cc\n"
+      "FUNC 1000 100 0 Scattered1\n"
+      "1000 10 11 0\n"
+      "1010 f0 12 0\n"
+      "STACK CFI INIT 1000 100 .cfa: $esp 4 + .ra: .cfa 4 - ^\n"
+      "STACK CFI INIT 2000 100 .cfa: $esp 4 + .ra: .cfa 4 - ^\n"
+      "STACK CFI 1004 .cfa: $esp 8 +\n"
+      "STACK CFI 2008 .cfa: $esp 12 +\n"
+      "STACK CFI 2004 .cfa: $esp 8 +\n"
+      "FUNC 2000 100 0 Scattered2\n"
+      "2000 100 21 0\n"
+      "STACK CFI 2010 $ebp: .cfa 8 - ^\n";
+
+  TestCodeModule module("scattered");
+  string eager_data(kSymbols);
+  ASSERT_TRUE(resolver.LoadModuleUsingMemoryBuffer(&module, &eager_data[0]));
+
+  BasicSourceLineResolver lazy(true);
+  string lazy_data(kSymbols);
+  ASSERT_TRUE(lazy.LoadModuleUsingMemoryBuffer(&module, &lazy_data[0]));
+
+  // Twice, so that lines come from the function's map the second time.
+  ExpectSameLookups(&resolver, &lazy, &module, 0x2200);
+  ExpectSameLookups(&resolver, &lazy, &module, 0x2200);
+
+  StackFrame frame;
+  frame.instruction = 0x2010;
+  frame.module = &module;
+  lazy.FillSourceLineInfo(&frame);
+  ASSERT_EQ("Scattered2", frame.function_name);
+  ASSERT_EQ(21, frame.source_line);
+  scoped_ptr<CFIFrameInfo> cfi(lazy.FindCFIFrameInfo(&frame));
+  ASSERT_TRUE(cfi.get());
+  ASSERT_EQ(".cfa: $esp 12 + .ra: .cfa 4 - ^ $ebp: .cfa 8 - ^",
+            cfi->Serialize());
+}
+
+// What each thread in TestConcurrentLoads does and sees.
+struct ConcurrentLoadThread {
+  BasicSourceLineResolver *resolver;
+  const CodeModule *module;
+  const char *symbol_data;
+  bool loaded;
+  string function_name;
+  bool found_cfi;
+};
+
+static void *ConcurrentLoadThreadMain(void *arg) {
+  ConcurrentLoadThread *thread = static_cast<ConcurrentLoadThread *>(arg);
+  // The resolver doesn't keep the buffer, so each thread can use its own.
+  string symbol_data(thread->symbol_data);
+  thread->loaded = thread->resolver->LoadModuleUsingMemoryBuffer(
+      thread->module, &symbol_data[0]);
+
+  StackFrame frame;
+  frame.instruction = 0x3d40;
+  frame.module = thread->module;
+  thread->resolver->FillSourceLineInfo(&frame);
+  thread->function_name = frame.function_name;
+  scoped_ptr<CFIFrameInfo> cfi_frame_info(
+      thread->resolver->FindCFIFrameInfo(&frame));
+  thread->found_cfi = cfi_frame_info.get() != NULL;
+  return NULL;
+}
+
+// Threads that race to load the same module must load it exactly once,
+// and all see its contents afterwards.
+TEST_F(TestBasicSourceLineResolver, TestConcurrentLoads)
+{
+  char *symbol_data;
+  ASSERT_TRUE(BasicSourceLineResolver::ReadSymbolFile(
+      &symbol_data, testdata_dir + "/module1.out"));
+  scoped_array<char> symbol_data_owner(symbol_data);
+
+  TestCodeModule module1("module1");
+  const int kThreadCount = 8;
+  ConcurrentLoadThread threads[kThreadCount];
+  pthread_t thread_ids[kThreadCount];
+  for (int i = 0; i < kThreadCount; i++) {
+    threads[i].resolver = &resolver;
+    threads[i].module = &module1;
+    threads[i].symbol_data = symbol_data;
+    threads[i].loaded = false;
+    threads[i].found_cfi = false;
+    ASSERT_EQ(0, pthread_create(&thread_ids[i], NULL,
+                                ConcurrentLoadThreadMain, &threads[i]));
+  }
+
+  int loads = 0;
+  for (int i = 0; i < kThreadCount; i++) {
+    ASSERT_EQ(0, pthread_join(thread_ids[i], NULL));
+    if (threads[i].loaded)
+      loads++;
+    EXPECT_EQ("LargeFunction", threads[i].function_name);
+    EXPECT_TRUE(threads[i].found_cfi);
+  }
+  EXPECT_EQ(1, loads);
+  EXPECT_TRUE(resolver.HasModule(&module1));
+}
+
 }  // namespace
 
 int main(int argc, char *argv[]) {
@@ -43,15 +43,122 @@
 
 namespace google_breakpad {
 
+// The slot compiled rules use for the CFA.
+static const size_t kCFASlot = 0;
+
+// Evaluate PROGRAM for a value, given register VALUES and VALID. Each
+// rule must see the callee's registers as they were before any other
+// rule ran, so if PROGRAM could assign to its variables, evaluate it on
+// a scratch copy of them.
+template<typename V>
+static bool EvaluateRule(const PostfixProgram &program,
+                         size_t slot_count, V *values, u_int64_t valid,
+                         const MemoryRegion &memory, V *result) {
+  if (!program.assigns())
+    return program.Evaluate(values, &valid, NULL, &memory, result);
+
+  V scratch_values[PostfixProgram::kMaxSlots];
+  memcpy(scratch_values, values, sizeof(V) * slot_count);
+  return program.Evaluate(scratch_values, &valid, NULL, &memory, result);
+}
+
+bool CFIFrameInfo::Compile() {
+  if (shared_)
+    return shared_->compiled_;
+
+  compiled_ = false;
+  slot_names_.clear();
+  slot_names_.push_back(".cfa");
+  register_programs_.clear();
+
+  if (cfa_rule_.empty() || ra_rule_.empty())
+    return false;
+
+  if (!cfa_program_.Compile(cfa_rule_, &slot_names_) ||
+      cfa_program_.final_depth() != 1 ||
+      !ra_program_.Compile(ra_rule_, &slot_names_) ||
+      ra_program_.final_depth() != 1)
+    return false;
+
+  register_programs_.resize(register_rules_.size());
+  size_t i = 0;
+  for (RuleMap::const_iterator it = register_rules_.begin();
+       it != register_rules_.end(); ++it, ++i) {
+    if (!register_programs_[i].Compile(it->second, &slot_names_) ||
+        register_programs_[i].final_depth() != 1)
+      return false;
+  }
+
+  compiled_ = true;
+  return true;
+}
+
+template<typename V>
+bool CFIFrameInfo::FindCallerRegsCompiled(
+    const RegisterValueMap<V> &registers,
+    const MemoryRegion &memory,
+    RegisterValueMap<V> *caller_registers) const {
+  // Gather the callee's values for the registers the rules mention.
+  size_t slot_count = slot_names_.size();
+  V values[PostfixProgram::kMaxSlots];
+  u_int64_t valid = 0;
+  for (size_t slot = 0; slot < slot_count; ++slot) {
+    typename RegisterValueMap<V>::const_iterator it =
+        registers.find(slot_names_[slot]);
+    if (it != registers.end()) {
+      values[slot] = it->second;
+      valid |= 1ULL << slot;
+    }
+  }
+
+  caller_registers->clear();
+
+  // First, compute the CFA.
+  V cfa;
+  if (!EvaluateRule(cfa_program_, slot_count, values, valid, memory, &cfa))
+    return false;
+
+  // The remaining rules see the CFA as ".cfa".
+  values[kCFASlot] = cfa;
+  valid |= 1ULL << kCFASlot;
+
+  // Then, compute the return address.
+  V ra;
+  if (!EvaluateRule(ra_program_, slot_count, values, valid, memory, &ra))
+    return false;
+
+  // Now, compute values for all the registers register_rules_ mentions.
+  size_t i = 0;
+  for (RuleMap::const_iterator it = register_rules_.begin();
+       it != register_rules_.end(); ++it, ++i) {
+    V value;
+    if (!EvaluateRule(register_programs_[i], slot_count, values, valid,
+                      memory, &value))
+      return false;
+    (*caller_registers)[it->first] = value;
+  }
+
+  (*caller_registers)[".ra"] = ra;
+  (*caller_registers)[".cfa"] = cfa;
+
+  return true;
+}
+
 template<typename V>
 bool CFIFrameInfo::FindCallerRegs(const RegisterValueMap<V> &registers,
                                   const MemoryRegion &memory,
                                   RegisterValueMap<V> *caller_registers) const {
+  if (shared_)
+    return shared_->FindCallerRegs(registers, memory, caller_registers);
+
   // If there are not rules for both .ra and .cfa in effect at this address,
   // don't use this CFI data for stack walking.
   if (cfa_rule_.empty() || ra_rule_.empty())
     return false;
 
+  if (compiled_)
+    return FindCallerRegsCompiled(registers, memory, caller_registers);
+
   RegisterValueMap<V> working;
   PostfixEvaluator<V> evaluator(&working, &memory);
 
@@ -98,6 +205,9 @@ template bool CFIFrameInfo::FindCallerRegs<u_int64_t>(
     RegisterValueMap<u_int64_t> *caller_registers) const;
 
 string CFIFrameInfo::Serialize() const {
+  if (shared_)
+    return shared_->Serialize();
+
   std::ostringstream stream;
 
   if (!cfa_rule_.empty()) {
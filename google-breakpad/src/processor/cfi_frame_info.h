@@ -40,8 +40,10 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "google_breakpad/common/breakpad_types.h"
+#include "processor/postfix_program.h"
 
 namespace google_breakpad {
 
@@ -63,21 +65,56 @@ class MemoryRegion;
 // address. Then, use the FindCallerRegs member function to apply the
 // rules to the callee frame's register values, yielding the caller
 // frame's register values.
+//
+// FindCallerRegs interprets the rules' postfix expressions afresh on
+// each call. Calling Compile once the rules are complete translates
+// them into PostfixPrograms, which FindCallerRegs then uses instead;
+// a resolver that caches compiled CFIFrameInfo objects pays for
+// parsing the rules only once. It can then hand out CFIFrameInfo
+// objects that refer to its cached rules rather than copy them.
 class CFIFrameInfo {
  public:
   // A map from register names onto values.
   template<typename ValueType> class RegisterValueMap: 
     public map<string, ValueType> { };
 
+  CFIFrameInfo() : shared_(NULL), compiled_(false) { }
+
+  // Construct a CFIFrameInfo that uses the rules of SHARED, without
+  // copying them. SHARED must outlive this object and must not change
+  // while this object uses it. Setting a rule copies SHARED's rules
+  // into this object first.
+  explicit CFIFrameInfo(const CFIFrameInfo *shared)
+      : shared_(shared->shared_ ? shared->shared_ : shared),
+        compiled_(false) { }
+
   // Set the expression for computing a call frame address, return
   // address, or register's value. At least the CFA rule and the RA
-  // rule must be set before calling FindCallerRegs.
-  void SetCFARule(const string &expression) { cfa_rule_ = expression; }
-  void SetRARule(const string &expression)  { ra_rule_ = expression; }
+  // rule must be set before calling FindCallerRegs. Changing a rule
+  // discards any compiled form.
+  void SetCFARule(const string &expression) {
+    Unshare();
+    cfa_rule_ = expression;
+    compiled_ = false;
+  }
+  void SetRARule(const string &expression) {
+    Unshare();
+    ra_rule_ = expression;
+    compiled_ = false;
+  }
   void SetRegisterRule(const string &register_name, const string &expression) {
+    Unshare();
     register_rules_[register_name] = expression;
+    compiled_ = false;
   }
 
+  // Compile the current rules, so that FindCallerRegs needn't parse
+  // them. Return true on success. If some rule can't be compiled,
+  // FindCallerRegs continues to interpret the rules, which yields the
+  // same results. An object using another's rules reports whether
+  // those are compiled.
+  bool Compile();
+
   // Compute the values of the calling frame's registers, according to
   // this rule set. Use ValueType in expression evaluation; this
   // should be u_int32_t on machines with 32-bit addresses, or
@@ -105,10 +142,25 @@ class CFIFrameInfo {
   string Serialize() const;
 
  private:
+  // If this object uses another's rules, copy them into this one.
+  void Unshare() {
+    if (shared_)
+      *this = *shared_;
+  }
+
+  // FindCallerRegs, using the compiled rules.
+  template<typename ValueType>
+  bool FindCallerRegsCompiled(const RegisterValueMap<ValueType> &registers,
+                              const MemoryRegion &memory,
+                              RegisterValueMap<ValueType> *caller_registers)
+      const;
 
   // A map from register names onto evaluation rules. 
   typedef map<string, string> RuleMap;
 
+  // The object whose rules this one uses in place of its own, or NULL.
+  const CFIFrameInfo *shared_;
+
   // In this type, a "postfix expression" is an expression of the sort
   // interpreted by google_breakpad::PostfixEvaluator.
 
@@ -132,6 +184,18 @@ class CFIFrameInfo {
   // which leaves the value of REG in the calling frame on the top of
   // the stack. You should evaluate this expression
   RuleMap register_rules_;
+
+  // True if the programs below are compiled from the current rules.
+  bool compiled_;
+
+  // The identifiers the compiled rules use. Slot 0 is always ".cfa".
+  PostfixProgram::SlotNames slot_names_;
+
+  // The compiled forms of cfa_rule_ and ra_rule_, and of the entries of
+  // register_rules_, in the latter's iteration order.
+  PostfixProgram cfa_program_;
+  PostfixProgram ra_program_;
+  std::vector<PostfixProgram> register_programs_;
 };
 
 // A parser for STACK CFI-style rule sets.
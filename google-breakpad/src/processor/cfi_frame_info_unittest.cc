@@ -159,6 +159,32 @@ TEST_F(Simple, RulesOverride) {
             cfi.Serialize());
 }
 
+// A CFIFrameInfo using another's rules should behave like a copy, and
+// setting a rule in it should leave the other's rules alone.
+TEST_F(Simple, SharedRules) {
+  ExpectNoMemoryReferences();
+
+  cfi.SetCFARule("330903416631436410");
+  cfi.SetRARule("5870666104170902211");
+  ASSERT_TRUE(cfi.Compile());
+  CFIFrameInfo shared(&cfi);
+  ASSERT_TRUE(shared.Compile());
+  ASSERT_TRUE(shared.FindCallerRegs<u_int64_t>(registers, memory,
+                                               &caller_registers));
+  ASSERT_EQ(2U, caller_registers.size());
+  ASSERT_EQ(330903416631436410ULL, caller_registers[".cfa"]);
+  ASSERT_EQ(5870666104170902211ULL, caller_registers[".ra"]);
+  ASSERT_EQ(cfi.Serialize(), shared.Serialize());
+
+  CFIFrameInfo shared_again(&shared);
+  shared.SetCFARule("2828089117179001");
+  ASSERT_EQ(".cfa: 2828089117179001 .ra: 5870666104170902211",
+            shared.Serialize());
+  ASSERT_EQ(".cfa: 330903416631436410 .ra: 5870666104170902211",
+            cfi.Serialize());
+  ASSERT_EQ(cfi.Serialize(), shared_again.Serialize());
+}
+
 class Scope: public CFIFixture, public Test { };
 
 // There should be no value for .cfa in scope when evaluating the CFA rule.
@@ -0,0 +1,127 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// code_address_filter.cc: Implement google_breakpad::CodeAddressFilter.
+// See code_address_filter.h.
+
+#include "processor/code_address_filter.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/code_modules.h"
+
+namespace google_breakpad {
+
+CodeAddressFilter::CodeAddressFilter(const CodeModules *modules)
+    : starts_(), lasts_(), lowest_(1), highest_(0) {
+  if (!modules)
+    return;
+
+  std::vector<std::pair<u_int64_t, u_int64_t> > ranges;
+  unsigned int module_count = modules->module_count();
+  ranges.reserve(module_count);
+  for (unsigned int index = 0; index < module_count; ++index) {
+    const CodeModule *module = modules->GetModuleAtIndex(index);
+    if (!module || module->size() == 0)
+      continue;
+    u_int64_t last = module->base_address() + module->size() - 1;
+    if (last < module->base_address())
+      last = static_cast<u_int64_t>(-1);
+    ranges.push_back(std::make_pair(module->base_address(), last));
+  }
+  if (ranges.empty())
+    return;
+
+  // CodeModules implementations generally keep their modules disjoint, but
+  // nothing here depends on that: merge any that overlap or abut.
+  std::sort(ranges.begin(), ranges.end());
+  starts_.reserve(ranges.size());
+  lasts_.reserve(ranges.size());
+  starts_.push_back(ranges[0].first);
+  lasts_.push_back(ranges[0].second);
+  for (size_t index = 1; index < ranges.size(); ++index) {
+    u_int64_t &last = lasts_.back();
+    if (last == static_cast<u_int64_t>(-1) ||
+        ranges[index].first <= last + 1) {
+      last = std::max(last, ranges[index].second);
+    } else {
+      starts_.push_back(ranges[index].first);
+      lasts_.push_back(ranges[index].second);
+    }
+  }
+
+  lowest_ = starts_.front();
+  highest_ = lasts_.back();
+}
+
+bool CodeAddressFilter::Contains(u_int64_t address) const {
+  bool in_code;
+  Filter(&address, 1, &in_code);
+  return in_code;
+}
+
+size_t CodeAddressFilter::Filter(const u_int64_t *addresses, size_t count,
+                                 bool *in_code) const {
+  size_t range_count = starts_.size();
+  if (range_count == 0) {
+    std::fill(in_code, in_code + count, false);
+    return 0;
+  }
+
+  const u_int64_t *starts = &starts_[0];
+  const u_int64_t *lasts = &lasts_[0];
+  size_t found = 0;
+  for (size_t index = 0; index < count; ++index) {
+    u_int64_t address = addresses[index];
+
+    // Find the last range that starts at or below address, or the first
+    // range if there is none.  The comparison only selects the next base,
+    // so compilers lower it to a conditional move; the trip count depends
+    // only on range_count.
+    const u_int64_t *base = starts;
+    size_t remaining = range_count;
+    while (remaining > 1) {
+      size_t half = remaining / 2;
+      base = base[half] <= address ? base + half : base;
+      remaining -= half;
+    }
+
+    // Combine the tests with & rather than && so that they, too, compile
+    // without branches.
+    bool hit = (address >= lowest_) & (address <= highest_) &
+               (*base <= address) & (address <= lasts[base - starts]);
+    in_code[index] = hit;
+    found += hit;
+  }
+  return found;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,90 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// code_address_filter.h: A compact index of the address ranges occupied
+// by a process's code modules.
+//
+// When a stackwalker falls back to scanning the stack for return
+// addresses, most of the words it reads are small integers, pointers into
+// the heap or stack, or other data that can't be an instruction address.
+// Stackwalker::InstructionAddressSeemsValid rejects such words too, but
+// only after a virtual module lookup, and for words that do fall inside a
+// module it may load symbols and resolve source lines.  CodeAddressFilter
+// lets the stackwalker discard the non-code words first: it flattens the
+// modules' ranges into sorted, non-overlapping arrays once, and then checks
+// a whole window of stack words against them in one loop that performs no
+// virtual calls, allocations, or data-dependent branches.
+
+#ifndef PROCESSOR_CODE_ADDRESS_FILTER_H__
+#define PROCESSOR_CODE_ADDRESS_FILTER_H__
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "google_breakpad/common/breakpad_types.h"
+
+namespace google_breakpad {
+
+class CodeModules;
+
+class CodeAddressFilter {
+ public:
+  // Builds the filter from the ranges of the modules in MODULES, which may
+  // be NULL.  The filter holds no reference to MODULES.
+  explicit CodeAddressFilter(const CodeModules *modules);
+
+  // Returns true if ADDRESS lies within one of the modules.
+  bool Contains(u_int64_t address) const;
+
+  // Sets in_code[i] to whether addresses[i] lies within one of the modules,
+  // for each i less than count.  Returns the number of addresses that do.
+  size_t Filter(const u_int64_t *addresses, size_t count,
+                bool *in_code) const;
+
+  // The number of disjoint ranges the modules' ranges were merged into.
+  size_t range_count() const { return starts_.size(); }
+
+ private:
+  // starts_[i] and lasts_[i] are the first and last addresses of the i'th
+  // range, in ascending order.  Ranges neither overlap nor abut.  Last
+  // addresses are inclusive so that a module ending at the top of the
+  // address space can be represented.
+  std::vector<u_int64_t> starts_;
+  std::vector<u_int64_t> lasts_;
+
+  // The lowest and highest addresses covered by any range.  If there are no
+  // ranges, lowest_ is greater than highest_.
+  u_int64_t lowest_;
+  u_int64_t highest_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_CODE_ADDRESS_FILTER_H__
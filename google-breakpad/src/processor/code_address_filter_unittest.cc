@@ -0,0 +1,154 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// code_address_filter_unittest.cc: Unit tests for
+// google_breakpad::CodeAddressFilter.
+
+#include "breakpad_googletest_includes.h"
+#include "processor/code_address_filter.h"
+#include "processor/stackwalker_unittest_utils.h"
+
+namespace {
+
+using google_breakpad::CodeAddressFilter;
+
+TEST(CodeAddressFilterTest, NoModules) {
+  CodeAddressFilter null_filter(NULL);
+  EXPECT_EQ(0U, null_filter.range_count());
+  EXPECT_FALSE(null_filter.Contains(0));
+  EXPECT_FALSE(null_filter.Contains(0x40000000));
+
+  MockCodeModules modules;
+  CodeAddressFilter empty_filter(&modules);
+  EXPECT_EQ(0U, empty_filter.range_count());
+  u_int64_t addresses[2] = { 0, static_cast<u_int64_t>(-1) };
+  bool in_code[2] = { true, true };
+  EXPECT_EQ(0U, empty_filter.Filter(addresses, 2, in_code));
+  EXPECT_FALSE(in_code[0]);
+  EXPECT_FALSE(in_code[1]);
+}
+
+TEST(CodeAddressFilterTest, Boundaries) {
+  MockCodeModule high(0x50000000, 0x1000, "high", "1");
+  MockCodeModule low(0x40000000, 0x2000, "low", "1");
+  MockCodeModules modules;
+  // Out of order, to check that the filter sorts them.
+  modules.Add(&high);
+  modules.Add(&low);
+  CodeAddressFilter filter(&modules);
+  EXPECT_EQ(2U, filter.range_count());
+
+  EXPECT_FALSE(filter.Contains(0));
+  EXPECT_FALSE(filter.Contains(0x3fffffff));
+  EXPECT_TRUE(filter.Contains(0x40000000));
+  EXPECT_TRUE(filter.Contains(0x40001fff));
+  EXPECT_FALSE(filter.Contains(0x40002000));
+  EXPECT_FALSE(filter.Contains(0x4fffffff));
+  EXPECT_TRUE(filter.Contains(0x50000000));
+  EXPECT_TRUE(filter.Contains(0x50000fff));
+  EXPECT_FALSE(filter.Contains(0x50001000));
+  EXPECT_FALSE(filter.Contains(static_cast<u_int64_t>(-1)));
+}
+
+TEST(CodeAddressFilterTest, MergesOverlappingAndAdjacentModules) {
+  MockCodeModule first(0x1000, 0x1000, "first", "1");
+  MockCodeModule adjacent(0x2000, 0x1000, "adjacent", "1");
+  MockCodeModule overlapping(0x2800, 0x1000, "overlapping", "1");
+  MockCodeModule contained(0x1100, 0x10, "contained", "1");
+  MockCodeModule empty(0x8000, 0, "empty", "1");
+  MockCodeModule apart(0x9000, 0x100, "apart", "1");
+  MockCodeModules modules;
+  modules.Add(&first);
+  modules.Add(&adjacent);
+  modules.Add(&overlapping);
+  modules.Add(&contained);
+  modules.Add(&empty);
+  modules.Add(&apart);
+  CodeAddressFilter filter(&modules);
+  EXPECT_EQ(2U, filter.range_count());
+
+  EXPECT_FALSE(filter.Contains(0xfff));
+  EXPECT_TRUE(filter.Contains(0x1000));
+  EXPECT_TRUE(filter.Contains(0x2000));
+  EXPECT_TRUE(filter.Contains(0x37ff));
+  EXPECT_FALSE(filter.Contains(0x3800));
+  EXPECT_FALSE(filter.Contains(0x8000));
+  EXPECT_TRUE(filter.Contains(0x90ff));
+}
+
+TEST(CodeAddressFilterTest, ModuleAtTopOfAddressSpace) {
+  MockCodeModule top(0xfffffffffffff000ULL, 0x1000, "top", "1");
+  MockCodeModule wrapping(0xffffffffffffff00ULL, 0x1000, "wrapping", "1");
+  MockCodeModules modules;
+  modules.Add(&top);
+  modules.Add(&wrapping);
+  CodeAddressFilter filter(&modules);
+  EXPECT_EQ(1U, filter.range_count());
+  EXPECT_FALSE(filter.Contains(0xffffffffffffefffULL));
+  EXPECT_TRUE(filter.Contains(0xfffffffffffff000ULL));
+  EXPECT_TRUE(filter.Contains(static_cast<u_int64_t>(-1)));
+  EXPECT_FALSE(filter.Contains(0));
+}
+
+TEST(CodeAddressFilterTest, FilterMatchesContains) {
+  MockCodeModules modules;
+  MockCodeModule *module_storage[64];
+  for (int i = 0; i < 64; ++i) {
+    module_storage[i] = new MockCodeModule(0x10000 * (i + 1), 0x8000,
+                                           "module", "1");
+    modules.Add(module_storage[i]);
+  }
+  CodeAddressFilter filter(&modules);
+  EXPECT_EQ(64U, filter.range_count());
+
+  u_int64_t addresses[1000];
+  bool in_code[1000];
+  size_t expected = 0;
+  for (int i = 0; i < 1000; ++i) {
+    addresses[i] = static_cast<u_int64_t>(i) * 0x1234;
+    if (modules.GetModuleForAddress(addresses[i]))
+      ++expected;
+  }
+  EXPECT_EQ(expected, filter.Filter(addresses, 1000, in_code));
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(modules.GetModuleForAddress(addresses[i]) != NULL, in_code[i])
+        << "address " << addresses[i];
+    EXPECT_EQ(in_code[i], filter.Contains(addresses[i]));
+  }
+
+  for (int i = 0; i < 64; ++i)
+    delete module_storage[i];
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
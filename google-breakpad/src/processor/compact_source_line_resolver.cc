@@ -0,0 +1,677 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// compact_source_line_resolver.cc: CompactSourceLineResolver implementation.
+//
+// See compact_source_line_resolver.h and
+// compact_source_line_resolver_types.h for documentation.
+
+#include "google_breakpad/processor/compact_source_line_resolver.h"
+#include "processor/compact_source_line_resolver_types.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "processor/logging.h"
+#include "processor/module_factory.h"
+#include "processor/scoped_ptr.h"
+#include "processor/tokenize.h"
+
+using std::vector;
+
+namespace google_breakpad {
+
+static const char *kWhitespace = " \r\n";
+
+typedef SourceLineResolverInterface::MemAddr MemAddr;
+
+CompactSourceLineResolver::CompactSourceLineResolver()
+  : SourceLineResolverBase(new CompactModuleFactory) { }
+
+bool CompactSourceLineResolver::ShouldDeleteMemoryBufferAfterLoadModule() {
+  return true;
+}
+
+// Returns the last address of the range record covers.
+template<typename Record>
+static MemAddr RangeHigh(const Record &record) {
+  return record.address + record.size - 1;
+}
+
+// Orders range records by their last address, for searching.
+template<typename Record>
+static bool RangeHighLess(const Record &record, const MemAddr &address) {
+  return RangeHigh(record) < address;
+}
+
+// Orders records by their address, for searching.
+template<typename Record>
+static bool AddressLess(const Record &record, const MemAddr &address) {
+  return record.address < address;
+}
+
+// Orders an address before the records above it, for searching.
+template<typename Record>
+static bool AddressGreater(const MemAddr &address, const Record &record) {
+  return address < record.address;
+}
+
+// Orders records by their id, for searching.
+template<typename Record>
+static bool IdLess(const Record &record, const int32_t &id) {
+  return record.id < id;
+}
+
+// Orders records by their id, for sorting.
+template<typename Record>
+static bool RecordIdLess(const Record &x, const Record &y) {
+  return x.id < y.id;
+}
+
+// Returns true if two records have the same id.
+template<typename Record>
+static bool RecordIdEqual(const Record &x, const Record &y) {
+  return x.id == y.id;
+}
+
+// Orders records by their address, for sorting.
+template<typename Record>
+static bool RecordAddressLess(const Record &x, const Record &y) {
+  return x.address < y.address;
+}
+
+// Returns the index of the first of the count sorted, non-overlapping
+// ranges at records that does not end below address.  That range covers
+// address if it does not start above it; the range before it, if any, is
+// the nearest range below address.
+template<typename Record>
+static size_t FindRange(const Record *records, size_t count,
+                        MemAddr address) {
+  return std::lower_bound(records, records + count, address,
+                          RangeHighLess<Record>) - records;
+}
+
+// Builds a module's tables from the records of a symbol file, which it
+// parses with the same rules as BasicSourceLineResolver::Module, and
+// copies them into the module's arena once the file has been read.
+class CompactSourceLineResolver::Module::Loader {
+ public:
+  explicit Loader(Module *module)
+      : module_(module), strings_(&module->arena_), in_function_(false),
+        line_number_(0) { }
+
+  // Parses a single NUL-terminated record, which it may modify.
+  bool ParseRecord(char *record);
+
+  // Stores the tables in the module.  Returns false if the symbol file
+  // was inconsistent.
+  bool Finish();
+
+ private:
+  bool ParseFile(char *file_line);
+  bool ParseFunction(char *function_line);
+  bool ParseLine(char *line_line);
+  bool ParsePublicSymbol(char *public_line);
+  bool ParseStackInfo(char *stack_info_line);
+  bool ParseCFIFrameInfo(char *stack_info_line);
+
+  // Stores the function whose lines are being parsed, if any.
+  void EndFunction();
+
+  // Adds record to the sorted, non-overlapping ranges, and returns true,
+  // unless it is empty or overflows or overlaps one of them, in which case
+  // it returns false.  This gives the same results as
+  // RangeMap::StoreRange.
+  template<typename Record>
+  static bool StoreRange(vector<Record> *ranges, const Record &record);
+
+  // Returns a copy of records in the module's arena.
+  template<typename Record>
+  Table<Record> CopyTable(const vector<Record> &records);
+
+  Module *module_;
+  StringPool strings_;
+
+  vector<File> files_;
+  vector<Function> functions_;
+  vector<Line> lines_;
+  vector<PublicSymbol> public_symbols_;
+  vector<CFIInitialRules> cfi_initial_rules_;
+  vector<CFIDeltaRules> cfi_delta_rules_;
+
+  // The FUNC record whose line records are being parsed, and its lines.
+  // It is only stored when its lines end, but whether it is stored does
+  // not depend on them.
+  bool in_function_;
+  Function function_;
+  vector<Line> function_lines_;
+
+  int line_number_;
+};
+
+template<typename Record>
+bool CompactSourceLineResolver::Module::Loader::StoreRange(
+    vector<Record> *ranges, const Record &record) {
+  if (record.size == 0 || RangeHigh(record) < record.address)
+    return false;
+
+  // Symbol files list their ranges in ascending order, so nearly every
+  // range belongs at the end.
+  if (ranges->empty() || RangeHigh(ranges->back()) < record.address) {
+    ranges->push_back(record);
+    return true;
+  }
+
+  typename vector<Record>::iterator next =
+      std::lower_bound(ranges->begin(), ranges->end(), record.address,
+                       RangeHighLess<Record>);
+  if (next != ranges->end() && next->address <= RangeHigh(record))
+    return false;
+  ranges->insert(next, record);
+  return true;
+}
+
+template<typename Record>
+CompactSourceLineResolver::Module::Table<Record>
+CompactSourceLineResolver::Module::Loader::CopyTable(
+    const vector<Record> &records) {
+  Table<Record> table;
+  if (records.empty())
+    return table;
+  Record *copy = module_->arena_.AllocateArray<Record>(records.size());
+  std::copy(records.begin(), records.end(), copy);
+  table.records = copy;
+  table.count = records.size();
+  return table;
+}
+
+bool CompactSourceLineResolver::Module::Loader::ParseRecord(char *buffer) {
+  ++line_number_;
+
+  if (strncmp(buffer, "FILE ", 5) == 0) {
+    if (!ParseFile(buffer)) {
+      BPLOG(ERROR) << "ParseFile on buffer failed at " <<
+          ":" << line_number_;
+      return false;
+    }
+  } else if (strncmp(buffer, "STACK ", 6) == 0) {
+    if (!ParseStackInfo(buffer)) {
+      BPLOG(ERROR) << "ParseStackInfo failed at " <<
+          ":" << line_number_;
+      return false;
+    }
+  } else if (strncmp(buffer, "FUNC ", 5) == 0) {
+    EndFunction();
+    if (!ParseFunction(buffer)) {
+      BPLOG(ERROR) << "ParseFunction failed at " <<
+          ":" << line_number_;
+      return false;
+    }
+  } else if (strncmp(buffer, "PUBLIC ", 7) == 0) {
+    // Public symbols don't contain line number information.
+    EndFunction();
+    if (!ParsePublicSymbol(buffer)) {
+      BPLOG(ERROR) << "ParsePublicSymbol failed at " <<
+          ":" << line_number_;
+      return false;
+    }
+  } else if (strncmp(buffer, "MODULE ", 7) == 0 ||
+             strncmp(buffer, "INFO ", 5) == 0) {
+    // Ignore these, as BasicSourceLineResolver does.
+  } else {
+    if (!in_function_) {
+      BPLOG(ERROR) << "Found source line data without a function at " <<
+          ":" << line_number_;
+      return false;
+    }
+    if (!ParseLine(buffer)) {
+      BPLOG(ERROR) << "ParseLine failed at " << line_number_ << " for " <<
+          buffer;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CompactSourceLineResolver::Module::Loader::ParseFile(char *file_line) {
+  // FILE <id> <filename>
+  file_line += 5;  // skip prefix
+
+  vector<char*> tokens;
+  if (!Tokenize(file_line, kWhitespace, 2, &tokens))
+    return false;
+
+  int index = atoi(tokens[0]);
+  if (index < 0)
+    return false;
+
+  char *filename = tokens[1];
+  if (!filename)
+    return false;
+
+  File file = { index, strings_.Intern(filename, strlen(filename)) };
+  files_.push_back(file);
+  return true;
+}
+
+bool CompactSourceLineResolver::Module::Loader::ParseFunction(
+    char *function_line) {
+  // FUNC <address> <size> <stack_param_size> <name>
+  function_line += 5;  // skip prefix
+
+  vector<char*> tokens;
+  if (!Tokenize(function_line, kWhitespace, 4, &tokens))
+    return false;
+
+  function_.address = strtoull(tokens[0], NULL, 16);
+  function_.size = strtoull(tokens[1], NULL, 16);
+  function_.parameter_size = strtoull(tokens[2], NULL, 16);
+  function_.name = strings_.Intern(tokens[3], strlen(tokens[3]));
+  function_.first_line = 0;
+  function_.line_count = 0;
+  function_lines_.clear();
+  in_function_ = true;
+  return true;
+}
+
+bool CompactSourceLineResolver::Module::Loader::ParseLine(char *line_line) {
+  // <address> <size> <line number> <source file id>
+  vector<char*> tokens;
+  if (!Tokenize(line_line, kWhitespace, 4, &tokens))
+    return false;
+
+  Line line;
+  line.address = strtoull(tokens[0], NULL, 16);
+  line.size = strtoull(tokens[1], NULL, 16);
+  line.line = atoi(tokens[2]);
+  line.source_file_id = atoi(tokens[3]);
+  if (line.line <= 0)
+    return false;
+
+  // As with a RangeMap, a line that is empty or overlaps an earlier one is
+  // silently dropped.
+  StoreRange(&function_lines_, line);
+  return true;
+}
+
+void CompactSourceLineResolver::Module::Loader::EndFunction() {
+  if (!in_function_)
+    return;
+  in_function_ = false;
+
+  // A function that is empty or overlaps an earlier one is silently
+  // dropped, along with its lines.
+  function_.first_line = lines_.size();
+  function_.line_count = function_lines_.size();
+  if (StoreRange(&functions_, function_))
+    lines_.insert(lines_.end(), function_lines_.begin(), function_lines_.end());
+  function_lines_.clear();
+}
+
+bool CompactSourceLineResolver::Module::Loader::ParsePublicSymbol(
+    char *public_line) {
+  // PUBLIC <address> <stack_param_size> <name>
+  public_line += 7;  // skip prefix
+
+  vector<char*> tokens;
+  if (!Tokenize(public_line, kWhitespace, 3, &tokens))
+    return false;
+
+  PublicSymbol symbol;
+  symbol.address = strtoull(tokens[0], NULL, 16);
+  symbol.parameter_size = strtoull(tokens[1], NULL, 16);
+
+  // Public symbols at address 0 are invalid, and are accepted without
+  // being stored; see BasicSourceLineResolver::Module::ParsePublicSymbol.
+  if (symbol.address == 0)
+    return true;
+
+  symbol.name = strings_.Intern(tokens[2], strlen(tokens[2]));
+  public_symbols_.push_back(symbol);
+  return true;
+}
+
+bool CompactSourceLineResolver::Module::Loader::ParseStackInfo(
+    char *stack_info_line) {
+  // Skip "STACK " prefix.
+  stack_info_line += 6;
+
+  // Find the token indicating what sort of stack frame walking
+  // information this is.
+  while (*stack_info_line == ' ')
+    stack_info_line++;
+  const char *platform = stack_info_line;
+  while (!strchr(kWhitespace, *stack_info_line))
+    stack_info_line++;
+  *stack_info_line++ = '\0';
+
+  // MSVC stack frame info.
+  if (strcmp(platform, "WIN") == 0) {
+    int type = 0;
+    u_int64_t rva, code_size;
+    linked_ptr<WindowsFrameInfo>
+      stack_frame_info(WindowsFrameInfo::ParseFromString(stack_info_line,
+                                                         type,
+                                                         rva,
+                                                         code_size));
+    if (stack_frame_info == NULL)
+      return false;
+
+    // As in BasicSourceLineResolver, conflicting ranges are not an error;
+    // see the comment in BasicSourceLineResolver::Module::ParseStackInfo.
+    module_->windows_frame_info_[type].StoreRange(rva, code_size,
+                                                  stack_frame_info);
+    return true;
+  } else if (strcmp(platform, "CFI") == 0) {
+    // DWARF CFI stack frame info
+    return ParseCFIFrameInfo(stack_info_line);
+  } else {
+    // Something unrecognized.
+    return false;
+  }
+}
+
+bool CompactSourceLineResolver::Module::Loader::ParseCFIFrameInfo(
+    char *stack_info_line) {
+  char *cursor;
+
+  // Is this an INIT record or a delta record?
+  char *init_or_address = strtok_r(stack_info_line, " \r\n", &cursor);
+  if (!init_or_address)
+    return false;
+
+  if (strcmp(init_or_address, "INIT") == 0) {
+    // This record has the form "STACK INIT <address> <size> <rules...>".
+    char *address_field = strtok_r(NULL, " \r\n", &cursor);
+    if (!address_field) return false;
+
+    char *size_field = strtok_r(NULL, " \r\n", &cursor);
+    if (!size_field) return false;
+
+    char *initial_rules = strtok_r(NULL, "\r\n", &cursor);
+    if (!initial_rules) return false;
+
+    CFIInitialRules record;
+    record.address = strtoul(address_field, NULL, 16);
+    record.size = strtoul(size_field, NULL, 16);
+    record.rules = strings_.Intern(initial_rules, strlen(initial_rules));
+    StoreRange(&cfi_initial_rules_, record);
+    return true;
+  }
+
+  // This record has the form "STACK <address> <rules...>".
+  char *address_field = init_or_address;
+  char *delta_rules = strtok_r(NULL, "\r\n", &cursor);
+  if (!delta_rules) return false;
+  CFIDeltaRules record;
+  record.address = strtoul(address_field, NULL, 16);
+  record.rules = strings_.Intern(delta_rules, strlen(delta_rules));
+  cfi_delta_rules_.push_back(record);
+  return true;
+}
+
+bool CompactSourceLineResolver::Module::Loader::Finish() {
+  EndFunction();
+
+  // When files share an id, the first one wins, as in a std::map.
+  std::stable_sort(files_.begin(), files_.end(), RecordIdLess<File>);
+  files_.erase(std::unique(files_.begin(), files_.end(),
+                           RecordIdEqual<File>),
+               files_.end());
+
+  // Two public symbols at the same address are an error, which
+  // BasicSourceLineResolver reports as soon as it stores the second.
+  std::sort(public_symbols_.begin(), public_symbols_.end(),
+            RecordAddressLess<PublicSymbol>);
+  for (size_t i = 1; i < public_symbols_.size(); ++i) {
+    if (public_symbols_[i].address == public_symbols_[i - 1].address) {
+      BPLOG(ERROR) << "ParsePublicSymbol failed, duplicate address " <<
+          HexString(public_symbols_[i].address);
+      return false;
+    }
+  }
+
+  // When delta rules share an address, the last one wins, as when
+  // assigning to a std::map.
+  std::stable_sort(cfi_delta_rules_.begin(), cfi_delta_rules_.end(),
+                   RecordAddressLess<CFIDeltaRules>);
+  size_t kept = 0;
+  for (size_t i = 0; i < cfi_delta_rules_.size(); ++i) {
+    if (kept > 0 &&
+        cfi_delta_rules_[kept - 1].address == cfi_delta_rules_[i].address)
+      --kept;
+    cfi_delta_rules_[kept++] = cfi_delta_rules_[i];
+  }
+  cfi_delta_rules_.resize(kept);
+
+  module_->files_ = CopyTable(files_);
+  module_->functions_ = CopyTable(functions_);
+  module_->lines_ = CopyTable(lines_);
+  module_->public_symbols_ = CopyTable(public_symbols_);
+  module_->cfi_initial_rules_ = CopyTable(cfi_initial_rules_);
+  module_->cfi_delta_rules_ = CopyTable(cfi_delta_rules_);
+
+  for (int type = 0; type < WindowsFrameInfo::STACK_INFO_LAST; ++type)
+    module_->windows_frame_info_[type].Freeze();
+  return true;
+}
+
+CompactSourceLineResolver::Module::Module(const string &name)
+    : name_(name), symbol_data_size_(0), arena_() { }
+
+bool CompactSourceLineResolver::Module::LoadMapFromMemory(
+    char *memory_buffer) {
+  // As in BasicSourceLineResolver, memory_buffer may be a read-only mapping
+  // of the symbol file, so each record is copied into a scratch buffer for
+  // the loader to tokenize.  An empty buffer gives an empty module.
+  Loader loader(this);
+  vector<char> record;
+  const char *cursor = memory_buffer;
+
+  while (*cursor != '\0') {
+    // Records are separated by runs of CR and LF characters.
+    size_t record_length = strcspn(cursor, "\r\n");
+    if (record_length == 0) {
+      ++cursor;
+      continue;
+    }
+    record.assign(cursor, cursor + record_length);
+    record.push_back('\0');
+    cursor += record_length;
+
+    if (!loader.ParseRecord(&record[0]))
+      return false;
+  }
+  symbol_data_size_ = cursor - memory_buffer;
+
+  return loader.Finish();
+}
+
+const CompactSourceLineResolver::Module::Function *
+CompactSourceLineResolver::Module::FindFunction(
+    MemAddr address, const Function **nearest) const {
+  size_t index = FindRange(functions_.records, functions_.count, address);
+  if (index < functions_.count &&
+      functions_.records[index].address <= address) {
+    *nearest = &functions_.records[index];
+    return *nearest;
+  }
+  *nearest = index > 0 ? &functions_.records[index - 1] : NULL;
+  return NULL;
+}
+
+const CompactSourceLineResolver::Module::PublicSymbol *
+CompactSourceLineResolver::Module::FindPublicSymbol(MemAddr address) const {
+  // The last public symbol whose address is not above address.
+  const PublicSymbol *end = public_symbols_.records + public_symbols_.count;
+  const PublicSymbol *next =
+      std::upper_bound(public_symbols_.records, end, address,
+                       AddressGreater<PublicSymbol>);
+  return next == public_symbols_.records ? NULL : next - 1;
+}
+
+const char *CompactSourceLineResolver::Module::FindFileName(int32_t id) const {
+  const File *end = files_.records + files_.count;
+  const File *file = std::lower_bound(files_.records, end, id, IdLess<File>);
+  return file != end && file->id == id ? file->name : NULL;
+}
+
+int CompactSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
+  MemAddr address = frame->instruction - frame->module->base_address();
+  int filled = SourceLineLookupCache::FIELD_NONE;
+
+  // First, look for a FUNC record that covers address.  If there is none,
+  // the nearest function below address bounds the extent of the PUBLIC
+  // symbol we find, below.
+  const Function *nearest;
+  const Function *function = FindFunction(address, &nearest);
+  if (function) {
+    frame->function_name = function->name;
+    frame->function_base = frame->module->base_address() + function->address;
+    filled |= SourceLineLookupCache::FIELD_FUNCTION;
+
+    const Line *lines = lines_.records + function->first_line;
+    size_t index = FindRange(lines, function->line_count, address);
+    if (index < function->line_count && lines[index].address <= address) {
+      const Line &line = lines[index];
+      const char *file_name = FindFileName(line.source_file_id);
+      if (file_name) {
+        frame->source_file_name = file_name;
+        filled |= SourceLineLookupCache::FIELD_SOURCE_FILE_NAME;
+      }
+      frame->source_line = line.line;
+      frame->source_line_base = frame->module->base_address() + line.address;
+      filled |= SourceLineLookupCache::FIELD_SOURCE_LINE;
+    }
+  } else {
+    const PublicSymbol *public_symbol = FindPublicSymbol(address);
+    if (public_symbol &&
+        (!nearest || public_symbol->address > nearest->address)) {
+      frame->function_name = public_symbol->name;
+      frame->function_base = frame->module->base_address() +
+                             public_symbol->address;
+      filled |= SourceLineLookupCache::FIELD_FUNCTION;
+    }
+  }
+  return filled;
+}
+
+WindowsFrameInfo *CompactSourceLineResolver::Module::FindWindowsFrameInfo(
+    const StackFrame *frame) const {
+  MemAddr address = frame->instruction - frame->module->base_address();
+  scoped_ptr<WindowsFrameInfo> result(new WindowsFrameInfo());
+
+  // We only know about WindowsFrameInfo::STACK_INFO_FRAME_DATA and
+  // WindowsFrameInfo::STACK_INFO_FPO. Prefer them in this order.
+  // See BasicSourceLineResolver::Module::FindWindowsFrameInfo.
+  linked_ptr<WindowsFrameInfo> frame_info;
+  if ((windows_frame_info_[WindowsFrameInfo::STACK_INFO_FRAME_DATA]
+       .RetrieveRange(address, &frame_info))
+      || (windows_frame_info_[WindowsFrameInfo::STACK_INFO_FPO]
+          .RetrieveRange(address, &frame_info))) {
+    ScopedMutexLock lock(&cache_lock_);
+    frame_info->CompileProgramString();
+    result->CopyFrom(*frame_info.get());
+    return result.release();
+  }
+
+  // Even without a relevant STACK line, many functions contain
+  // information about how much space their parameters consume on the
+  // stack.
+  const Function *nearest;
+  const Function *function = FindFunction(address, &nearest);
+  if (function) {
+    result->parameter_size = function->parameter_size;
+    result->valid |= WindowsFrameInfo::VALID_PARAMETER_SIZE;
+    return result.release();
+  }
+
+  // PUBLIC symbols might have a parameter size. Use the function we
+  // found above to limit the range the public symbol covers.
+  const PublicSymbol *public_symbol = FindPublicSymbol(address);
+  if (public_symbol &&
+      (!nearest || public_symbol->address > nearest->address)) {
+    result->parameter_size = public_symbol->parameter_size;
+  }
+
+  return NULL;
+}
+
+CFIFrameInfo *CompactSourceLineResolver::Module::FindCFIFrameInfo(
+    const StackFrame *frame) const {
+  MemAddr address = frame->instruction - frame->module->base_address();
+
+  // Find the initial rule whose range covers this address. That
+  // provides an initial set of register recovery rules. Then, walk
+  // forward from the initial rule's starting address to frame's
+  // instruction address, applying delta rules.
+  size_t index = FindRange(cfi_initial_rules_.records,
+                           cfi_initial_rules_.count, address);
+  if (index == cfi_initial_rules_.count ||
+      cfi_initial_rules_.records[index].address > address) {
+    return NULL;
+  }
+  const CFIInitialRules &initial = cfi_initial_rules_.records[index];
+
+  // Find the first delta rule that falls within the initial rule's range,
+  // and the end of the delta rules that apply at the frame's address.
+  const CFIDeltaRules *deltas_end =
+      cfi_delta_rules_.records + cfi_delta_rules_.count;
+  const CFIDeltaRules *first_delta =
+      std::lower_bound(cfi_delta_rules_.records, deltas_end, initial.address,
+                       AddressLess<CFIDeltaRules>);
+  const CFIDeltaRules *end_delta = first_delta;
+  MemAddr cache_key = initial.address;
+  while (end_delta != deltas_end && end_delta->address <= address) {
+    cache_key = end_delta->address;
+    end_delta++;
+  }
+
+  // If these rules have been assembled before, reuse them.
+  CFIFrameInfo *cached = FindCachedCFIFrameInfo(cache_key);
+  if (cached)
+    return cached;
+
+  // Create a frame info structure, and populate it with the rules from
+  // the STACK CFI INIT record.
+  scoped_ptr<CFIFrameInfo> rules(new CFIFrameInfo());
+  if (!ParseCFIRuleSet(initial.rules, rules.get()))
+    return NULL;
+
+  // Apply delta rules up to and including the frame's address.
+  for (const CFIDeltaRules *delta = first_delta; delta != end_delta; delta++)
+    ParseCFIRuleSet(delta->rules, rules.get());
+
+  return CacheCFIFrameInfo(cache_key, rules.release());
+}
+
+}  // namespace google_breakpad
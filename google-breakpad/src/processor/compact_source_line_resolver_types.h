@@ -0,0 +1,180 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// compact_source_line_resolver_types.h: definition of nested classes/structs
+// in CompactSourceLineResolver.  It moves the definitions out of
+// compact_source_line_resolver.cc, so that other classes could have access
+// to these private nested types without including
+// compact_source_line_resolver.cc
+
+#ifndef PROCESSOR_COMPACT_SOURCE_LINE_RESOLVER_TYPES_H__
+#define PROCESSOR_COMPACT_SOURCE_LINE_RESOLVER_TYPES_H__
+
+#include <string>
+
+#include "google_breakpad/processor/compact_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/arena.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/contained_range_map-inl.h"
+#include "processor/linked_ptr.h"
+#include "processor/source_line_resolver_base_types.h"
+#include "processor/windows_frame_info.h"
+
+namespace google_breakpad {
+
+class CompactSourceLineResolver::Module
+    : public SourceLineResolverBase::Module {
+ public:
+  explicit Module(const string &name);
+  virtual ~Module() { }
+
+  // Loads a map from the given buffer in char* type.  Does NOT have
+  // ownership of memory_buffer, does not modify it, and does not refer to
+  // it once loading is done.
+  virtual bool LoadMapFromMemory(char *memory_buffer);
+
+  // Looks up the given relative address, and fills the StackFrame struct
+  // with the result.
+  virtual int LookupAddress(StackFrame *frame) const;
+
+  // If Windows stack walking information is available covering ADDRESS,
+  // return a WindowsFrameInfo structure describing it. If the information
+  // is not available, returns NULL. A NULL return value does not indicate
+  // an error. The caller takes ownership of any returned WindowsFrameInfo
+  // object.
+  virtual WindowsFrameInfo *FindWindowsFrameInfo(const StackFrame *frame) const;
+
+  // If CFI stack walking information is available covering ADDRESS,
+  // return a CFIFrameInfo structure describing it. If the information
+  // is not available, return NULL. The caller takes ownership of any
+  // returned CFIFrameInfo object.
+  virtual CFIFrameInfo *FindCFIFrameInfo(const StackFrame *frame) const;
+
+  virtual size_t SymbolDataSize() const { return symbol_data_size_; }
+
+  // Returns the number of bytes the module's arena holds, which is nearly
+  // all of the module's memory unless it has STACK WIN records.
+  size_t ArenaSize() const { return arena_.slab_bytes(); }
+
+ private:
+  // Builds the module's tables while a symbol file is parsed.
+  class Loader;
+  friend class Loader;
+
+  // The records below live in arena_, and their strings in the arena's
+  // string pool.  Each table is sorted by address; ranges in a table do
+  // not overlap, and when a symbol file has overlapping ranges, the first
+  // is kept, just as BasicSourceLineResolver's RangeMaps keep it.
+  struct File {
+    int32_t id;
+    const char *name;
+  };
+
+  struct Line {
+    MemAddr address;
+    MemAddr size;
+    int32_t source_file_id;
+    int32_t line;
+  };
+
+  struct Function {
+    MemAddr address;
+    MemAddr size;
+    const char *name;
+
+    // The function's lines are lines_[first_line, first_line + line_count).
+    u_int32_t first_line;
+    u_int32_t line_count;
+
+    int32_t parameter_size;
+  };
+
+  struct PublicSymbol {
+    MemAddr address;
+    const char *name;
+    int32_t parameter_size;
+  };
+
+  // A STACK CFI INIT record, with its range and initial rules.
+  struct CFIInitialRules {
+    MemAddr address;
+    MemAddr size;
+    const char *rules;
+  };
+
+  // A STACK CFI delta record, whose rules take effect at address.
+  struct CFIDeltaRules {
+    MemAddr address;
+    const char *rules;
+  };
+
+  // A table of count records in the arena.
+  template<typename Record>
+  struct Table {
+    Table() : records(NULL), count(0) { }
+    const Record *records;
+    size_t count;
+  };
+
+  // Returns the function covering address, or NULL.  If there is none, sets
+  // *nearest to the closest function below address, or NULL if there is
+  // none either.
+  const Function *FindFunction(MemAddr address,
+                               const Function **nearest) const;
+
+  // Returns the public symbol at or below address, or NULL.
+  const PublicSymbol *FindPublicSymbol(MemAddr address) const;
+
+  // Returns the name of the source file with the given id, or NULL.
+  const char *FindFileName(int32_t id) const;
+
+  string name_;
+  size_t symbol_data_size_;
+
+  // Owns every record and string below except windows_frame_info_.
+  Arena arena_;
+
+  Table<File> files_;
+  Table<Function> functions_;
+  Table<Line> lines_;
+  Table<PublicSymbol> public_symbols_;
+  Table<CFIInitialRules> cfi_initial_rules_;
+  Table<CFIDeltaRules> cfi_delta_rules_;
+
+  // STACK WIN records, which only symbol files for Windows modules have,
+  // are kept as BasicSourceLineResolver keeps them: their containment
+  // rules need ContainedRangeMap.
+  ContainedRangeMap< MemAddr, linked_ptr<WindowsFrameInfo> >
+    windows_frame_info_[WindowsFrameInfo::STACK_INFO_LAST];
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_COMPACT_SOURCE_LINE_RESOLVER_TYPES_H__
@@ -0,0 +1,269 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// compact_source_line_resolver_unittest.cc: Unit tests for
+// CompactSourceLineResolver.  CompactSourceLineResolver must resolve every
+// address exactly as BasicSourceLineResolver does, so most of these tests
+// compare the two.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/compact_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/scoped_ptr.h"
+#include "processor/windows_frame_info.h"
+
+namespace {
+
+using std::string;
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CFIFrameInfo;
+using google_breakpad::CodeModule;
+using google_breakpad::CompactSourceLineResolver;
+using google_breakpad::SourceLineResolverInterface;
+using google_breakpad::StackFrame;
+using google_breakpad::WindowsFrameInfo;
+using google_breakpad::scoped_ptr;
+
+class TestCodeModule : public CodeModule {
+ public:
+  TestCodeModule(string code_file) : code_file_(code_file) {}
+  virtual ~TestCodeModule() {}
+
+  virtual u_int64_t base_address() const { return 0; }
+  virtual u_int64_t size() const { return 0xb000; }
+  virtual string code_file() const { return code_file_; }
+  virtual string code_identifier() const { return ""; }
+  virtual string debug_file() const { return ""; }
+  virtual string debug_identifier() const { return ""; }
+  virtual string version() const { return ""; }
+  virtual const CodeModule* Copy() const {
+    return new TestCodeModule(code_file_);
+  }
+
+ private:
+  string code_file_;
+};
+
+// Checks that RESOLVER gives the same results as EXPECTED_RESOLVER for
+// every address in MODULE below LIMIT.
+static void ExpectSameLookups(SourceLineResolverInterface *expected_resolver,
+                              SourceLineResolverInterface *resolver,
+                              const CodeModule *module, u_int64_t limit) {
+  for (u_int64_t address = 0; address < limit; address++) {
+    StackFrame expected;
+    expected.instruction = module->base_address() + address;
+    expected.module = module;
+    expected_resolver->FillSourceLineInfo(&expected);
+    scoped_ptr<CFIFrameInfo> expected_cfi(
+        expected_resolver->FindCFIFrameInfo(&expected));
+    scoped_ptr<WindowsFrameInfo> expected_windows(
+        expected_resolver->FindWindowsFrameInfo(&expected));
+
+    StackFrame frame;
+    frame.instruction = module->base_address() + address;
+    frame.module = module;
+    resolver->FillSourceLineInfo(&frame);
+    scoped_ptr<CFIFrameInfo> cfi(resolver->FindCFIFrameInfo(&frame));
+    scoped_ptr<WindowsFrameInfo> windows(resolver->FindWindowsFrameInfo(&frame));
+
+    ASSERT_EQ(expected.function_name, frame.function_name) << address;
+    ASSERT_EQ(expected.function_base, frame.function_base) << address;
+    ASSERT_EQ(expected.source_file_name, frame.source_file_name) << address;
+    ASSERT_EQ(expected.source_line, frame.source_line) << address;
+    ASSERT_EQ(expected.source_line_base, frame.source_line_base) << address;
+    ASSERT_EQ(expected_cfi.get() != NULL, cfi.get() != NULL) << address;
+    if (cfi.get())
+      ASSERT_EQ(expected_cfi->Serialize(), cfi->Serialize()) << address;
+    ASSERT_EQ(expected_windows.get() != NULL, windows.get() != NULL)
+        << address;
+    if (windows.get()) {
+      ASSERT_EQ(expected_windows->valid, windows->valid) << address;
+      ASSERT_EQ(expected_windows->parameter_size, windows->parameter_size)
+          << address;
+      ASSERT_EQ(expected_windows->program_string, windows->program_string)
+          << address;
+    }
+  }
+}
+
+class TestCompactSourceLineResolver : public ::testing::Test {
+public:
+  void SetUp() {
+    testdata_dir = string(getenv("srcdir") ? getenv("srcdir") : ".") +
+                         "/src/processor/testdata";
+  }
+
+  // Loads SYMBOL_DATA into both resolvers as MODULE, and checks that
+  // they agree on whether it loaded.
+  bool LoadBoth(const CodeModule *module, const string &symbol_data) {
+    string basic_data(symbol_data), compact_data(symbol_data);
+    bool basic_loaded =
+        basic_resolver.LoadModuleUsingMemoryBuffer(module, &basic_data[0]);
+    bool loaded = resolver.LoadModuleUsingMemoryBuffer(module,
+                                                       &compact_data[0]);
+    EXPECT_EQ(basic_loaded, loaded);
+    return loaded;
+  }
+
+  BasicSourceLineResolver basic_resolver;
+  CompactSourceLineResolver resolver;
+  string testdata_dir;
+};
+
+TEST_F(TestCompactSourceLineResolver, TestLoadAndResolve)
+{
+  const char *kModules[] = { "module0", "module1", "module2" };
+  for (size_t i = 0; i < sizeof(kModules) / sizeof(kModules[0]); i++) {
+    TestCodeModule module(kModules[i]);
+    string path = testdata_dir + "/" + kModules[i] + ".out";
+    ASSERT_TRUE(basic_resolver.LoadModule(&module, path));
+    ASSERT_TRUE(resolver.LoadModule(&module, path));
+    ASSERT_TRUE(resolver.HasModule(&module));
+    ASSERT_EQ(basic_resolver.LoadedSymbolDataSize(),
+              resolver.LoadedSymbolDataSize());
+    ExpectSameLookups(&basic_resolver, &resolver, &module, 0x5000);
+  }
+
+  StackFrame frame;
+  TestCodeModule module1("module1");
+  frame.instruction = 0x1000;
+  frame.module = &module1;
+  resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ(frame.function_name, "Function1_1");
+  ASSERT_EQ(frame.function_base, 0x1000);
+  ASSERT_EQ(frame.source_file_name, "file1_1.cc");
+  ASSERT_EQ(frame.source_line, 44);
+  ASSERT_EQ(frame.source_line_base, 0x1000);
+}
+
+TEST_F(TestCompactSourceLineResolver, TestInvalidLoads)
+{
+  TestCodeModule module3("module3");
+  ASSERT_FALSE(resolver.LoadModule(&module3,
+                                   testdata_dir + "/module3_bad.out"));
+  ASSERT_FALSE(resolver.HasModule(&module3));
+  TestCodeModule module4("module4");
+  ASSERT_FALSE(resolver.LoadModule(&module4,
+                                   testdata_dir + "/module4_bad.out"));
+  ASSERT_FALSE(resolver.HasModule(&module4));
+  TestCodeModule module5("module5");
+  ASSERT_FALSE(resolver.LoadModule(&module5,
+                                   testdata_dir + "/invalid-filename"));
+  ASSERT_FALSE(resolver.HasModule(&module5));
+}
+
+TEST_F(TestCompactSourceLineResolver, TestUnload)
+{
+  TestCodeModule module1("module1");
+  ASSERT_FALSE(resolver.HasModule(&module1));
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  ASSERT_TRUE(resolver.HasModule(&module1));
+  resolver.UnloadModule(&module1);
+  ASSERT_FALSE(resolver.HasModule(&module1));
+  ASSERT_EQ(0U, resolver.LoadedSymbolDataSize());
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  ASSERT_TRUE(resolver.HasModule(&module1));
+}
+
+// Conflicting and out-of-order records must be resolved as
+// BasicSourceLineResolver resolves them.
+TEST_F(TestCompactSourceLineResolver, TestConflictingRecords)
+{
+  TestCodeModule module("conflicts");
+  ASSERT_TRUE(LoadBoth(&module,
+      "MODULE Linux x86 000000000000000000000000000000000 conflicts\n"
+      "FILE 1 first.cc\n"
+      "FILE 1 second.cc\n"
+      "FILE 2 other.cc\n"
+      "FUNC 2000 100 8 Later\n"
+      "2000 10 7 1\n"
+      "2008 10 8 2\n"
+      "2040 20 9 2\n"
+      "FUNC 1000 200 4 Earlier\n"
+      "1000 100 3 2\n"
+      "1100 100 4 1\n"
+      "FUNC 1100 200 0 Overlapping\n"
+      "1100 200 5 1\n"
+      "FUNC 3000 0 0 Empty\n"
+      "PUBLIC 2800 c Public\n"
+      "PUBLIC 0 0 Ignored\n"
+      "PUBLIC 1800 4 Hidden\n"
+      "STACK CFI INIT 1000 100 .cfa: $esp 4 + .ra: .cfa 4 - ^\n"
+      "STACK CFI 1010 .cfa: $esp 8 +\n"
+      "STACK CFI INIT 1080 100 .cfa: $esp 12 + .ra: .cfa 4 - ^\n"
+      "STACK CFI 1020 .cfa: $esp 16 +\n"
+      "STACK CFI 1010 .cfa: $esp 20 +\n"
+      "STACK CFI INIT 1200 80 .cfa: $esp 4 + .ra: .cfa 4 - ^\n"
+      "STACK WIN 4 1000 200 1 0 8 4 0 0 0 1 $eip 4 + ^ =\n"
+      "STACK WIN 4 1010 20 1 0 8 4 0 0 0 1 $ebp 4 + ^ =\n"));
+  ExpectSameLookups(&basic_resolver, &resolver, &module, 0x4000);
+
+  StackFrame frame;
+  frame.instruction = 0x1150;
+  frame.module = &module;
+  resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ("Earlier", frame.function_name);
+  ASSERT_EQ("first.cc", frame.source_file_name);
+  ASSERT_EQ(4, frame.source_line);
+}
+
+TEST_F(TestCompactSourceLineResolver, TestDuplicatePublicSymbols)
+{
+  TestCodeModule module("duplicates");
+  ASSERT_FALSE(LoadBoth(&module,
+      "PUBLIC 2000 0 First\n"
+      "PUBLIC 1000 0 Other\n"
+      "PUBLIC 2000 0 Second\n"));
+  ASSERT_FALSE(resolver.HasModule(&module));
+}
+
+TEST_F(TestCompactSourceLineResolver, TestLineWithoutFunction)
+{
+  TestCodeModule module("orphan");
+  ASSERT_FALSE(LoadBoth(&module,
+      "FUNC 1000 10 0 Function\n"
+      "1000 10 1 1\n"
+      "PUBLIC 2000 0 Public\n"
+      "2000 10 2 1\n"));
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
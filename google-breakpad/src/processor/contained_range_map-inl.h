@@ -122,6 +122,11 @@ bool ContainedRangeMap<AddressType, EntryType>::StoreRange(
   if (contains_high)
     ++iterator_high;
 
+  // This range's set of children is about to change, so its index no longer
+  // reflects map_.
+  delete frozen_;
+  frozen_ = NULL;
+
   // Optimization: if the iterators are equal, no child ranges would be
   // moved.  Create the new child range with a NULL map to conserve space
   // in leaf nodes, of which there will be many.
@@ -164,15 +169,26 @@ bool ContainedRangeMap<AddressType, EntryType>::RetrieveRange(
   // contain a child at address, so return false.  If the supplied address
   // is lower than the base address of the child range, then it is not within
   // the child range, so return false.
-  MapConstIterator iterator = map_->lower_bound(address);
-  if (iterator == map_->end() || address < iterator->second->base_)
+  const ContainedRangeMap *child;
+  if (frozen_) {
+    size_t index = frozen_->LowerBound(address);
+    if (index == frozen_->size())
+      return false;
+    child = frozen_->ValueAtIndex(index);
+  } else {
+    MapConstIterator iterator = map_->lower_bound(address);
+    if (iterator == map_->end())
+      return false;
+    child = iterator->second;
+  }
+  if (address < child->base_)
     return false;
 
-  // The child in iterator->second contains the specified address.  Find out
-  // if it has a more-specific descendant that also contains it.  If it does,
-  // it will set |entry| appropriately.  If not, set |entry| to the child.
-  if (!iterator->second->RetrieveRange(address, entry))
-    *entry = iterator->second->entry_;
+  // The child contains the specified address.  Find out if it has a
+  // more-specific descendant that also contains it.  If it does, it will
+  // set |entry| appropriately.  If not, set |entry| to the child.
+  if (!child->RetrieveRange(address, entry))
+    *entry = child->entry_;
 
   return true;
 }
@@ -180,6 +196,9 @@ bool ContainedRangeMap<AddressType, EntryType>::RetrieveRange(
 
 template<typename AddressType, typename EntryType>
 void ContainedRangeMap<AddressType, EntryType>::Clear() {
+  delete frozen_;
+  frozen_ = NULL;
+
   if (map_) {
     MapConstIterator end = map_->end();
     for (MapConstIterator child = map_->begin(); child != end; ++child)
@@ -191,6 +210,21 @@ void ContainedRangeMap<AddressType, EntryType>::Clear() {
 }
 
 
+template<typename AddressType, typename EntryType>
+void ContainedRangeMap<AddressType, EntryType>::Freeze() {
+  if (!map_)
+    return;
+
+  MapConstIterator end = map_->end();
+  for (MapConstIterator child = map_->begin(); child != end; ++child)
+    child->second->Freeze();
+
+  if (!frozen_)
+    frozen_ = new FrozenIndex();
+  frozen_->Build(*map_);
+}
+
+
 }  // namespace google_breakpad
 
 
@@ -63,6 +63,8 @@
 
 #include <map>
 
+#include "processor/frozen_address_index.h"
+
 
 namespace google_breakpad {
 
@@ -75,7 +77,7 @@ class ContainedRangeMap {
   // The default constructor creates a ContainedRangeMap with no geometry
   // and no entry, and as such is only suitable for the root node of a
   // ContainedRangeMap tree.
-  ContainedRangeMap() : base_(), entry_(), map_(NULL) {}
+  ContainedRangeMap() : base_(), entry_(), map_(NULL), frozen_(NULL) {}
 
   ~ContainedRangeMap();
 
@@ -104,6 +106,13 @@ class ContainedRangeMap {
   // empty state when called on the root node.
   void Clear();
 
+  // Builds, for this range and each of its descendants, a contiguous index
+  // of child ranges that RetrieveRange searches instead of the underlying
+  // std::map.  Call this on the root node once all ranges have been stored.
+  // A subsequent StoreRange discards the index of each range whose set of
+  // children it changes.
+  void Freeze();
+
  private:
   friend class ContainedRangeMapSerializer<AddressType, EntryType>;
   friend class ModuleComparer;
@@ -120,7 +129,7 @@ class ContainedRangeMap {
   // by ContainedRangeMap when it creates a new child.
   ContainedRangeMap(const AddressType &base, const EntryType &entry,
                     AddressToRangeMap *map)
-      : base_(base), entry_(entry), map_(map) {}
+      : base_(base), entry_(entry), map_(map), frozen_(NULL) {}
 
   // The base address of this range.  The high address does not need to
   // be stored, because it is used as the key to an object in its parent's
@@ -141,6 +150,11 @@ class ContainedRangeMap {
   // address.  This is a pointer to avoid allocating map structures for
   // leaf nodes, where they are not needed.
   AddressToRangeMap *map_;
+
+  // A sorted index over map_, built by Freeze.  Like map_, this is only
+  // allocated for ranges that have children.
+  typedef FrozenAddressIndex<AddressType, ContainedRangeMap *> FrozenIndex;
+  FrozenIndex *frozen_;
 };
 
 
@@ -247,6 +247,21 @@ static bool RunTests() {
 
 #ifdef GENERATE_TEST_DATA
   printf("  };\n");
+#else  // GENERATE_TEST_DATA
+  // Freezing the map must not change the results of any lookup.
+  crm.Freeze();
+  for (unsigned int address = 0; address < test_high; ++address) {
+    int value;
+    if (!crm.RetrieveRange(address, &value))
+      value = 0;
+
+    if (value != test_data[address]) {
+      fprintf(stderr, "FAIL: frozen retrieve %d expected %d observed %d "
+              "@ %s:%d\n",
+              address, test_data[address], value, __FILE__, __LINE__);
+      return false;
+    }
+  }
 #endif  // GENERATE_TEST_DATA
 
   return true;
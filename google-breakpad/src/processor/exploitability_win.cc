@@ -202,24 +202,17 @@ ExploitabilityRating ExploitabilityWin::CheckPlatformExploitability() {
             return EXPLOITABILITY_ERR_PROCESSING;
             break;
         }
-        MinidumpMemoryRegion *instruction_region = 0;
-        if (memory_available) {
-          instruction_region =
-              memory_list->GetMemoryRegionForAddress(instruction_ptr);
-        }
-        if (!near_null && instruction_region &&
+        if (!near_null && memory_available &&
             context->GetContextCPU() == MD_CONTEXT_X86 &&
             (bad_read || bad_write)) {
           // Perform checks related to memory around instruction pointer.
-          u_int32_t memory_offset =
-              instruction_ptr - instruction_region->GetBase();
-          u_int32_t available_memory =
-              instruction_region->GetSize() - memory_offset;
-          available_memory = available_memory > kDisassembleBytesBeyondPC ?
-              kDisassembleBytesBeyondPC : available_memory;
+          // The code after it may continue into an adjacent region.
+          MinidumpProcessMemory process_memory(memory_list);
+          u_int8_t raw_memory[kDisassembleBytesBeyondPC];
+          size_t available_memory =
+              process_memory.GetBytesAtAddress(instruction_ptr, raw_memory,
+                                               sizeof(raw_memory));
           if (available_memory) {
-            const u_int8_t *raw_memory =
-                instruction_region->GetMemory() + memory_offset;
             DisassemblerX86 disassembler(raw_memory,
                                          available_memory,
                                          instruction_ptr);
@@ -43,6 +43,7 @@
 #include <map>
 #include <utility>
 
+#include "processor/logging.h"
 #include "processor/module_factory.h"
 #include "processor/scoped_ptr.h"
 
@@ -58,8 +59,9 @@ bool FastSourceLineResolver::ShouldDeleteMemoryBufferAfterLoadModule() {
   return false;
 }
 
-void FastSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
+int FastSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
   MemAddr address = frame->instruction - frame->module->base_address();
+  int filled = SourceLineLookupCache::FIELD_NONE;
 
   // First, look for a FUNC record that covers address. Use
   // RetrieveNearestRange instead of RetrieveRange so that, if there
@@ -81,6 +83,7 @@ void FastSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
     func.get()->CopyFrom(func_ptr);
     frame->function_name = func->name;
     frame->function_base = frame->module->base_address() + function_base;
+    filled |= SourceLineLookupCache::FIELD_FUNCTION;
 
     scoped_ptr<Line> line(new Line);
     const Line* line_ptr = 0;
@@ -91,9 +94,11 @@ void FastSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
       if (it != files_.end()) {
         frame->source_file_name =
             files_.find(line->source_file_id).GetValuePtr();
+        filled |= SourceLineLookupCache::FIELD_SOURCE_FILE_NAME;
       }
       frame->source_line = line->line;
       frame->source_line_base = frame->module->base_address() + line_base;
+      filled |= SourceLineLookupCache::FIELD_SOURCE_LINE;
     }
   } else if (public_symbols_.Retrieve(address,
                                       public_symbol_ptr, &public_address) &&
@@ -101,7 +106,9 @@ void FastSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
     public_symbol.get()->CopyFrom(public_symbol_ptr);
     frame->function_name = public_symbol->name;
     frame->function_base = frame->module->base_address() + public_address;
+    filled |= SourceLineLookupCache::FIELD_FUNCTION;
   }
+  return filled;
 }
 
 // WFI: WindowsFrameInfo.
@@ -138,9 +145,17 @@ WindowsFrameInfo FastSourceLineResolver::CopyWFI(const char *raw) {
 bool FastSourceLineResolver::Module::LoadMapFromMemory(char *mem_buffer) {
   if (!mem_buffer) return false;
 
-  const u_int32_t *map_sizes = reinterpret_cast<const u_int32_t*>(mem_buffer);
+  // The data starts with a magic number and format version, followed by
+  // the sizes of the maps.
+  const u_int32_t *header = reinterpret_cast<const u_int32_t*>(mem_buffer);
+  if (header[0] != kMagic_ || header[1] != kVersion_) {
+    BPLOG(ERROR) << "Serialized symbol data for " << name_ << " is not in "
+                 << "format version " << kVersion_;
+    return false;
+  }
+  const u_int32_t *map_sizes = header + 2;
 
-  unsigned int header_size = kNumberMaps_ * sizeof(unsigned int);
+  unsigned int header_size = (2 + kNumberMaps_) * sizeof(u_int32_t);
 
   // offsets[]: an array of offset addresses (with respect to mem_buffer),
   // for each "Static***Map" component of Module.
@@ -151,6 +166,9 @@ bool FastSourceLineResolver::Module::LoadMapFromMemory(char *mem_buffer) {
   for (int i = 1; i < kNumberMaps_; ++i) {
     offsets[i] = offsets[i - 1] + map_sizes[i - 1];
   }
+  // The data ends with a null terminator after the last map.
+  symbol_data_size_ = offsets[kNumberMaps_ - 1] + map_sizes[kNumberMaps_ - 1]
+                      + 1;
 
   // Use pointers to construct Static*Map data members in Module:
   int map_id = 0;
@@ -238,23 +256,35 @@ CFIFrameInfo *FastSourceLineResolver::Module::FindCFIFrameInfo(
     return NULL;
   }
 
+  // Find the first delta rule that falls within the initial rule's range,
+  // and the end of the delta rules that apply at the frame's address.
+  StaticMap<MemAddr, char>::iterator first_delta =
+    cfi_delta_rules_.lower_bound(initial_base);
+  StaticMap<MemAddr, char>::iterator end_delta = first_delta;
+  MemAddr cache_key = initial_base;
+  while (end_delta != cfi_delta_rules_.end() && end_delta.GetKey() <= address) {
+    cache_key = end_delta.GetKey();
+    end_delta++;
+  }
+
+  // If these rules have been assembled before, reuse them.
+  CFIFrameInfo *cached = FindCachedCFIFrameInfo(cache_key);
+  if (cached)
+    return cached;
+
   // Create a frame info structure, and populate it with the rules from
   // the STACK CFI INIT record.
   scoped_ptr<CFIFrameInfo> rules(new CFIFrameInfo());
   if (!ParseCFIRuleSet(initial_rules, rules.get()))
     return NULL;
 
-  // Find the first delta rule that falls within the initial rule's range.
-  StaticMap<MemAddr, char>::iterator delta =
-    cfi_delta_rules_.lower_bound(initial_base);
-
   // Apply delta rules up to and including the frame's address.
-  while (delta != cfi_delta_rules_.end() && delta.GetKey() <= address) {
+  for (StaticMap<MemAddr, char>::iterator delta = first_delta;
+       delta != end_delta; delta++) {
     ParseCFIRuleSet(delta.GetValuePtr(), rules.get());
-    delta++;
   }
 
-  return rules.release();
+  return CacheCFIFrameInfo(cache_key, rules.release());
 }
 
 }  // namespace google_breakpad
@@ -112,12 +112,12 @@ public SourceLineResolverBase::PublicSymbol {
 
 class FastSourceLineResolver::Module: public SourceLineResolverBase::Module {
  public:
-  explicit Module(const string &name) : name_(name) { }
+  explicit Module(const string &name) : name_(name), symbol_data_size_(0) { }
   virtual ~Module() { }
 
   // Looks up the given relative address, and fills the StackFrame struct
   // with the result.
-  virtual void LookupAddress(StackFrame *frame) const;
+  virtual int LookupAddress(StackFrame *frame) const;
 
   // Loads a map from the given buffer in char* type.
   virtual bool LoadMapFromMemory(char *memory_buffer);
@@ -135,9 +135,16 @@ class FastSourceLineResolver::Module: public SourceLineResolverBase::Module {
   // returned CFIFrameInfo object.
   virtual CFIFrameInfo *FindCFIFrameInfo(const StackFrame *frame) const;
 
+  virtual size_t SymbolDataSize() const { return symbol_data_size_; }
+
   // Number of serialized map components of Module.
   static const int kNumberMaps_ = 5 + WindowsFrameInfo::STACK_INFO_LAST;
 
+  // The magic number and format version that serialized data starts with.
+  // Change the version whenever the layout of the data changes.
+  static const u_int32_t kMagic_ = 0x46535042;  // "BPSF", little-endian
+  static const u_int32_t kVersion_ = 1;
+
  private:
   friend class FastSourceLineResolver;
   friend class ModuleComparer;
@@ -172,6 +179,9 @@ class FastSourceLineResolver::Module: public SourceLineResolverBase::Module {
   // this map, or the end of the range as given by the cfi_initial_rules_
   // entry (which FindCFIFrameInfo looks up first).
   StaticMap<MemAddr, char> cfi_delta_rules_;
+
+  // The size of the serialized data LoadMapFromMemory loaded.
+  size_t symbol_data_size_;
 };
 
 }  // namespace google_breakpad
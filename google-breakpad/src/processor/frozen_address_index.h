@@ -0,0 +1,142 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// frozen_address_index.h: A contiguous, read-only index over the keys of
+// an address-keyed std::map.
+//
+// RangeMap, AddressMap and ContainedRangeMap store their contents in
+// std::map, which is convenient while a symbol file is being loaded but
+// makes every lookup chase a chain of tree nodes scattered across the heap.
+// Once a map is fully populated it can be "frozen": FrozenAddressIndex
+// copies the map's keys into a sorted vector and records, alongside each
+// key, a pointer to the value stored in the map.  Lookups then perform a
+// branch-free binary search over the key vector, touching only a handful of
+// cache lines, and dereference a single value pointer at the end.
+//
+// The index does not own the values it points to; they remain in the
+// std::map, whose nodes are never relocated.  Any modification of the map
+// invalidates the index, so owners must Clear it before mutating the map.
+// Copying an index produces an empty one, because the copied pointers would
+// refer to the source map's nodes.
+
+#ifndef PROCESSOR_FROZEN_ADDRESS_INDEX_H__
+#define PROCESSOR_FROZEN_ADDRESS_INDEX_H__
+
+#include <map>
+#include <vector>
+
+namespace google_breakpad {
+
+template<typename AddressType, typename ValueType>
+class FrozenAddressIndex {
+ public:
+  FrozenAddressIndex() : keys_(), values_() {}
+  FrozenAddressIndex(const FrozenAddressIndex &) : keys_(), values_() {}
+  FrozenAddressIndex &operator=(const FrozenAddressIndex &) {
+    Clear();
+    return *this;
+  }
+
+  // Replaces the contents of the index with the keys of map, and pointers
+  // to its values, in ascending key order.
+  void Build(const std::map<AddressType, ValueType> &map) {
+    Clear();
+    keys_.reserve(map.size());
+    values_.reserve(map.size());
+    for (typename std::map<AddressType, ValueType>::const_iterator iterator =
+             map.begin();
+         iterator != map.end(); ++iterator) {
+      keys_.push_back(iterator->first);
+      values_.push_back(&iterator->second);
+    }
+  }
+
+  // Releases the index's storage.  After this, empty() returns true.
+  void Clear() {
+    std::vector<AddressType>().swap(keys_);
+    std::vector<const ValueType *>().swap(values_);
+  }
+
+  bool empty() const { return keys_.empty(); }
+  size_t size() const { return keys_.size(); }
+
+  // Returns the index of the first key that is not less than address, or
+  // size() if every key is less than address.
+  size_t LowerBound(const AddressType &address) const {
+    return Search<false>(address);
+  }
+
+  // Returns the index of the first key that is greater than address, or
+  // size() if no key is greater than address.
+  size_t UpperBound(const AddressType &address) const {
+    return Search<true>(address);
+  }
+
+  const AddressType &KeyAtIndex(size_t index) const { return keys_[index]; }
+  const ValueType &ValueAtIndex(size_t index) const {
+    return *values_[index];
+  }
+
+ private:
+  // Binary search whose loop body contains no data-dependent branch: the
+  // comparison only selects the next base pointer, which compilers lower to
+  // a conditional move.  The loop trip count depends only on size(), so the
+  // search never suffers a branch misprediction.  If or_equal is true, keys
+  // equal to address are skipped, giving upper_bound semantics.
+  template<bool or_equal>
+  size_t Search(const AddressType &address) const {
+    size_t count = keys_.size();
+    if (count == 0)
+      return 0;
+
+    const AddressType *first = &keys_[0];
+    const AddressType *base = first;
+    while (count > 1) {
+      size_t half = count / 2;
+      base = Before<or_equal>(base[half], address) ? base + half : base;
+      count -= half;
+    }
+    return (base - first) + Before<or_equal>(*base, address);
+  }
+
+  template<bool or_equal>
+  static bool Before(const AddressType &key, const AddressType &address) {
+    return or_equal ? !(address < key) : key < address;
+  }
+
+  // The keys of the map from which the index was built, in ascending order.
+  std::vector<AddressType> keys_;
+
+  // values_[i] points to the map's value for keys_[i].
+  std::vector<const ValueType *> values_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_FROZEN_ADDRESS_INDEX_H__
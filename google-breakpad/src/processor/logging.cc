@@ -48,6 +48,16 @@
 
 namespace google_breakpad {
 
+LogStream::Severity LogStream::minimum_severity_ = LogStream::SEVERITY_INFO;
+
+// static
+bool LogStream::ShouldLogOccurrence(LogOccurrenceCounter *counter, int n) {
+  pthread_mutex_lock(&counter->lock);
+  u_int64_t count = counter->count++;
+  pthread_mutex_unlock(&counter->lock);
+  return n <= 1 || count % n == 0;
+}
+
 LogStream::LogStream(std::ostream &stream, Severity severity,
                      const char *file, int line)
     : stream_(stream) {
@@ -52,11 +52,29 @@
 // BPLOG_INIT(&argc, &argv); before any logging can be performed; define
 // BPLOG_INIT appropriately if initialization is required.
 //
+// Messages less severe than a threshold are discarded before their
+// arguments are evaluated, so that disabled logging in hot paths costs no
+// more than a comparison.  The threshold is the greater of
+// BPLOG_MINIMUM_SEVERITY, fixed at compile time (for example,
+// -DBPLOG_MINIMUM_SEVERITY=SEVERITY_ERROR), and
+// LogStream::minimum_severity(), which may be changed at run time.  When
+// the compile-time threshold disables a severity, the compiler drops its
+// logging statements entirely.
+//
+// Chatty messages may be logged with
+//   BPLOG_EVERY_N(severity, n) << "message";
+// which logs only the first of every n times that statement is reached.
+// Each such statement keeps its own count in a function-local static, so
+// the macro expands to more than one statement: don't use it as the
+// unbraced body of an if, else, or loop, or twice on one line.
+//
 // Author: Mark Mentovai
 
 #ifndef PROCESSOR_LOGGING_H__
 #define PROCESSOR_LOGGING_H__
 
+#include <pthread.h>
+
 #include <iostream>
 #include <string>
 
@@ -77,6 +95,16 @@ namespace google_breakpad {
 #undef ERROR
 #endif
 
+// The count of times one BPLOG_EVERY_N statement has been reached.  It is
+// initialized statically with BPLOG_OCCURRENCE_COUNTER_INITIALIZER, so it
+// needs no thread-unsafe construction.
+struct LogOccurrenceCounter {
+  pthread_mutex_t lock;
+  u_int64_t count;
+};
+
+#define BPLOG_OCCURRENCE_COUNTER_INITIALIZER { PTHREAD_MUTEX_INITIALIZER, 0 }
+
 class LogStream {
  public:
   enum Severity {
@@ -97,7 +125,23 @@ class LogStream {
     return stream_ << t;
   }
 
+  // The least severe messages that are logged.  The default is
+  // SEVERITY_INFO, which logs everything.  Set this before any threads
+  // that may log are started.
+  static Severity minimum_severity() { return minimum_severity_; }
+  static void set_minimum_severity(Severity severity) {
+    minimum_severity_ = severity;
+  }
+
+  // Counts an occurrence of the statement that owns |counter|, and returns
+  // true if it should log this time: that is, if it has been reached a
+  // multiple of |n| times before.  This is the test behind BPLOG_EVERY_N,
+  // and is thread-safe.
+  static bool ShouldLogOccurrence(LogOccurrenceCounter *counter, int n);
+
  private:
+  static Severity minimum_severity_;
+
   std::ostream &stream_;
 
   // Disallow copy constructor and assignment operator
@@ -133,8 +177,18 @@ int ErrnoString(std::string *error_string);
 #define BPLOG_INIT(pargc, pargv)
 #endif  // BPLOG_INIT
 
+#ifndef BPLOG_MINIMUM_SEVERITY
+#define BPLOG_MINIMUM_SEVERITY SEVERITY_INFO
+#endif  // BPLOG_MINIMUM_SEVERITY
+
+#define BPLOG_ENABLED(severity) \
+    (google_breakpad::LogStream::SEVERITY_ ## severity >= \
+         google_breakpad::LogStream::BPLOG_MINIMUM_SEVERITY && \
+     google_breakpad::LogStream::SEVERITY_ ## severity >= \
+         google_breakpad::LogStream::minimum_severity())
+
 #ifndef BPLOG
-#define BPLOG(severity) BPLOG_ ## severity
+#define BPLOG(severity) BPLOG_IF(severity, true)
 #endif  // BPLOG
 
 #ifndef BPLOG_INFO
@@ -156,7 +210,18 @@ int ErrnoString(std::string *error_string);
 #endif  // BPLOG_ERROR
 
 #define BPLOG_IF(severity, condition) \
-    !(condition) ? (void) 0 : \
-                   google_breakpad::LogMessageVoidify() & BPLOG(severity)
+    !(BPLOG_ENABLED(severity) && (condition)) ? (void) 0 : \
+        google_breakpad::LogMessageVoidify() & BPLOG_ ## severity
+
+#define BPLOG_CONCAT_INNER(a, b) a ## b
+#define BPLOG_CONCAT(a, b) BPLOG_CONCAT_INNER(a, b)
+#define BPLOG_OCCURRENCE_COUNTER \
+    BPLOG_CONCAT(bplog_occurrence_counter_, __LINE__)
+
+#define BPLOG_EVERY_N(severity, n) \
+    static google_breakpad::LogOccurrenceCounter BPLOG_OCCURRENCE_COUNTER = \
+        BPLOG_OCCURRENCE_COUNTER_INITIALIZER; \
+    BPLOG_IF(severity, google_breakpad::LogStream::ShouldLogOccurrence( \
+                           &BPLOG_OCCURRENCE_COUNTER, n))
 
 #endif  // PROCESSOR_LOGGING_H__
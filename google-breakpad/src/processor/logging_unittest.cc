@@ -0,0 +1,144 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// logging_unittest.cc: Unit tests for Breakpad logging's severity
+// thresholds and BPLOG_EVERY_N.
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "processor/logging.h"
+
+namespace {
+
+using google_breakpad::LogStream;
+using std::ostringstream;
+using std::streambuf;
+using std::string;
+
+// Captures what is logged to std::clog and std::cerr, and restores the
+// default threshold afterwards.
+class LoggingTest : public ::testing::Test {
+ public:
+  void SetUp() {
+    saved_clog_ = std::clog.rdbuf(info_.rdbuf());
+    saved_cerr_ = std::cerr.rdbuf(error_.rdbuf());
+    evaluations_ = 0;
+  }
+
+  void TearDown() {
+    std::clog.rdbuf(saved_clog_);
+    std::cerr.rdbuf(saved_cerr_);
+    LogStream::set_minimum_severity(LogStream::SEVERITY_INFO);
+  }
+
+  // Returns a value to log, counting how often it is asked for.
+  string Evaluate() {
+    ++evaluations_;
+    return "evaluated";
+  }
+
+  ostringstream info_, error_;
+  streambuf *saved_clog_, *saved_cerr_;
+  int evaluations_;
+};
+
+TEST_F(LoggingTest, LogsAtDefaultThreshold) {
+  EXPECT_EQ(LogStream::SEVERITY_INFO, LogStream::minimum_severity());
+  BPLOG(INFO) << Evaluate();
+  BPLOG(ERROR) << Evaluate();
+  EXPECT_EQ(2, evaluations_);
+  EXPECT_NE(string::npos, info_.str().find("INFO: evaluated\n"));
+  EXPECT_NE(string::npos, error_.str().find("ERROR: evaluated\n"));
+}
+
+TEST_F(LoggingTest, DisabledStatementsSkipArguments) {
+  LogStream::set_minimum_severity(LogStream::SEVERITY_ERROR);
+  BPLOG(INFO) << Evaluate();
+  BPLOG_IF(INFO, true) << Evaluate();
+  EXPECT_EQ(0, evaluations_);
+  EXPECT_EQ("", info_.str());
+
+  BPLOG(ERROR) << Evaluate();
+  EXPECT_EQ(1, evaluations_);
+  EXPECT_NE(string::npos, error_.str().find("ERROR: evaluated\n"));
+}
+
+TEST_F(LoggingTest, FalseConditionSkipsArguments) {
+  BPLOG_IF(ERROR, false) << Evaluate();
+  EXPECT_EQ(0, evaluations_);
+  EXPECT_EQ("", error_.str());
+}
+
+TEST_F(LoggingTest, EveryN) {
+  for (int i = 0; i < 10; ++i) {
+    BPLOG_EVERY_N(INFO, 4) << "occurrence " << i;
+  }
+  EXPECT_EQ(string::npos, info_.str().find("occurrence 1\n"));
+  EXPECT_NE(string::npos, info_.str().find("occurrence 0\n"));
+  EXPECT_NE(string::npos, info_.str().find("occurrence 4\n"));
+  EXPECT_NE(string::npos, info_.str().find("occurrence 8\n"));
+
+  // Disabled statements don't count as occurrences.
+  LogStream::set_minimum_severity(LogStream::SEVERITY_ERROR);
+  for (int i = 0; i < 3; ++i) {
+    BPLOG_EVERY_N(INFO, 2) << Evaluate();
+  }
+  EXPECT_EQ(0, evaluations_);
+  LogStream::set_minimum_severity(LogStream::SEVERITY_INFO);
+}
+
+TEST_F(LoggingTest, OccurrencesAreCountedByStatement) {
+  for (int i = 0; i < 3; ++i) {
+    BPLOG_EVERY_N(INFO, 2) << "first " << i;
+    BPLOG_EVERY_N(INFO, 2) << "second " << i;
+  }
+  EXPECT_NE(string::npos, info_.str().find("first 0\n"));
+  EXPECT_NE(string::npos, info_.str().find("second 0\n"));
+  EXPECT_EQ(string::npos, info_.str().find("first 1\n"));
+  EXPECT_EQ(string::npos, info_.str().find("second 1\n"));
+  EXPECT_NE(string::npos, info_.str().find("first 2\n"));
+  EXPECT_NE(string::npos, info_.str().find("second 2\n"));
+
+  google_breakpad::LogOccurrenceCounter counter =
+      BPLOG_OCCURRENCE_COUNTER_INITIALIZER;
+  EXPECT_TRUE(LogStream::ShouldLogOccurrence(&counter, 2));
+  EXPECT_FALSE(LogStream::ShouldLogOccurrence(&counter, 2));
+  EXPECT_TRUE(LogStream::ShouldLogOccurrence(&counter, 2));
+  EXPECT_TRUE(LogStream::ShouldLogOccurrence(&counter, 1));
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
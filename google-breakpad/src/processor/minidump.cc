@@ -48,6 +48,8 @@ typedef SSIZE_T ssize_t;
 #define PRIx32 "lx"
 #define snprintf _snprintf
 #else  // _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #define O_BINARY 0
 #endif  // _WIN32
@@ -1100,7 +1102,8 @@ u_int32_t MinidumpMemoryRegion::max_bytes_ = 1024 * 1024;  // 1MB
 MinidumpMemoryRegion::MinidumpMemoryRegion(Minidump* minidump)
     : MinidumpObject(minidump),
       descriptor_(NULL),
-      memory_(NULL) {
+      memory_(NULL),
+      mapped_memory_(NULL) {
 }
 
 
@@ -1110,6 +1113,7 @@ MinidumpMemoryRegion::~MinidumpMemoryRegion() {
 
 
 void MinidumpMemoryRegion::SetDescriptor(MDMemoryDescriptor* descriptor) {
+  FreeMemory();
   descriptor_ = descriptor;
   valid_ = descriptor &&
            descriptor_->memory.data_size <=
@@ -1124,6 +1128,9 @@ const u_int8_t* MinidumpMemoryRegion::GetMemory() const {
     return NULL;
   }
 
+  if (mapped_memory_)
+    return mapped_memory_;
+
   if (!memory_) {
     if (descriptor_->memory.data_size == 0) {
       BPLOG(ERROR) << "MinidumpMemoryRegion is empty";
@@ -1135,6 +1142,15 @@ const u_int8_t* MinidumpMemoryRegion::GetMemory() const {
       return NULL;
     }
 
+    if (minidump_->mapped()) {
+      mapped_memory_ =
+          minidump_->ReadBytesInPlace(descriptor_->memory.data_size);
+      if (!mapped_memory_) {
+        BPLOG(ERROR) << "MinidumpMemoryRegion could not read memory region";
+      }
+      return mapped_memory_;
+    }
+
     if (descriptor_->memory.data_size > max_bytes_) {
       BPLOG(ERROR) << "MinidumpMemoryRegion size " <<
                       descriptor_->memory.data_size << " exceeds maximum " <<
@@ -1180,6 +1196,7 @@ u_int32_t MinidumpMemoryRegion::GetSize() const {
 void MinidumpMemoryRegion::FreeMemory() {
   delete memory_;
   memory_ = NULL;
+  mapped_memory_ = NULL;
 }
 
 
@@ -1202,10 +1219,10 @@ bool MinidumpMemoryRegion::GetMemoryAtAddressInternal(u_int64_t address,
       sizeof(T) > numeric_limits<u_int64_t>::max() - address ||
       address + sizeof(T) > descriptor_->start_of_memory_range +
                             descriptor_->memory.data_size) {
-    BPLOG(INFO) << "MinidumpMemoryRegion request out of range: " <<
-                    HexString(address) << "+" << sizeof(T) << "/" <<
-                    HexString(descriptor_->start_of_memory_range) << "+" <<
-                    HexString(descriptor_->memory.data_size);
+    BPLOG_EVERY_N(INFO, 100) << "MinidumpMemoryRegion request out of range: " <<
+        HexString(address) << "+" << sizeof(T) << "/" <<
+        HexString(descriptor_->start_of_memory_range) << "+" <<
+        HexString(descriptor_->memory.data_size);
     return false;
   }
 
@@ -1215,10 +1232,10 @@ bool MinidumpMemoryRegion::GetMemoryAtAddressInternal(u_int64_t address,
     return false;
   }
 
-  // If the CPU requires memory accesses to be aligned, this can crash.
-  // x86 and ppc are able to cope, though.
-  *value = *reinterpret_cast<const T*>(
-      &memory[address - descriptor_->start_of_memory_range]);
+  // Memory in a mapped minidump is only as aligned as the minidump file
+  // left it, so copy the value out rather than dereferencing it in place.
+  memcpy(value, &memory[address - descriptor_->start_of_memory_range],
+         sizeof(T));
 
   if (minidump_->swap())
     Swap(value);
@@ -1605,8 +1622,10 @@ MinidumpModule::MinidumpModule(Minidump* minidump)
       module_(),
       name_(NULL),
       cv_record_(NULL),
+      cv_record_data_(NULL),
       cv_record_signature_(MD_CVINFOUNKNOWN_SIGNATURE),
-      misc_record_(NULL) {
+      misc_record_(NULL),
+      misc_record_data_(NULL) {
 }
 
 
@@ -1623,9 +1642,11 @@ bool MinidumpModule::Read() {
   name_ = NULL;
   delete cv_record_;
   cv_record_ = NULL;
+  cv_record_data_ = NULL;
   cv_record_signature_ = MD_CVINFOUNKNOWN_SIGNATURE;
   delete misc_record_;
   misc_record_ = NULL;
+  misc_record_data_ = NULL;
 
   module_valid_ = false;
   has_debug_info_ = false;
@@ -1791,11 +1812,11 @@ string MinidumpModule::debug_file() const {
 
   string file;
   // Prefer the CodeView record if present.
-  if (cv_record_) {
+  if (cv_record_data_) {
     if (cv_record_signature_ == MD_CVINFOPDB70_SIGNATURE) {
       // It's actually an MDCVInfoPDB70 structure.
       const MDCVInfoPDB70* cv_record_70 =
-          reinterpret_cast<const MDCVInfoPDB70*>(&(*cv_record_)[0]);
+          reinterpret_cast<const MDCVInfoPDB70*>(cv_record_data_);
       assert(cv_record_70->cv_signature == MD_CVINFOPDB70_SIGNATURE);
 
       // GetCVRecord guarantees pdb_file_name is null-terminated.
@@ -1803,7 +1824,7 @@ string MinidumpModule::debug_file() const {
     } else if (cv_record_signature_ == MD_CVINFOPDB20_SIGNATURE) {
       // It's actually an MDCVInfoPDB20 structure.
       const MDCVInfoPDB20* cv_record_20 =
-          reinterpret_cast<const MDCVInfoPDB20*>(&(*cv_record_)[0]);
+          reinterpret_cast<const MDCVInfoPDB20*>(cv_record_data_);
       assert(cv_record_20->cv_header.signature == MD_CVINFOPDB20_SIGNATURE);
 
       // GetCVRecord guarantees pdb_file_name is null-terminated.
@@ -1816,9 +1837,9 @@ string MinidumpModule::debug_file() const {
 
   if (file.empty()) {
     // No usable CodeView record.  Try the miscellaneous debug record.
-    if (misc_record_) {
+    if (misc_record_data_) {
       const MDImageDebugMisc* misc_record =
-          reinterpret_cast<const MDImageDebugMisc *>(&(*misc_record_)[0]);
+          reinterpret_cast<const MDImageDebugMisc *>(misc_record_data_);
       if (!misc_record->unicode) {
         // If it's not Unicode, just stuff it into the string.  It's unclear
         // if misc_record->data is 0-terminated, so use an explicit size.
@@ -1872,11 +1893,11 @@ string MinidumpModule::debug_identifier() const {
   string identifier;
 
   // Use the CodeView record if present.
-  if (cv_record_) {
+  if (cv_record_data_) {
     if (cv_record_signature_ == MD_CVINFOPDB70_SIGNATURE) {
       // It's actually an MDCVInfoPDB70 structure.
       const MDCVInfoPDB70* cv_record_70 =
-          reinterpret_cast<const MDCVInfoPDB70*>(&(*cv_record_)[0]);
+          reinterpret_cast<const MDCVInfoPDB70*>(cv_record_data_);
       assert(cv_record_70->cv_signature == MD_CVINFOPDB70_SIGNATURE);
 
       // Use the same format that the MS symbol server uses in filesystem
@@ -1900,7 +1921,7 @@ string MinidumpModule::debug_identifier() const {
     } else if (cv_record_signature_ == MD_CVINFOPDB20_SIGNATURE) {
       // It's actually an MDCVInfoPDB20 structure.
       const MDCVInfoPDB20* cv_record_20 =
-          reinterpret_cast<const MDCVInfoPDB20*>(&(*cv_record_)[0]);
+          reinterpret_cast<const MDCVInfoPDB20*>(cv_record_data_);
       assert(cv_record_20->cv_header.signature == MD_CVINFOPDB20_SIGNATURE);
 
       // Use the same format that the MS symbol server uses in filesystem
@@ -1966,13 +1987,33 @@ const CodeModule* MinidumpModule::Copy() const {
 }
 
 
+const u_int8_t* MinidumpModule::ReadRecord(u_int32_t size,
+                                           vector<u_int8_t>** copy) {
+  // A record in a mapped minidump is used where it lies, unless it must be
+  // byte-swapped, or is not aligned well enough to be accessed as a
+  // structure.
+  if (minidump_->mapped() && !minidump_->swap()) {
+    const u_int8_t* bytes = minidump_->ReadBytesInPlace(size);
+    if (!bytes || reinterpret_cast<size_t>(bytes) % sizeof(u_int32_t) == 0)
+      return bytes;
+    *copy = new vector<u_int8_t>(bytes, bytes + size);
+    return &(**copy)[0];
+  }
+
+  *copy = new vector<u_int8_t>(size);
+  if (!minidump_->ReadBytes(&(**copy)[0], size))
+    return NULL;
+  return &(**copy)[0];
+}
+
+
 const u_int8_t* MinidumpModule::GetCVRecord(u_int32_t* size) {
   if (!module_valid_) {
     BPLOG(ERROR) << "Invalid MinidumpModule for GetCVRecord";
     return NULL;
   }
 
-  if (!cv_record_) {
+  if (!cv_record_data_) {
     // This just guards against 0-sized CodeView records; more specific checks
     // are used when the signature is checked against various structure types.
     if (module_.cv_record.data_size == 0) {
@@ -1998,18 +2039,19 @@ const u_int8_t* MinidumpModule::GetCVRecord(u_int32_t* size) {
     // variable-sized due to their pdb_file_name fields; these structures
     // are not MDCVInfoPDB70_minsize or MDCVInfoPDB20_minsize and treating
     // them as such would result in incomplete structures or overruns.
-    scoped_ptr< vector<u_int8_t> > cv_record(
-        new vector<u_int8_t>(module_.cv_record.data_size));
-
-    if (!minidump_->ReadBytes(&(*cv_record)[0], module_.cv_record.data_size)) {
+    vector<u_int8_t>* cv_record_copy = NULL;
+    const u_int8_t* cv_data = ReadRecord(module_.cv_record.data_size,
+                                         &cv_record_copy);
+    scoped_ptr< vector<u_int8_t> > cv_record(cv_record_copy);
+    if (!cv_data) {
       BPLOG(ERROR) << "MinidumpModule could not read CodeView record";
       return NULL;
     }
 
     u_int32_t signature = MD_CVINFOUNKNOWN_SIGNATURE;
     if (module_.cv_record.data_size > sizeof(signature)) {
-      MDCVInfoPDB70* cv_record_signature =
-          reinterpret_cast<MDCVInfoPDB70*>(&(*cv_record)[0]);
+      const MDCVInfoPDB70* cv_record_signature =
+          reinterpret_cast<const MDCVInfoPDB70*>(cv_data);
       signature = cv_record_signature->cv_signature;
       if (minidump_->swap())
         Swap(&signature);
@@ -2036,7 +2078,7 @@ const u_int8_t* MinidumpModule::GetCVRecord(u_int32_t* size) {
 
       // The last field of either structure is null-terminated 8-bit character
       // data.  Ensure that it's null-terminated.
-      if ((*cv_record)[module_.cv_record.data_size - 1] != '\0') {
+      if (cv_data[module_.cv_record.data_size - 1] != '\0') {
         BPLOG(ERROR) << "MinidumpModule CodeView7 record string is not "
                         "0-terminated";
         return NULL;
@@ -2062,7 +2104,7 @@ const u_int8_t* MinidumpModule::GetCVRecord(u_int32_t* size) {
 
       // The last field of either structure is null-terminated 8-bit character
       // data.  Ensure that it's null-terminated.
-      if ((*cv_record)[module_.cv_record.data_size - 1] != '\0') {
+      if (cv_data[module_.cv_record.data_size - 1] != '\0') {
         BPLOG(ERROR) << "MindumpModule CodeView2 record string is not "
                         "0-terminated";
         return NULL;
@@ -2075,16 +2117,17 @@ const u_int8_t* MinidumpModule::GetCVRecord(u_int32_t* size) {
     // don't bail out here - allow the data to be returned to the user,
     // although byte-swapping can't be done.
 
-    // Store the vector type because that's how storage was allocated, but
-    // return it casted to u_int8_t*.
+    // Store the vector type because that's how storage was allocated, if
+    // the record was copied, but return it casted to u_int8_t*.
     cv_record_ = cv_record.release();
+    cv_record_data_ = cv_data;
     cv_record_signature_ = signature;
   }
 
   if (size)
     *size = module_.cv_record.data_size;
 
-  return &(*cv_record_)[0];
+  return cv_record_data_;
 }
 
 
@@ -2094,7 +2137,7 @@ const MDImageDebugMisc* MinidumpModule::GetMiscRecord(u_int32_t* size) {
     return NULL;
   }
 
-  if (!misc_record_) {
+  if (!misc_record_data_) {
     if (module_.misc_record.data_size == 0) {
       return NULL;
     }
@@ -2125,16 +2168,18 @@ const MDImageDebugMisc* MinidumpModule::GetMiscRecord(u_int32_t* size) {
     // because the MDImageDebugMisc is variable-sized due to its data field;
     // this structure is not MDImageDebugMisc_minsize and treating it as such
     // would result in an incomplete structure or an overrun.
-    scoped_ptr< vector<u_int8_t> > misc_record_mem(
-        new vector<u_int8_t>(module_.misc_record.data_size));
-    MDImageDebugMisc* misc_record =
-        reinterpret_cast<MDImageDebugMisc*>(&(*misc_record_mem)[0]);
-
-    if (!minidump_->ReadBytes(misc_record, module_.misc_record.data_size)) {
+    vector<u_int8_t>* misc_record_copy = NULL;
+    const u_int8_t* misc_data = ReadRecord(module_.misc_record.data_size,
+                                           &misc_record_copy);
+    scoped_ptr< vector<u_int8_t> > misc_record_mem(misc_record_copy);
+    if (!misc_data) {
       BPLOG(ERROR) << "MinidumpModule could not read miscellaneous debugging "
                       "record";
       return NULL;
     }
+    // Only a copied record is byte-swapped, so only a copy is modified.
+    MDImageDebugMisc* misc_record = reinterpret_cast<MDImageDebugMisc*>(
+        const_cast<u_int8_t*>(misc_data));
 
     if (minidump_->swap()) {
       Swap(&misc_record->data_type);
@@ -2164,15 +2209,16 @@ const MDImageDebugMisc* MinidumpModule::GetMiscRecord(u_int32_t* size) {
       return NULL;
     }
 
-    // Store the vector type because that's how storage was allocated, but
-    // return it casted to MDImageDebugMisc*.
+    // Store the vector type because that's how storage was allocated, if
+    // the record was copied, but return it casted to MDImageDebugMisc*.
     misc_record_ = misc_record_mem.release();
+    misc_record_data_ = misc_data;
   }
 
   if (size)
     *size = module_.misc_record.data_size;
 
-  return reinterpret_cast<MDImageDebugMisc*>(&(*misc_record_)[0]);
+  return reinterpret_cast<const MDImageDebugMisc*>(misc_record_data_);
 }
 
 
@@ -2465,8 +2511,8 @@ const MinidumpModule* MinidumpModuleList::GetModuleForAddress(
 
   unsigned int module_index;
   if (!range_map_->RetrieveRange(address, &module_index, NULL, NULL)) {
-    BPLOG(INFO) << "MinidumpModuleList has no module at " <<
-                   HexString(address);
+    BPLOG_EVERY_N(INFO, 100) << "MinidumpModuleList has no module at " <<
+        HexString(address);
     return NULL;
   }
 
@@ -2682,6 +2728,10 @@ bool MinidumpMemoryList::Read(u_int32_t expected_size) {
     regions_ = regions.release();
   }
 
+  // Index the regions for GetMemoryRegionForAddress, now that they're all
+  // known.
+  range_map_->Freeze();
+
   region_count_ = region_count;
 
   valid_ = true;
@@ -2756,6 +2806,112 @@ void MinidumpMemoryList::Print() {
 }
 
 
+//
+// MinidumpProcessMemory
+//
+
+
+MinidumpProcessMemory::MinidumpProcessMemory(MinidumpMemoryList* memory_list)
+    : memory_list_(memory_list),
+      base_(0),
+      size_(0) {
+  RangeMap<u_int64_t, unsigned int>* range_map = memory_list_->range_map_;
+  int count = memory_list_->valid_ ? range_map->GetCount() : 0;
+  if (count == 0)
+    return;
+
+  unsigned int index;
+  u_int64_t last_base, last_size;
+  range_map->RetrieveRangeAtIndex(0, &index, &base_, NULL);
+  range_map->RetrieveRangeAtIndex(count - 1, &index, &last_base, &last_size);
+  u_int64_t span = last_base - base_ + last_size;
+  size_ = span > numeric_limits<u_int32_t>::max() ?
+          numeric_limits<u_int32_t>::max() : static_cast<u_int32_t>(span);
+}
+
+
+size_t MinidumpProcessMemory::GetBytesAtAddress(u_int64_t address,
+                                                u_int8_t* buffer,
+                                                size_t size) const {
+  if (!memory_list_->valid_)
+    return 0;
+
+  size_t copied = 0;
+  while (copied < size) {
+    u_int64_t next_address = address + copied;
+    // Stop at the top of the address space rather than wrapping around.
+    if (next_address < address)
+      break;
+
+    // A gap in the memory list ends the read.
+    unsigned int region_index;
+    u_int64_t region_base, region_size;
+    if (!memory_list_->range_map_->RetrieveRange(next_address, &region_index,
+                                                 &region_base, &region_size))
+      break;
+
+    const u_int8_t* memory = (*memory_list_->regions_)[region_index].GetMemory();
+    if (!memory)
+      break;
+
+    u_int64_t offset = next_address - region_base;
+    u_int64_t available = region_size - offset;
+    size_t count = available < size - copied ?
+                   static_cast<size_t>(available) : size - copied;
+    memcpy(buffer + copied, memory + offset, count);
+    copied += count;
+  }
+  return copied;
+}
+
+
+template<typename T>
+bool MinidumpProcessMemory::GetMemoryAtAddressInternal(u_int64_t address,
+                                                       T*        value) const {
+  BPLOG_IF(ERROR, !value) << "MinidumpProcessMemory::"
+                             "GetMemoryAtAddressInternal requires |value|";
+  assert(value);
+  *value = 0;
+
+  if (GetBytesAtAddress(address, reinterpret_cast<u_int8_t*>(value),
+                        sizeof(T)) != sizeof(T)) {
+    BPLOG_EVERY_N(INFO, 100) << "MinidumpProcessMemory has no memory at " <<
+        HexString(address) << "+" << sizeof(T);
+    *value = 0;
+    return false;
+  }
+
+  if (memory_list_->minidump_->swap())
+    Swap(value);
+
+  return true;
+}
+
+
+bool MinidumpProcessMemory::GetMemoryAtAddress(u_int64_t  address,
+                                               u_int8_t*  value) const {
+  return GetMemoryAtAddressInternal(address, value);
+}
+
+
+bool MinidumpProcessMemory::GetMemoryAtAddress(u_int64_t  address,
+                                               u_int16_t* value) const {
+  return GetMemoryAtAddressInternal(address, value);
+}
+
+
+bool MinidumpProcessMemory::GetMemoryAtAddress(u_int64_t  address,
+                                               u_int32_t* value) const {
+  return GetMemoryAtAddressInternal(address, value);
+}
+
+
+bool MinidumpProcessMemory::GetMemoryAtAddress(u_int64_t  address,
+                                               u_int64_t* value) const {
+  return GetMemoryAtAddressInternal(address, value);
+}
+
+
 //
 // MinidumpException
 //
@@ -3645,6 +3801,10 @@ bool MinidumpMemoryInfoList::Read(u_int32_t expected_size) {
     infos_ = infos.release();
   }
 
+  // Index the infos for GetMemoryInfoForAddress, now that they're all
+  // known.
+  range_map_->Freeze();
+
   info_count_ = header.number_of_entries;
 
   valid_ = true;
@@ -3723,6 +3883,24 @@ Minidump::Minidump(const string& path)
       stream_map_(new MinidumpStreamMap()),
       path_(path),
       stream_(NULL),
+      map_file_(false),
+      mapped_data_(NULL),
+      mapped_size_(0),
+      mapped_position_(0),
+      swap_(false),
+      valid_(false) {
+}
+
+Minidump::Minidump(const string& path, bool map_file)
+    : header_(),
+      directory_(NULL),
+      stream_map_(new MinidumpStreamMap()),
+      path_(path),
+      stream_(NULL),
+      map_file_(map_file),
+      mapped_data_(NULL),
+      mapped_size_(0),
+      mapped_position_(0),
       swap_(false),
       valid_(false) {
 }
@@ -3733,24 +3911,33 @@ Minidump::Minidump(istream& stream)
       stream_map_(new MinidumpStreamMap()),
       path_(),
       stream_(&stream),
+      map_file_(false),
+      mapped_data_(NULL),
+      mapped_size_(0),
+      mapped_position_(0),
       swap_(false),
       valid_(false) {
 }
 
 Minidump::~Minidump() {
-  if (stream_) {
+  if (stream_ || mapped_data_) {
     BPLOG(INFO) << "Minidump closing minidump";
   }
   if (!path_.empty()) {
     delete stream_;
   }
+#ifndef _WIN32
+  if (mapped_data_) {
+    munmap(const_cast<u_int8_t*>(mapped_data_), mapped_size_);
+  }
+#endif  // _WIN32
   delete directory_;
   delete stream_map_;
 }
 
 
 bool Minidump::Open() {
-  if (stream_ != NULL) {
+  if (stream_ != NULL || mapped_data_ != NULL) {
     BPLOG(INFO) << "Minidump reopening minidump " << path_;
 
     // The file is already open.  Seek to the beginning, which is the position
@@ -3758,6 +3945,12 @@ bool Minidump::Open() {
     return SeekSet(0);
   }
 
+  // If the file can't be mapped, fall back to reading it through a stream,
+  // which will report the error if it can't be read either.
+  if (map_file_ && MapFile()) {
+    return true;
+  }
+
   stream_ = new ifstream(path_.c_str(), std::ios::in | std::ios::binary);
   if (!stream_ || !stream_->good()) {
     string error_string;
@@ -3772,6 +3965,56 @@ bool Minidump::Open() {
 }
 
 
+bool Minidump::MapFile() {
+#ifdef _WIN32
+  return false;
+#else  // _WIN32
+  int fd = open(path_.c_str(), O_RDONLY | O_BINARY);
+  if (fd == -1) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(INFO) << "Minidump could not open minidump " << path_ <<
+                    ", error " << error_code << ": " << error_string;
+    return false;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == -1) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(INFO) << "Minidump could not stat minidump " << path_ <<
+                    ", error " << error_code << ": " << error_string;
+    close(fd);
+    return false;
+  }
+
+  // An empty file can't be mapped, and isn't a minidump anyway.
+  if (file_stat.st_size == 0) {
+    BPLOG(INFO) << "Minidump " << path_ << " is empty";
+    close(fd);
+    return false;
+  }
+
+  void* data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(INFO) << "Minidump could not map minidump " << path_ <<
+                    ", error " << error_code << ": " << error_string;
+    return false;
+  }
+
+  mapped_data_ = static_cast<const u_int8_t*>(data);
+  mapped_size_ = file_stat.st_size;
+  mapped_position_ = 0;
+
+  BPLOG(INFO) << "Minidump mapped minidump " << path_;
+  return true;
+#endif  // _WIN32
+}
+
+
 bool Minidump::Read() {
   // Invalidate cached data.
   delete directory_;
@@ -4027,6 +4270,14 @@ const MDRawDirectory* Minidump::GetDirectoryEntryAtIndex(unsigned int index)
 bool Minidump::ReadBytes(void* bytes, size_t count) {
   // Can't check valid_ because Read needs to call this method before
   // validity can be determined.
+  if (mapped_data_) {
+    const u_int8_t* mapped_bytes = ReadBytesInPlace(count);
+    if (!mapped_bytes) {
+      return false;
+    }
+    memcpy(bytes, mapped_bytes, count);
+    return true;
+  }
   if (!stream_) {
     return false;
   }
@@ -4046,9 +4297,35 @@ bool Minidump::ReadBytes(void* bytes, size_t count) {
 }
 
 
+const u_int8_t* Minidump::ReadBytesInPlace(size_t count) {
+  if (!mapped_data_) {
+    return NULL;
+  }
+  size_t available = mapped_size_ - mapped_position_;
+  if (count > available) {
+    BPLOG(ERROR) << "ReadBytes: read " << available << "/" << count;
+    // Like a short read from a stream, this leaves the position at the end.
+    mapped_position_ = mapped_size_;
+    return NULL;
+  }
+  const u_int8_t* bytes = mapped_data_ + mapped_position_;
+  mapped_position_ += count;
+  return bytes;
+}
+
+
 bool Minidump::SeekSet(off_t offset) {
   // Can't check valid_ because Read needs to call this method before
   // validity can be determined.
+  if (mapped_data_) {
+    if (offset < 0 || static_cast<u_int64_t>(offset) > mapped_size_) {
+      BPLOG(ERROR) << "SeekSet: offset " << offset << " is beyond the " <<
+                      mapped_size_ << "-byte minidump";
+      return false;
+    }
+    mapped_position_ = offset;
+    return true;
+  }
   if (!stream_) {
     return false;
   }
@@ -4063,10 +4340,14 @@ bool Minidump::SeekSet(off_t offset) {
 }
 
 off_t Minidump::Tell() {
-  if (!valid_ || !stream_) {
+  if (!valid_ || !(stream_ || mapped_data_)) {
     return (off_t)-1;
   }
 
+  if (mapped_data_) {
+    return mapped_position_;
+  }
+
   return stream_->tellg();
 }
 
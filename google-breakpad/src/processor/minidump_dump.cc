@@ -93,7 +93,7 @@ static void DumpRawStream(Minidump *minidump,
 }
 
 static bool PrintMinidumpDump(const char *minidump_file) {
-  Minidump minidump(minidump_file);
+  Minidump minidump(minidump_file, true);
   if (!minidump.Read()) {
     BPLOG(ERROR) << "minidump.Read() failed";
     return false;
@@ -30,29 +30,153 @@
 #include "google_breakpad/processor/minidump_processor.h"
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdio.h>
 
+#include <vector>
+
 #include "google_breakpad/processor/call_stack.h"
 #include "google_breakpad/processor/minidump.h"
 #include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/process_stats.h"
 #include "google_breakpad/processor/exploitability.h"
+#include "processor/linked_ptr.h"
 #include "processor/logging.h"
+#include "processor/mutex.h"
 #include "processor/scoped_ptr.h"
 #include "processor/stackwalker_x86.h"
+#include "processor/stopwatch.h"
+#include "processor/symbol_load_coordinator.h"
 
 namespace google_breakpad {
 
+using std::vector;
+
+namespace {
+
+// A thread's stack, waiting to be walked concurrently with others.
+struct StackwalkJob {
+  StackwalkJob(Stackwalker *set_stackwalker, CallStack *set_stack,
+               const string &set_thread_string)
+      : stackwalker(set_stackwalker), stack(set_stack),
+        thread_string(set_thread_string), completed(false) {}
+
+  linked_ptr<Stackwalker> stackwalker;
+
+  // The CallStack to fill in.  The ProcessState owns it.
+  CallStack *stack;
+
+  // Describes the thread for log messages.
+  string thread_string;
+
+  // The value Stackwalker::Walk returned.
+  bool completed;
+};
+
+// The jobs to run, and the index of the next one that no thread has
+// started yet.
+struct StackwalkQueue {
+  explicit StackwalkQueue(vector<StackwalkJob> *set_jobs)
+      : jobs(set_jobs), next(0) {}
+
+  vector<StackwalkJob> *jobs;
+  size_t next;
+  Mutex lock;
+};
+
+// Walk stacks from QUEUE until none are left.
+void WalkQueuedStacks(StackwalkQueue *queue) {
+  while (true) {
+    StackwalkJob *job;
+    {
+      ScopedMutexLock lock(&queue->lock);
+      if (queue->next == queue->jobs->size())
+        return;
+      job = &(*queue->jobs)[queue->next++];
+    }
+    job->completed = job->stackwalker->Walk(job->stack);
+  }
+}
+
+void *StackwalkThreadMain(void *queue) {
+  WalkQueuedStacks(static_cast<StackwalkQueue *>(queue));
+  return NULL;
+}
+
+// Walk the stacks in JOBS, using up to THREAD_COUNT threads including the
+// calling one.  Return false if any walk was interrupted.
+bool WalkStacks(vector<StackwalkJob> *jobs, int thread_count) {
+  StackwalkQueue queue(jobs);
+
+  vector<pthread_t> threads;
+  for (int i = 1; i < thread_count && static_cast<size_t>(i) < jobs->size();
+       ++i) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, StackwalkThreadMain, &queue) != 0) {
+      // Carry on with the threads we have; the calling thread walks too.
+      BPLOG(ERROR) << "Could not start stackwalking thread " << i;
+      break;
+    }
+    threads.push_back(thread);
+  }
+
+  WalkQueuedStacks(&queue);
+  for (size_t i = 0; i < threads.size(); ++i)
+    pthread_join(threads[i], NULL);
+
+  bool completed = true;
+  for (size_t i = 0; i < jobs->size(); ++i) {
+    if (!(*jobs)[i].completed) {
+      BPLOG(INFO) << "Stackwalker interrupt (missing symbols?) at " <<
+          (*jobs)[i].thread_string;
+      completed = false;
+    }
+  }
+  return completed;
+}
+
+// Return the index in THREADS of the thread whose ID is THREAD_ID.  Return
+// -1 if there is no such thread, if there is more than one, or if some
+// thread or its ID can't be read, all of which Process reports as it walks
+// the threads in order.
+int FindThreadIndex(MinidumpThreadList *threads, u_int32_t thread_id) {
+  int found_index = -1;
+  unsigned int thread_count = threads->thread_count();
+  for (unsigned int thread_index = 0;
+       thread_index < thread_count;
+       ++thread_index) {
+    MinidumpThread *thread = threads->GetThreadAtIndex(thread_index);
+    u_int32_t id;
+    if (!thread || !thread->GetThreadID(&id))
+      return -1;
+    if (id == thread_id) {
+      if (found_index >= 0)
+        return -1;
+      found_index = thread_index;
+    }
+  }
+  return found_index;
+}
+
+}  // namespace
+
 MinidumpProcessor::MinidumpProcessor(SymbolSupplier *supplier,
                                      SourceLineResolverInterface *resolver)
     : supplier_(supplier), resolver_(resolver),
-      enable_exploitability_(false) {
+      enable_exploitability_(false),
+      walker_thread_count_(1),
+      collect_stats_(false),
+      requesting_thread_handler_(NULL) {
 }
 
 MinidumpProcessor::MinidumpProcessor(SymbolSupplier *supplier,
                                      SourceLineResolverInterface *resolver,
                                      bool enable_exploitability)
     : supplier_(supplier), resolver_(resolver),
-      enable_exploitability_(enable_exploitability) {
+      enable_exploitability_(enable_exploitability),
+      walker_thread_count_(1),
+      collect_stats_(false),
+      requesting_thread_handler_(NULL) {
 }
 
 MinidumpProcessor::~MinidumpProcessor() {
@@ -65,6 +189,11 @@ ProcessResult MinidumpProcessor::Process(
 
   process_state->Clear();
 
+  ProcessStats *stats = NULL;
+  if (collect_stats_)
+    stats = process_state->stats_ = new ProcessStats();
+  Stopwatch stopwatch;
+
   const MDRawHeader *header = dump->header();
   if (!header) {
     BPLOG(ERROR) << "Minidump " << dump->path() << " has no header";
@@ -104,10 +233,16 @@ ProcessResult MinidumpProcessor::Process(
   // Put a copy of the module list into ProcessState object.  This is not
   // necessarily a MinidumpModuleList, but it adheres to the CodeModules
   // interface, which is all that ProcessState needs to expose.
+  if (stats)
+    stopwatch.AddElapsed(&stats->read);
   if (module_list)
     process_state->modules_ = module_list->Copy();
+  if (stats)
+    stopwatch.AddElapsed(&stats->module_copy);
 
   MinidumpThreadList *threads = dump->GetThreadList();
+  if (stats)
+    stopwatch.AddElapsed(&stats->read);
   if (!threads) {
     BPLOG(ERROR) << "Minidump " << dump->path() << " has no thread list";
     return PROCESS_ERROR_NO_THREAD_LIST;
@@ -124,11 +259,75 @@ ProcessResult MinidumpProcessor::Process(
       (has_requesting_thread  ? "" : "no ") << "requesting thread";
 
   bool interrupted = false;
+
+  // With a requesting thread handler, walk the requesting thread's stack
+  // before any other, and hand it over.  The loop below then puts the
+  // stack in its place among the others, walking them only if the handler
+  // asks.  If the requesting thread is missing or duplicated, or the thread
+  // list can't be read, the handler isn't called: the threads are walked
+  // in order, and the loop reports the problem.
+  int early_thread_index = -1;
+  scoped_ptr<CallStack> early_stack;
+  MinidumpMemoryRegion *early_memory = NULL;
+  StackwalkStats early_stats;
+  bool walk_other_threads = true;
+  if (requesting_thread_handler_ && has_requesting_thread &&
+      !(has_dump_thread && requesting_thread_id == dump_thread_id)) {
+    early_thread_index = FindThreadIndex(threads, requesting_thread_id);
+  }
+  if (early_thread_index >= 0) {
+    MinidumpThread *thread = threads->GetThreadAtIndex(early_thread_index);
+    MinidumpContext *context = thread->GetContext();
+    if (process_state->crashed_ && exception->GetContext())
+      context = exception->GetContext();
+    early_memory = thread->GetMemory();
+    scoped_ptr<Stackwalker> stackwalker(
+        early_memory ? Stackwalker::StackwalkerForCPU(
+                           process_state->system_info(),
+                           context,
+                           early_memory,
+                           process_state->modules_,
+                           supplier_,
+                           resolver_)
+                     : NULL);
+    if (stackwalker.get()) {
+      if (stats)
+        stackwalker->set_stats(&early_stats);
+      early_stack.reset(new CallStack());
+      if (!stackwalker->Walk(early_stack.get())) {
+        BPLOG(INFO) << "Stackwalker interrupt (missing symbols?) at " <<
+            "requesting thread " << HexString(requesting_thread_id);
+        interrupted = true;
+      } else {
+        walk_other_threads = requesting_thread_handler_->
+            RequestingThreadWalked(*process_state, *early_stack);
+      }
+    }
+  }
+
+  // When walking concurrently, the loop below sets up each thread's
+  // Stackwalker and adds its (empty) CallStack to process_state, so that
+  // threads keep their minidump order; the stacks are walked afterwards.
+  // Errors stop the loop without returning, so that the threads before
+  // the failing one are walked as they would be when walking serially.
+  bool concurrent = walker_thread_count_ > 1;
+  SymbolLoadCoordinator symbol_load_coordinator;
+  vector<StackwalkJob> stackwalk_jobs;
+  ProcessResult thread_error = PROCESS_OK;
+
   bool found_requesting_thread = false;
   unsigned int thread_count = threads->thread_count();
+  // Reserve room for every thread, so that the stats the Stackwalkers
+  // are given stay put.
+  if (stats)
+    stats->threads.reserve(thread_count);
   for (unsigned int thread_index = 0;
        thread_index < thread_count;
        ++thread_index) {
+    bool early_thread = static_cast<int>(thread_index) == early_thread_index;
+    if (!walk_other_threads && !early_thread)
+      continue;
+
     char thread_string_buffer[64];
     snprintf(thread_string_buffer, sizeof(thread_string_buffer), "%d/%d",
              thread_index, thread_count);
@@ -137,13 +336,15 @@ ProcessResult MinidumpProcessor::Process(
     MinidumpThread *thread = threads->GetThreadAtIndex(thread_index);
     if (!thread) {
       BPLOG(ERROR) << "Could not get thread for " << thread_string;
-      return PROCESS_ERROR_GETTING_THREAD;
+      thread_error = PROCESS_ERROR_GETTING_THREAD;
+      break;
     }
 
     u_int32_t thread_id;
     if (!thread->GetThreadID(&thread_id)) {
       BPLOG(ERROR) << "Could not get thread ID for " << thread_string;
-      return PROCESS_ERROR_GETTING_THREAD_ID;
+      thread_error = PROCESS_ERROR_GETTING_THREAD_ID;
+      break;
     }
 
     thread_string += " id " + HexString(thread_id);
@@ -163,7 +364,8 @@ ProcessResult MinidumpProcessor::Process(
       if (found_requesting_thread) {
         // There can't be more than one requesting thread.
         BPLOG(ERROR) << "Duplicate requesting thread: " << thread_string;
-        return PROCESS_ERROR_DUPLICATE_REQUESTING_THREADS;
+        thread_error = PROCESS_ERROR_DUPLICATE_REQUESTING_THREADS;
+        break;
       }
 
       // Use processed_state->threads_.size() instead of thread_index.
@@ -189,10 +391,19 @@ ProcessResult MinidumpProcessor::Process(
       }
     }
 
+    if (early_thread && early_stack.get()) {
+      if (stats)
+        stats->threads.push_back(early_stats);
+      process_state->threads_.push_back(early_stack.release());
+      process_state->thread_memory_regions_.push_back(early_memory);
+      continue;
+    }
+
     MinidumpMemoryRegion *thread_memory = thread->GetMemory();
     if (!thread_memory) {
       BPLOG(ERROR) << "No memory region for " << thread_string;
-      return PROCESS_ERROR_NO_MEMORY_FOR_THREAD;
+      thread_error = PROCESS_ERROR_NO_MEMORY_FOR_THREAD;
+      break;
     }
 
     // Use process_state->modules_ instead of module_list, because the
@@ -212,11 +423,23 @@ ProcessResult MinidumpProcessor::Process(
                                        resolver_));
     if (!stackwalker.get()) {
       BPLOG(ERROR) << "No stackwalker for " << thread_string;
-      return PROCESS_ERROR_NO_STACKWALKER_FOR_THREAD;
+      thread_error = PROCESS_ERROR_NO_STACKWALKER_FOR_THREAD;
+      break;
+    }
+    if (stats) {
+      stats->threads.push_back(StackwalkStats());
+      stackwalker->set_stats(&stats->threads.back());
     }
 
     scoped_ptr<CallStack> stack(new CallStack());
-    if (!stackwalker->Walk(stack.get())) {
+    if (concurrent) {
+      // Read the thread's stack memory now: MinidumpMemoryRegion reads it
+      // from the minidump on first use, which is not thread-safe.
+      thread_memory->GetMemory();
+      stackwalker->set_symbol_load_coordinator(&symbol_load_coordinator);
+      stackwalk_jobs.push_back(StackwalkJob(stackwalker.release(),
+                                            stack.get(), thread_string));
+    } else if (!stackwalker->Walk(stack.get())) {
       BPLOG(INFO) << "Stackwalker interrupt (missing symbols?) at " <<
           thread_string;
       interrupted = true;
@@ -225,6 +448,23 @@ ProcessResult MinidumpProcessor::Process(
     process_state->thread_memory_regions_.push_back(thread_memory);
   }
 
+  if (!stackwalk_jobs.empty() &&
+      !WalkStacks(&stackwalk_jobs, walker_thread_count_)) {
+    interrupted = true;
+  }
+
+  if (stats) {
+    stopwatch.AddElapsed(&stats->stackwalk);
+    for (size_t i = 0; i < stats->threads.size(); ++i)
+      stats->all_threads.Add(stats->threads[i]);
+    // The walks may have run concurrently on other threads, whose CPU
+    // time the stopwatch doesn't see.
+    stats->stackwalk.cpu_seconds = stats->all_threads.walk.cpu_seconds;
+  }
+
+  if (thread_error != PROCESS_OK)
+    return thread_error;
+
   if (interrupted) {
     BPLOG(INFO) << "Processing interrupted for " << dump->path();
     return PROCESS_SYMBOL_SUPPLIER_INTERRUPTED;
@@ -263,13 +503,22 @@ ProcessResult MinidumpProcessor::Process(
     const string &minidump_file, ProcessState *process_state) {
   BPLOG(INFO) << "Processing minidump in file " << minidump_file;
 
-  Minidump dump(minidump_file);
+  Stopwatch stopwatch;
+  ProcessingTime read_time;
+
+  // Map the minidump, so that its memory regions needn't be copied.
+  Minidump dump(minidump_file, true);
   if (!dump.Read()) {
      BPLOG(ERROR) << "Minidump " << dump.path() << " could not be read";
      return PROCESS_ERROR_MINIDUMP_NOT_FOUND;
   }
+  if (collect_stats_)
+    stopwatch.AddElapsed(&read_time);
 
-  return Process(&dump, process_state);
+  ProcessResult result = Process(&dump, process_state);
+  if (process_state->stats_)
+    process_state->stats_->read.Add(read_time);
+  return result;
 }
 
 // Returns the MDRawSystemInfo from a minidump, or NULL if system info is
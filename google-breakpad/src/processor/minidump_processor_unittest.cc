@@ -31,11 +31,13 @@
 // corresponding symbol file, and checks the stack frames for correctness.
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <string>
 #include <iostream>
 #include <fstream>
 #include <map>
+#include <sstream>
 #include <utility>
 
 #include "breakpad_googletest_includes.h"
@@ -46,12 +48,15 @@
 #include "google_breakpad/processor/minidump.h"
 #include "google_breakpad/processor/minidump_processor.h"
 #include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/process_stats.h"
 #include "google_breakpad/processor/stack_frame.h"
 #include "google_breakpad/processor/symbol_supplier.h"
 #include "processor/logging.h"
 #include "processor/scoped_ptr.h"
+#include "processor/synth_minidump.h"
 
 using std::map;
+using std::vector;
 
 namespace google_breakpad {
 class MockMinidump : public Minidump {
@@ -71,14 +76,29 @@ namespace {
 using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::CallStack;
 using google_breakpad::CodeModule;
+using google_breakpad::Minidump;
 using google_breakpad::MinidumpProcessor;
 using google_breakpad::MinidumpThreadList;
 using google_breakpad::MinidumpThread;
 using google_breakpad::MockMinidump;
 using google_breakpad::ProcessState;
+using google_breakpad::ProcessStats;
+using google_breakpad::RequestingThreadHandler;
+using google_breakpad::StackwalkStats;
 using google_breakpad::scoped_ptr;
+using google_breakpad::StackFrame;
 using google_breakpad::SymbolSupplier;
 using google_breakpad::SystemInfo;
+using google_breakpad::SynthMinidump::Context;
+using google_breakpad::SynthMinidump::Dump;
+using google_breakpad::SynthMinidump::Exception;
+using google_breakpad::SynthMinidump::Memory;
+using google_breakpad::SynthMinidump::Module;
+using google_breakpad::SynthMinidump::Section;
+using google_breakpad::SynthMinidump::String;
+using google_breakpad::SynthMinidump::Thread;
+using google_breakpad::test_assembler::kLittleEndian;
+using std::istringstream;
 using std::string;
 using ::testing::_;
 using ::testing::Mock;
@@ -372,6 +392,423 @@ TEST_F(MinidumpProcessorTest, TestBasicProcessing) {
   ASSERT_EQ(processor.Process(minidump_file, &state),
             google_breakpad::PROCESS_SYMBOL_SUPPLIER_INTERRUPTED);
 }
+
+// Walking threads concurrently must produce the same results as walking
+// them one at a time, and must still report interruptions.
+TEST_F(MinidumpProcessorTest, TestConcurrentProcessing) {
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver serial_resolver, concurrent_resolver;
+  MinidumpProcessor serial_processor(&supplier, &serial_resolver);
+  MinidumpProcessor concurrent_processor(&supplier, &concurrent_resolver);
+  concurrent_processor.set_walker_thread_count(4);
+  ASSERT_EQ(concurrent_processor.walker_thread_count(), 4);
+
+  string minidump_file = string(getenv("srcdir") ? getenv("srcdir") : ".") +
+                         "/src/processor/testdata/minidump2.dmp";
+
+  ProcessState serial_state, concurrent_state;
+  ASSERT_EQ(serial_processor.Process(minidump_file, &serial_state),
+            google_breakpad::PROCESS_OK);
+  ASSERT_EQ(concurrent_processor.Process(minidump_file, &concurrent_state),
+            google_breakpad::PROCESS_OK);
+
+  ASSERT_EQ(concurrent_state.requesting_thread(),
+            serial_state.requesting_thread());
+  ASSERT_EQ(concurrent_state.threads()->size(),
+            serial_state.threads()->size());
+  for (size_t i = 0; i < serial_state.threads()->size(); ++i) {
+    const vector<StackFrame *> *serial_frames =
+        serial_state.threads()->at(i)->frames();
+    const vector<StackFrame *> *concurrent_frames =
+        concurrent_state.threads()->at(i)->frames();
+    ASSERT_EQ(concurrent_frames->size(), serial_frames->size());
+    for (size_t j = 0; j < serial_frames->size(); ++j) {
+      EXPECT_EQ(concurrent_frames->at(j)->instruction,
+                serial_frames->at(j)->instruction);
+      EXPECT_EQ(concurrent_frames->at(j)->function_name,
+                serial_frames->at(j)->function_name);
+      EXPECT_EQ(concurrent_frames->at(j)->source_file_name,
+                serial_frames->at(j)->source_file_name);
+      EXPECT_EQ(concurrent_frames->at(j)->source_line,
+                serial_frames->at(j)->source_line);
+    }
+  }
+  ASSERT_EQ(concurrent_state.threads()->at(0)->frames()->at(0)->function_name,
+            "`anonymous namespace'::CrashFunction");
+
+  // The symbol supplier can still interrupt processing.
+  concurrent_state.Clear();
+  supplier.set_interrupt(true);
+  ASSERT_EQ(concurrent_processor.Process(minidump_file, &concurrent_state),
+            google_breakpad::PROCESS_SYMBOL_SUPPLIER_INTERRUPTED);
+}
+
+TEST_F(MinidumpProcessorTest, TestStats) {
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+
+  string minidump_file = string(getenv("srcdir") ? getenv("srcdir") : ".") +
+                         "/src/processor/testdata/minidump2.dmp";
+
+  // Statistics are only collected on request.
+  ProcessState state;
+  ASSERT_FALSE(processor.collect_stats());
+  ASSERT_EQ(processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  ASSERT_TRUE(state.stats() == NULL);
+
+  BasicSourceLineResolver fresh_resolver;
+  MinidumpProcessor stats_processor(&supplier, &fresh_resolver);
+  stats_processor.set_collect_stats(true);
+  ASSERT_EQ(stats_processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  const ProcessStats *stats = state.stats();
+  ASSERT_TRUE(stats);
+  ASSERT_EQ(state.threads()->size(), stats->threads.size());
+
+  // minidump2.dmp's crashing thread starts from the exception context,
+  // and its callers are recovered from STACK WIN records.
+  const StackwalkStats &thread = stats->threads[0];
+  EXPECT_EQ(state.threads()->at(0)->frames()->size(),
+            thread.context_frames + thread.cfi_frames +
+            thread.frame_pointer_frames + thread.cfi_scan_frames +
+            thread.scan_frames + thread.other_frames);
+  EXPECT_EQ(1U, thread.context_frames);
+  EXPECT_EQ(3U, thread.cfi_frames);
+  EXPECT_EQ(3U, thread.stack_win_frames);
+  EXPECT_EQ(thread.cfi_frames, stats->all_threads.cfi_frames);
+
+  EXPECT_GE(stats->read.wall_seconds, 0);
+  EXPECT_GE(stats->module_copy.wall_seconds, 0);
+  EXPECT_GE(thread.walk.wall_seconds, thread.symbol_parse.wall_seconds);
+  EXPECT_GT(thread.symbol_parse.cpu_seconds, 0);
+  EXPECT_GE(stats->stackwalk.wall_seconds, thread.walk.wall_seconds);
+  EXPECT_EQ(stats->all_threads.walk.cpu_seconds,
+            stats->stackwalk.cpu_seconds);
+
+  // The symbols are loaded now, so a second pass doesn't parse them.
+  ASSERT_EQ(stats_processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  ASSERT_TRUE(state.stats());
+  EXPECT_EQ(0, state.stats()->all_threads.symbol_parse.wall_seconds);
+
+  state.Clear();
+  ASSERT_TRUE(state.stats() == NULL);
+}
+
+// Supplies symbols for c:\\app.exe from memory, choosing the symbol file
+// by the module's debug identifier, as a symbol store would.
+class BuildSymbolSupplier : public SymbolSupplier {
+ public:
+  explicit BuildSymbolSupplier(const map<string, string> &symbols)
+      : symbols_(symbols), fetches(0) {}
+
+  ~BuildSymbolSupplier() {
+    for (map<string, char *>::iterator it = memory_buffers_.begin();
+         it != memory_buffers_.end(); ++it)
+      delete [] it->second;
+  }
+
+  virtual SymbolResult GetSymbolFile(const CodeModule *module,
+                                     const SystemInfo *system_info,
+                                     string *symbol_file) {
+    map<string, string>::const_iterator it =
+        symbols_.find(module->debug_identifier());
+    if (module->code_file() != "c:\\app.exe" || it == symbols_.end())
+      return NOT_FOUND;
+    *symbol_file = module->debug_identifier();
+    return FOUND;
+  }
+
+  virtual SymbolResult GetSymbolFile(const CodeModule *module,
+                                     const SystemInfo *system_info,
+                                     string *symbol_file,
+                                     string *symbol_data) {
+    SymbolResult s = GetSymbolFile(module, system_info, symbol_file);
+    if (s == FOUND)
+      *symbol_data = symbols_.find(*symbol_file)->second;
+    return s;
+  }
+
+  virtual SymbolResult GetCStringSymbolData(const CodeModule *module,
+                                            const SystemInfo *system_info,
+                                            string *symbol_file,
+                                            char **symbol_data) {
+    string symbol_data_string;
+    SymbolResult s = GetSymbolFile(module, system_info, symbol_file,
+                                   &symbol_data_string);
+    if (s != FOUND)
+      return s;
+    ++fetches;
+    // The previous buffer must have been freed before a new one is asked
+    // for.
+    EXPECT_TRUE(memory_buffers_.find(module->code_file()) ==
+                memory_buffers_.end());
+    *symbol_data = new char[symbol_data_string.size() + 1];
+    strcpy(*symbol_data, symbol_data_string.c_str());
+    memory_buffers_[module->code_file()] = *symbol_data;
+    return s;
+  }
+
+  virtual void FreeSymbolData(const CodeModule *module) {
+    map<string, char *>::iterator it =
+        memory_buffers_.find(module->code_file());
+    if (it != memory_buffers_.end()) {
+      delete [] it->second;
+      memory_buffers_.erase(it);
+    }
+  }
+
+ private:
+  map<string, string> symbols_;
+  map<string, char *> memory_buffers_;
+
+ public:
+  int fetches;
+};
+
+// Return the contents of a minidump with one x86 thread, stopped at
+// 0x40001010 in c:\\app.exe, whose PDB 7.0 CodeView record carries
+// pdb_signature as the first part of its GUID.
+string AppMinidump(u_int32_t pdb_signature) {
+  Dump dump(0, kLittleEndian);
+  Memory stack(dump, 0x10000);
+  stack.Append(64, 0);
+  MDRawContextX86 raw_context;
+  memset(&raw_context, 0, sizeof(raw_context));
+  raw_context.context_flags = MD_CONTEXT_X86_INTEGER | MD_CONTEXT_X86_CONTROL;
+  raw_context.eip = 0x40001010;
+  raw_context.esp = raw_context.ebp = 0x10000;
+  Context context(dump, raw_context);
+  Thread thread(dump, 0x100, stack, context);
+
+  String module_name(dump, "c:\\app.exe");
+  Section cv_record(dump);
+  cv_record.D32(MD_CVINFOPDB70_SIGNATURE)
+           .D32(pdb_signature).D16(0).D16(0).Append(8, 0)  // GUID
+           .D32(1)                                         // age
+           .AppendCString("app.pdb");
+  MDVSFixedFileInfo version_info;
+  memset(&version_info, 0, sizeof(version_info));
+  Module module(dump, 0x40000000, 0x10000, module_name,
+                0, 0, version_info, &cv_record);
+
+  dump.Add(&stack);
+  dump.Add(&context);
+  dump.Add(&thread);
+  dump.Add(&module_name);
+  dump.Add(&cv_record);
+  dump.Add(&module);
+  dump.Finish();
+
+  string contents;
+  EXPECT_TRUE(dump.GetContents(&contents));
+  return contents;
+}
+
+// A processor used for a batch of minidumps keeps symbols loaded from one
+// to the next, but must not use them for a different build of a module
+// that has the same code file.
+TEST_F(MinidumpProcessorTest, TestBatchWithDifferentBuilds) {
+  const string kBuild1 = "111111110000000000000000000000001";
+  const string kBuild2 = "222222220000000000000000000000001";
+  map<string, string> symbols;
+  symbols[kBuild1] = "MODULE windows x86 " + kBuild1 + " app.pdb\n"
+                     "FUNC 1000 100 0 BuildOneFunction\n";
+  symbols[kBuild2] = "MODULE windows x86 " + kBuild2 + " app.pdb\n"
+                     "FUNC 1000 100 0 BuildTwoFunction\n";
+  const u_int32_t dump_signatures[] = { 0x11111111, 0x22222222, 0x22222222,
+                                        0x11111111 };
+  const char *expected_functions[] = { "BuildOneFunction",
+                                       "BuildTwoFunction",
+                                       "BuildTwoFunction",
+                                       "BuildOneFunction" };
+
+  // Check both a resolver that frees the symbol data after parsing it and
+  // one that leaves it with the supplier.
+  for (int parse_lazily = 0; parse_lazily < 2; ++parse_lazily) {
+    BuildSymbolSupplier supplier(symbols);
+    BasicSourceLineResolver resolver(parse_lazily != 0);
+    MinidumpProcessor processor(&supplier, &resolver);
+    for (size_t i = 0; i < 4; ++i) {
+      istringstream stream(AppMinidump(dump_signatures[i]));
+      Minidump dump(stream);
+      ASSERT_TRUE(dump.Read());
+      ProcessState state;
+      ASSERT_EQ(google_breakpad::PROCESS_OK, processor.Process(&dump, &state));
+      ASSERT_EQ(1U, state.threads()->size());
+      ASSERT_FALSE(state.threads()->at(0)->frames()->empty());
+      const StackFrame *frame = state.threads()->at(0)->frames()->at(0);
+      ASSERT_TRUE(frame->module);
+      EXPECT_EQ("c:\\app.exe", frame->module->code_file());
+      EXPECT_EQ(expected_functions[i], frame->function_name);
+    }
+    // The third minidump reuses the second's symbols; the others each
+    // need their build's symbols loaded.
+    EXPECT_EQ(3, supplier.fetches);
+  }
+}
+
+// Records the requesting thread's stack, and tells the processor whether
+// to walk the other threads.
+class TestRequestingThreadHandler : public RequestingThreadHandler {
+ public:
+  explicit TestRequestingThreadHandler(bool walk_other_threads)
+      : walk_other_threads_(walk_other_threads),
+        calls(0), thread_count(0), crashed(false), instruction(0) { }
+
+  bool RequestingThreadWalked(const ProcessState &process_state,
+                              const CallStack &stack) {
+    ++calls;
+    thread_count = process_state.threads()->size();
+    crashed = process_state.crashed();
+    if (!stack.frames()->empty())
+      instruction = stack.frames()->at(0)->instruction;
+    return walk_other_threads_;
+  }
+
+  bool walk_other_threads_;
+  int calls;
+  size_t thread_count;
+  bool crashed;
+  u_int64_t instruction;
+};
+
+// Return the contents of a minidump with three x86 threads, whose IDs
+// are 0x100, 0x200 and third_thread_id, and whose stacks are empty.  The
+// thread whose ID is crashed_thread_id, if any, crashed at 0x40001abc.
+string ThreeThreadMinidump(u_int32_t crashed_thread_id = 0x200,
+                           u_int32_t third_thread_id = 0x300) {
+  Dump dump(0, kLittleEndian);
+  Memory stack0(dump, 0x10000), stack1(dump, 0x20000), stack2(dump, 0x30000);
+  Memory *stacks[] = { &stack0, &stack1, &stack2 };
+  MDRawContextX86 raw_contexts[3];
+  for (int i = 0; i < 3; ++i) {
+    stacks[i]->Append(64, 0);
+    memset(&raw_contexts[i], 0, sizeof(raw_contexts[i]));
+    raw_contexts[i].context_flags = MD_CONTEXT_X86_INTEGER |
+                                    MD_CONTEXT_X86_CONTROL;
+    raw_contexts[i].eip = 0x40000000 + 0x1000 * i;
+    raw_contexts[i].esp = raw_contexts[i].ebp = 0x10000 * (i + 1);
+  }
+  Context context0(dump, raw_contexts[0]);
+  Context context1(dump, raw_contexts[1]);
+  Context context2(dump, raw_contexts[2]);
+  Thread thread0(dump, 0x100, stack0, context0);
+  Thread thread1(dump, 0x200, stack1, context1);
+  Thread thread2(dump, third_thread_id, stack2, context2);
+
+  MDRawContextX86 raw_crash_context = raw_contexts[1];
+  raw_crash_context.eip = 0x40001abc;
+  Context crash_context(dump, raw_crash_context);
+  Exception exception(dump, crash_context, crashed_thread_id);
+
+  dump.Add(&stack0);
+  dump.Add(&stack1);
+  dump.Add(&stack2);
+  dump.Add(&context0);
+  dump.Add(&context1);
+  dump.Add(&context2);
+  dump.Add(&crash_context);
+  dump.Add(&thread0);
+  dump.Add(&thread1);
+  dump.Add(&thread2);
+  dump.Add(&exception);
+  dump.Finish();
+
+  string contents;
+  EXPECT_TRUE(dump.GetContents(&contents));
+  return contents;
+}
+
+TEST_F(MinidumpProcessorTest, TestRequestingThreadFirst) {
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  string contents = ThreeThreadMinidump();
+
+  // Without a handler, every thread is walked in minidump order.
+  istringstream plain_stream(contents);
+  Minidump plain_dump(plain_stream);
+  ASSERT_TRUE(plain_dump.Read());
+  ProcessState plain_state;
+  ASSERT_EQ(processor.Process(&plain_dump, &plain_state),
+            google_breakpad::PROCESS_OK);
+  ASSERT_EQ(3U, plain_state.threads()->size());
+  ASSERT_EQ(1, plain_state.requesting_thread());
+
+  // The handler sees the crashing thread before any other is walked,
+  // and asking for the rest gives the same result as walking in order.
+  TestRequestingThreadHandler walk_all(true);
+  processor.set_requesting_thread_handler(&walk_all);
+  istringstream walk_all_stream(contents);
+  Minidump walk_all_dump(walk_all_stream);
+  ASSERT_TRUE(walk_all_dump.Read());
+  ProcessState walk_all_state;
+  ASSERT_EQ(processor.Process(&walk_all_dump, &walk_all_state),
+            google_breakpad::PROCESS_OK);
+  EXPECT_EQ(1, walk_all.calls);
+  EXPECT_EQ(0U, walk_all.thread_count);
+  EXPECT_TRUE(walk_all.crashed);
+  EXPECT_EQ(0x40001abcU, walk_all.instruction);
+  ASSERT_EQ(3U, walk_all_state.threads()->size());
+  ASSERT_EQ(1, walk_all_state.requesting_thread());
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_FALSE(walk_all_state.threads()->at(i)->frames()->empty());
+    EXPECT_EQ(plain_state.threads()->at(i)->frames()->at(0)->instruction,
+              walk_all_state.threads()->at(i)->frames()->at(0)->instruction);
+  }
+
+  // Declining the rest leaves only the crashing thread.
+  TestRequestingThreadHandler walk_one(false);
+  processor.set_requesting_thread_handler(&walk_one);
+  processor.set_collect_stats(true);
+  istringstream walk_one_stream(contents);
+  Minidump walk_one_dump(walk_one_stream);
+  ASSERT_TRUE(walk_one_dump.Read());
+  ProcessState walk_one_state;
+  ASSERT_EQ(processor.Process(&walk_one_dump, &walk_one_state),
+            google_breakpad::PROCESS_OK);
+  EXPECT_EQ(1, walk_one.calls);
+  ASSERT_EQ(1U, walk_one_state.threads()->size());
+  ASSERT_EQ(0, walk_one_state.requesting_thread());
+  ASSERT_FALSE(walk_one_state.threads()->at(0)->frames()->empty());
+  EXPECT_EQ(0x40001abcU,
+            walk_one_state.threads()->at(0)->frames()->at(0)->instruction);
+  ASSERT_TRUE(walk_one_state.stats());
+  EXPECT_EQ(1U, walk_one_state.stats()->threads.size());
+}
+
+TEST_F(MinidumpProcessorTest, TestRequestingThreadInvalid) {
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  TestRequestingThreadHandler handler(false);
+  processor.set_requesting_thread_handler(&handler);
+
+  // A duplicated requesting thread is an error, found before the handler
+  // could be told about either copy.  MinidumpThreadList itself rejects
+  // duplicate thread IDs, so this fails in reading the thread list.
+  istringstream duplicate_stream(ThreeThreadMinidump(0x200, 0x200));
+  Minidump duplicate_dump(duplicate_stream);
+  ASSERT_TRUE(duplicate_dump.Read());
+  ProcessState duplicate_state;
+  ASSERT_EQ(google_breakpad::PROCESS_ERROR_NO_THREAD_LIST,
+            processor.Process(&duplicate_dump, &duplicate_state));
+  EXPECT_EQ(0, handler.calls);
+
+  // A missing one leaves every thread to be walked.
+  istringstream missing_stream(ThreeThreadMinidump(0x400));
+  Minidump missing_dump(missing_stream);
+  ASSERT_TRUE(missing_dump.Read());
+  ProcessState missing_state;
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(&missing_dump, &missing_state));
+  EXPECT_EQ(0, handler.calls);
+  ASSERT_EQ(3U, missing_state.threads()->size());
+  ASSERT_EQ(-1, missing_state.requesting_thread());
+}
 }  // namespace
 
 int main(int argc, char *argv[]) {
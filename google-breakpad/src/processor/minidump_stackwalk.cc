@@ -32,50 +32,76 @@
 //
 // Author: Mark Mentovai
 
+#include <dirent.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
 
+#include <algorithm>
+#include <iostream>
 #include <string>
 #include <vector>
 
 #include "google_breakpad/processor/basic_source_line_resolver.h"
 #include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/compact_source_line_resolver.h"
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
 #include "google_breakpad/processor/minidump.h"
 #include "google_breakpad/processor/minidump_processor.h"
 #include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/process_stats.h"
 #include "google_breakpad/processor/stack_frame_cpu.h"
+#include "processor/basic_code_module.h"
 #include "processor/logging.h"
 #include "processor/pathname_stripper.h"
+#include "processor/process_state_serializer.h"
 #include "processor/scoped_ptr.h"
+#include "processor/serialized_symbol_supplier.h"
 #include "processor/simple_symbol_supplier.h"
 
 namespace {
 
 using std::string;
 using std::vector;
+using google_breakpad::BasicCodeModule;
 using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::CallStack;
 using google_breakpad::CodeModule;
 using google_breakpad::CodeModules;
+using google_breakpad::CompactSourceLineResolver;
+using google_breakpad::ErrnoString;
+using google_breakpad::FastSourceLineResolver;
 using google_breakpad::MinidumpModule;
 using google_breakpad::MinidumpProcessor;
 using google_breakpad::PathnameStripper;
 using google_breakpad::ProcessState;
+using google_breakpad::ProcessStateSerializer;
+using google_breakpad::ProcessStats;
+using google_breakpad::ProcessingTime;
 using google_breakpad::scoped_ptr;
+using google_breakpad::StackwalkStats;
+using google_breakpad::SerializedSymbolSupplier;
 using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::SourceLineResolverBase;
 using google_breakpad::StackFrame;
 using google_breakpad::StackFramePPC;
 using google_breakpad::StackFrameSPARC;
 using google_breakpad::StackFrameX86;
 using google_breakpad::StackFrameAMD64;
 using google_breakpad::StackFrameARM;
+using google_breakpad::SymbolSupplier;
 
 // Separator character for machine readable output.
 static const char kOutputSeparator = '|';
 
+// The default budget, in batch mode, for the symbol text of the modules
+// kept loaded between minidumps.
+static const int kDefaultSymbolTextBudgetMB = 512;
+
 // PrintRegister prints a register's name and value to stdout.  It will
 // print four registers on a line.  For the first register in a set,
 // pass 0 for |start_col|.  For registers in a set, pass the most recent
@@ -500,88 +526,367 @@ static void PrintProcessStateMachineReadable(const ProcessState& process_state)
   }
 }
 
+// Prints |time| as a JSON object to |file|.
+static void PrintTimeJSON(FILE *file, const char *name,
+                          const ProcessingTime &time) {
+  fprintf(file, "\"%s\": {\"wall_seconds\": %.6f, \"cpu_seconds\": %.6f}",
+          name, time.wall_seconds, time.cpu_seconds);
+}
+
+// Prints the members of |stats| to |file|, as members of a JSON object.
+static void PrintStackwalkStatsJSON(FILE *file, const StackwalkStats &stats) {
+  PrintTimeJSON(file, "walk", stats.walk);
+  fprintf(file, ", ");
+  PrintTimeJSON(file, "symbol_fetch", stats.symbol_fetch);
+  fprintf(file, ", ");
+  PrintTimeJSON(file, "symbol_parse", stats.symbol_parse);
+  fprintf(file, ", \"frames\": {\"context\": %u, \"cfi\": %u, "
+          "\"stack_win\": %u, \"frame_pointer\": %u, \"cfi_scan\": %u, "
+          "\"scan\": %u, \"other\": %u}",
+          stats.context_frames, stats.cfi_frames, stats.stack_win_frames,
+          stats.frame_pointer_frames, stats.cfi_scan_frames,
+          stats.scan_frames, stats.other_frames);
+}
+
+// Prints |stats|, gathered while processing |minidump_file|, to stderr as
+// a JSON object on a single line.
+static void PrintProcessStatsJSON(const string &minidump_file,
+                                  const ProcessStats &stats) {
+  fprintf(stderr, "{\"minidump\": \"");
+  for (string::const_iterator it = minidump_file.begin();
+       it != minidump_file.end(); ++it) {
+    unsigned char c = *it;
+    if (c == '"' || c == '\\')
+      fprintf(stderr, "\\%c", c);
+    else if (c < 0x20)
+      fprintf(stderr, "\\u%04x", c);
+    else
+      fputc(c, stderr);
+  }
+  fprintf(stderr, "\", ");
+  PrintTimeJSON(stderr, "read", stats.read);
+  fprintf(stderr, ", ");
+  PrintTimeJSON(stderr, "module_copy", stats.module_copy);
+  fprintf(stderr, ", ");
+  PrintTimeJSON(stderr, "stackwalk", stats.stackwalk);
+  fprintf(stderr, ", ");
+  PrintStackwalkStatsJSON(stderr, stats.all_threads);
+  fprintf(stderr, ", \"threads\": [");
+  for (size_t i = 0; i < stats.threads.size(); ++i) {
+    fprintf(stderr, i ? ", {" : "{");
+    PrintStackwalkStatsJSON(stderr, stats.threads[i]);
+    fprintf(stderr, "}");
+  }
+  fprintf(stderr, "]}\n");
+}
+
+// Writes |process_state| to stdout as a binary ProcessStateProto, preceded
+// by its length as a varint.
+static void WriteProcessStateProto(const ProcessState &process_state) {
+  string encoded;
+  ProcessStateSerializer::SerializeDelimited(process_state, &encoded);
+  fwrite(encoded.data(), 1, encoded.size(), stdout);
+}
+
+// Processes |minidump_file| with |minidump_processor| and prints the
+// result, as a binary ProcessStateProto if |binary| is set, or otherwise
+// in machine-readable form if |machine_readable| is set.  If the
+// processor collects statistics, they are printed to stderr as JSON.
+// Returns false if processing fails.
+static bool ProcessAndPrintMinidump(MinidumpProcessor *minidump_processor,
+                                    const string &minidump_file,
+                                    bool machine_readable,
+                                    bool binary) {
+  // Process the minidump.
+  ProcessState process_state;
+  if (minidump_processor->Process(minidump_file, &process_state) !=
+      google_breakpad::PROCESS_OK) {
+    BPLOG(ERROR) << "MinidumpProcessor::Process failed";
+    return false;
+  }
+
+  if (process_state.stats())
+    PrintProcessStatsJSON(minidump_file, *process_state.stats());
+
+  if (binary) {
+    WriteProcessStateProto(process_state);
+  } else if (machine_readable) {
+    PrintProcessStateMachineReadable(process_state);
+  } else {
+    PrintProcessState(process_state);
+  }
+
+  return true;
+}
+
+// Places the next minidump to process in batch mode in |minidump_file|.
+// If |directory_files| is NULL, the minidump paths are read from stdin,
+// one per line, as they become available; otherwise they are taken from
+// |directory_files| in turn, starting at |*next_file|.  Returns false when
+// there are no more.
+static bool NextBatchMinidump(const vector<string> *directory_files,
+                              size_t *next_file,
+                              string *minidump_file) {
+  if (!directory_files) {
+    while (std::getline(std::cin, *minidump_file)) {
+      if (!minidump_file->empty())
+        return true;
+    }
+    return false;
+  }
+
+  if (*next_file == directory_files->size())
+    return false;
+  *minidump_file = (*directory_files)[(*next_file)++];
+  return true;
+}
+
+// Places the paths of the regular files in |directory| in
+// |directory_files|, sorted by name.  Returns false if the directory
+// cannot be read.
+static bool ListMinidumpDirectory(const string &directory,
+                                  vector<string> *directory_files) {
+  DIR *dir = opendir(directory.c_str());
+  if (!dir) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not open directory " << directory <<
+        ", error " << error_code << ": " << error_string;
+    return false;
+  }
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    string path = directory + "/" + entry->d_name;
+    struct stat sb;
+    if (stat(path.c_str(), &sb) == 0 && S_ISREG(sb.st_mode))
+      directory_files->push_back(path);
+  }
+  closedir(dir);
+  std::sort(directory_files->begin(), directory_files->end());
+  return true;
+}
+
 // Processes |minidump_file| using MinidumpProcessor.  |symbol_path|, if
 // non-empty, is the base directory of a symbol storage area, laid out in
 // the format required by SimpleSymbolSupplier.  If such a storage area
 // is specified, it is made available for use by the MinidumpProcessor.
+// If |cache_path| is non-empty, symbols are serialized into a cache there
+// by SerializedSymbolSupplier and resolved with FastSourceLineResolver.
+// Otherwise, if |compact| is set, symbol files are parsed into
+// CompactSourceLineResolver's arena-allocated tables, or if |parse_lazily|
+// is set, symbol files are only indexed when loaded, and parsed piecemeal
+// as lookups need them.
 //
-// Returns the value of MinidumpProcessor::Process.  If processing succeeds,
-// prints identifying OS and CPU information from the minidump, crash
-// information if the minidump was produced as a result of a crash, and
-// call stacks for each thread contained in the minidump.  All information
-// is printed to stdout.
+// If |batch| is set, |minidump_file| is instead a directory of minidumps,
+// or "-" to read minidump paths from stdin, and each minidump is processed
+// in turn by the same processor.  Symbols stay loaded from one minidump to
+// the next, as long as the symbol data they were loaded from totals no more
+// than |symbol_text_budget| bytes; past that, the least recently used
+// modules are unloaded after each minidump.  This bounds the symbol text,
+// not the memory the loaded modules occupy, which can be several times
+// larger once they are parsed.  The time
+// taken to process each minidump, and the share of source line lookups
+// answered from the resolver's cache so far, are reported on stderr.
+//
+// Returns the value of MinidumpProcessor::Process, or in batch mode,
+// whether every minidump was processed successfully.  If processing
+// succeeds, prints identifying OS and CPU information from the minidump,
+// crash information if the minidump was produced as a result of a crash,
+// and call stacks for each thread contained in the minidump.  All
+// information is printed to stdout; if |binary| is set, it is written as
+// a sequence of length-delimited ProcessStateProto messages instead, one
+// per minidump processed successfully.  If |print_stats| is set, the time
+// spent in each phase of processing each minidump, and how its stack
+// frames were recovered, is printed to stderr as a line of JSON.
 static bool PrintMinidumpProcess(const string &minidump_file,
                                  const vector<string> &symbol_paths,
-                                 bool machine_readable) {
+                                 const string &cache_path,
+                                 bool compact,
+                                 bool parse_lazily,
+                                 bool machine_readable,
+                                 bool binary,
+                                 bool batch,
+                                 size_t symbol_text_budget,
+                                 bool print_stats) {
   scoped_ptr<SimpleSymbolSupplier> symbol_supplier;
+  scoped_ptr<SerializedSymbolSupplier> serialized_supplier;
+  SymbolSupplier *supplier = NULL;
   if (!symbol_paths.empty()) {
     // TODO(mmentovai): check existence of symbol_path if specified?
     symbol_supplier.reset(new SimpleSymbolSupplier(symbol_paths));
+    // BasicSourceLineResolver parses symbol files without modifying them,
+    // so they can be mapped rather than copied onto the heap.
+    symbol_supplier->set_map_symbol_files(true);
+    supplier = symbol_supplier.get();
+    if (!cache_path.empty()) {
+      serialized_supplier.reset(
+          new SerializedSymbolSupplier(symbol_supplier.get(), cache_path));
+      supplier = serialized_supplier.get();
+    }
   }
 
-  BasicSourceLineResolver resolver;
-  MinidumpProcessor minidump_processor(symbol_supplier.get(), &resolver);
-
-  // Process the minidump.
-  ProcessState process_state;
-  if (minidump_processor.Process(minidump_file, &process_state) !=
-      google_breakpad::PROCESS_OK) {
-    BPLOG(ERROR) << "MinidumpProcessor::Process failed";
+  BasicSourceLineResolver basic_resolver(parse_lazily);
+  FastSourceLineResolver fast_resolver;
+  CompactSourceLineResolver compact_resolver;
+  SourceLineResolverBase *resolver = &basic_resolver;
+  if (!cache_path.empty())
+    resolver = &fast_resolver;
+  else if (compact)
+    resolver = &compact_resolver;
+  bool resolver_keeps_buffers = resolver == &fast_resolver ||
+                                (resolver == &basic_resolver && parse_lazily);
+  MinidumpProcessor minidump_processor(supplier, resolver);
+  minidump_processor.set_collect_stats(print_stats);
+
+  if (!batch)
+    return ProcessAndPrintMinidump(&minidump_processor, minidump_file,
+                                   machine_readable, binary);
+
+  vector<string> directory_files;
+  if (minidump_file != "-" &&
+      !ListMinidumpDirectory(minidump_file, &directory_files))
     return false;
-  }
 
-  if (machine_readable) {
-    PrintProcessStateMachineReadable(process_state);
-  } else {
-    PrintProcessState(process_state);
+  bool succeeded = true;
+  bool first = true;
+  size_t next_file = 0;
+  string batch_file;
+  while (NextBatchMinidump(minidump_file == "-" ? NULL : &directory_files,
+                           &next_file, &batch_file)) {
+    if (!first && !machine_readable && !binary)
+      printf("\n");
+    first = false;
+
+    struct timeval start_time, end_time;
+    gettimeofday(&start_time, NULL);
+    bool processed = ProcessAndPrintMinidump(&minidump_processor, batch_file,
+                                             machine_readable, binary);
+    if (!processed)
+      succeeded = false;
+    fflush(stdout);
+    gettimeofday(&end_time, NULL);
+
+    // Keep the symbol text within budget for the next minidump.  A resolver
+    // that keeps using the buffers it loads leaves them with the supplier,
+    // which must be told to release them.
+    vector<string> unloaded_code_files;
+    resolver->UnloadLeastRecentlyUsedModules(symbol_text_budget,
+                                             &unloaded_code_files);
+    if (supplier && resolver_keeps_buffers) {
+      for (vector<string>::const_iterator it = unloaded_code_files.begin();
+           it != unloaded_code_files.end(); ++it) {
+        BasicCodeModule code_module(0, 0, *it, "", "", "", "");
+        supplier->FreeSymbolData(&code_module);
+      }
+    }
+
+    double elapsed_ms = (end_time.tv_sec - start_time.tv_sec) * 1000.0 +
+                        (end_time.tv_usec - start_time.tv_usec) / 1000.0;
+    u_int64_t lookup_hits = 0, lookup_misses = 0;
+    resolver->GetLookupCacheStats(&lookup_hits, &lookup_misses);
+    u_int64_t lookups = lookup_hits + lookup_misses;
+    fprintf(stderr, "%s: %s in %.3f ms, %llu bytes of symbol text loaded, "
+            "%.1f%% of %llu source line lookups cached\n",
+            batch_file.c_str(), processed ? "processed" : "failed",
+            elapsed_ms,
+            static_cast<unsigned long long>(resolver->LoadedSymbolDataSize()),
+            lookups ? 100.0 * lookup_hits / lookups : 0.0,
+            static_cast<unsigned long long>(lookups));
   }
 
-  return true;
+  return succeeded;
 }
 
 }  // namespace
 
 static void usage(const char *program_name) {
-  fprintf(stderr, "usage: %s [-m] <minidump-file> [symbol-path ...]\n"
-          "    -m : Output in machine-readable format\n",
-          program_name);
+  fprintf(stderr, "usage: %s [-m | -p] [-s] [-a | -l] [-c cache-path] "
+          "[-b [-T text-mb]] <minidump-file> [symbol-path ...]\n"
+          "    -m : Output in machine-readable format\n"
+          "    -p : Output each minidump's results as a binary\n"
+          "         ProcessStateProto (see processor/proto/), preceded\n"
+          "         by its length as a varint\n"
+          "    -s : Print processing time and frame statistics to stderr,\n"
+          "         as a line of JSON per minidump\n"
+          "    -a : Keep parsed symbols in compact, arena-allocated tables\n"
+          "    -l : Parse symbol files lazily, as lookups need them\n"
+          "    -c : Keep serialized symbols in cache-path, and use them in\n"
+          "         place of parsing symbol files\n"
+          "    -b : Batch mode: minidump-file is a directory of minidumps,\n"
+          "         or - to read minidump paths from stdin, one per line\n"
+          "    -T : In batch mode, keep modules loaded between minidumps\n"
+          "         while their symbol files total up to text-mb megabytes\n"
+          "         (default %d).  Parsed symbols can take several times\n"
+          "         as much memory as their text.\n",
+          program_name, kDefaultSymbolTextBudgetMB);
 }
 
 int main(int argc, char **argv) {
   BPLOG_INIT(&argc, &argv);
 
-  if (argc < 2) {
-    usage(argv[0]);
-    return 1;
-  }
-
-  const char *minidump_file;
-  bool machine_readable;
-  int symbol_path_arg;
-
-  if (strcmp(argv[1], "-m") == 0) {
-    if (argc < 3) {
+  bool machine_readable = false;
+  bool binary = false;
+  bool print_stats = false;
+  string cache_path;
+  bool compact = false;
+  bool parse_lazily = false;
+  bool batch = false;
+  int symbol_text_budget_mb = kDefaultSymbolTextBudgetMB;
+  int arg_index = 1;
+  // A lone "-" is batch mode's stdin, not an option.
+  while (arg_index < argc && argv[arg_index][0] == '-' &&
+         argv[arg_index][1] != '\0') {
+    if (strcmp(argv[arg_index], "-m") == 0) {
+      machine_readable = true;
+      ++arg_index;
+    } else if (strcmp(argv[arg_index], "-p") == 0) {
+      binary = true;
+      ++arg_index;
+    } else if (strcmp(argv[arg_index], "-s") == 0) {
+      print_stats = true;
+      ++arg_index;
+    } else if (strcmp(argv[arg_index], "-a") == 0) {
+      compact = true;
+      ++arg_index;
+    } else if (strcmp(argv[arg_index], "-l") == 0) {
+      parse_lazily = true;
+      ++arg_index;
+    } else if (strcmp(argv[arg_index], "-c") == 0 && arg_index + 1 < argc) {
+      cache_path = argv[arg_index + 1];
+      arg_index += 2;
+    } else if (strcmp(argv[arg_index], "-b") == 0) {
+      batch = true;
+      ++arg_index;
+    } else if (strcmp(argv[arg_index], "-T") == 0 && arg_index + 1 < argc &&
+               (symbol_text_budget_mb = atoi(argv[arg_index + 1])) >= 0) {
+      arg_index += 2;
+    } else {
       usage(argv[0]);
       return 1;
     }
+  }
 
-    machine_readable = true;
-    minidump_file = argv[2];
-    symbol_path_arg = 3;
-  } else {
-    machine_readable = false;
-    minidump_file = argv[1];
-    symbol_path_arg = 2;
+  if (arg_index >= argc) {
+    usage(argv[0]);
+    return 1;
   }
+  const char *minidump_file = argv[arg_index++];
 
   // extra arguments are symbol paths
   std::vector<std::string> symbol_paths;
-  if (argc > symbol_path_arg) {
-    for (int argi = symbol_path_arg; argi < argc; ++argi)
-      symbol_paths.push_back(argv[argi]);
-  }
+  for (; arg_index < argc; ++arg_index)
+    symbol_paths.push_back(argv[arg_index]);
 
   return PrintMinidumpProcess(minidump_file,
                               symbol_paths,
-                              machine_readable) ? 0 : 1;
+                              cache_path,
+                              compact,
+                              parse_lazily,
+                              machine_readable,
+                              binary,
+                              batch,
+                              static_cast<size_t>(symbol_text_budget_mb) << 20,
+                              print_stats)
+      ? 0 : 1;
 }
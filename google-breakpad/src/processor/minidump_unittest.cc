@@ -34,6 +34,7 @@
 #include <fstream>
 #include <sstream>
 #include <stdlib.h>
+#include <string.h>
 #include <string>
 #include <vector>
 #include "breakpad_googletest_includes.h"
@@ -53,6 +54,7 @@ using google_breakpad::MinidumpMemoryList;
 using google_breakpad::MinidumpMemoryRegion;
 using google_breakpad::MinidumpModule;
 using google_breakpad::MinidumpModuleList;
+using google_breakpad::MinidumpProcessMemory;
 using google_breakpad::MinidumpSystemInfo;
 using google_breakpad::MinidumpThread;
 using google_breakpad::MinidumpThreadList;
@@ -92,6 +94,64 @@ TEST_F(MinidumpTest, TestMinidumpFromFile) {
   //TODO: add more checks here
 }
 
+TEST_F(MinidumpTest, TestMappedMinidumpFromFile) {
+  Minidump streamed(minidump_file_);
+  ASSERT_TRUE(streamed.Read());
+  ASSERT_FALSE(streamed.mapped());
+  Minidump mapped(minidump_file_, true);
+  ASSERT_TRUE(mapped.Read());
+  ASSERT_TRUE(mapped.mapped());
+  ASSERT_EQ(0, memcmp(streamed.header(), mapped.header(),
+                      sizeof(MDRawHeader)));
+
+  // Thread stacks come straight from the mapping, but hold the same bytes.
+  MinidumpThreadList *streamed_threads = streamed.GetThreadList();
+  MinidumpThreadList *mapped_threads = mapped.GetThreadList();
+  ASSERT_TRUE(streamed_threads != NULL);
+  ASSERT_TRUE(mapped_threads != NULL);
+  ASSERT_EQ(streamed_threads->thread_count(), mapped_threads->thread_count());
+  for (unsigned int i = 0; i < mapped_threads->thread_count(); i++) {
+    MinidumpMemoryRegion *streamed_memory =
+        streamed_threads->GetThreadAtIndex(i)->GetMemory();
+    MinidumpMemoryRegion *mapped_memory =
+        mapped_threads->GetThreadAtIndex(i)->GetMemory();
+    ASSERT_TRUE(streamed_memory != NULL);
+    ASSERT_TRUE(mapped_memory != NULL);
+    ASSERT_EQ(streamed_memory->GetBase(), mapped_memory->GetBase());
+    ASSERT_EQ(streamed_memory->GetSize(), mapped_memory->GetSize());
+    ASSERT_EQ(0, memcmp(streamed_memory->GetMemory(),
+                        mapped_memory->GetMemory(),
+                        mapped_memory->GetSize()));
+    u_int32_t streamed_word, mapped_word;
+    u_int64_t address = mapped_memory->GetBase() + 1;
+    ASSERT_TRUE(streamed_memory->GetMemoryAtAddress(address, &streamed_word));
+    ASSERT_TRUE(mapped_memory->GetMemoryAtAddress(address, &mapped_word));
+    ASSERT_EQ(streamed_word, mapped_word);
+  }
+
+  // So do the modules' CodeView records.
+  MinidumpModuleList *streamed_modules = streamed.GetModuleList();
+  MinidumpModuleList *mapped_modules = mapped.GetModuleList();
+  ASSERT_TRUE(streamed_modules != NULL);
+  ASSERT_TRUE(mapped_modules != NULL);
+  ASSERT_EQ(streamed_modules->module_count(), mapped_modules->module_count());
+  for (unsigned int i = 0; i < mapped_modules->module_count(); i++) {
+    const MinidumpModule *streamed_module =
+        streamed_modules->GetModuleAtIndex(i);
+    const MinidumpModule *mapped_module = mapped_modules->GetModuleAtIndex(i);
+    ASSERT_EQ(streamed_module->code_file(), mapped_module->code_file());
+    ASSERT_EQ(streamed_module->debug_file(), mapped_module->debug_file());
+    ASSERT_EQ(streamed_module->debug_identifier(),
+              mapped_module->debug_identifier());
+  }
+}
+
+TEST_F(MinidumpTest, TestMappedMinidumpMissing) {
+  Minidump minidump(minidump_file_ + "-missing", true);
+  ASSERT_FALSE(minidump.Read());
+  ASSERT_FALSE(minidump.mapped());
+}
+
 TEST_F(MinidumpTest, TestMinidumpFromStream) {
   // read minidump contents into memory, construct a stringstream around them
   ifstream file_stream(minidump_file_.c_str(), std::ios::in);
@@ -205,6 +265,63 @@ TEST(Dump, OneMemory) {
   ASSERT_TRUE(memcmp("memory contents", region1_bytes, 15) == 0);
 }
 
+TEST(Dump, ProcessMemory) {
+  Dump dump(0, kBigEndian);
+  // Two adjacent regions, listed out of order, and one apart from them.
+  Memory high(dump, 0x1008);
+  high.D32(0x89abcdef).D32(0x01234567);
+  Memory low(dump, 0x1000);
+  low.D32(0x00112233).D32(0x44556677);
+  Memory apart(dump, 0x2000);
+  apart.D16(0xbeef);
+  dump.Add(&high);
+  dump.Add(&low);
+  dump.Add(&apart);
+  dump.Finish();
+
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  istringstream minidump_stream(contents);
+  Minidump minidump(minidump_stream);
+  ASSERT_TRUE(minidump.Read());
+  MinidumpMemoryList *memory_list = minidump.GetMemoryList();
+  ASSERT_TRUE(memory_list != NULL);
+  ASSERT_EQ(3U, memory_list->region_count());
+  EXPECT_EQ(0x1000U, memory_list->GetMemoryRegionForAddress(0x1007)->GetBase());
+  EXPECT_EQ(0x1008U, memory_list->GetMemoryRegionForAddress(0x1008)->GetBase());
+  EXPECT_TRUE(memory_list->GetMemoryRegionForAddress(0x1010) == NULL);
+
+  MinidumpProcessMemory process_memory(memory_list);
+  EXPECT_EQ(0x1000U, process_memory.GetBase());
+  EXPECT_EQ(0x1002U, process_memory.GetSize());
+
+  u_int32_t value32;
+  ASSERT_TRUE(process_memory.GetMemoryAtAddress(0x1004, &value32));
+  EXPECT_EQ(0x44556677U, value32);
+  ASSERT_TRUE(process_memory.GetMemoryAtAddress(0x100c, &value32));
+  EXPECT_EQ(0x01234567U, value32);
+
+  // A read that straddles the two adjacent regions is served by both.
+  u_int64_t value64;
+  ASSERT_TRUE(process_memory.GetMemoryAtAddress(0x1004, &value64));
+  EXPECT_EQ(0x4455667789abcdefULL, value64);
+  u_int8_t bytes[20];
+  EXPECT_EQ(16U, process_memory.GetBytesAtAddress(0x1000, bytes,
+                                                  sizeof(bytes)));
+  EXPECT_EQ(0x77, bytes[7]);
+  EXPECT_EQ(0x89, bytes[8]);
+
+  // Reads can't cross gaps, or start in them.
+  EXPECT_FALSE(process_memory.GetMemoryAtAddress(0x100c, &value64));
+  EXPECT_EQ(0U, value64);
+  EXPECT_FALSE(process_memory.GetMemoryAtAddress(0x1800, &value32));
+
+  u_int16_t value16;
+  ASSERT_TRUE(process_memory.GetMemoryAtAddress(0x2000, &value16));
+  EXPECT_EQ(0xbeef, value16);
+  EXPECT_FALSE(process_memory.GetMemoryAtAddress(0x2001, &value16));
+}
+
 // One thread --- and its requisite entourage.
 TEST(Dump, OneThread) {
   Dump dump(0, kLittleEndian);
@@ -54,7 +54,6 @@ namespace google_breakpad {
 
 bool ModuleComparer::Compare(const string &symbol_data) {
   scoped_ptr<BasicModule> basic_module(new BasicModule("test_module"));
-  scoped_ptr<FastModule> fast_module(new FastModule("test_module"));
 
   // Load symbol data into basic_module
   scoped_array<char> buffer(new char[symbol_data.size() + 1]);
@@ -69,8 +68,24 @@ bool ModuleComparer::Compare(const string &symbol_data) {
   ASSERT_TRUE(serialized_data.get());
   BPLOG(INFO) << "Serialized size = " << serialized_size << " Bytes";
 
-  // Load FastSourceLineResolver::Module using serialized data.
-  ASSERT_TRUE(fast_module->LoadMapFromMemory(serialized_data.get()));
+  return Compare(symbol_data, serialized_data.get());
+}
+
+bool ModuleComparer::Compare(const string &symbol_data,
+                             const char *serialized_data) {
+  scoped_ptr<BasicModule> basic_module(new BasicModule("test_module"));
+  scoped_ptr<FastModule> fast_module(new FastModule("test_module"));
+
+  // Load symbol data into basic_module
+  scoped_array<char> buffer(new char[symbol_data.size() + 1]);
+  strcpy(buffer.get(), symbol_data.c_str());
+  ASSERT_TRUE(basic_module->LoadMapFromMemory(buffer.get()));
+  buffer.reset();
+
+  // Load FastSourceLineResolver::Module using serialized data.  It does not
+  // write to the buffer.
+  ASSERT_TRUE(fast_module->LoadMapFromMemory(
+      const_cast<char *>(serialized_data)));
 
   // Compare FastSourceLineResolver::Module with
   // BasicSourceLineResolver::Module.
@@ -66,6 +66,13 @@ class ModuleComparer {
   // return true if both modules contain exactly same data.
   bool Compare(const string &symbol_data);
 
+  // BasicSourceLineResolver loads its module using the symbol data, and
+  // FastSourceLineResolver loads its module using serialized_data, which
+  // was produced some other way, such as by
+  // ModuleSerializer::SerializeDumpedModule.  Return true if both modules
+  // contain exactly same data.
+  bool Compare(const string &symbol_data, const char *serialized_data);
+
  private:
   typedef BasicSourceLineResolver::Module BasicModule;
   typedef FastSourceLineResolver::Module FastModule;
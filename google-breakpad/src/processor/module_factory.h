@@ -37,6 +37,7 @@
 #define PROCESSOR_MODULE_FACTORY_H__
 
 #include "processor/basic_source_line_resolver_types.h"
+#include "processor/compact_source_line_resolver_types.h"
 #include "processor/fast_source_line_resolver_types.h"
 #include "processor/source_line_resolver_base_types.h"
 
@@ -51,11 +52,18 @@ class ModuleFactory {
 
 class BasicModuleFactory : public ModuleFactory {
  public:
+  // If parse_lazily is true, the modules created only index their symbol
+  // files when loaded; see BasicSourceLineResolver.
+  explicit BasicModuleFactory(bool parse_lazily = false)
+      : parse_lazily_(parse_lazily) { }
   virtual ~BasicModuleFactory() { }
   virtual BasicSourceLineResolver::Module* CreateModule(
       const string &name) const {
-    return new BasicSourceLineResolver::Module(name);
+    return new BasicSourceLineResolver::Module(name, parse_lazily_);
   }
+
+ private:
+  bool parse_lazily_;
 };
 
 class FastModuleFactory : public ModuleFactory {
@@ -67,6 +75,15 @@ class FastModuleFactory : public ModuleFactory {
   }
 };
 
+class CompactModuleFactory : public ModuleFactory {
+ public:
+  virtual ~CompactModuleFactory() { }
+  virtual CompactSourceLineResolver::Module* CreateModule(
+      const string &name) const {
+    return new CompactSourceLineResolver::Module(name);
+  }
+};
+
 }  // namespace google_breakpad
 
 #endif  // PROCESSOR_MODULE_FACTORY_H__
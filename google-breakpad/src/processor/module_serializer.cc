@@ -36,8 +36,11 @@
 #include "processor/module_serializer.h"
 
 #include <map>
+#include <sstream>
 #include <string>
+#include <vector>
 
+#include "common/module.h"
 #include "processor/basic_code_module.h"
 #include "processor/logging.h"
 
@@ -48,6 +51,11 @@ namespace google_breakpad {
 RangeMapSerializer< MemAddr, linked_ptr<BasicSourceLineResolver::Line> >
 SimpleSerializer<BasicSourceLineResolver::Function>::range_map_serializer_;
 
+// Definitions of the header constants, which SimpleSerializer::Write takes
+// by reference.
+const u_int32_t ModuleSerializer::kMagic_;
+const u_int32_t ModuleSerializer::kVersion_;
+
 size_t ModuleSerializer::SizeOf(const BasicSourceLineResolver::Module &module) {
   size_t total_size_alloc_ = 0;
 
@@ -65,7 +73,7 @@ size_t ModuleSerializer::SizeOf(const BasicSourceLineResolver::Module &module) {
      module.cfi_delta_rules_);
 
   // Header size.
-  total_size_alloc_ = kNumberMaps_ * sizeof(u_int32_t);
+  total_size_alloc_ = HeaderSize();
 
   for (int i = 0; i < kNumberMaps_; ++i)
    total_size_alloc_ += map_sizes_[i];
@@ -79,6 +87,8 @@ size_t ModuleSerializer::SizeOf(const BasicSourceLineResolver::Module &module) {
 char *ModuleSerializer::Write(const BasicSourceLineResolver::Module &module,
                               char *dest) {
   // Write header.
+  dest = SimpleSerializer<u_int32_t>::Write(kMagic_, dest);
+  dest = SimpleSerializer<u_int32_t>::Write(kVersion_, dest);
   memcpy(dest, map_sizes_, kNumberMaps_ * sizeof(u_int32_t));
   dest += kNumberMaps_ * sizeof(u_int32_t);
   // Write each map.
@@ -96,6 +106,15 @@ char *ModuleSerializer::Write(const BasicSourceLineResolver::Module &module,
 
 char* ModuleSerializer::Serialize(
     const BasicSourceLineResolver::Module &module, unsigned int *size) {
+  // A lazily parsed module holds its line and CFI records as text, which
+  // has no serialized form.
+  if (module.parse_lazily_) {
+    BPLOG(ERROR) << "ModuleSerializer: cannot serialize lazily parsed "
+                 << "module " << module.name_;
+    if (size) *size = 0;
+    return NULL;
+  }
+
   // Compute size of memory to allocate.
   unsigned int size_to_alloc = SizeOf(module);
 
@@ -124,6 +143,114 @@ char* ModuleSerializer::Serialize(
   return serialized_data;
 }
 
+// Return RULE_MAP in the form Module::Write gives it in 'STACK CFI'
+// records.
+static string DumpedRuleMapString(const Module::RuleMap &rule_map) {
+  std::ostringstream stream;
+  for (Module::RuleMap::const_iterator it = rule_map.begin();
+       it != rule_map.end(); ++it) {
+    if (it != rule_map.begin())
+      stream << ' ';
+    stream << it->first << ": " << it->second;
+  }
+  return stream.str();
+}
+
+char* ModuleSerializer::SerializeDumpedModule(Module *module, bool cfi,
+                                              unsigned int *size) {
+  if (size) *size = 0;
+
+  // Fill in a BasicSourceLineResolver::Module as loading the text symbol
+  // file would, record by record, so that the serialized data is the same.
+  BasicSourceLineResolver::Module basic_module("no name");
+  const MemAddr load_address = module->load_address();
+  module->AssignSourceIds();
+
+  // FILE records, for the files that lines refer to.
+  vector<Module::File *> files;
+  module->GetFiles(&files);
+  for (vector<Module::File *>::const_iterator it = files.begin();
+       it != files.end(); ++it) {
+    if ((*it)->source_id != -1)
+      basic_module.files_.insert(make_pair((*it)->source_id, (*it)->name));
+  }
+
+  // FUNC records, each followed by its lines.  As when loading, a function
+  // or line whose range is invalid or overlaps an earlier one is dropped.
+  vector<Module::Function *> functions;
+  module->GetFunctions(&functions, functions.end());
+  for (vector<Module::Function *>::const_iterator it = functions.begin();
+       it != functions.end(); ++it) {
+    const Module::Function *dumped_function = *it;
+    linked_ptr<Function> function(
+        new Function(dumped_function->name,
+                     dumped_function->address - load_address,
+                     dumped_function->size,
+                     static_cast<int>(dumped_function->parameter_size)));
+    for (vector<Module::Line>::const_iterator line =
+             dumped_function->lines.begin();
+         line != dumped_function->lines.end(); ++line) {
+      if (line->number <= 0) {
+        BPLOG(ERROR) << "ModuleSerializer: function " << function->name
+                     << " has a line with line number " << line->number;
+        return NULL;
+      }
+      function->lines.StoreRange(
+          line->address - load_address, line->size,
+          linked_ptr<Line>(new Line(line->address - load_address, line->size,
+                                    line->file->source_id, line->number)));
+    }
+    basic_module.functions_.StoreRange(function->address, function->size,
+                                       function);
+  }
+
+  // PUBLIC records.  Those at address zero are ignored when loading.
+  vector<Module::Extern *> externs;
+  module->GetExterns(&externs, externs.end());
+  for (vector<Module::Extern *>::const_iterator it = externs.begin();
+       it != externs.end(); ++it) {
+    MemAddr address = (*it)->address - load_address;
+    if (address == 0)
+      continue;
+    basic_module.public_symbols_.Store(
+        address, linked_ptr<PublicSymbol>(new PublicSymbol((*it)->name,
+                                                           address, 0)));
+  }
+
+  // STACK CFI INIT records, each followed by its deltas.
+  if (cfi) {
+    vector<Module::StackFrameEntry *> entries;
+    module->GetStackFrameEntries(&entries);
+    for (vector<Module::StackFrameEntry *>::const_iterator it =
+             entries.begin();
+         it != entries.end(); ++it) {
+      const Module::StackFrameEntry *entry = *it;
+      string initial_rules = DumpedRuleMapString(entry->initial_rules);
+      if (initial_rules.empty()) {
+        BPLOG(ERROR) << "ModuleSerializer: CFI entry at "
+                     << HexString(entry->address) << " has no rules";
+        return NULL;
+      }
+      basic_module.cfi_initial_rules_.StoreRange(
+          entry->address - load_address, entry->size, initial_rules);
+      for (Module::RuleChangeMap::const_iterator delta =
+               entry->rule_changes.begin();
+           delta != entry->rule_changes.end(); ++delta) {
+        string delta_rules = DumpedRuleMapString(delta->second);
+        if (delta_rules.empty()) {
+          BPLOG(ERROR) << "ModuleSerializer: CFI delta at "
+                       << HexString(delta->first) << " has no rules";
+          return NULL;
+        }
+        basic_module.cfi_delta_rules_[delta->first - load_address] =
+            delta_rules;
+      }
+    }
+  }
+
+  return Serialize(basic_module, size);
+}
+
 bool ModuleSerializer::SerializeModuleAndLoadIntoFastResolver(
     const BasicSourceLineResolver::ModuleMap::const_iterator &iter,
     FastSourceLineResolver *fast_resolver) {
@@ -186,15 +313,37 @@ bool ModuleSerializer::ConvertOneModule(
 
 char* ModuleSerializer::SerializeSymbolFileData(
     const string &symbol_data, unsigned int *size) {
+  return SerializeSymbolFileData(symbol_data.c_str(), size);
+}
+
+char* ModuleSerializer::SerializeSymbolFileData(
+    const char *symbol_data, unsigned int *size) {
   scoped_ptr<BasicSourceLineResolver::Module> module(
       new BasicSourceLineResolver::Module("no name"));
-  scoped_array<char> buffer(new char[symbol_data.size() + 1]);
-  strcpy(buffer.get(), symbol_data.c_str());
-  if (!module->LoadMapFromMemory(buffer.get())) {
+  // LoadMapFromMemory does not write to the buffer.
+  if (!module->LoadMapFromMemory(const_cast<char *>(symbol_data))) {
     return NULL;
   }
-  buffer.reset(NULL);
   return Serialize(*(module.get()), size);
 }
 
+// static
+bool ModuleSerializer::IsCurrentHeader(const char *header) {
+  u_int32_t magic_and_version[2];
+  memcpy(magic_and_version, header, sizeof(magic_and_version));
+  return magic_and_version[0] == kMagic_ && magic_and_version[1] == kVersion_;
+}
+
+// static
+u_int64_t ModuleSerializer::SerializedSize(const char *header) {
+  if (!IsCurrentHeader(header))
+    return 0;
+  u_int32_t map_sizes[kNumberMaps_];
+  memcpy(map_sizes, header + 2 * sizeof(u_int32_t), sizeof(map_sizes));
+  u_int64_t total_size = HeaderSize() + 1;
+  for (u_int32_t i = 0; i < kNumberMaps_; ++i)
+    total_size += map_sizes[i];
+  return total_size;
+}
+
 }  // namespace google_breakpad
@@ -32,6 +32,14 @@
 // chunk of data. The serialized data can be read and loaded by
 // FastSourceLineResolver without CPU & memory-intensive parsing.
 //
+// ModuleSerializer can also serialize the google_breakpad::Module that the
+// symbol dumpers build, producing the same data as writing that Module out
+// as a text symbol file and serializing the result, without the text.
+//
+// Serialized data starts with a header: a magic number, a format version,
+// and the sizes of each of the module's serialized maps, all u_int32_t.
+// The maps follow in turn, and the data ends with a null terminator.
+//
 // Author: Siyang Xie (lambxsy@google.com)
 
 #ifndef PROCESSOR_MODULE_SERIALIZER_H__
@@ -51,6 +59,8 @@
 
 namespace google_breakpad {
 
+class Module;
+
 // ModuleSerializer serializes a loaded BasicSourceLineResolver::Module into a
 // chunk of memory data. ModuleSerializer also provides interface to compute
 // memory size of the serialized data, write serialized data directly into
@@ -75,12 +85,40 @@ class ModuleSerializer {
   char* Serialize(const BasicSourceLineResolver::Module &module,
                   unsigned int *size = NULL);
 
+  // Serializes a Module produced by a symbol dumper, as Serialize would
+  // serialize the result of loading the text symbol file that
+  // module->Write(stream, cfi) writes.  Like Write, this assigns source
+  // ids to module's files.  Returns NULL if the text symbol file would not
+  // load, which happens if a line has a line number that is not positive or
+  // a CFI record has no rules.  Caller takes ownership of the serialized
+  // data (on heap), and owner should call delete [] to free the memory.
+  char* SerializeDumpedModule(Module *module, bool cfi,
+                              unsigned int *size = NULL);
+
   // Given the string format symbol_data, produces a chunk of serialized data.
   // Caller takes ownership of the serialized data (on heap), and owner should
   // call delete [] to free the memory after use.
   char* SerializeSymbolFileData(const string &symbol_data,
                                 unsigned int *size = NULL);
 
+  // Same as above, but parses the C-string symbol_data in place.  The
+  // buffer is not modified, so it may be a read-only mapping.
+  char* SerializeSymbolFileData(const char *symbol_data,
+                                unsigned int *size = NULL);
+
+  // The number of bytes at the start of serialized data that give its
+  // magic number, format version, and the sizes of the serialized maps.
+  static size_t HeaderSize() { return (2 + kNumberMaps_) * sizeof(u_int32_t); }
+
+  // Returns true if the first HeaderSize() bytes of serialized data have
+  // the right magic number and format version.
+  static bool IsCurrentHeader(const char *header);
+
+  // Given the first HeaderSize() bytes of serialized data, returns the
+  // total size of the data, including its null terminator, or zero if
+  // the header is not current.
+  static u_int64_t SerializedSize(const char *header);
+
   // Serializes one loaded module with given moduleid in the basic source line
   // resolver, and loads the serialized data into the fast source line resolver.
   // Return false if the basic source line doesn't have a module with the given
@@ -109,6 +147,11 @@ class ModuleSerializer {
   static const u_int32_t kNumberMaps_ =
       FastSourceLineResolver::Module::kNumberMaps_;
 
+  // The magic number and format version that the header starts with.
+  static const u_int32_t kMagic_ = FastSourceLineResolver::Module::kMagic_;
+  static const u_int32_t kVersion_ =
+      FastSourceLineResolver::Module::kVersion_;
+
   // Memory sizes required to serialize map components in Module.
   u_int32_t map_sizes_[kNumberMaps_];
 
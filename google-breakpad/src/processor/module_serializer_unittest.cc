@@ -0,0 +1,216 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// module_serializer_unittest.cc: Unit tests for
+// ModuleSerializer::SerializeDumpedModule, which serializes a dumped
+// google_breakpad::Module without writing and parsing a symbol file.
+
+#include <sstream>
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/module.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/basic_code_module.h"
+#include "processor/module_comparer.h"
+#include "processor/module_serializer.h"
+#include "processor/scoped_ptr.h"
+
+namespace {
+
+using google_breakpad::BasicCodeModule;
+using google_breakpad::FastSourceLineResolver;
+using google_breakpad::Module;
+using google_breakpad::ModuleComparer;
+using google_breakpad::ModuleSerializer;
+using google_breakpad::StackFrame;
+using google_breakpad::scoped_array;
+using std::string;
+using std::stringstream;
+
+class SerializeDumpedModule : public ::testing::Test {
+ public:
+  SerializeDumpedModule()
+      : module("module name", "os", "architecture", "id") { }
+
+  // Fill module with a little of everything a symbol file can hold,
+  // relative to a nonzero load address.
+  void PopulateModule() {
+    module.SetLoadAddress(0x10000);
+    Module::File *file1 = module.FindFile("file1.cc");
+    Module::File *file2 = module.FindFile("file2.cc");
+    module.FindFile("unused.cc");
+
+    Module::Function *function1 = new Module::Function;
+    function1->name = "function1";
+    function1->address = 0x11000;
+    function1->size = 0x100;
+    function1->parameter_size = 8;
+    Module::Line line1 = { 0x11000, 0x40, file1, 27 };
+    Module::Line line2 = { 0x11040, 0xc0, file2, 152 };
+    function1->lines.push_back(line1);
+    function1->lines.push_back(line2);
+    module.AddFunction(function1);
+
+    Module::Function *function2 = new Module::Function;
+    function2->name = "function2(int, char)";
+    function2->address = 0x12000;
+    function2->size = 0x80;
+    function2->parameter_size = 0;
+    Module::Line line3 = { 0x12000, 0x80, file1, 1003 };
+    function2->lines.push_back(line3);
+    module.AddFunction(function2);
+
+    Module::Extern *extern1 = new Module::Extern;
+    extern1->address = 0x13000;
+    extern1->name = "extern1";
+    module.AddExtern(extern1);
+    // Loading a symbol file drops PUBLIC records at address zero.
+    Module::Extern *extern2 = new Module::Extern;
+    extern2->address = 0x10000;
+    extern2->name = "at_load_address";
+    module.AddExtern(extern2);
+
+    Module::StackFrameEntry *entry = new Module::StackFrameEntry;
+    entry->address = 0x11000;
+    entry->size = 0x100;
+    entry->initial_rules[".cfa"] = "$esp 4 +";
+    entry->initial_rules[".ra"] = ".cfa 4 - ^";
+    entry->rule_changes[0x11001][".cfa"] = "$esp 8 +";
+    entry->rule_changes[0x11003][".cfa"] = "$ebp 8 +";
+    entry->rule_changes[0x11003]["$ebp"] = ".cfa 8 - ^";
+    module.AddStackFrameEntry(entry);
+  }
+
+  // Serialize module as its symbol file would be, returning the data and
+  // storing its text in symbol_data.
+  string SerializeSymbolFile(bool cfi) {
+    stringstream stream;
+    EXPECT_TRUE(module.Write(stream, cfi));
+    symbol_data = stream.str();
+    unsigned int size = 0;
+    scoped_array<char> data(
+        serializer.SerializeSymbolFileData(symbol_data, &size));
+    EXPECT_TRUE(data.get() != NULL);
+    return data.get() ? string(data.get(), size) : string();
+  }
+
+  // Serialize module directly.
+  string SerializeDirectly(bool cfi) {
+    unsigned int size = 0;
+    scoped_array<char> data(
+        serializer.SerializeDumpedModule(&module, cfi, &size));
+    EXPECT_TRUE(data.get() != NULL);
+    return data.get() ? string(data.get(), size) : string();
+  }
+
+  Module module;
+  ModuleSerializer serializer;
+  string symbol_data;
+};
+
+TEST_F(SerializeDumpedModule, Empty) {
+  string expected = SerializeSymbolFile(true);
+  EXPECT_EQ(expected, SerializeDirectly(true));
+}
+
+TEST_F(SerializeDumpedModule, MatchesSymbolFile) {
+  PopulateModule();
+  string expected = SerializeSymbolFile(true);
+  string serialized = SerializeDirectly(true);
+  EXPECT_EQ(expected, serialized);
+
+  ModuleComparer comparer;
+  EXPECT_TRUE(comparer.Compare(symbol_data, serialized.c_str()));
+}
+
+TEST_F(SerializeDumpedModule, NoCFI) {
+  PopulateModule();
+  string expected = SerializeSymbolFile(false);
+  EXPECT_EQ(expected, SerializeDirectly(false));
+}
+
+TEST_F(SerializeDumpedModule, Lookup) {
+  PopulateModule();
+  string serialized = SerializeDirectly(true);
+  ASSERT_FALSE(serialized.empty());
+
+  BasicCodeModule code_module(0x7f000000, 0x10000, "module name", "", "", "",
+                              "");
+  FastSourceLineResolver resolver;
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&code_module, serialized));
+
+  StackFrame frame;
+  frame.module = &code_module;
+  frame.instruction = 0x7f001050;
+  resolver.FillSourceLineInfo(&frame);
+  EXPECT_EQ("function1", frame.function_name);
+  EXPECT_EQ(0x7f001000U, frame.function_base);
+  EXPECT_EQ("file2.cc", frame.source_file_name);
+  EXPECT_EQ(152, frame.source_line);
+  EXPECT_EQ(0x7f001040U, frame.source_line_base);
+}
+
+TEST_F(SerializeDumpedModule, OldFormat) {
+  string serialized = SerializeDirectly(true);
+  ASSERT_FALSE(serialized.empty());
+  EXPECT_TRUE(ModuleSerializer::IsCurrentHeader(serialized.data()));
+  EXPECT_EQ(serialized.size(),
+            ModuleSerializer::SerializedSize(serialized.data()));
+
+  // Change the version number, as data from some other version of
+  // ModuleSerializer would have.
+  serialized[4] ^= 0x80;
+  EXPECT_FALSE(ModuleSerializer::IsCurrentHeader(serialized.data()));
+  EXPECT_EQ(0U, ModuleSerializer::SerializedSize(serialized.data()));
+
+  BasicCodeModule code_module(0x7f000000, 0x10000, "module name", "", "", "",
+                              "");
+  FastSourceLineResolver resolver;
+  EXPECT_FALSE(resolver.LoadModuleUsingMapBuffer(&code_module, serialized));
+}
+
+TEST_F(SerializeDumpedModule, BadLineNumber) {
+  Module::File *file = module.FindFile("file.cc");
+  Module::Function *function = new Module::Function;
+  function->name = "function";
+  function->address = 0x1000;
+  function->size = 0x10;
+  function->parameter_size = 0;
+  Module::Line line = { 0x1000, 0x10, file, 0 };
+  function->lines.push_back(line);
+  module.AddFunction(function);
+
+  unsigned int size = 1;
+  EXPECT_TRUE(serializer.SerializeDumpedModule(&module, true, &size) == NULL);
+  EXPECT_EQ(0U, size);
+}
+
+}  // namespace
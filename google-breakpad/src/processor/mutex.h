@@ -0,0 +1,122 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// mutex.h: Minimal wrappers around POSIX mutexes and condition variables,
+// used by the processor where several threads may share one object.
+//
+// Mutex and ConditionVariable are non-recursive and non-copyable.
+// ScopedMutexLock holds a Mutex for the duration of a scope.
+
+#ifndef PROCESSOR_MUTEX_H__
+#define PROCESSOR_MUTEX_H__
+
+#include <assert.h>
+#include <pthread.h>
+
+namespace google_breakpad {
+
+class Mutex {
+ public:
+  Mutex() {
+    int result = pthread_mutex_init(&mutex_, NULL);
+    assert(result == 0);
+    (void)result;
+  }
+  ~Mutex() { pthread_mutex_destroy(&mutex_); }
+
+  void Lock() {
+    int result = pthread_mutex_lock(&mutex_);
+    assert(result == 0);
+    (void)result;
+  }
+  void Unlock() {
+    int result = pthread_mutex_unlock(&mutex_);
+    assert(result == 0);
+    (void)result;
+  }
+
+ private:
+  friend class ConditionVariable;
+
+  pthread_mutex_t mutex_;
+
+  // Disallow copy constructor and assignment operator.
+  Mutex(const Mutex &);
+  void operator=(const Mutex &);
+};
+
+class ScopedMutexLock {
+ public:
+  explicit ScopedMutexLock(Mutex *mutex) : mutex_(mutex) { mutex_->Lock(); }
+  ~ScopedMutexLock() { mutex_->Unlock(); }
+
+ private:
+  Mutex *mutex_;
+
+  // Disallow copy constructor and assignment operator.
+  ScopedMutexLock(const ScopedMutexLock &);
+  void operator=(const ScopedMutexLock &);
+};
+
+class ConditionVariable {
+ public:
+  ConditionVariable() {
+    int result = pthread_cond_init(&condition_, NULL);
+    assert(result == 0);
+    (void)result;
+  }
+  ~ConditionVariable() { pthread_cond_destroy(&condition_); }
+
+  // Atomically release MUTEX, which the caller must hold, and wait to be
+  // woken by Broadcast.  MUTEX is held again on return.  Wakeups may be
+  // spurious, so callers should re-check their condition in a loop.
+  void Wait(Mutex *mutex) {
+    int result = pthread_cond_wait(&condition_, &mutex->mutex_);
+    assert(result == 0);
+    (void)result;
+  }
+
+  // Wake all threads waiting on this condition variable.
+  void Broadcast() {
+    int result = pthread_cond_broadcast(&condition_);
+    assert(result == 0);
+    (void)result;
+  }
+
+ private:
+  pthread_cond_t condition_;
+
+  // Disallow copy constructor and assignment operator.
+  ConditionVariable(const ConditionVariable &);
+  void operator=(const ConditionVariable &);
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_MUTEX_H__
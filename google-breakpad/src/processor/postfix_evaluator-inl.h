@@ -237,6 +237,38 @@ bool PostfixEvaluator<ValueType>::EvaluateForValue(const string &expression,
   return PopValue(result);
 }
 
+template<typename ValueType>
+bool PostfixEvaluator<ValueType>::Evaluate(
+    const PostfixProgram &program,
+    const PostfixProgram::SlotNames &slot_names,
+    DictionaryValidityType *assigned) {
+  ValueType values[PostfixProgram::kMaxSlots];
+  u_int64_t valid = 0;
+  for (size_t slot = 0; slot < slot_names.size(); ++slot) {
+    typename DictionaryType::const_iterator iterator =
+        dictionary_->find(slot_names[slot]);
+    if (iterator != dictionary_->end()) {
+      values[slot] = iterator->second;
+      valid |= 1ULL << slot;
+    }
+  }
+
+  u_int64_t assigned_slots = 0;
+  bool result = program.Evaluate(values, &valid, &assigned_slots, memory_,
+                                 static_cast<ValueType *>(NULL));
+
+  // Like Evaluate, leave any assignments made before a failure in place.
+  for (size_t slot = 0; slot < slot_names.size(); ++slot) {
+    if (assigned_slots & (1ULL << slot)) {
+      (*dictionary_)[slot_names[slot]] = values[slot];
+      if (assigned)
+        (*assigned)[slot_names[slot]] = true;
+    }
+  }
+
+  return result;
+}
+
 template<typename ValueType>
 typename PostfixEvaluator<ValueType>::PopResult
 PostfixEvaluator<ValueType>::PopValueOrIdentifier(
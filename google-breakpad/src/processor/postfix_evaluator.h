@@ -72,6 +72,8 @@
 #include <string>
 #include <vector>
 
+#include "processor/postfix_program.h"
+
 namespace google_breakpad {
 
 using std::map;
@@ -110,6 +112,14 @@ class PostfixEvaluator {
   // Otherwise, return false.
   bool EvaluateForValue(const string &expression, ValueType *result);
 
+  // Like Evaluate, but runs PROGRAM, which was compiled against
+  // SLOT_NAMES, instead of parsing an expression.  The values of the
+  // program's identifiers are taken from the dictionary, and any
+  // assignments are stored back into it.
+  bool Evaluate(const PostfixProgram &program,
+                const PostfixProgram::SlotNames &slot_names,
+                DictionaryValidityType *assigned);
+
   DictionaryType* dictionary() const { return dictionary_; }
 
   // Reset the dictionary.  PostfixEvaluator does not take ownership.
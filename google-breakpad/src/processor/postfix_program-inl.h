@@ -0,0 +1,155 @@
+// -*- mode: C++ -*-
+
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// postfix_program-inl.h: Evaluation of compiled postfix programs.
+//
+// Documentation in postfix_program.h.
+
+#ifndef PROCESSOR_POSTFIX_PROGRAM_INL_H__
+#define PROCESSOR_POSTFIX_PROGRAM_INL_H__
+
+#include "processor/postfix_program.h"
+
+#include <limits>
+
+#include "google_breakpad/processor/memory_region.h"
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+template<typename ValueType>
+bool PostfixProgram::Evaluate(ValueType *values,
+                              u_int64_t *valid,
+                              u_int64_t *assigned,
+                              const MemoryRegion *memory,
+                              ValueType *result) const {
+  if (!compiled_)
+    return false;
+  if (final_depth_ != (result ? 1U : 0U)) {
+    BPLOG(ERROR) << "Expression yields " << final_depth_ << " values, "
+                    "expected " << (result ? 1 : 0) << ": " << expression_;
+    return false;
+  }
+  if (largest_literal_ > std::numeric_limits<ValueType>::max()) {
+    BPLOG(INFO) << "Literal out of range: " << expression_;
+    return false;
+  }
+
+  // Compile has verified that the stack never underflows and never grows
+  // beyond kMaxStackDepth entries, so no checks are needed here.
+  ValueType stack[kMaxStackDepth];
+  size_t depth = 0;
+
+  for (vector<Instruction>::const_iterator it = instructions_.begin();
+       it != instructions_.end(); ++it) {
+    switch (it->opcode) {
+      case OP_LITERAL:
+        stack[depth++] = static_cast<ValueType>(it->literal);
+        break;
+
+      case OP_LOAD:
+        if (!(*valid & (1ULL << it->slot))) {
+          BPLOG(INFO) << "Identifier not in dictionary: " << expression_;
+          return false;
+        }
+        stack[depth++] = values[it->slot];
+        break;
+
+      case OP_TARGET:
+        stack[depth++] = ValueType();
+        break;
+
+      case OP_ADD:
+        --depth;
+        stack[depth - 1] = stack[depth - 1] + stack[depth];
+        break;
+
+      case OP_SUBTRACT:
+        --depth;
+        stack[depth - 1] = stack[depth - 1] - stack[depth];
+        break;
+
+      case OP_MULTIPLY:
+        --depth;
+        stack[depth - 1] = stack[depth - 1] * stack[depth];
+        break;
+
+      case OP_DIVIDE_QUOTIENT:
+        --depth;
+        if (stack[depth] == 0) {
+          BPLOG(ERROR) << "Division by zero: " << expression_;
+          return false;
+        }
+        stack[depth - 1] = stack[depth - 1] / stack[depth];
+        break;
+
+      case OP_DIVIDE_MODULUS:
+        --depth;
+        if (stack[depth] == 0) {
+          BPLOG(ERROR) << "Division by zero: " << expression_;
+          return false;
+        }
+        stack[depth - 1] = stack[depth - 1] % stack[depth];
+        break;
+
+      case OP_DEREFERENCE: {
+        if (!memory) {
+          BPLOG(ERROR) << "Attempt to dereference without memory: " <<
+                          expression_;
+          return false;
+        }
+        ValueType address = stack[depth - 1];
+        if (!memory->GetMemoryAtAddress(address, &stack[depth - 1])) {
+          BPLOG(ERROR) << "Could not dereference memory at address " <<
+                          HexString(address) << ": " << expression_;
+          return false;
+        }
+        break;
+      }
+
+      case OP_ASSIGN:
+        depth -= 2;
+        values[it->slot] = stack[depth + 1];
+        *valid |= 1ULL << it->slot;
+        if (assigned)
+          *assigned |= 1ULL << it->slot;
+        break;
+    }
+  }
+
+  if (result)
+    *result = stack[0];
+  return true;
+}
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_POSTFIX_PROGRAM_INL_H__
@@ -0,0 +1,201 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// postfix_program.cc: Compilation of postfix expressions.
+//
+// See postfix_program.h for documentation.
+
+#include "processor/postfix_program.h"
+
+#include <limits>
+#include <sstream>
+
+namespace google_breakpad {
+
+using std::istringstream;
+using std::numeric_limits;
+
+bool PostfixProgram::Compile(const string &expression,
+                             SlotNames *slot_names) {
+  instructions_.clear();
+  expression_ = expression;
+  final_depth_ = 0;
+  largest_literal_ = 0;
+  assigns_ = false;
+  compiled_ = false;
+
+  // For each value on the stack at this point in the program, the index of
+  // the instruction that pushed it, or -1 if it was computed by an operator.
+  // An assignment uses this to find and patch the instruction that pushed
+  // its target.
+  vector<int> pushed_by;
+
+  istringstream stream(expression);
+  string token;
+  while (stream >> token) {
+    Opcode opcode;
+    if (token == "+")
+      opcode = OP_ADD;
+    else if (token == "-")
+      opcode = OP_SUBTRACT;
+    else if (token == "*")
+      opcode = OP_MULTIPLY;
+    else if (token == "/")
+      opcode = OP_DIVIDE_QUOTIENT;
+    else if (token == "%")
+      opcode = OP_DIVIDE_MODULUS;
+    else if (token == "^")
+      opcode = OP_DEREFERENCE;
+    else if (token == "=")
+      opcode = OP_ASSIGN;
+    else
+      opcode = OP_LOAD;
+
+    if (opcode == OP_LOAD) {
+      u_int64_t magnitude;
+      bool negative;
+      if (ParseLiteral(token, &magnitude, &negative)) {
+        instructions_.push_back(Instruction(OP_LITERAL, 0,
+                                            negative ? -magnitude : magnitude));
+        if (magnitude > largest_literal_)
+          largest_literal_ = magnitude;
+      } else {
+        int slot = InternSlot(token, slot_names);
+        if (slot < 0)
+          return CompileFailed();
+        instructions_.push_back(Instruction(OP_LOAD, slot, 0));
+      }
+      if (pushed_by.size() == kMaxStackDepth)
+        return CompileFailed();
+      pushed_by.push_back(instructions_.size() - 1);
+    } else if (opcode == OP_DEREFERENCE) {
+      if (pushed_by.empty())
+        return CompileFailed();
+      instructions_.push_back(Instruction(opcode, 0, 0));
+      pushed_by.back() = -1;
+    } else if (opcode == OP_ASSIGN) {
+      if (pushed_by.size() < 2)
+        return CompileFailed();
+      pushed_by.pop_back();
+      int target = pushed_by.back();
+      pushed_by.pop_back();
+
+      // The target must be a variable, not a literal or computed value.
+      if (target < 0 || instructions_[target].opcode != OP_LOAD)
+        return CompileFailed();
+      u_int32_t slot = instructions_[target].slot;
+      const string &name = (*slot_names)[slot];
+      if (name.empty() || name[0] != '$')
+        return CompileFailed();
+
+      // PostfixEvaluator looks identifiers up when they are popped, not
+      // when they are pushed.  If the variable's old value is still on the
+      // stack beneath the target, it would see the new value where a
+      // compiled program sees the old one, so leave such expressions to
+      // PostfixEvaluator.
+      bool pending_load = false;
+      for (size_t i = 0; i < pushed_by.size(); ++i) {
+        if (pushed_by[i] >= 0 &&
+            instructions_[pushed_by[i]].opcode == OP_LOAD &&
+            instructions_[pushed_by[i]].slot == slot) {
+          pending_load = true;
+        }
+      }
+      if (pending_load)
+        return CompileFailed();
+
+      instructions_[target].opcode = OP_TARGET;
+      instructions_.push_back(Instruction(opcode, slot, 0));
+      assigns_ = true;
+    } else {
+      // A binary operator.
+      if (pushed_by.size() < 2)
+        return CompileFailed();
+      instructions_.push_back(Instruction(opcode, 0, 0));
+      pushed_by.pop_back();
+      pushed_by.back() = -1;
+    }
+  }
+
+  final_depth_ = pushed_by.size();
+  compiled_ = true;
+  return true;
+}
+
+bool PostfixProgram::CompileFailed() {
+  instructions_.clear();
+  largest_literal_ = 0;
+  assigns_ = false;
+  compiled_ = false;
+  return false;
+}
+
+// static
+int PostfixProgram::InternSlot(const string &name, SlotNames *slot_names) {
+  for (size_t i = 0; i < slot_names->size(); ++i) {
+    if ((*slot_names)[i] == name)
+      return i;
+  }
+  if (slot_names->size() == kMaxSlots)
+    return -1;
+  slot_names->push_back(name);
+  return slot_names->size() - 1;
+}
+
+// static
+bool PostfixProgram::ParseLiteral(const string &token, u_int64_t *magnitude,
+                                  bool *negative) {
+  // PostfixEvaluator accepts an optional sign followed by decimal digits.
+  size_t start = 0;
+  *negative = false;
+  if (token[0] == '-' || token[0] == '+') {
+    *negative = token[0] == '-';
+    start = 1;
+  }
+  if (start == token.size())
+    return false;
+
+  // Accumulate the digits by hand: strtoull would quietly clamp a value
+  // that overflows, where PostfixEvaluator's stream extraction fails.
+  const u_int64_t kMax = numeric_limits<u_int64_t>::max();
+  u_int64_t value = 0;
+  for (size_t i = start; i < token.size(); ++i) {
+    if (token[i] < '0' || token[i] > '9')
+      return false;
+    u_int64_t digit = token[i] - '0';
+    if (value > (kMax - digit) / 10)
+      return false;
+    value = value * 10 + digit;
+  }
+
+  *magnitude = value;
+  return true;
+}
+
+}  // namespace google_breakpad
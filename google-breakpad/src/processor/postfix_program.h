@@ -0,0 +1,173 @@
+// -*- mode: C++ -*-
+
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// postfix_program.h: A compiled form of the postfix expressions evaluated
+// by PostfixEvaluator.
+//
+// PostfixEvaluator re-tokenizes its expression string on every evaluation,
+// keeps its stack as strings, and looks every identifier up in a
+// string-keyed map.  That is fine for evaluating an expression once, but
+// STACK CFI rules and STACK WIN program strings are evaluated for every
+// frame that uses them.  PostfixProgram parses an expression once into a
+// flat array of instructions whose identifiers have been resolved to small
+// integer "slots", so that subsequent evaluations need no parsing, no
+// string comparisons, and no heap allocation.
+//
+// A set of programs that will be evaluated against the same registers
+// shares a SlotNames table: Compile assigns each distinct identifier the
+// index of its entry in the table, adding entries as needed.  The caller
+// supplies values for the slots as an array indexed the same way, along
+// with a bit mask saying which slots hold values.
+//
+// A compiled program behaves exactly as PostfixEvaluator would on the same
+// expression, with the exception that division by zero fails instead of
+// trapping.  Compile refuses expressions whose meaning PostfixEvaluator
+// only determines while running, such as one that assigns to a variable
+// whose previous value is still on the stack; callers should fall back to
+// PostfixEvaluator for those.  Since the depth of a postfix expression's
+// stack is known statically, Compile also rejects expressions that would
+// underflow the stack or leave a wrong number of values on it.
+
+#ifndef PROCESSOR_POSTFIX_PROGRAM_H__
+#define PROCESSOR_POSTFIX_PROGRAM_H__
+
+#include <string>
+#include <vector>
+
+#include "google_breakpad/common/breakpad_types.h"
+
+namespace google_breakpad {
+
+using std::string;
+using std::vector;
+
+class MemoryRegion;
+
+class PostfixProgram {
+ public:
+  // The identifiers referenced by a set of programs.  Slot i holds the
+  // value of slot_names[i].
+  typedef vector<string> SlotNames;
+
+  // The largest number of slots a table may have, so that validity can be
+  // tracked in a u_int64_t, and the deepest stack a program may need.
+  static const size_t kMaxSlots = 64;
+  static const size_t kMaxStackDepth = 32;
+
+  PostfixProgram()
+      : final_depth_(0), largest_literal_(0), assigns_(false),
+        compiled_(false) {}
+
+  // Compile EXPRESSION, adding any identifiers it uses to SLOT_NAMES.
+  // Return true on success.  On failure, this program is left empty, and
+  // SLOT_NAMES may have gained entries.
+  bool Compile(const string &expression, SlotNames *slot_names);
+
+  // Evaluate this program.  VALUES holds the value of each slot whose bit
+  // is set in *VALID; it must have room for every slot in the table the
+  // program was compiled against.  Assignments store into VALUES and set
+  // the slot's bit in *VALID, and in *ASSIGNED if that is non-NULL.
+  // MEMORY may be NULL, in which case dereferencing fails.
+  //
+  // If RESULT is NULL, the program must leave nothing on the stack, as
+  // PostfixEvaluator::Evaluate requires; otherwise it must leave exactly
+  // one value, which is stored in *RESULT, as with
+  // PostfixEvaluator::EvaluateForValue.  Return true on success.
+  template<typename ValueType>
+  bool Evaluate(ValueType *values, u_int64_t *valid, u_int64_t *assigned,
+                const MemoryRegion *memory, ValueType *result) const;
+
+  // True if Compile has succeeded on this program.
+  bool compiled() const { return compiled_; }
+
+  // True if evaluating this program may store into VALUES.
+  bool assigns() const { return assigns_; }
+
+  // The number of values this program leaves on the stack.
+  size_t final_depth() const { return final_depth_; }
+
+  // The expression this program was compiled from.
+  const string &expression() const { return expression_; }
+
+ private:
+  enum Opcode {
+    OP_LITERAL,       // push literal
+    OP_LOAD,          // push values[slot], failing if it is not valid
+    OP_TARGET,        // push a placeholder for the target of an OP_ASSIGN
+    OP_ADD,
+    OP_SUBTRACT,
+    OP_MULTIPLY,
+    OP_DIVIDE_QUOTIENT,
+    OP_DIVIDE_MODULUS,
+    OP_DEREFERENCE,
+    OP_ASSIGN         // pop a value and a placeholder; values[slot] = value
+  };
+
+  struct Instruction {
+    Instruction(Opcode set_opcode, u_int32_t set_slot, u_int64_t set_literal)
+        : opcode(set_opcode), slot(set_slot), literal(set_literal) {}
+    u_int32_t opcode;
+    u_int32_t slot;
+    u_int64_t literal;
+  };
+
+  // Discard a partially compiled program, and return false.
+  bool CompileFailed();
+
+  // Return the index of NAME in SLOT_NAMES, adding it if necessary.  Return
+  // -1 if the table is full.
+  static int InternSlot(const string &name, SlotNames *slot_names);
+
+  // If TOKEN is a literal as PostfixEvaluator understands it, store its
+  // magnitude in *MAGNITUDE and its sign in *NEGATIVE, and return true.
+  // Like PostfixEvaluator, return false for a magnitude too large to
+  // represent, so that TOKEN is treated as an identifier.
+  static bool ParseLiteral(const string &token, u_int64_t *magnitude,
+                           bool *negative);
+
+  vector<Instruction> instructions_;
+  string expression_;
+  size_t final_depth_;
+
+  // The largest literal magnitude in the program.  PostfixEvaluator
+  // rejects literals that do not fit in its ValueType, so Evaluate must
+  // too.
+  u_int64_t largest_literal_;
+
+  bool assigns_;
+  bool compiled_;
+};
+
+}  // namespace google_breakpad
+
+#include "processor/postfix_program-inl.h"
+
+#endif  // PROCESSOR_POSTFIX_PROGRAM_H__
@@ -0,0 +1,284 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// postfix_program_unittest.cc: Unit tests for PostfixProgram.
+
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "google_breakpad/common/breakpad_types.h"
+#include "google_breakpad/processor/memory_region.h"
+#include "processor/postfix_evaluator-inl.h"
+#include "processor/postfix_program.h"
+
+namespace {
+
+using google_breakpad::MemoryRegion;
+using google_breakpad::PostfixEvaluator;
+using google_breakpad::PostfixProgram;
+using std::string;
+
+// FakeMemoryRegion returns one more than the address being dereferenced,
+// like the one in postfix_evaluator_unittest.cc.
+class FakeMemoryRegion : public MemoryRegion {
+ public:
+  virtual u_int64_t GetBase() const { return 0; }
+  virtual u_int32_t GetSize() const { return 0; }
+  virtual bool GetMemoryAtAddress(u_int64_t address, u_int8_t  *value) const {
+    *value = address + 1;
+    return true;
+  }
+  virtual bool GetMemoryAtAddress(u_int64_t address, u_int16_t *value) const {
+    *value = address + 1;
+    return true;
+  }
+  virtual bool GetMemoryAtAddress(u_int64_t address, u_int32_t *value) const {
+    *value = address + 1;
+    return true;
+  }
+  virtual bool GetMemoryAtAddress(u_int64_t address, u_int64_t *value) const {
+    *value = address + 1;
+    return true;
+  }
+};
+
+class PostfixProgramTest : public ::testing::Test {
+ public:
+  PostfixProgramTest() : valid(0), assigned(0) {
+    for (size_t i = 0; i < PostfixProgram::kMaxSlots; i++)
+      values[i] = 0;
+  }
+
+  // Give the identifier NAME the value VALUE.
+  void Set(const string &name, u_int32_t value) {
+    size_t slot = Slot(name);
+    values[slot] = value;
+    valid |= static_cast<u_int64_t>(1) << slot;
+  }
+
+  // Return the slot assigned to NAME, adding one if necessary.
+  size_t Slot(const string &name) {
+    for (size_t i = 0; i < slot_names.size(); i++)
+      if (slot_names[i] == name)
+        return i;
+    slot_names.push_back(name);
+    return slot_names.size() - 1;
+  }
+
+  PostfixProgram::SlotNames slot_names;
+  u_int32_t values[PostfixProgram::kMaxSlots];
+  u_int64_t valid, assigned;
+  FakeMemoryRegion memory;
+  PostfixProgram program;
+};
+
+TEST_F(PostfixProgramTest, Literals) {
+  u_int32_t result;
+  ASSERT_TRUE(program.Compile("42", &slot_names));
+  EXPECT_EQ(1U, program.final_depth());
+  EXPECT_FALSE(program.assigns());
+  ASSERT_TRUE(program.Evaluate(values, &valid, &assigned, &memory, &result));
+  EXPECT_EQ(42U, result);
+
+  ASSERT_TRUE(program.Compile("-3", &slot_names));
+  ASSERT_TRUE(program.Evaluate(values, &valid, &assigned, &memory, &result));
+  EXPECT_EQ(static_cast<u_int32_t>(-3), result);
+  EXPECT_TRUE(slot_names.empty());
+}
+
+// Like PostfixEvaluator, reject literals that do not fit in the value type
+// rather than truncating them.
+TEST_F(PostfixProgramTest, LiteralOverflow) {
+  const char *kExpressions[] = {
+    "4294967296",
+    "-4294967296",
+    "4294967296 1 +",
+    "18446744073709551616"
+  };
+  for (size_t i = 0; i < sizeof(kExpressions) / sizeof(kExpressions[0]);
+       i++) {
+    SCOPED_TRACE(kExpressions[i]);
+    PostfixEvaluator<u_int32_t>::DictionaryType dictionary;
+    PostfixEvaluator<u_int32_t> evaluator(&dictionary, &memory);
+    u_int32_t evaluator_result;
+    EXPECT_FALSE(evaluator.EvaluateForValue(kExpressions[i],
+                                            &evaluator_result));
+
+    u_int32_t result;
+    ASSERT_TRUE(program.Compile(kExpressions[i], &slot_names));
+    EXPECT_FALSE(program.Evaluate(values, &valid, &assigned, &memory,
+                                  &result));
+  }
+
+  // The same literals fit in a u_int64_t.
+  u_int64_t values64[PostfixProgram::kMaxSlots];
+  u_int64_t result64;
+  ASSERT_TRUE(program.Compile("4294967296 1 +", &slot_names));
+  ASSERT_TRUE(program.Evaluate(values64, &valid, &assigned, &memory,
+                               &result64));
+  EXPECT_EQ(0x100000001ULL, result64);
+  ASSERT_TRUE(program.Compile("18446744073709551615", &slot_names));
+  ASSERT_TRUE(program.Evaluate(values64, &valid, &assigned, &memory,
+                               &result64));
+  EXPECT_EQ(0xffffffffffffffffULL, result64);
+
+  // One past that is not a literal at all, but an unknown identifier.
+  slot_names.clear();
+  ASSERT_TRUE(program.Compile("18446744073709551616", &slot_names));
+  ASSERT_EQ(1U, slot_names.size());
+  EXPECT_EQ("18446744073709551616", slot_names[0]);
+  EXPECT_FALSE(program.Evaluate(values64, &valid, &assigned, &memory,
+                                &result64));
+}
+
+TEST_F(PostfixProgramTest, Arithmetic) {
+  u_int32_t result;
+  ASSERT_TRUE(program.Compile("2 3 + 4 * 10 - 3 / 7 %", &slot_names));
+  ASSERT_TRUE(program.Evaluate(values, &valid, &assigned, &memory, &result));
+  EXPECT_EQ(((2U + 3U) * 4U - 10U) / 3U % 7U, result);
+}
+
+TEST_F(PostfixProgramTest, DivideByZero) {
+  u_int32_t result;
+  ASSERT_TRUE(program.Compile("1 0 /", &slot_names));
+  EXPECT_FALSE(program.Evaluate(values, &valid, &assigned, &memory, &result));
+  ASSERT_TRUE(program.Compile("1 0 %", &slot_names));
+  EXPECT_FALSE(program.Evaluate(values, &valid, &assigned, &memory, &result));
+}
+
+TEST_F(PostfixProgramTest, Dereference) {
+  u_int32_t result;
+  ASSERT_TRUE(program.Compile("$esp ^ 4 +", &slot_names));
+  Set("$esp", 0x1000);
+  ASSERT_TRUE(program.Evaluate(values, &valid, &assigned, &memory, &result));
+  EXPECT_EQ(0x1005U, result);
+
+  // Without memory, dereferencing fails.
+  EXPECT_FALSE(program.Evaluate(values, &valid, &assigned, NULL, &result));
+}
+
+TEST_F(PostfixProgramTest, MissingIdentifier) {
+  u_int32_t result;
+  ASSERT_TRUE(program.Compile("$ebp 8 +", &slot_names));
+  EXPECT_FALSE(program.Evaluate(values, &valid, &assigned, &memory, &result));
+  Set("$ebp", 0x20);
+  ASSERT_TRUE(program.Evaluate(values, &valid, &assigned, &memory, &result));
+  EXPECT_EQ(0x28U, result);
+}
+
+TEST_F(PostfixProgramTest, Assignment) {
+  ASSERT_TRUE(program.Compile("$T0 $ebp 8 + = $eip $T0 ^ =", &slot_names));
+  EXPECT_EQ(0U, program.final_depth());
+  EXPECT_TRUE(program.assigns());
+  Set("$ebp", 0x100);
+  ASSERT_TRUE(program.Evaluate(values, &valid, &assigned, &memory,
+                               static_cast<u_int32_t *>(NULL)));
+  EXPECT_EQ(0x108U, values[Slot("$T0")]);
+  EXPECT_EQ(0x109U, values[Slot("$eip")]);
+  u_int64_t expected = (static_cast<u_int64_t>(1) << Slot("$T0")) |
+                       (static_cast<u_int64_t>(1) << Slot("$eip"));
+  EXPECT_EQ(expected, assigned);
+  EXPECT_EQ(expected | (static_cast<u_int64_t>(1) << Slot("$ebp")), valid);
+}
+
+TEST_F(PostfixProgramTest, WrongFinalDepth) {
+  u_int32_t result;
+  ASSERT_TRUE(program.Compile("1 2", &slot_names));
+  EXPECT_EQ(2U, program.final_depth());
+  EXPECT_FALSE(program.Evaluate(values, &valid, &assigned, &memory, &result));
+  EXPECT_FALSE(program.Evaluate(values, &valid, &assigned, &memory,
+                                static_cast<u_int32_t *>(NULL)));
+}
+
+TEST_F(PostfixProgramTest, CompileFailures) {
+  // Stack underflow.
+  EXPECT_FALSE(program.Compile("+", &slot_names));
+  EXPECT_FALSE(program.Compile("1 +", &slot_names));
+  EXPECT_FALSE(program.Compile("^", &slot_names));
+  EXPECT_FALSE(program.Compile("1 =", &slot_names));
+  EXPECT_FALSE(program.compiled());
+
+  // Assignment targets must be '$' variables.
+  EXPECT_FALSE(program.Compile("1 2 =", &slot_names));
+  EXPECT_FALSE(program.Compile("eip 2 =", &slot_names));
+  EXPECT_FALSE(program.Compile("$a $b + 2 =", &slot_names));
+
+  // An assignment whose target's old value is still on the stack.
+  EXPECT_FALSE(program.Compile("$a $a 1 = +", &slot_names));
+
+  // Too many identifiers for the slot table.
+  PostfixProgram::SlotNames full(PostfixProgram::kMaxSlots, "$x");
+  for (size_t i = 0; i < full.size(); i++)
+    full[i] += static_cast<char>('0' + i % 10) + string(i / 10 + 1, 'y');
+  EXPECT_FALSE(program.Compile("$new", &full));
+
+  ASSERT_TRUE(program.Compile("$a 1 =", &slot_names));
+  EXPECT_TRUE(program.compiled());
+}
+
+// A compiled program must agree with PostfixEvaluator on the same input.
+TEST_F(PostfixProgramTest, MatchesPostfixEvaluator) {
+  const char *kExpressions[] = {
+    "$T0 $ebp = $eip $T0 4 + ^ = $ebp $T0 ^ = $esp $T0 8 + =",
+    "$T1 .raSearchStart = $eip $T1 ^ = $ebp $T1 4 - ^ = $esp $T1 4 + =",
+    "$T0 $ebp 12 - = $eip $T0 ^ = $T0 $T0 100 * = $L $T0 7 % =",
+    "$T2 $esp 16 + = $T2 $T2 3 / = $eip $T2 ^ ="
+  };
+  for (size_t i = 0; i < sizeof(kExpressions) / sizeof(kExpressions[0]);
+       i++) {
+    SCOPED_TRACE(kExpressions[i]);
+    PostfixEvaluator<u_int32_t>::DictionaryType dictionary;
+    dictionary["$ebp"] = 0x2000;
+    dictionary["$esp"] = 0x1ff0;
+    dictionary[".raSearchStart"] = 0x1ff8;
+    PostfixEvaluator<u_int32_t>::DictionaryValidityType evaluator_assigned;
+    PostfixEvaluator<u_int32_t> evaluator(&dictionary, &memory);
+    bool evaluator_ok = evaluator.Evaluate(kExpressions[i],
+                                           &evaluator_assigned);
+
+    slot_names.clear();
+    valid = assigned = 0;
+    Set("$ebp", 0x2000);
+    Set("$esp", 0x1ff0);
+    Set(".raSearchStart", 0x1ff8);
+    ASSERT_TRUE(program.Compile(kExpressions[i], &slot_names));
+    ASSERT_EQ(evaluator_ok,
+              program.Evaluate(values, &valid, &assigned, &memory,
+                               static_cast<u_int32_t *>(NULL)));
+    for (size_t slot = 0; slot < slot_names.size(); slot++) {
+      if (!(assigned & (static_cast<u_int64_t>(1) << slot)))
+        continue;
+      SCOPED_TRACE(slot_names[slot]);
+      EXPECT_TRUE(evaluator_assigned[slot_names[slot]]);
+      EXPECT_EQ(dictionary[slot_names[slot]], values[slot]);
+    }
+  }
+}
+
+}  // namespace
@@ -36,6 +36,7 @@
 #include "google_breakpad/processor/process_state.h"
 #include "google_breakpad/processor/call_stack.h"
 #include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/process_stats.h"
 
 namespace google_breakpad {
 
@@ -59,6 +60,8 @@ void ProcessState::Clear() {
   system_info_.Clear();
   delete modules_;
   modules_ = NULL;
+  delete stats_;
+  stats_ = NULL;
 }
 
 }  // namespace google_breakpad
@@ -0,0 +1,728 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_state_serializer.cc: Encodes ProcessStates as ProcessStateProtos
+// and decodes them.
+//
+// See process_state_serializer.h for documentation.
+
+#include "processor/process_state_serializer.h"
+
+#include <algorithm>
+
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/basic_code_module.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// Protocol buffer wire types.
+enum WireType {
+  WIRETYPE_VARINT = 0,
+  WIRETYPE_FIXED64 = 1,
+  WIRETYPE_LENGTH_DELIMITED = 2,
+  WIRETYPE_FIXED32 = 5
+};
+
+// Field numbers from process_state.proto.
+enum ProcessStateField {
+  PROCESS_TIME_DATE_STAMP = 1,
+  PROCESS_CRASH = 2,
+  PROCESS_ASSERTION = 3,
+  PROCESS_REQUESTING_THREAD = 4,
+  PROCESS_THREADS = 5,
+  PROCESS_MODULES = 6,
+  PROCESS_OS = 7,
+  PROCESS_OS_SHORT = 8,
+  PROCESS_OS_VERSION = 9,
+  PROCESS_CPU = 10,
+  PROCESS_CPU_INFO = 11,
+  PROCESS_CPU_COUNT = 12
+};
+
+enum CrashField {
+  CRASH_REASON = 1,
+  CRASH_ADDRESS = 2
+};
+
+enum ThreadField {
+  THREAD_FRAMES = 1
+};
+
+enum StackFrameField {
+  FRAME_INSTRUCTION = 1,
+  FRAME_MODULE = 2,
+  FRAME_FUNCTION_NAME = 3,
+  FRAME_FUNCTION_BASE = 4,
+  FRAME_SOURCE_FILE_NAME = 5,
+  FRAME_SOURCE_LINE = 6,
+  FRAME_SOURCE_LINE_BASE = 7
+};
+
+enum CodeModuleField {
+  MODULE_BASE_ADDRESS = 1,
+  MODULE_SIZE = 2,
+  MODULE_CODE_FILE = 3,
+  MODULE_CODE_IDENTIFIER = 4,
+  MODULE_DEBUG_FILE = 5,
+  MODULE_DEBUG_IDENTIFIER = 6,
+  MODULE_VERSION = 7
+};
+
+size_t VarintSize(u_int64_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+// Every field number in the schema is below 16, so every tag is one byte.
+size_t IntegerFieldSize(u_int64_t value) {
+  return 1 + VarintSize(value);
+}
+
+size_t LengthDelimitedFieldSize(size_t length) {
+  return 1 + VarintSize(length) + length;
+}
+
+void AppendVarint(u_int64_t value, string *output) {
+  char bytes[10];
+  size_t count = 0;
+  while (value >= 0x80) {
+    bytes[count++] = static_cast<char>((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  bytes[count++] = static_cast<char>(value);
+  output->append(bytes, count);
+}
+
+void AppendTag(int field, WireType wire_type, string *output) {
+  output->push_back(static_cast<char>((field << 3) | wire_type));
+}
+
+// int32 and int64 fields are encoded as the varint of their 64-bit two's
+// complement, so negative values take ten bytes.
+void AppendIntegerField(int field, u_int64_t value, string *output) {
+  AppendTag(field, WIRETYPE_VARINT, output);
+  AppendVarint(value, output);
+}
+
+void AppendLengthField(int field, size_t length, string *output) {
+  AppendTag(field, WIRETYPE_LENGTH_DELIMITED, output);
+  AppendVarint(length, output);
+}
+
+void AppendStringField(int field, const string &value, string *output) {
+  AppendLengthField(field, value.size(), output);
+  output->append(value);
+}
+
+// Optional strings are omitted when empty, as a reader defaults them to
+// empty anyway.
+size_t OptionalStringFieldSize(const string &value) {
+  return value.empty() ? 0 : LengthDelimitedFieldSize(value.size());
+}
+
+void AppendOptionalStringField(int field, const string &value,
+                               string *output) {
+  if (!value.empty())
+    AppendStringField(field, value, output);
+}
+
+// Appends |module| as a length-delimited CodeModule field numbered
+// |field|.  CodeModule's accessors return strings by value, so each is
+// fetched only once.
+void AppendCodeModuleField(int field, const CodeModule &module,
+                           string *output) {
+  u_int64_t base_address = module.base_address();
+  u_int64_t size = module.size();
+  string code_file = module.code_file();
+  string code_identifier = module.code_identifier();
+  string debug_file = module.debug_file();
+  string debug_identifier = module.debug_identifier();
+  string version = module.version();
+
+  AppendLengthField(field,
+                    IntegerFieldSize(base_address) +
+                    IntegerFieldSize(size) +
+                    OptionalStringFieldSize(code_file) +
+                    OptionalStringFieldSize(code_identifier) +
+                    OptionalStringFieldSize(debug_file) +
+                    OptionalStringFieldSize(debug_identifier) +
+                    OptionalStringFieldSize(version),
+                    output);
+  AppendIntegerField(MODULE_BASE_ADDRESS, base_address, output);
+  AppendIntegerField(MODULE_SIZE, size, output);
+  AppendOptionalStringField(MODULE_CODE_FILE, code_file, output);
+  AppendOptionalStringField(MODULE_CODE_IDENTIFIER, code_identifier, output);
+  AppendOptionalStringField(MODULE_DEBUG_FILE, debug_file, output);
+  AppendOptionalStringField(MODULE_DEBUG_IDENTIFIER, debug_identifier,
+                            output);
+  AppendOptionalStringField(MODULE_VERSION, version, output);
+}
+
+// A frame's module is written as a CodeModule holding only its base
+// address; the full module is among the ProcessStateProto's modules.
+size_t StackFrameSize(const StackFrame &frame) {
+  size_t size = IntegerFieldSize(frame.instruction);
+  if (frame.module) {
+    size += LengthDelimitedFieldSize(
+        IntegerFieldSize(frame.module->base_address()));
+  }
+  if (!frame.function_name.empty()) {
+    size += LengthDelimitedFieldSize(frame.function_name.size()) +
+            IntegerFieldSize(frame.function_base);
+  }
+  if (!frame.source_file_name.empty()) {
+    size += LengthDelimitedFieldSize(frame.source_file_name.size()) +
+            IntegerFieldSize(static_cast<int64_t>(frame.source_line)) +
+            IntegerFieldSize(frame.source_line_base);
+  }
+  return size;
+}
+
+void AppendStackFrame(const StackFrame &frame, string *output) {
+  AppendIntegerField(FRAME_INSTRUCTION, frame.instruction, output);
+  if (frame.module) {
+    u_int64_t base_address = frame.module->base_address();
+    AppendLengthField(FRAME_MODULE, IntegerFieldSize(base_address), output);
+    AppendIntegerField(MODULE_BASE_ADDRESS, base_address, output);
+  }
+  if (!frame.function_name.empty()) {
+    AppendStringField(FRAME_FUNCTION_NAME, frame.function_name, output);
+    AppendIntegerField(FRAME_FUNCTION_BASE, frame.function_base, output);
+  }
+  if (!frame.source_file_name.empty()) {
+    AppendStringField(FRAME_SOURCE_FILE_NAME, frame.source_file_name, output);
+    AppendIntegerField(FRAME_SOURCE_LINE,
+                       static_cast<int64_t>(frame.source_line), output);
+    AppendIntegerField(FRAME_SOURCE_LINE_BASE, frame.source_line_base,
+                       output);
+  }
+}
+
+size_t ThreadSize(const CallStack &stack) {
+  size_t size = 0;
+  const vector<StackFrame*> *frames = stack.frames();
+  for (size_t i = 0; i < frames->size(); ++i)
+    size += LengthDelimitedFieldSize(StackFrameSize(*(*frames)[i]));
+  return size;
+}
+
+void AppendThread(const CallStack &stack, string *output) {
+  const vector<StackFrame*> *frames = stack.frames();
+  for (size_t i = 0; i < frames->size(); ++i) {
+    const StackFrame &frame = *(*frames)[i];
+    AppendLengthField(THREAD_FRAMES, StackFrameSize(frame), output);
+    AppendStackFrame(frame, output);
+  }
+}
+
+}  // namespace
+
+void ProcessStateSerializer::Serialize(const ProcessState &process_state,
+                                       string *output) {
+  AppendIntegerField(PROCESS_TIME_DATE_STAMP, process_state.time_date_stamp(),
+                     output);
+  if (process_state.crashed()) {
+    const string &reason = process_state.crash_reason();
+    AppendLengthField(PROCESS_CRASH,
+                      LengthDelimitedFieldSize(reason.size()) +
+                      IntegerFieldSize(process_state.crash_address()),
+                      output);
+    AppendStringField(CRASH_REASON, reason, output);
+    AppendIntegerField(CRASH_ADDRESS, process_state.crash_address(), output);
+  }
+  AppendOptionalStringField(PROCESS_ASSERTION, process_state.assertion(),
+                            output);
+  if (process_state.requesting_thread() != -1) {
+    AppendIntegerField(PROCESS_REQUESTING_THREAD,
+                       static_cast<int64_t>(process_state.requesting_thread()),
+                       output);
+  }
+
+  // Modules precede threads, so readers can resolve frames' modules as
+  // they go.
+  const CodeModules *modules = process_state.modules();
+  if (modules) {
+    unsigned int module_count = modules->module_count();
+    for (unsigned int i = 0; i < module_count; ++i) {
+      AppendCodeModuleField(PROCESS_MODULES, *modules->GetModuleAtSequence(i),
+                            output);
+    }
+  }
+
+  const SystemInfo *system_info = process_state.system_info();
+  AppendOptionalStringField(PROCESS_OS, system_info->os, output);
+  AppendOptionalStringField(PROCESS_OS_SHORT, system_info->os_short, output);
+  AppendOptionalStringField(PROCESS_OS_VERSION, system_info->os_version,
+                            output);
+  AppendOptionalStringField(PROCESS_CPU, system_info->cpu, output);
+  AppendOptionalStringField(PROCESS_CPU_INFO, system_info->cpu_info, output);
+  AppendIntegerField(PROCESS_CPU_COUNT,
+                     static_cast<int64_t>(system_info->cpu_count), output);
+
+  const vector<CallStack*> *threads = process_state.threads();
+  for (size_t i = 0; i < threads->size(); ++i) {
+    const CallStack &stack = *(*threads)[i];
+    AppendLengthField(PROCESS_THREADS, ThreadSize(stack), output);
+    AppendThread(stack, output);
+  }
+}
+
+void ProcessStateSerializer::SerializeDelimited(
+    const ProcessState &process_state, string *output) {
+  // The message's size is only known once it has been encoded, so its
+  // length goes in afterwards.
+  size_t start = output->size();
+  Serialize(process_state, output);
+  string length;
+  AppendVarint(output->size() - start, &length);
+  output->insert(start, length);
+}
+
+void ProcessSummary::Clear() {
+  time_date_stamp = 0;
+  crashed = false;
+  crash_reason.clear();
+  crash_address = 0;
+  assertion.clear();
+  requesting_thread = -1;
+  system_info.Clear();
+}
+
+// A bounds-checked position in an encoded message.
+class ProcessStateReader::Cursor {
+ public:
+  Cursor(const char *data, size_t size)
+      : position_(reinterpret_cast<const u_int8_t*>(data)),
+        end_(position_ + size) {}
+
+  bool AtEnd() const { return position_ == end_; }
+
+  bool ReadVarint(u_int64_t *value) {
+    u_int64_t result = 0;
+    for (int shift = 0; shift < 64 && position_ < end_; shift += 7) {
+      u_int8_t byte = *position_++;
+      result |= static_cast<u_int64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        *value = result;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ReadTag(int *field, int *wire_type) {
+    u_int64_t tag;
+    if (!ReadVarint(&tag) || (tag >> 3) == 0 || (tag >> 3) > 0x1fffffff)
+      return false;
+    *field = static_cast<int>(tag >> 3);
+    *wire_type = static_cast<int>(tag & 7);
+    return true;
+  }
+
+  // Sets |*nested| to the length-delimited value at the cursor, and
+  // advances past it.
+  bool ReadNested(Cursor *nested) {
+    u_int64_t length;
+    if (!ReadVarint(&length) ||
+        length > static_cast<u_int64_t>(end_ - position_))
+      return false;
+    nested->position_ = position_;
+    nested->end_ = position_ + length;
+    position_ += length;
+    return true;
+  }
+
+  bool ReadString(string *value) {
+    Cursor nested(NULL, 0);
+    if (!ReadNested(&nested))
+      return false;
+    value->assign(reinterpret_cast<const char*>(nested.position_),
+                  nested.end_ - nested.position_);
+    return true;
+  }
+
+  // Reads an integer field of |wire_type|, as it must be a varint.
+  bool ReadInteger(int wire_type, u_int64_t *value) {
+    return wire_type == WIRETYPE_VARINT && ReadVarint(value);
+  }
+
+  bool ReadString(int wire_type, string *value) {
+    return wire_type == WIRETYPE_LENGTH_DELIMITED && ReadString(value);
+  }
+
+  bool ReadNested(int wire_type, Cursor *nested) {
+    return wire_type == WIRETYPE_LENGTH_DELIMITED && ReadNested(nested);
+  }
+
+  // Skips the value of a field this reader doesn't know.
+  bool Skip(int wire_type) {
+    u_int64_t value;
+    Cursor nested(NULL, 0);
+    size_t size;
+    switch (wire_type) {
+      case WIRETYPE_VARINT:
+        return ReadVarint(&value);
+      case WIRETYPE_LENGTH_DELIMITED:
+        return ReadNested(&nested);
+      case WIRETYPE_FIXED64:
+        size = 8;
+        break;
+      case WIRETYPE_FIXED32:
+        size = 4;
+        break;
+      default:
+        // Groups are deprecated, and not used by the schema.
+        return false;
+    }
+    if (size > static_cast<size_t>(end_ - position_))
+      return false;
+    position_ += size;
+    return true;
+  }
+
+ private:
+  const u_int8_t *position_;
+  const u_int8_t *end_;
+};
+
+// A module decoded from a CodeModule message.
+class ProcessStateReader::DecodedModule : public CodeModule {
+ public:
+  DecodedModule() { Clear(); }
+
+  void Clear() {
+    base_address_ = 0;
+    size_ = 0;
+    code_file_.clear();
+    code_identifier_.clear();
+    debug_file_.clear();
+    debug_identifier_.clear();
+    version_.clear();
+  }
+
+  virtual u_int64_t base_address() const { return base_address_; }
+  virtual u_int64_t size() const { return size_; }
+  virtual string code_file() const { return code_file_; }
+  virtual string code_identifier() const { return code_identifier_; }
+  virtual string debug_file() const { return debug_file_; }
+  virtual string debug_identifier() const { return debug_identifier_; }
+  virtual string version() const { return version_; }
+  virtual const CodeModule* Copy() const { return new BasicCodeModule(this); }
+
+  u_int64_t base_address_;
+  u_int64_t size_;
+  string code_file_;
+  string code_identifier_;
+  string debug_file_;
+  string debug_identifier_;
+  string version_;
+};
+
+ProcessStateReader::~ProcessStateReader() {
+  for (size_t i = 0; i < module_pool_.size(); ++i)
+    delete module_pool_[i];
+}
+
+const CodeModule *ProcessStateReader::FindModule(u_int64_t base_address) {
+  if (!modules_sorted_) {
+    std::sort(modules_by_address_.begin(), modules_by_address_.end());
+    modules_sorted_ = true;
+  }
+  vector<AddressAndModule>::const_iterator found =
+      std::lower_bound(modules_by_address_.begin(),
+                       modules_by_address_.end(),
+                       AddressAndModule(base_address, NULL));
+  if (found == modules_by_address_.end() || found->first != base_address)
+    return NULL;
+  return found->second;
+}
+
+bool ProcessStateReader::Read(const char *data, size_t size) {
+  modules_used_ = 0;
+  modules_by_address_.clear();
+  modules_sorted_ = true;
+  handler_->BeginProcessState();
+  ProcessSummary summary;
+  Cursor cursor(data, size);
+  int thread_index = 0;
+  bool ok = true;
+  while (ok && !cursor.AtEnd()) {
+    int field, wire_type;
+    if (!cursor.ReadTag(&field, &wire_type)) {
+      ok = false;
+      break;
+    }
+
+    u_int64_t value = 0;
+    Cursor nested(NULL, 0);
+    const CodeModule *module = NULL;
+    switch (field) {
+      case PROCESS_TIME_DATE_STAMP:
+        ok = cursor.ReadInteger(wire_type, &value);
+        summary.time_date_stamp = static_cast<u_int32_t>(value);
+        break;
+      case PROCESS_CRASH:
+        ok = cursor.ReadNested(wire_type, &nested);
+        summary.crashed = true;
+        while (ok && !nested.AtEnd()) {
+          ok = nested.ReadTag(&field, &wire_type);
+          if (!ok)
+            break;
+          if (field == CRASH_REASON)
+            ok = nested.ReadString(wire_type, &summary.crash_reason);
+          else if (field == CRASH_ADDRESS)
+            ok = nested.ReadInteger(wire_type, &summary.crash_address);
+          else
+            ok = nested.Skip(wire_type);
+        }
+        break;
+      case PROCESS_ASSERTION:
+        ok = cursor.ReadString(wire_type, &summary.assertion);
+        break;
+      case PROCESS_REQUESTING_THREAD:
+        ok = cursor.ReadInteger(wire_type, &value);
+        summary.requesting_thread = static_cast<int>(value);
+        break;
+      case PROCESS_THREADS:
+        ok = cursor.ReadNested(wire_type, &nested) &&
+             ReadThread(&nested, thread_index++);
+        break;
+      case PROCESS_MODULES:
+        ok = cursor.ReadNested(wire_type, &nested) &&
+             ReadModule(&nested, false, &module);
+        if (ok)
+          handler_->Module(*module);
+        break;
+      case PROCESS_OS:
+        ok = cursor.ReadString(wire_type, &summary.system_info.os);
+        break;
+      case PROCESS_OS_SHORT:
+        ok = cursor.ReadString(wire_type, &summary.system_info.os_short);
+        break;
+      case PROCESS_OS_VERSION:
+        ok = cursor.ReadString(wire_type, &summary.system_info.os_version);
+        break;
+      case PROCESS_CPU:
+        ok = cursor.ReadString(wire_type, &summary.system_info.cpu);
+        break;
+      case PROCESS_CPU_INFO:
+        ok = cursor.ReadString(wire_type, &summary.system_info.cpu_info);
+        break;
+      case PROCESS_CPU_COUNT:
+        ok = cursor.ReadInteger(wire_type, &value);
+        summary.system_info.cpu_count = static_cast<int>(value);
+        break;
+      default:
+        ok = cursor.Skip(wire_type);
+        break;
+    }
+  }
+
+  if (ok)
+    handler_->EndProcessState(summary);
+  return ok;
+}
+
+bool ProcessStateReader::ReadThread(Cursor *cursor, int thread_index) {
+  handler_->BeginThread(thread_index);
+  int frame_index = 0;
+  while (!cursor->AtEnd()) {
+    int field, wire_type;
+    if (!cursor->ReadTag(&field, &wire_type))
+      return false;
+    if (field != THREAD_FRAMES) {
+      if (!cursor->Skip(wire_type))
+        return false;
+      continue;
+    }
+
+    Cursor nested(NULL, 0);
+    if (!cursor->ReadNested(wire_type, &nested) || !ReadFrame(&nested, &frame_))
+      return false;
+    handler_->Frame(thread_index, frame_index++, frame_);
+  }
+  handler_->EndThread(thread_index);
+  return true;
+}
+
+bool ProcessStateReader::ReadFrame(Cursor *cursor, StackFrame *frame) {
+  frame->instruction = 0;
+  frame->module = NULL;
+  frame->function_name.clear();
+  frame->function_base = 0;
+  frame->source_file_name.clear();
+  frame->source_line = 0;
+  frame->source_line_base = 0;
+  frame->trust = StackFrame::FRAME_TRUST_NONE;
+  while (!cursor->AtEnd()) {
+    int field, wire_type;
+    if (!cursor->ReadTag(&field, &wire_type))
+      return false;
+
+    u_int64_t value = 0;
+    Cursor nested(NULL, 0);
+    bool ok;
+    switch (field) {
+      case FRAME_INSTRUCTION:
+        ok = cursor->ReadInteger(wire_type, &frame->instruction);
+        break;
+      case FRAME_MODULE:
+        ok = cursor->ReadNested(wire_type, &nested) &&
+             ReadModule(&nested, true, &frame->module);
+        break;
+      case FRAME_FUNCTION_NAME:
+        ok = cursor->ReadString(wire_type, &frame->function_name);
+        break;
+      case FRAME_FUNCTION_BASE:
+        ok = cursor->ReadInteger(wire_type, &frame->function_base);
+        break;
+      case FRAME_SOURCE_FILE_NAME:
+        ok = cursor->ReadString(wire_type, &frame->source_file_name);
+        break;
+      case FRAME_SOURCE_LINE:
+        ok = cursor->ReadInteger(wire_type, &value);
+        frame->source_line = static_cast<int>(value);
+        break;
+      case FRAME_SOURCE_LINE_BASE:
+        ok = cursor->ReadInteger(wire_type, &frame->source_line_base);
+        break;
+      default:
+        ok = cursor->Skip(wire_type);
+        break;
+    }
+    if (!ok)
+      return false;
+  }
+  return true;
+}
+
+bool ProcessStateReader::ReadModule(Cursor *cursor, bool in_frame,
+                                    const CodeModule **module) {
+  if (modules_used_ == module_pool_.size())
+    module_pool_.push_back(new DecodedModule());
+  DecodedModule *decoded = module_pool_[modules_used_];
+  decoded->Clear();
+
+  bool only_base_address = true;
+  while (!cursor->AtEnd()) {
+    int field, wire_type;
+    if (!cursor->ReadTag(&field, &wire_type))
+      return false;
+    if (field != MODULE_BASE_ADDRESS)
+      only_base_address = false;
+
+    bool ok;
+    switch (field) {
+      case MODULE_BASE_ADDRESS:
+        ok = cursor->ReadInteger(wire_type, &decoded->base_address_);
+        break;
+      case MODULE_SIZE:
+        ok = cursor->ReadInteger(wire_type, &decoded->size_);
+        break;
+      case MODULE_CODE_FILE:
+        ok = cursor->ReadString(wire_type, &decoded->code_file_);
+        break;
+      case MODULE_CODE_IDENTIFIER:
+        ok = cursor->ReadString(wire_type, &decoded->code_identifier_);
+        break;
+      case MODULE_DEBUG_FILE:
+        ok = cursor->ReadString(wire_type, &decoded->debug_file_);
+        break;
+      case MODULE_DEBUG_IDENTIFIER:
+        ok = cursor->ReadString(wire_type, &decoded->debug_identifier_);
+        break;
+      case MODULE_VERSION:
+        ok = cursor->ReadString(wire_type, &decoded->version_);
+        break;
+      default:
+        ok = cursor->Skip(wire_type);
+        break;
+    }
+    if (!ok)
+      return false;
+  }
+
+  if (in_frame && only_base_address) {
+    const CodeModule *known = FindModule(decoded->base_address_);
+    if (known) {
+      *module = known;
+      return true;
+    }
+  }
+
+  ++modules_used_;
+  if (!in_frame) {
+    modules_by_address_.push_back(
+        AddressAndModule(decoded->base_address_, decoded));
+    modules_sorted_ = false;
+  }
+  *module = decoded;
+  return true;
+}
+
+const size_t ProcessStateReader::kMaxMessageSize;
+
+bool ProcessStateReader::ReadDelimited(std::istream &stream,
+                                       bool *end_of_stream) {
+  *end_of_stream = false;
+  u_int64_t length = 0;
+  for (int shift = 0; ; shift += 7) {
+    std::istream::int_type byte = stream.get();
+    if (byte == std::istream::traits_type::eof()) {
+      // Running out before the first byte is the end of the stream;
+      // anywhere else, the message is truncated.
+      *end_of_stream = shift == 0;
+      return false;
+    }
+    if (shift >= 64)
+      return false;
+    length |= static_cast<u_int64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      break;
+  }
+
+  if (length > kMaxMessageSize)
+    return false;
+  buffer_.resize(length);
+  if (length && !stream.read(&buffer_[0], length))
+    return false;
+  return Read(buffer_.data(), buffer_.size());
+}
+
+}  // namespace google_breakpad
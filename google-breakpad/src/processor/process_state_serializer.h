@@ -0,0 +1,190 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_state_serializer.h: Encodes a ProcessState as a ProcessStateProto,
+// the message defined in processor/proto/process_state.proto, and reads
+// such messages back.
+//
+// ProcessStateSerializer produces the protocol buffer wire format directly,
+// so neither it nor ProcessStateReader needs the protocol buffer library;
+// any protocol buffer implementation can parse the output with the
+// generated ProcessStateProto class.  To keep the output compact, the
+// CodeModule of each StackFrame carries only its base_address, which
+// identifies one of the ProcessStateProto's modules, and top-level fields
+// are written with the modules before the threads, so a reader can resolve
+// frames' modules as it goes.
+//
+// A stream of ProcessStates is written as a sequence of messages, each
+// preceded by its length as a varint, the framing protocol buffer
+// libraries use for delimited messages.
+
+#ifndef PROCESSOR_PROCESS_STATE_SERIALIZER_H__
+#define PROCESSOR_PROCESS_STATE_SERIALIZER_H__
+
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google_breakpad/common/breakpad_types.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/system_info.h"
+
+namespace google_breakpad {
+
+using std::pair;
+using std::string;
+using std::vector;
+
+class CodeModule;
+class ProcessState;
+
+class ProcessStateSerializer {
+ public:
+  // Appends the encoding of |process_state| as a ProcessStateProto to
+  // |output|.
+  static void Serialize(const ProcessState &process_state, string *output);
+
+  // Appends the length of the encoding of |process_state| as a varint,
+  // followed by the encoding itself, to |output|.
+  static void SerializeDelimited(const ProcessState &process_state,
+                                 string *output);
+};
+
+// The fields of a ProcessStateProto that describe the whole process.
+struct ProcessSummary {
+  ProcessSummary() { Clear(); }
+  void Clear();
+
+  u_int32_t time_date_stamp;
+  bool crashed;
+  string crash_reason;
+  u_int64_t crash_address;
+  string assertion;
+  int requesting_thread;  // -1 if not known
+  SystemInfo system_info;
+};
+
+// ProcessStateReader reports the contents of each ProcessStateProto it
+// reads to a ProcessStateHandler as it decodes them, so a consumer never
+// needs to hold more than the parts it keeps.
+class ProcessStateHandler {
+ public:
+  virtual ~ProcessStateHandler() {}
+
+  // Called when the reader starts decoding a message.
+  virtual void BeginProcessState() {}
+
+  // Called for each of the process's modules.
+  virtual void Module(const CodeModule &module) {}
+
+  // Called for each thread in turn, with the frames of the thread's stack
+  // from innermost to outermost between the calls to BeginThread and
+  // EndThread.  |frame|'s module, if any, is one that has already been
+  // passed to Module, or if the message didn't list the frame's module
+  // before its threads, one built from the frame's own CodeModule.
+  // Modules remain valid until EndProcessState returns; a handler that
+  // needs one for longer should keep a CodeModule::Copy of it.
+  virtual void BeginThread(int thread_index) {}
+  virtual void Frame(int thread_index, int frame_index,
+                     const StackFrame &frame) {}
+  virtual void EndThread(int thread_index) {}
+
+  // Called once the whole message has been read, with the process-wide
+  // fields, which may appear anywhere in the message.
+  virtual void EndProcessState(const ProcessSummary &summary) {}
+};
+
+class ProcessStateReader {
+ public:
+  explicit ProcessStateReader(ProcessStateHandler *handler)
+      : handler_(handler),
+        module_pool_(),
+        modules_used_(0),
+        modules_by_address_(),
+        modules_sorted_(true),
+        frame_() {}
+  ~ProcessStateReader();
+
+  // Decodes the ProcessStateProto in the |size| bytes at |data|, passing its
+  // contents to the handler.  Returns false if the data is malformed, in
+  // which case the handler may have seen only part of the message.
+  bool Read(const char *data, size_t size);
+
+  // Reads one length-delimited ProcessStateProto from |stream| and decodes
+  // it.  Returns false if no message could be read, setting
+  // |*end_of_stream| to true if that is because |stream| ended cleanly
+  // before the next message, and to false if the stream ended in the middle
+  // of a message or the message was malformed.
+  // A message whose length prefix exceeds kMaxMessageSize is treated as
+  // malformed rather than allocated.
+  bool ReadDelimited(std::istream &stream, bool *end_of_stream);
+
+  // The largest message ReadDelimited accepts.
+  static const size_t kMaxMessageSize = 64 << 20;
+
+ private:
+  class Cursor;
+  class DecodedModule;
+  typedef pair<u_int64_t, const CodeModule*> AddressAndModule;
+
+  bool ReadThread(Cursor *cursor, int thread_index);
+  bool ReadFrame(Cursor *cursor, StackFrame *frame);
+
+  // Decodes a CodeModule message and sets |*module| to the module it
+  // describes.  If |in_frame| is true and the message carries only a base
+  // address, |*module| is the module already read at that address.
+  bool ReadModule(Cursor *cursor, bool in_frame, const CodeModule **module);
+
+  // Returns the listed module at |base_address|, or NULL if there is none.
+  const CodeModule *FindModule(u_int64_t base_address);
+
+  ProcessStateHandler *handler_;
+
+  // The modules decoded from the message being read are the first
+  // modules_used_ in module_pool_.  The pool is kept from one message to
+  // the next, so steady-state decoding reuses the modules' storage.
+  vector<DecodedModule*> module_pool_;
+  size_t modules_used_;
+
+  // The modules listed in the message's modules field, by base address.
+  // They are only sorted once a frame needs to look one up.
+  vector<AddressAndModule> modules_by_address_;
+  bool modules_sorted_;
+
+  // The frame being decoded, reused for each frame likewise.
+  StackFrame frame_;
+
+  // Storage for ReadDelimited's messages.
+  string buffer_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_PROCESS_STATE_SERIALIZER_H__
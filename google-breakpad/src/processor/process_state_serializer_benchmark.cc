@@ -0,0 +1,356 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_state_serializer_benchmark.cc: Compares the size of a processed
+// minidump, and the time to encode and decode it, as minidump_stackwalk's
+// pipe-delimited machine-readable text and as a binary ProcessStateProto.
+//
+// The benchmark processes a minidump once, with symbols, and then encodes
+// the resulting ProcessState repeatedly in each format.  The text encoder
+// produces the same lines as minidump_stackwalk -m.  Each decoder splits
+// its input into the fields an ingestion pipeline would store, copying
+// strings and converting numbers, so the two decoders do comparable work.
+//
+// Usage: process_state_serializer_benchmark [iterations [minidump-file
+//                                           [symbol-path]]]
+// The minidump and symbols default to those in src/processor/testdata.
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <string>
+#include <vector>
+
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/pathname_stripper.h"
+#include "processor/process_state_serializer.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace {
+
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CallStack;
+using google_breakpad::CodeModule;
+using google_breakpad::CodeModules;
+using google_breakpad::MinidumpProcessor;
+using google_breakpad::PathnameStripper;
+using google_breakpad::ProcessState;
+using google_breakpad::ProcessStateHandler;
+using google_breakpad::ProcessStateReader;
+using google_breakpad::ProcessStateSerializer;
+using google_breakpad::ProcessSummary;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::StackFrame;
+using std::string;
+using std::vector;
+
+const int kDefaultIterations = 20000;
+
+double Now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+// The decoded form of a frame, as an ingestion pipeline might store it.
+struct DecodedFrame {
+  int thread;
+  int frame;
+  string module;
+  string function;
+  string source_file;
+  int source_line;
+  u_int64_t offset;
+};
+
+struct DecodedProcess {
+  vector<string> header_fields;
+  vector<string> modules;
+  vector<DecodedFrame> frames;
+
+  void Clear() {
+    header_fields.clear();
+    modules.clear();
+    frames.clear();
+  }
+};
+
+// Appends printf-style output to |output|.
+void Appendf(string *output, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+void Appendf(string *output, const char *format, ...) {
+  char buffer[1024];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (length > 0)
+    output->append(buffer, length < static_cast<int>(sizeof(buffer)) ?
+                   length : sizeof(buffer) - 1);
+}
+
+string StripSeparator(const string &original) {
+  string result;
+  for (size_t i = 0; i < original.size(); ++i) {
+    if (original[i] != '|' && original[i] != '\n')
+      result.push_back(original[i]);
+  }
+  return result;
+}
+
+// Formats |process_state| as minidump_stackwalk -m does.
+void FormatPipe(const ProcessState &process_state, string *output) {
+  const google_breakpad::SystemInfo *info = process_state.system_info();
+  Appendf(output, "OS|%s|%s\n", StripSeparator(info->os).c_str(),
+          StripSeparator(info->os_version).c_str());
+  Appendf(output, "CPU|%s|%s|%d\n", StripSeparator(info->cpu).c_str(),
+          StripSeparator(info->cpu_info).c_str(), info->cpu_count);
+  int requesting_thread = process_state.requesting_thread();
+  if (process_state.crashed()) {
+    Appendf(output, "Crash|%s|0x%" PRIx64 "|",
+            StripSeparator(process_state.crash_reason()).c_str(),
+            process_state.crash_address());
+  } else {
+    Appendf(output, "Crash|No crash||");
+  }
+  if (requesting_thread != -1)
+    Appendf(output, "%d", requesting_thread);
+  output->push_back('\n');
+
+  const CodeModules *modules = process_state.modules();
+  if (modules) {
+    const CodeModule *main_module = modules->GetMainModule();
+    for (unsigned int i = 0; i < modules->module_count(); ++i) {
+      const CodeModule *module = modules->GetModuleAtSequence(i);
+      u_int64_t base_address = module->base_address();
+      Appendf(output, "Module|%s|%s|%s|%s|0x%08" PRIx64 "|0x%08" PRIx64
+              "|%d\n",
+              StripSeparator(PathnameStripper::File(
+                  module->code_file())).c_str(),
+              StripSeparator(module->version()).c_str(),
+              StripSeparator(PathnameStripper::File(
+                  module->debug_file())).c_str(),
+              StripSeparator(module->debug_identifier()).c_str(),
+              base_address, base_address + module->size() - 1,
+              main_module && main_module->base_address() == base_address);
+    }
+  }
+  output->push_back('\n');
+
+  const vector<CallStack*> *threads = process_state.threads();
+  for (size_t i = 0; i < threads->size(); ++i) {
+    const vector<StackFrame*> *frames = (*threads)[i]->frames();
+    for (size_t j = 0; j < frames->size(); ++j) {
+      const StackFrame *frame = (*frames)[j];
+      Appendf(output, "%d|%d|", static_cast<int>(i), static_cast<int>(j));
+      if (!frame->module) {
+        Appendf(output, "||||0x%" PRIx64 "\n", frame->instruction);
+        continue;
+      }
+      output->append(StripSeparator(
+          PathnameStripper::File(frame->module->code_file())));
+      if (frame->function_name.empty()) {
+        Appendf(output, "||||0x%" PRIx64 "\n",
+                frame->instruction - frame->module->base_address());
+      } else if (frame->source_file_name.empty()) {
+        Appendf(output, "|%s|||0x%" PRIx64 "\n",
+                StripSeparator(frame->function_name).c_str(),
+                frame->instruction - frame->function_base);
+      } else {
+        Appendf(output, "|%s|%s|%d|0x%" PRIx64 "\n",
+                StripSeparator(frame->function_name).c_str(),
+                StripSeparator(frame->source_file_name).c_str(),
+                frame->source_line,
+                frame->instruction - frame->source_line_base);
+      }
+    }
+  }
+}
+
+// Splits pipe-delimited text into |decoded|.
+void ParsePipe(const string &text, DecodedProcess *decoded) {
+  decoded->Clear();
+  bool in_threads = false;
+  vector<string> fields;
+  size_t line_start = 0;
+  while (line_start < text.size()) {
+    size_t line_end = text.find('\n', line_start);
+    if (line_end == string::npos)
+      line_end = text.size();
+    fields.clear();
+    size_t field_start = line_start;
+    for (size_t i = line_start; i <= line_end; ++i) {
+      if (i == line_end || text[i] == '|') {
+        fields.push_back(text.substr(field_start, i - field_start));
+        field_start = i + 1;
+      }
+    }
+    line_start = line_end + 1;
+
+    if (fields.size() == 1 && fields[0].empty()) {
+      in_threads = true;
+    } else if (in_threads && fields.size() == 7) {
+      DecodedFrame frame;
+      frame.thread = atoi(fields[0].c_str());
+      frame.frame = atoi(fields[1].c_str());
+      frame.module = fields[2];
+      frame.function = fields[3];
+      frame.source_file = fields[4];
+      frame.source_line = atoi(fields[5].c_str());
+      frame.offset = strtoull(fields[6].c_str(), NULL, 16);
+      decoded->frames.push_back(frame);
+    } else if (fields[0] == "Module") {
+      decoded->modules.push_back(fields[1]);
+    } else {
+      decoded->header_fields.insert(decoded->header_fields.end(),
+                                    fields.begin() + 1, fields.end());
+    }
+  }
+}
+
+// Stores what ProcessStateReader reports in a DecodedProcess.
+class DecodingHandler : public ProcessStateHandler {
+ public:
+  explicit DecodingHandler(DecodedProcess *decoded) : decoded_(decoded) {}
+
+  virtual void BeginProcessState() { decoded_->Clear(); }
+  virtual void Module(const CodeModule &module) {
+    decoded_->modules.push_back(module.code_file());
+  }
+  virtual void Frame(int thread_index, int frame_index,
+                     const StackFrame &frame) {
+    DecodedFrame decoded;
+    decoded.thread = thread_index;
+    decoded.frame = frame_index;
+    if (frame.module)
+      decoded.module = frame.module->code_file();
+    decoded.function = frame.function_name;
+    decoded.source_file = frame.source_file_name;
+    decoded.source_line = frame.source_line;
+    decoded.offset = frame.instruction;
+    decoded_->frames.push_back(decoded);
+  }
+  virtual void EndProcessState(const ProcessSummary &summary) {
+    decoded_->header_fields.push_back(summary.system_info.os);
+    decoded_->header_fields.push_back(summary.system_info.os_version);
+    decoded_->header_fields.push_back(summary.system_info.cpu);
+    decoded_->header_fields.push_back(summary.system_info.cpu_info);
+    decoded_->header_fields.push_back(summary.crash_reason);
+  }
+
+ private:
+  DecodedProcess *decoded_;
+};
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : kDefaultIterations;
+  string srcdir = getenv("srcdir") ? getenv("srcdir") : ".";
+  string minidump_file = argc > 2 ? argv[2] :
+      srcdir + "/src/processor/testdata/minidump2.dmp";
+  string symbol_path = argc > 3 ? argv[3] :
+      srcdir + "/src/processor/testdata/symbols";
+  if (iterations <= 0) {
+    fprintf(stderr, "usage: %s [iterations [minidump-file [symbol-path]]]\n",
+            argv[0]);
+    return 1;
+  }
+
+  SimpleSymbolSupplier supplier(symbol_path);
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  ProcessState state;
+  if (processor.Process(minidump_file, &state) !=
+      google_breakpad::PROCESS_OK) {
+    fprintf(stderr, "could not process %s\n", minidump_file.c_str());
+    return 1;
+  }
+
+  string pipe, proto;
+  DecodedProcess decoded;
+  double start = Now();
+  for (int i = 0; i < iterations; ++i) {
+    pipe.clear();
+    FormatPipe(state, &pipe);
+  }
+  double pipe_encode = Now() - start;
+  start = Now();
+  for (int i = 0; i < iterations; ++i)
+    ParsePipe(pipe, &decoded);
+  double pipe_decode = Now() - start;
+  size_t pipe_frames = decoded.frames.size();
+
+  start = Now();
+  for (int i = 0; i < iterations; ++i) {
+    proto.clear();
+    ProcessStateSerializer::Serialize(state, &proto);
+  }
+  double proto_encode = Now() - start;
+  DecodingHandler handler(&decoded);
+  ProcessStateReader reader(&handler);
+  start = Now();
+  for (int i = 0; i < iterations; ++i) {
+    if (!reader.Read(proto.data(), proto.size())) {
+      fprintf(stderr, "could not decode the ProcessStateProto\n");
+      return 1;
+    }
+  }
+  double proto_decode = Now() - start;
+  if (decoded.frames.size() != pipe_frames) {
+    fprintf(stderr, "decoded %lu frames from text but %lu from proto\n",
+            static_cast<unsigned long>(pipe_frames),
+            static_cast<unsigned long>(decoded.frames.size()));
+    return 1;
+  }
+
+  printf("%lu threads, %lu frames, %d iterations\n",
+         static_cast<unsigned long>(state.threads()->size()),
+         static_cast<unsigned long>(pipe_frames), iterations);
+  printf("%-6s %8s %14s %14s\n", "format", "bytes", "encode (us)",
+         "decode (us)");
+  printf("%-6s %8lu %14.3f %14.3f\n", "pipe",
+         static_cast<unsigned long>(pipe.size()),
+         pipe_encode * 1e6 / iterations, pipe_decode * 1e6 / iterations);
+  printf("%-6s %8lu %14.3f %14.3f\n", "proto",
+         static_cast<unsigned long>(proto.size()),
+         proto_encode * 1e6 / iterations, proto_decode * 1e6 / iterations);
+  return 0;
+}
@@ -0,0 +1,266 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_state_serializer_unittest.cc: Unit tests for
+// ProcessStateSerializer and ProcessStateReader.
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/process_state_serializer.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace {
+
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CallStack;
+using google_breakpad::CodeModule;
+using google_breakpad::CodeModules;
+using google_breakpad::MinidumpProcessor;
+using google_breakpad::ProcessState;
+using google_breakpad::ProcessStateHandler;
+using google_breakpad::ProcessStateReader;
+using google_breakpad::ProcessStateSerializer;
+using google_breakpad::ProcessSummary;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::StackFrame;
+using std::string;
+using std::vector;
+
+// Records everything a ProcessStateReader reports.
+class RecordingHandler : public ProcessStateHandler {
+ public:
+  struct RecordedFrame {
+    u_int64_t instruction;
+    string module_code_file;
+    string function_name;
+    u_int64_t function_base;
+    string source_file_name;
+    int source_line;
+    u_int64_t source_line_base;
+  };
+
+  RecordingHandler() : process_states(0) {}
+
+  virtual void BeginProcessState() {
+    modules.clear();
+    threads.clear();
+  }
+  virtual void Module(const CodeModule &module) {
+    modules.push_back(module.code_file());
+  }
+  virtual void BeginThread(int thread_index) {
+    EXPECT_EQ(threads.size(), static_cast<size_t>(thread_index));
+    threads.push_back(vector<RecordedFrame>());
+  }
+  virtual void Frame(int thread_index, int frame_index,
+                     const StackFrame &frame) {
+    ASSERT_EQ(threads.size(), static_cast<size_t>(thread_index + 1));
+    EXPECT_EQ(threads.back().size(), static_cast<size_t>(frame_index));
+    RecordingHandler::RecordedFrame recorded;
+    recorded.instruction = frame.instruction;
+    recorded.module_code_file = frame.module ? frame.module->code_file() : "";
+    recorded.function_name = frame.function_name;
+    recorded.function_base = frame.function_base;
+    recorded.source_file_name = frame.source_file_name;
+    recorded.source_line = frame.source_line;
+    recorded.source_line_base = frame.source_line_base;
+    threads.back().push_back(recorded);
+  }
+  virtual void EndProcessState(const ProcessSummary &summary) {
+    this->summary = summary;
+    ++process_states;
+  }
+
+  vector<string> modules;
+  vector<vector<RecordedFrame> > threads;
+  ProcessSummary summary;
+  int process_states;
+};
+
+class ProcessStateSerializerTest : public ::testing::Test {
+ public:
+  ProcessStateSerializerTest()
+      : supplier_(string(getenv("srcdir") ? getenv("srcdir") : ".") +
+                  "/src/processor/testdata/symbols/"),
+        processor_(&supplier_, &resolver_) {}
+
+  void ProcessMinidump(ProcessState *state) {
+    string minidump_file = string(getenv("srcdir") ? getenv("srcdir") : ".") +
+                           "/src/processor/testdata/minidump2.dmp";
+    ASSERT_EQ(google_breakpad::PROCESS_OK,
+              processor_.Process(minidump_file, state));
+  }
+
+  SimpleSymbolSupplier supplier_;
+  BasicSourceLineResolver resolver_;
+  MinidumpProcessor processor_;
+};
+
+TEST_F(ProcessStateSerializerTest, EmptyProcessState) {
+  ProcessState state;
+  string encoded;
+  ProcessStateSerializer::Serialize(state, &encoded);
+  // time_date_stamp = 0, cpu_count = 0.
+  EXPECT_EQ(string("\x08\x00\x60\x00", 4), encoded);
+
+  RecordingHandler handler;
+  ProcessStateReader reader(&handler);
+  ASSERT_TRUE(reader.Read(encoded.data(), encoded.size()));
+  EXPECT_EQ(1, handler.process_states);
+  EXPECT_FALSE(handler.summary.crashed);
+  EXPECT_EQ(-1, handler.summary.requesting_thread);
+  EXPECT_TRUE(handler.threads.empty());
+}
+
+TEST_F(ProcessStateSerializerTest, RoundTrip) {
+  ProcessState state;
+  ProcessMinidump(&state);
+  string encoded;
+  ProcessStateSerializer::Serialize(state, &encoded);
+
+  RecordingHandler handler;
+  ProcessStateReader reader(&handler);
+  ASSERT_TRUE(reader.Read(encoded.data(), encoded.size()));
+  ASSERT_EQ(1, handler.process_states);
+
+  const ProcessSummary &summary = handler.summary;
+  EXPECT_EQ(state.time_date_stamp(), summary.time_date_stamp);
+  EXPECT_EQ(state.crashed(), summary.crashed);
+  EXPECT_EQ(state.crash_reason(), summary.crash_reason);
+  EXPECT_EQ(state.crash_address(), summary.crash_address);
+  EXPECT_EQ(state.requesting_thread(), summary.requesting_thread);
+  EXPECT_EQ(state.system_info()->os, summary.system_info.os);
+  EXPECT_EQ(state.system_info()->os_short, summary.system_info.os_short);
+  EXPECT_EQ(state.system_info()->os_version, summary.system_info.os_version);
+  EXPECT_EQ(state.system_info()->cpu, summary.system_info.cpu);
+  EXPECT_EQ(state.system_info()->cpu_info, summary.system_info.cpu_info);
+  EXPECT_EQ(state.system_info()->cpu_count, summary.system_info.cpu_count);
+
+  const CodeModules *modules = state.modules();
+  ASSERT_EQ(modules->module_count(), handler.modules.size());
+  for (unsigned int i = 0; i < modules->module_count(); ++i)
+    EXPECT_EQ(modules->GetModuleAtSequence(i)->code_file(),
+              handler.modules[i]);
+
+  ASSERT_EQ(state.threads()->size(), handler.threads.size());
+  for (size_t i = 0; i < handler.threads.size(); ++i) {
+    const vector<StackFrame*> *frames = state.threads()->at(i)->frames();
+    ASSERT_EQ(frames->size(), handler.threads[i].size());
+    for (size_t j = 0; j < frames->size(); ++j) {
+      const StackFrame *frame = frames->at(j);
+      const RecordingHandler::RecordedFrame &read = handler.threads[i][j];
+      EXPECT_EQ(frame->instruction, read.instruction);
+      EXPECT_EQ(frame->module ? frame->module->code_file() : "",
+                read.module_code_file);
+      EXPECT_EQ(frame->function_name, read.function_name);
+      EXPECT_EQ(frame->function_base, read.function_base);
+      EXPECT_EQ(frame->source_file_name, read.source_file_name);
+      EXPECT_EQ(frame->source_line, read.source_line);
+      EXPECT_EQ(frame->source_line_base, read.source_line_base);
+    }
+  }
+
+  // The symbols were found, so the crashing frame has a function name.
+  ASSERT_FALSE(handler.threads[0].empty());
+  EXPECT_EQ("`anonymous namespace'::CrashFunction",
+            handler.threads[0][0].function_name);
+}
+
+TEST_F(ProcessStateSerializerTest, DelimitedStream) {
+  ProcessState state;
+  ProcessMinidump(&state);
+  string encoded;
+  ProcessStateSerializer::SerializeDelimited(state, &encoded);
+  ProcessStateSerializer::SerializeDelimited(state, &encoded);
+
+  RecordingHandler handler;
+  ProcessStateReader reader(&handler);
+  std::istringstream stream(encoded);
+  bool end_of_stream;
+  EXPECT_TRUE(reader.ReadDelimited(stream, &end_of_stream));
+  EXPECT_TRUE(reader.ReadDelimited(stream, &end_of_stream));
+  EXPECT_FALSE(reader.ReadDelimited(stream, &end_of_stream));
+  EXPECT_TRUE(end_of_stream);
+  EXPECT_EQ(2, handler.process_states);
+
+  // A truncated message is an error, not the end of the stream.
+  std::istringstream truncated(encoded.substr(0, encoded.size() - 1));
+  EXPECT_TRUE(reader.ReadDelimited(truncated, &end_of_stream));
+  EXPECT_FALSE(reader.ReadDelimited(truncated, &end_of_stream));
+  EXPECT_FALSE(end_of_stream);
+
+  // A length prefix larger than any message the reader accepts.
+  string oversized;
+  u_int64_t length = ProcessStateReader::kMaxMessageSize + 1;
+  while (length >= 0x80) {
+    oversized += static_cast<char>((length & 0x7f) | 0x80);
+    length >>= 7;
+  }
+  oversized += static_cast<char>(length);
+  std::istringstream oversized_stream(oversized);
+  EXPECT_FALSE(reader.ReadDelimited(oversized_stream, &end_of_stream));
+  EXPECT_FALSE(end_of_stream);
+}
+
+TEST_F(ProcessStateSerializerTest, SkipsUnknownFieldsAndRejectsMalformed) {
+  // time_date_stamp = 5, an unknown fixed32 field 13, an unknown
+  // length-delimited field 14, and os = "Linux".
+  string encoded("\x08\x05\x6d\x01\x02\x03\x04\x72\x02xy\x3a\x05Linux", 18);
+  RecordingHandler handler;
+  ProcessStateReader reader(&handler);
+  ASSERT_TRUE(reader.Read(encoded.data(), encoded.size()));
+  EXPECT_EQ(5U, handler.summary.time_date_stamp);
+  EXPECT_EQ("Linux", handler.summary.system_info.os);
+
+  // A string that runs past the end of the message.
+  string overrun("\x3a\x09Linux", 7);
+  EXPECT_FALSE(reader.Read(overrun.data(), overrun.size()));
+
+  // A string field with an integer's wire type.
+  string mistyped("\x38\x05", 2);
+  EXPECT_FALSE(reader.Read(mistyped.data(), mistyped.size()));
+  EXPECT_EQ(1, handler.process_states);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
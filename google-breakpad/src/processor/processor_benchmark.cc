@@ -0,0 +1,823 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// processor_benchmark.cc: Measures the processor's throughput on
+// generated minidumps and symbol files.
+//
+// Each workload is a minidump built with synth_minidump: a list of x86
+// modules, and threads whose stacks are chains of calls between
+// pseudo-randomly chosen functions in those modules, plus a text symbol
+// file for every module.  The parameters set the number of threads, the
+// depth of their stacks, the number of modules, the size of each
+// module's symbol file (functions per module and line records per
+// function), and how frames are to be unwound:
+//
+//   cfi   Every function has a STACK CFI record, so each caller is
+//         recovered from CFI.
+//   scan  There are no stack records, and %ebp is useless, so each
+//         caller is found by scanning past a few words of locals for
+//         the return address.
+//
+// For each unwinding style and each of BasicSourceLineResolver and
+// FastSourceLineResolver, the benchmark measures:
+//
+//   symbol_serialize  converting text symbols to FastSourceLineResolver's
+//                     serialized form, per module (fast only)
+//   symbol_load       loading every module's symbols, per module
+//   lookup_line       FillSourceLineInfo at random code addresses
+//   lookup_cfi        FindCFIFrameInfo at random code addresses (cfi only)
+//   process_cold      MinidumpProcessor::Process with a fresh resolver,
+//                     so that symbols are loaded as they are needed
+//   process           MinidumpProcessor::Process with the symbols loaded
+//   process_frames    the frames walked during the "process" runs
+//
+// Process runs include reading the minidump from memory.  Results are
+// printed to stdout as one JSON object per line, giving the workload's
+// parameters, the resolver, the measurement, the number of operations,
+// the elapsed seconds, and operations per second; a "workload" line first
+// gives the size of the generated minidump and symbol files.
+//
+// Usage: processor_benchmark [options]
+// Run with -h for the options and their defaults.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "google_breakpad/common/breakpad_types.h"
+#include "google_breakpad/common/minidump_format.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
+#include "google_breakpad/processor/minidump.h"
+#include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/symbol_supplier.h"
+#include "processor/basic_code_module.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/linked_ptr.h"
+#include "processor/logging.h"
+#include "processor/module_serializer.h"
+#include "processor/synth_minidump.h"
+
+namespace {
+
+using google_breakpad::BasicCodeModule;
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CFIFrameInfo;
+using google_breakpad::CodeModule;
+using google_breakpad::FastSourceLineResolver;
+using google_breakpad::LogStream;
+using google_breakpad::Minidump;
+using google_breakpad::MinidumpProcessor;
+using google_breakpad::ModuleSerializer;
+using google_breakpad::ProcessState;
+using google_breakpad::SourceLineResolverInterface;
+using google_breakpad::StackFrame;
+using google_breakpad::SymbolSupplier;
+using google_breakpad::SynthMinidump::Context;
+using google_breakpad::SynthMinidump::Dump;
+using google_breakpad::SynthMinidump::Exception;
+using google_breakpad::SynthMinidump::Memory;
+using google_breakpad::SynthMinidump::Module;
+using google_breakpad::SynthMinidump::Section;
+using google_breakpad::SynthMinidump::String;
+using google_breakpad::SynthMinidump::Thread;
+using google_breakpad::linked_ptr;
+using google_breakpad::test_assembler::kLittleEndian;
+using std::istringstream;
+using std::map;
+using std::string;
+using std::vector;
+
+// Where the generated modules and stacks are placed.  Modules start at
+// kFirstModuleBase, each on a kModuleAlignment boundary; their functions
+// start kFirstFunctionOffset bytes in, and each of a function's line
+// records covers kLineSize bytes.  Stacks start at kFirstStackBase, well
+// above every module, so that no stack address looks like code.
+const u_int64_t kFirstModuleBase = 0x10000000;
+const u_int64_t kModuleAlignment = 0x10000;
+const u_int64_t kFirstFunctionOffset = 0x1000;
+const u_int64_t kLineSize = 0x10;
+const u_int64_t kFirstStackBase = 0x80000000;
+const u_int64_t kStackAlignment = 0x10000;
+const u_int64_t kAddressLimit = 0x100000000ULL;
+
+// The x86 stack walker scans at most this many words for a return address.
+const int kMaxLocalWords = 29;
+
+struct Options {
+  Options()
+      : threads(8), depth(32), modules(50), functions(500), lines(8),
+        locals(6), iterations(20), cold_iterations(3), lookups(200000),
+        run_cfi(true), run_scan(true), run_basic(true), run_fast(true) { }
+
+  int threads;          // threads in the minidump
+  int depth;            // frames on each thread's stack
+  int modules;          // modules in the module list
+  int functions;        // functions per module
+  int lines;            // line records per function
+  int locals;           // words of locals between return addresses
+  int iterations;       // timed "process" runs
+  int cold_iterations;  // timed "process_cold" runs
+  int lookups;          // lookups per lookup measurement
+  bool run_cfi, run_scan, run_basic, run_fast;
+};
+
+double Now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+// A small linear congruential generator, so that every run generates the
+// same workload regardless of the C library's rand implementation.
+class Random {
+ public:
+  explicit Random(u_int64_t seed) : state_(seed) {}
+  u_int32_t Next() {
+    state_ = state_ * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<u_int32_t>(state_ >> 32);
+  }
+  u_int32_t Below(u_int32_t limit) { return Next() % limit; }
+
+ private:
+  u_int64_t state_;
+};
+
+// Appends printf-style output to |output|.
+void Appendf(string *output, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+void Appendf(string *output, const char *format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (length > 0)
+    output->append(buffer, length < static_cast<int>(sizeof(buffer)) ?
+                   length : sizeof(buffer) - 1);
+}
+
+// A generated minidump and the symbol files that go with it.
+class Workload {
+ public:
+  Workload(const Options &options, bool cfi)
+      : options_(options), cfi_(cfi), function_spacing_(0), module_span_(0) {}
+  ~Workload();
+
+  // Generates the symbol files and the minidump.  Returns false, after
+  // printing a message, if the options describe an impossible layout.
+  bool Generate();
+
+  const char *unwind() const { return cfi_ ? "cfi" : "scan"; }
+  const string &minidump() const { return minidump_; }
+  const vector<CodeModule *> &modules() const { return modules_; }
+  const string &symbols(int module) const { return symbols_[module]; }
+  u_int64_t symbol_bytes() const;
+
+  // Returns an address within line |line| of function |function| of
+  // module |module|, five bytes in, as a return address might be.
+  u_int64_t CodeAddress(int module, int function, int line) const {
+    return modules_[module]->base_address() + kFirstFunctionOffset +
+           function * function_spacing_ + line * kLineSize + 5;
+  }
+
+  // Returns a pseudo-random code address from |random|, and the module it
+  // is in.
+  u_int64_t RandomCodeAddress(Random *random, int *module) const {
+    *module = random->Below(options_.modules);
+    return CodeAddress(*module, random->Below(options_.functions),
+                       random->Below(options_.lines));
+  }
+
+ private:
+  void GenerateSymbols(int module);
+  void GenerateMinidump();
+
+  const Options options_;
+  bool cfi_;
+
+  // The distance between the starts of adjacent functions, and between
+  // the bases of adjacent modules.
+  u_int64_t function_spacing_;
+  u_int64_t module_span_;
+
+  vector<CodeModule *> modules_;
+  vector<string> symbols_;
+  string minidump_;
+};
+
+Workload::~Workload() {
+  for (size_t i = 0; i < modules_.size(); ++i)
+    delete modules_[i];
+}
+
+bool Workload::Generate() {
+  if (options_.threads < 1 || options_.depth < 1 || options_.modules < 1 ||
+      options_.functions < 1 || options_.lines < 1 || options_.locals < 0 ||
+      options_.locals > kMaxLocalWords) {
+    fprintf(stderr, "Workload parameters out of range\n");
+    return false;
+  }
+
+  // Leave a line's worth of padding between functions, so that frames
+  // never land between them.
+  function_spacing_ = (options_.lines + 1) * kLineSize;
+  u_int64_t module_size = kFirstFunctionOffset +
+                          options_.functions * function_spacing_;
+  module_span_ = (module_size + kModuleAlignment - 1) &
+                 ~(kModuleAlignment - 1);
+  if (kFirstModuleBase + options_.modules * module_span_ > kFirstStackBase) {
+    fprintf(stderr, "%d modules of %d functions don't fit below 0x%llx\n",
+            options_.modules, options_.functions,
+            static_cast<unsigned long long>(kFirstStackBase));
+    return false;
+  }
+  u_int64_t stack_size = options_.depth * (options_.locals + 1) * 4;
+  u_int64_t stack_span = (stack_size + kStackAlignment - 1) &
+                         ~(kStackAlignment - 1);
+  if (kFirstStackBase + options_.threads * stack_span > kAddressLimit) {
+    fprintf(stderr, "%d stacks of %d frames don't fit in 32 bits\n",
+            options_.threads, options_.depth);
+    return false;
+  }
+
+  for (int i = 0; i < options_.modules; ++i) {
+    char code_file[32], debug_file[32], debug_identifier[40];
+    snprintf(code_file, sizeof(code_file), "c:\\bench\\module%d.dll", i);
+    snprintf(debug_file, sizeof(debug_file), "module%d.pdb", i);
+    snprintf(debug_identifier, sizeof(debug_identifier),
+             "%08X000000000000000000000000001", i + 1);
+    modules_.push_back(new BasicCodeModule(
+        kFirstModuleBase + i * module_span_, module_size, code_file, "",
+        debug_file, debug_identifier, ""));
+    symbols_.push_back(string());
+    GenerateSymbols(i);
+  }
+  GenerateMinidump();
+  return true;
+}
+
+u_int64_t Workload::symbol_bytes() const {
+  u_int64_t bytes = 0;
+  for (size_t i = 0; i < symbols_.size(); ++i)
+    bytes += symbols_[i].size();
+  return bytes;
+}
+
+// Writes a symbol file like one dump_syms would write for a Windows
+// module: a FILE record for every ten functions, a FUNC record and line
+// records for every function, a PUBLIC record for every tenth function,
+// and, in cfi workloads, a STACK CFI INIT record for every function
+// saying that its frame is |locals| words and a return address.
+void Workload::GenerateSymbols(int module) {
+  string *symbols = &symbols_[module];
+  Appendf(symbols, "MODULE windows x86 %s %s\n",
+          modules_[module]->debug_identifier().c_str(),
+          modules_[module]->debug_file().c_str());
+  int files = (options_.functions + 9) / 10;
+  for (int file = 0; file < files; ++file)
+    Appendf(symbols, "FILE %d c:\\bench\\module%d\\file%d.cc\n",
+            file, module, file);
+
+  u_int64_t function_size = options_.lines * kLineSize;
+  for (int function = 0; function < options_.functions; ++function) {
+    u_int64_t address = kFirstFunctionOffset + function * function_spacing_;
+    Appendf(symbols, "FUNC %llx %llx 8 bench::Module%d::Function%d"
+            "(int, char const *)\n",
+            static_cast<unsigned long long>(address),
+            static_cast<unsigned long long>(function_size),
+            module, function);
+    for (int line = 0; line < options_.lines; ++line) {
+      Appendf(symbols, "%llx %llx %d %d\n",
+              static_cast<unsigned long long>(address + line * kLineSize),
+              static_cast<unsigned long long>(kLineSize),
+              function * options_.lines + line + 1, function / 10);
+    }
+  }
+  for (int function = 0; function < options_.functions; function += 10) {
+    Appendf(symbols, "PUBLIC %llx 8 bench::Module%d::Public%d\n",
+            static_cast<unsigned long long>(
+                kFirstFunctionOffset + function * function_spacing_),
+            module, function);
+  }
+  if (cfi_) {
+    for (int function = 0; function < options_.functions; ++function) {
+      Appendf(symbols, "STACK CFI INIT %llx %llx "
+              ".cfa: $esp %d + .ra: .cfa 4 - ^\n",
+              static_cast<unsigned long long>(
+                  kFirstFunctionOffset + function * function_spacing_),
+              static_cast<unsigned long long>(function_size),
+              (options_.locals + 1) * 4);
+    }
+  }
+}
+
+// Builds the minidump: a system info stream, the module list, and a
+// thread list whose first thread has crashed.  Each thread's stack holds,
+// for every frame, |locals| words that aren't code addresses followed by
+// the return address into the next frame's function; the outermost
+// frame's return address is zero.  The threads' %ebp is zero, so the
+// walker can't use frame pointers.
+void Workload::GenerateMinidump() {
+  Dump dump(0, kLittleEndian);
+
+  // The dump refers to its sections until it is finished.
+  vector< linked_ptr<Section> > sections;
+
+  String csd_version(dump, "Service Pack 3");
+  google_breakpad::SynthMinidump::SystemInfo system_info(
+      dump, google_breakpad::SynthMinidump::SystemInfo::windows_x86,
+      csd_version);
+  dump.Add(&system_info);
+  dump.Add(&csd_version);
+
+  // Module requires CodeView and miscellaneous debug records.  The
+  // miscellaneous record is empty.
+  MDVSFixedFileInfo version_info;
+  memset(&version_info, 0, sizeof(version_info));
+  version_info.signature = MD_VSFIXEDFILEINFO_SIGNATURE;
+  version_info.struct_version = MD_VSFIXEDFILEINFO_VERSION;
+  for (int i = 0; i < options_.modules; ++i) {
+    const CodeModule *code_module = modules_[i];
+    String *name = new String(dump, code_module->code_file());
+    sections.push_back(linked_ptr<Section>(name));
+    Section *cv_record = new Section(dump);
+    sections.push_back(linked_ptr<Section>(cv_record));
+    cv_record->D32(MD_CVINFOPDB70_SIGNATURE)
+              .D32(i + 1).D16(0).D16(0).Append(8, 0)  // signature GUID
+              .D32(1)                                  // age
+              .AppendCString(code_module->debug_file());
+    Section *misc_record = new Section(dump);
+    sections.push_back(linked_ptr<Section>(misc_record));
+    Module *module = new Module(dump, code_module->base_address(),
+                                code_module->size(), *name,
+                                1262805309, 0, version_info,
+                                cv_record, misc_record);
+    sections.push_back(linked_ptr<Section>(module));
+    dump.Add(module);
+    dump.Add(name);
+    dump.Add(cv_record);
+    dump.Add(misc_record);
+  }
+
+  Random random(1);
+  u_int64_t stack_span = (options_.depth * (options_.locals + 1) * 4 +
+                          kStackAlignment - 1) & ~(kStackAlignment - 1);
+  Context *crash_context = NULL;
+  for (int i = 0; i < options_.threads; ++i) {
+    u_int64_t stack_base = kFirstStackBase + i * stack_span;
+    Memory *stack = new Memory(dump, stack_base);
+    sections.push_back(linked_ptr<Section>(stack));
+    int module;
+    u_int64_t eip = RandomCodeAddress(&random, &module);
+    for (int frame = 0; frame < options_.depth; ++frame) {
+      for (int word = 0; word < options_.locals; ++word)
+        stack->D32(0x00100000 + random.Below(0x10000) * 4);
+      u_int64_t return_address = 0;
+      if (frame + 1 < options_.depth)
+        return_address = RandomCodeAddress(&random, &module);
+      stack->D32(return_address);
+    }
+
+    MDRawContextX86 raw_context;
+    memset(&raw_context, 0, sizeof(raw_context));
+    raw_context.context_flags = MD_CONTEXT_X86_FULL;
+    raw_context.eip = eip;
+    raw_context.esp = stack_base;
+    raw_context.ebp = 0;
+    Context *context = new Context(dump, raw_context);
+    sections.push_back(linked_ptr<Section>(context));
+    Thread *thread = new Thread(dump, 0x1000 + i, *stack, *context);
+    sections.push_back(linked_ptr<Section>(thread));
+    dump.Add(stack);
+    dump.Add(context);
+    dump.Add(thread);
+    if (!crash_context)
+      crash_context = context;
+  }
+
+  Exception exception(dump, *crash_context, 0x1000,
+                      MD_EXCEPTION_CODE_WIN_ACCESS_VIOLATION, 0, 0x45);
+  dump.Add(&exception);
+
+  dump.Finish();
+  dump.GetContents(&minidump_);
+}
+
+// Hands out a Workload's symbols: a copy of the text, which
+// BasicSourceLineResolver modifies as it parses, or the serialized form
+// that FastSourceLineResolver uses in place.
+class WorkloadSymbolSupplier : public SymbolSupplier {
+ public:
+  // If serialized is not NULL, it holds each module's serialized symbols,
+  // in the order of workload.modules(), and remains owned by the caller.
+  WorkloadSymbolSupplier(const Workload &workload,
+                         const vector<char *> *serialized)
+      : workload_(workload), serialized_(serialized) {
+    for (size_t i = 0; i < workload.modules().size(); ++i)
+      module_indices_[workload.modules()[i]->code_file()] = i;
+  }
+  virtual ~WorkloadSymbolSupplier() {
+    for (map<string, char *>::iterator it = copies_.begin();
+         it != copies_.end(); ++it) {
+      delete [] it->second;
+    }
+  }
+
+  virtual SymbolResult GetSymbolFile(const CodeModule *module,
+                                     const google_breakpad::SystemInfo *,
+                                     string *symbol_file) {
+    if (!Find(module))
+      return NOT_FOUND;
+    *symbol_file = module->code_file();
+    return FOUND;
+  }
+
+  virtual SymbolResult GetSymbolFile(const CodeModule *module,
+                                     const google_breakpad::SystemInfo *,
+                                     string *symbol_file,
+                                     string *symbol_data) {
+    int index;
+    if (!Find(module, &index))
+      return NOT_FOUND;
+    *symbol_file = module->code_file();
+    *symbol_data = workload_.symbols(index);
+    return FOUND;
+  }
+
+  virtual SymbolResult GetCStringSymbolData(
+      const CodeModule *module, const google_breakpad::SystemInfo *,
+      string *symbol_file, char **symbol_data) {
+    int index;
+    if (!Find(module, &index))
+      return NOT_FOUND;
+    *symbol_file = module->code_file();
+    if (serialized_) {
+      *symbol_data = (*serialized_)[index];
+      return FOUND;
+    }
+    const string &text = workload_.symbols(index);
+    char *copy = new char[text.size() + 1];
+    memcpy(copy, text.c_str(), text.size() + 1);
+    char *&slot = copies_[module->code_file()];
+    delete [] slot;
+    slot = copy;
+    *symbol_data = copy;
+    return FOUND;
+  }
+
+  virtual void FreeSymbolData(const CodeModule *module) {
+    map<string, char *>::iterator it = copies_.find(module->code_file());
+    if (it != copies_.end()) {
+      delete [] it->second;
+      copies_.erase(it);
+    }
+  }
+
+ private:
+  bool Find(const CodeModule *module, int *index = NULL) const {
+    map<string, int>::const_iterator it =
+        module_indices_.find(module->code_file());
+    if (it == module_indices_.end())
+      return false;
+    if (index)
+      *index = it->second;
+    return true;
+  }
+
+  const Workload &workload_;
+  const vector<char *> *serialized_;
+  map<string, int> module_indices_;
+  map<string, char *> copies_;
+};
+
+// Prints one result to stdout as a line of JSON.
+void PrintResult(const Options &options, const Workload &workload,
+                 const char *resolver, const char *measurement,
+                 u_int64_t operations, double seconds) {
+  printf("{\"unwind\": \"%s\", \"threads\": %d, \"depth\": %d, "
+         "\"modules\": %d, \"functions\": %d, \"lines\": %d, "
+         "\"locals\": %d, \"resolver\": \"%s\", \"measurement\": \"%s\", "
+         "\"operations\": %llu, \"seconds\": %.6f, "
+         "\"per_second\": %.1f}\n",
+         workload.unwind(), options.threads, options.depth,
+         options.modules, options.functions, options.lines,
+         options.locals, resolver, measurement,
+         static_cast<unsigned long long>(operations), seconds,
+         seconds > 0 ? operations / seconds : 0);
+  fflush(stdout);
+}
+
+SourceLineResolverInterface *NewResolver(bool fast) {
+  if (fast)
+    return new FastSourceLineResolver();
+  return new BasicSourceLineResolver();
+}
+
+// Processes the workload's minidump, returning the number of frames
+// walked, or -1 on failure.
+int ProcessWorkload(const Workload &workload, MinidumpProcessor *processor) {
+  istringstream stream(workload.minidump());
+  Minidump dump(stream);
+  ProcessState process_state;
+  if (!dump.Read() ||
+      processor->Process(&dump, &process_state) !=
+          google_breakpad::PROCESS_OK) {
+    return -1;
+  }
+  int frames = 0;
+  for (size_t i = 0; i < process_state.threads()->size(); ++i)
+    frames += process_state.threads()->at(i)->frames()->size();
+  return frames;
+}
+
+// Runs every measurement for one resolver on |workload|.  Returns false
+// on failure.
+bool RunResolver(const Options &options, const Workload &workload,
+                 bool fast) {
+  const char *resolver_name = fast ? "fast" : "basic";
+  const vector<CodeModule *> &modules = workload.modules();
+
+  // Serialize the symbols for FastSourceLineResolver.
+  vector<char *> serialized;
+  if (fast) {
+    ModuleSerializer serializer;
+    double start = Now();
+    for (size_t i = 0; i < modules.size(); ++i) {
+      serialized.push_back(
+          serializer.SerializeSymbolFileData(workload.symbols(i)));
+    }
+    PrintResult(options, workload, resolver_name, "symbol_serialize",
+                modules.size(), Now() - start);
+  }
+
+  bool ok = true;
+  {
+    // Load every module's symbols.  BasicSourceLineResolver parses in
+    // place, so it is given copies made before the clock starts.
+    SourceLineResolverInterface *resolver = NewResolver(fast);
+    vector<char *> copies;
+    if (!fast) {
+      for (size_t i = 0; i < modules.size(); ++i) {
+        const string &text = workload.symbols(i);
+        copies.push_back(new char[text.size() + 1]);
+        memcpy(copies.back(), text.c_str(), text.size() + 1);
+      }
+    }
+    double start = Now();
+    for (size_t i = 0; i < modules.size() && ok; ++i) {
+      ok = resolver->LoadModuleUsingMemoryBuffer(
+          modules[i], fast ? serialized[i] : copies[i]);
+    }
+    double elapsed = Now() - start;
+    for (size_t i = 0; i < copies.size(); ++i)
+      delete [] copies[i];
+    if (ok) {
+      PrintResult(options, workload, resolver_name, "symbol_load",
+                  modules.size(), elapsed);
+    } else {
+      fprintf(stderr, "Could not load generated symbols\n");
+    }
+
+    // Look up random code addresses.
+    Random random(2);
+    int found = 0;
+    start = Now();
+    for (int i = 0; i < options.lookups && ok; ++i) {
+      StackFrame frame;
+      int module;
+      frame.instruction = workload.RandomCodeAddress(&random, &module);
+      frame.module = modules[module];
+      resolver->FillSourceLineInfo(&frame);
+      if (!frame.function_name.empty())
+        ++found;
+    }
+    elapsed = Now() - start;
+    if (ok && found != options.lookups) {
+      fprintf(stderr, "Only %d of %d lookups found a function\n",
+              found, options.lookups);
+      ok = false;
+    }
+    if (ok) {
+      PrintResult(options, workload, resolver_name, "lookup_line",
+                  options.lookups, elapsed);
+    }
+
+    if (ok && workload.unwind()[0] == 'c') {
+      found = 0;
+      start = Now();
+      for (int i = 0; i < options.lookups; ++i) {
+        StackFrame frame;
+        int module;
+        frame.instruction = workload.RandomCodeAddress(&random, &module);
+        frame.module = modules[module];
+        CFIFrameInfo *cfi_frame_info = resolver->FindCFIFrameInfo(&frame);
+        if (cfi_frame_info)
+          ++found;
+        delete cfi_frame_info;
+      }
+      elapsed = Now() - start;
+      if (found != options.lookups) {
+        fprintf(stderr, "Only %d of %d CFI lookups found a record\n",
+                found, options.lookups);
+        ok = false;
+      } else {
+        PrintResult(options, workload, resolver_name, "lookup_cfi",
+                    options.lookups, elapsed);
+      }
+    }
+    delete resolver;
+  }
+
+  // Process with a fresh resolver each time, loading symbols as needed.
+  int expected_frames = options.threads * options.depth;
+  if (ok && options.cold_iterations > 0) {
+    double elapsed = 0;
+    for (int i = 0; i < options.cold_iterations && ok; ++i) {
+      SourceLineResolverInterface *resolver = NewResolver(fast);
+      WorkloadSymbolSupplier supplier(workload, fast ? &serialized : NULL);
+      MinidumpProcessor processor(&supplier, resolver);
+      double start = Now();
+      ok = ProcessWorkload(workload, &processor) == expected_frames;
+      elapsed += Now() - start;
+      delete resolver;
+    }
+    if (ok) {
+      PrintResult(options, workload, resolver_name, "process_cold",
+                  options.cold_iterations, elapsed);
+    }
+  }
+
+  // Process repeatedly with the same resolver, after one untimed pass
+  // that loads the symbols.
+  if (ok) {
+    SourceLineResolverInterface *resolver = NewResolver(fast);
+    WorkloadSymbolSupplier supplier(workload, fast ? &serialized : NULL);
+    MinidumpProcessor processor(&supplier, resolver);
+    ok = ProcessWorkload(workload, &processor) == expected_frames;
+    u_int64_t frames = 0;
+    double start = Now();
+    for (int i = 0; i < options.iterations && ok; ++i) {
+      int walked = ProcessWorkload(workload, &processor);
+      ok = walked == expected_frames;
+      frames += walked;
+    }
+    double elapsed = Now() - start;
+    if (ok) {
+      PrintResult(options, workload, resolver_name, "process",
+                  options.iterations, elapsed);
+      PrintResult(options, workload, resolver_name, "process_frames",
+                  frames, elapsed);
+    }
+    delete resolver;
+  }
+  if (!ok)
+    fprintf(stderr, "Processing did not walk the expected %d frames\n",
+            expected_frames);
+
+  for (size_t i = 0; i < serialized.size(); ++i)
+    delete [] serialized[i];
+  return ok;
+}
+
+static void usage(const char *program_name) {
+  Options defaults;
+  fprintf(stderr, "usage: %s [-t threads] [-d depth] [-m modules] "
+          "[-f functions] [-l lines]\n"
+          "       [-w words] [-u cfi|scan] [-r basic|fast] "
+          "[-i iterations] [-c iterations]\n"
+          "       [-k lookups] [-v]\n"
+          "    -t : Threads in the minidump (default %d)\n"
+          "    -d : Frames on each thread's stack (default %d)\n"
+          "    -m : Modules in the minidump (default %d)\n"
+          "    -f : Functions in each module's symbol file (default %d)\n"
+          "    -l : Line records per function (default %d)\n"
+          "    -w : Words of locals in each frame, at most %d (default %d)\n"
+          "    -u : Only measure CFI or scanning workloads\n"
+          "    -r : Only measure one resolver\n"
+          "    -i : Timed passes with symbols loaded (default %d)\n"
+          "    -c : Timed passes with a fresh resolver (default %d)\n"
+          "    -k : Lookups per lookup measurement (default %d)\n"
+          "    -v : Log processor messages at INFO severity\n",
+          program_name, defaults.threads, defaults.depth, defaults.modules,
+          defaults.functions, defaults.lines, kMaxLocalWords,
+          defaults.locals, defaults.iterations, defaults.cold_iterations,
+          defaults.lookups);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  BPLOG_INIT(&argc, &argv);
+
+  Options options;
+  bool verbose = false;
+  int arg_index = 1;
+  while (arg_index < argc) {
+    const char *arg = argv[arg_index];
+    const char *value = arg_index + 1 < argc ? argv[arg_index + 1] : NULL;
+    int *number = NULL;
+    if (strcmp(arg, "-t") == 0) {
+      number = &options.threads;
+    } else if (strcmp(arg, "-d") == 0) {
+      number = &options.depth;
+    } else if (strcmp(arg, "-m") == 0) {
+      number = &options.modules;
+    } else if (strcmp(arg, "-f") == 0) {
+      number = &options.functions;
+    } else if (strcmp(arg, "-l") == 0) {
+      number = &options.lines;
+    } else if (strcmp(arg, "-w") == 0) {
+      number = &options.locals;
+    } else if (strcmp(arg, "-i") == 0) {
+      number = &options.iterations;
+    } else if (strcmp(arg, "-c") == 0) {
+      number = &options.cold_iterations;
+    } else if (strcmp(arg, "-k") == 0) {
+      number = &options.lookups;
+    } else if (strcmp(arg, "-u") == 0 && value &&
+               (strcmp(value, "cfi") == 0 || strcmp(value, "scan") == 0)) {
+      options.run_cfi = strcmp(value, "cfi") == 0;
+      options.run_scan = !options.run_cfi;
+      arg_index += 2;
+      continue;
+    } else if (strcmp(arg, "-r") == 0 && value &&
+               (strcmp(value, "basic") == 0 || strcmp(value, "fast") == 0)) {
+      options.run_basic = strcmp(value, "basic") == 0;
+      options.run_fast = !options.run_basic;
+      arg_index += 2;
+      continue;
+    } else if (strcmp(arg, "-v") == 0) {
+      verbose = true;
+      ++arg_index;
+      continue;
+    }
+    if (!number || !value) {
+      usage(argv[0]);
+      return 1;
+    }
+    *number = atoi(value);
+    arg_index += 2;
+  }
+
+  if (!verbose)
+    LogStream::set_minimum_severity(LogStream::SEVERITY_ERROR);
+
+  for (int cfi = 1; cfi >= 0; --cfi) {
+    if (!(cfi ? options.run_cfi : options.run_scan))
+      continue;
+    Workload workload(options, cfi);
+    if (!workload.Generate())
+      return 1;
+    printf("{\"unwind\": \"%s\", \"threads\": %d, \"depth\": %d, "
+           "\"modules\": %d, \"functions\": %d, \"lines\": %d, "
+           "\"locals\": %d, \"measurement\": \"workload\", "
+           "\"minidump_bytes\": %llu, \"symbol_bytes\": %llu}\n",
+           workload.unwind(), options.threads, options.depth,
+           options.modules, options.functions, options.lines,
+           options.locals,
+           static_cast<unsigned long long>(workload.minidump().size()),
+           static_cast<unsigned long long>(workload.symbol_bytes()));
+    if (options.run_basic && !RunResolver(options, workload, false))
+      return 1;
+    if (options.run_fast && !RunResolver(options, workload, true))
+      return 1;
+  }
+  return 0;
+}
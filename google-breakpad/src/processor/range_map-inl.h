@@ -98,7 +98,9 @@ bool RangeMap<AddressType, EntryType>::StoreRange(const AddressType &base,
   }
 
   // Store the range in the map by its high address, so that lower_bound can
-  // be used to quickly locate a range by address.
+  // be used to quickly locate a range by address.  The frozen index no
+  // longer reflects the map's contents, so discard it.
+  frozen_.Clear();
   map_.insert(MapValue(high, Range(base, entry)));
   return true;
 }
@@ -111,8 +113,9 @@ bool RangeMap<AddressType, EntryType>::RetrieveRange(
   BPLOG_IF(ERROR, !entry) << "RangeMap::RetrieveRange requires |entry|";
   assert(entry);
 
-  MapConstIterator iterator = map_.lower_bound(address);
-  if (iterator == map_.end())
+  AddressType high;
+  const Range *range;
+  if (!LowerBound(address, &high, &range))
     return false;
 
   // The map is keyed by the high address of each range, so |address| is
@@ -120,15 +123,10 @@ bool RangeMap<AddressType, EntryType>::RetrieveRange(
   // not directly preceded by another range, it's possible for address to
   // be below the range's low address, though.  When that happens, address
   // references something not within any range, so return false.
-  if (address < iterator->second.base())
+  if (address < range->base())
     return false;
 
-  *entry = iterator->second.entry();
-  if (entry_base)
-    *entry_base = iterator->second.base();
-  if (entry_size)
-    *entry_size = iterator->first - iterator->second.base() + 1;
-
+  GetRange(high, *range, entry, entry_base, entry_size);
   return true;
 }
 
@@ -144,6 +142,20 @@ bool RangeMap<AddressType, EntryType>::RetrieveNearestRange(
   if (RetrieveRange(address, entry, entry_base, entry_size))
     return true;
 
+  if (!frozen_.empty()) {
+    // No range contains address, so no range's high address equals it, and
+    // the first range whose high address is not below address is also the
+    // first whose high address is above it.  The range before that one, if
+    // any, is the nearest range below address.
+    size_t index = frozen_.LowerBound(address);
+    if (index == 0)
+      return false;
+    --index;
+    GetRange(frozen_.KeyAtIndex(index), frozen_.ValueAtIndex(index),
+             entry, entry_base, entry_size);
+    return true;
+  }
+
   // upper_bound gives the first element whose key is greater than address,
   // but we want the first element whose key is less than or equal to address.
   // Decrement the iterator to get there, but not if the upper_bound already
@@ -154,12 +166,7 @@ bool RangeMap<AddressType, EntryType>::RetrieveNearestRange(
     return false;
   --iterator;
 
-  *entry = iterator->second.entry();
-  if (entry_base)
-    *entry_base = iterator->second.base();
-  if (entry_size)
-    *entry_size = iterator->first - iterator->second.base() + 1;
-
+  GetRange(iterator->first, iterator->second, entry, entry_base, entry_size);
   return true;
 }
 
@@ -176,18 +183,19 @@ bool RangeMap<AddressType, EntryType>::RetrieveRangeAtIndex(
     return false;
   }
 
+  if (!frozen_.empty() && index >= 0) {
+    GetRange(frozen_.KeyAtIndex(index), frozen_.ValueAtIndex(index),
+             entry, entry_base, entry_size);
+    return true;
+  }
+
   // Walk through the map.  Although it's ordered, it's not a vector, so it
   // can't be addressed directly by index.
   MapConstIterator iterator = map_.begin();
   for (int this_index = 0; this_index < index; ++this_index)
     ++iterator;
 
-  *entry = iterator->second.entry();
-  if (entry_base)
-    *entry_base = iterator->second.base();
-  if (entry_size)
-    *entry_size = iterator->first - iterator->second.base() + 1;
-
+  GetRange(iterator->first, iterator->second, entry, entry_base, entry_size);
   return true;
 }
 
@@ -200,10 +208,51 @@ int RangeMap<AddressType, EntryType>::GetCount() const {
 
 template<typename AddressType, typename EntryType>
 void RangeMap<AddressType, EntryType>::Clear() {
+  frozen_.Clear();
   map_.clear();
 }
 
 
+template<typename AddressType, typename EntryType>
+void RangeMap<AddressType, EntryType>::Freeze() {
+  frozen_.Build(map_);
+}
+
+
+template<typename AddressType, typename EntryType>
+bool RangeMap<AddressType, EntryType>::LowerBound(
+    const AddressType &address,
+    AddressType *high, const Range **range) const {
+  if (!frozen_.empty()) {
+    size_t index = frozen_.LowerBound(address);
+    if (index == frozen_.size())
+      return false;
+    *high = frozen_.KeyAtIndex(index);
+    *range = &frozen_.ValueAtIndex(index);
+    return true;
+  }
+
+  MapConstIterator iterator = map_.lower_bound(address);
+  if (iterator == map_.end())
+    return false;
+  *high = iterator->first;
+  *range = &iterator->second;
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+void RangeMap<AddressType, EntryType>::GetRange(
+    const AddressType &high, const Range &range, EntryType *entry,
+    AddressType *entry_base, AddressType *entry_size) {
+  *entry = range.entry();
+  if (entry_base)
+    *entry_base = range.base();
+  if (entry_size)
+    *entry_size = high - range.base() + 1;
+}
+
+
 }  // namespace google_breakpad
 
 
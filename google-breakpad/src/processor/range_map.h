@@ -43,6 +43,8 @@
 
 #include <map>
 
+#include "processor/frozen_address_index.h"
+
 
 namespace google_breakpad {
 
@@ -52,7 +54,7 @@ template<class, class> class RangeMapSerializer;
 template<typename AddressType, typename EntryType>
 class RangeMap {
  public:
-  RangeMap() : map_() {}
+  RangeMap() : map_(), frozen_() {}
 
   // Inserts a range into the map.  Returns false for a parameter error,
   // or if the location of the range would conflict with a range already
@@ -82,7 +84,8 @@ class RangeMap {
   // and entry_size, if non-NULL, are set to the base and size of the entry's
   // range.
   //
-  // RetrieveRangeAtIndex is not optimized for speedy operation.
+  // RetrieveRangeAtIndex is not optimized for speedy operation unless the
+  // map has been frozen.
   bool RetrieveRangeAtIndex(int index, EntryType *entry,
                             AddressType *entry_base, AddressType *entry_size)
                             const;
@@ -94,6 +97,16 @@ class RangeMap {
   // initially created.
   void Clear();
 
+  // Builds a contiguous index of the stored ranges that the Retrieve*
+  // methods search instead of the underlying std::map.  Call this once all
+  // ranges have been stored.  A subsequent StoreRange or Clear discards
+  // the index, after which lookups fall back to the map until Freeze is
+  // called again.
+  void Freeze();
+
+  // Returns true if the map has been frozen and not modified since.
+  bool IsFrozen() const { return !frozen_.empty(); }
+
  private:
   // Friend declarations.
   friend class ModuleComparer;
@@ -121,8 +134,24 @@ class RangeMap {
   typedef typename AddressToRangeMap::const_iterator MapConstIterator;
   typedef typename AddressToRangeMap::value_type MapValue;
 
+  // Locates the range whose high address is the lowest one not below
+  // address, whether or not address lies within it.  Returns false if
+  // there is no such range.
+  bool LowerBound(const AddressType &address,
+                  AddressType *high, const Range **range) const;
+
+  // Sets entry, entry_base and entry_size, the last two if non-NULL, from
+  // a range and its high address.
+  static void GetRange(const AddressType &high, const Range &range,
+                       EntryType *entry,
+                       AddressType *entry_base, AddressType *entry_size);
+
   // Maps the high address of each range to a EntryType.
   AddressToRangeMap map_;
+
+  // A sorted index over map_, built by Freeze.  Empty while the map is
+  // being populated.
+  FrozenAddressIndex<AddressType, Range> frozen_;
 };
 
 
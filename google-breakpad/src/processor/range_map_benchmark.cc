@@ -0,0 +1,212 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// range_map_benchmark.cc: Measures RangeMap and AddressMap lookup speed
+// before and after Freeze.
+//
+// The maps are populated the way BasicSourceLineResolver populates them
+// from a large symbol file: a RangeMap of functions, a RangeMap of lines
+// within each function, and an AddressMap of public symbols, for about
+// 500,000 records in all.  The benchmark then performs the same sequence of
+// lookups that BasicSourceLineResolver::Module::LookupAddress does, for a
+// fixed set of pseudo-random addresses, once against the std::map storage
+// and once against the frozen indices, and reports the time per lookup.
+//
+// Usage: range_map_benchmark [lookup-count]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <vector>
+
+#include "google_breakpad/common/breakpad_types.h"
+#include "processor/address_map-inl.h"
+#include "processor/linked_ptr.h"
+#include "processor/range_map-inl.h"
+
+namespace {
+
+using google_breakpad::AddressMap;
+using google_breakpad::linked_ptr;
+using google_breakpad::RangeMap;
+using std::vector;
+
+typedef u_int64_t MemAddr;
+
+// 50,000 functions of 9 lines each, plus a public symbol for every tenth
+// function, approximates the record count of a large browser's symbol file.
+const int kFunctionCount = 50000;
+const int kLinesPerFunction = 9;
+const int kPublicSymbolInterval = 10;
+const int kDefaultLookupCount = 2000000;
+
+struct Function {
+  explicit Function(int id) : id(id), lines() {}
+  int id;
+  RangeMap<MemAddr, int> lines;
+};
+
+typedef RangeMap<MemAddr, linked_ptr<Function> > FunctionMap;
+typedef AddressMap<MemAddr, int> PublicSymbolMap;
+
+// A small linear congruential generator, so that every run looks up the
+// same addresses regardless of the C library's rand implementation.
+class Random {
+ public:
+  explicit Random(u_int64_t seed) : state_(seed) {}
+  u_int32_t Next() {
+    state_ = state_ * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<u_int32_t>(state_ >> 32);
+  }
+
+ private:
+  u_int64_t state_;
+};
+
+double Now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+// Lays functions out back to back, separated by occasional gaps so that
+// some lookups miss every function and fall through to the public symbols,
+// as they do for code without debugging information.
+MemAddr Populate(FunctionMap *functions, PublicSymbolMap *public_symbols) {
+  Random random(1);
+  MemAddr address = 0x1000;
+  for (int id = 0; id < kFunctionCount; ++id) {
+    if (random.Next() % 8 == 0)
+      address += 16 + random.Next() % 256;
+
+    linked_ptr<Function> function(new Function(id));
+    MemAddr function_base = address;
+    for (int line = 0; line < kLinesPerFunction; ++line) {
+      MemAddr size = 1 + random.Next() % 32;
+      function->lines.StoreRange(address, size, line);
+      address += size;
+    }
+    functions->StoreRange(function_base, address - function_base, function);
+
+    if (id % kPublicSymbolInterval == 0)
+      public_symbols->Store(function_base, id);
+  }
+  return address;
+}
+
+void Freeze(FunctionMap *functions, PublicSymbolMap *public_symbols) {
+  functions->Freeze();
+  for (int index = 0; index < functions->GetCount(); ++index) {
+    linked_ptr<Function> function;
+    functions->RetrieveRangeAtIndex(index, &function, NULL, NULL);
+    function->lines.Freeze();
+  }
+  public_symbols->Freeze();
+}
+
+// Looks up each address as LookupAddress would, and returns a checksum of
+// the results so that the two passes can be compared and the compiler
+// cannot discard the work.
+u_int64_t LookupAll(const FunctionMap &functions,
+                    const PublicSymbolMap &public_symbols,
+                    const vector<MemAddr> &addresses) {
+  u_int64_t checksum = 0;
+  for (size_t i = 0; i < addresses.size(); ++i) {
+    MemAddr address = addresses[i];
+    linked_ptr<Function> function;
+    MemAddr function_base;
+    MemAddr function_size;
+    int line;
+    int public_symbol;
+    MemAddr public_address;
+    if (functions.RetrieveNearestRange(address, &function,
+                                       &function_base, &function_size) &&
+        address >= function_base && address - function_base < function_size) {
+      checksum = checksum * 31 + function->id;
+      if (function->lines.RetrieveRange(address, &line, NULL, NULL))
+        checksum = checksum * 31 + line;
+    } else if (public_symbols.Retrieve(address,
+                                       &public_symbol, &public_address)) {
+      checksum = checksum * 31 + public_symbol + public_address;
+    }
+  }
+  return checksum;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int lookup_count = kDefaultLookupCount;
+  if (argc > 1)
+    lookup_count = atoi(argv[1]);
+  if (lookup_count <= 0) {
+    fprintf(stderr, "usage: %s [lookup-count]\n", argv[0]);
+    return 1;
+  }
+
+  FunctionMap functions;
+  PublicSymbolMap public_symbols;
+  double start = Now();
+  MemAddr high = Populate(&functions, &public_symbols);
+  double populate_time = Now() - start;
+  printf("stored %d functions, %d lines, %d public symbols in %.3f s\n",
+         kFunctionCount, kFunctionCount * kLinesPerFunction,
+         kFunctionCount / kPublicSymbolInterval, populate_time);
+
+  Random random(2);
+  vector<MemAddr> addresses(lookup_count);
+  for (int i = 0; i < lookup_count; ++i)
+    addresses[i] = 0x1000 + random.Next() % (high - 0x1000);
+
+  start = Now();
+  u_int64_t map_checksum = LookupAll(functions, public_symbols, addresses);
+  double map_time = Now() - start;
+
+  start = Now();
+  Freeze(&functions, &public_symbols);
+  double freeze_time = Now() - start;
+
+  start = Now();
+  u_int64_t frozen_checksum = LookupAll(functions, public_symbols, addresses);
+  double frozen_time = Now() - start;
+
+  printf("froze maps in %.3f s\n", freeze_time);
+  printf("std::map: %d lookups in %.3f s, %.1f ns/lookup\n",
+         lookup_count, map_time, map_time * 1e9 / lookup_count);
+  printf("frozen:   %d lookups in %.3f s, %.1f ns/lookup\n",
+         lookup_count, frozen_time, frozen_time * 1e9 / lookup_count);
+  printf("speedup:  %.2fx\n", map_time / frozen_time);
+
+  if (map_checksum != frozen_checksum) {
+    fprintf(stderr, "FAILED: frozen lookups returned different results\n");
+    return 1;
+  }
+  return 0;
+}
@@ -511,6 +511,19 @@ static bool RunTests() {
         return false;
     }
 
+    if (!RetrieveIndexTest(range_map.get(), range_test_set_index))
+      return false;
+
+    // Freezing the map must not change the results of any lookup.
+    range_map->Freeze();
+    for (unsigned int range_test_index = 0;
+         range_test_index < range_test_count;
+         ++range_test_index) {
+      const RangeTest *range_test = &range_tests[range_test_index];
+      if (!RetrieveTest(range_map.get(), range_test))
+        return false;
+    }
+
     if (!RetrieveIndexTest(range_map.get(), range_test_set_index))
       return false;
 
@@ -0,0 +1,393 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// serialized_symbol_supplier.cc: A SymbolSupplier that keeps a persistent
+// cache of symbols serialized for FastSourceLineResolver.
+//
+// See serialized_symbol_supplier.h for documentation.
+
+#include "processor/serialized_symbol_supplier.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#include "google_breakpad/processor/code_module.h"
+#include "processor/logging.h"
+#include "processor/module_serializer.h"
+#include "processor/pathname_stripper.h"
+#include "processor/scoped_ptr.h"
+
+namespace google_breakpad {
+
+using std::make_pair;
+using std::pair;
+
+SerializedSymbolSupplier::~SerializedSymbolSupplier() {
+  for (map<string, SymbolBuffer>::iterator it = memory_buffers_.begin();
+       it != memory_buffers_.end(); ++it) {
+    ReleaseSymbolBuffer(it->second);
+  }
+}
+
+SymbolSupplier::SymbolResult SerializedSymbolSupplier::GetSymbolFile(
+    const CodeModule *module, const SystemInfo *system_info,
+    string *symbol_file) {
+  BPLOG_IF(ERROR, !symbol_file) << "SerializedSymbolSupplier::GetSymbolFile "
+                                   "requires |symbol_file|";
+  assert(symbol_file);
+  symbol_file->clear();
+
+  string cache_file = CacheFilePath(module);
+  if (cache_file.empty())
+    return NOT_FOUND;
+
+  char *serialized_data;
+  size_t serialized_size;
+  SymbolResult s = UpdateCacheFile(module, system_info, cache_file,
+                                   &serialized_data, &serialized_size);
+  if (serialized_data) {
+    // There is no file to point the caller at.
+    delete [] serialized_data;
+    return NOT_FOUND;
+  }
+  if (s == FOUND)
+    *symbol_file = cache_file;
+  return s;
+}
+
+SymbolSupplier::SymbolResult SerializedSymbolSupplier::GetSymbolFile(
+    const CodeModule *module,
+    const SystemInfo *system_info,
+    string *symbol_file,
+    string *symbol_data) {
+  assert(symbol_file);
+  assert(symbol_data);
+  symbol_file->clear();
+  symbol_data->clear();
+
+  string cache_file = CacheFilePath(module);
+  if (cache_file.empty())
+    return NOT_FOUND;
+
+  char *serialized_data;
+  size_t serialized_size;
+  SymbolResult s = UpdateCacheFile(module, system_info, cache_file,
+                                   &serialized_data, &serialized_size);
+  if (s != FOUND)
+    return s;
+  *symbol_file = cache_file;
+
+  if (serialized_data) {
+    symbol_data->assign(serialized_data, serialized_size);
+    delete [] serialized_data;
+  } else {
+    // The data is binary, so read it all rather than up to a delimiter.
+    std::ifstream in(cache_file.c_str(), std::ios::in | std::ios::binary);
+    symbol_data->assign(std::istreambuf_iterator<char>(in),
+                        std::istreambuf_iterator<char>());
+    in.close();
+  }
+  return s;
+}
+
+SymbolSupplier::SymbolResult SerializedSymbolSupplier::GetCStringSymbolData(
+    const CodeModule *module,
+    const SystemInfo *system_info,
+    string *symbol_file,
+    char **symbol_data) {
+  assert(symbol_file);
+  assert(symbol_data);
+  symbol_file->clear();
+
+  string cache_file = CacheFilePath(module);
+  if (cache_file.empty())
+    return NOT_FOUND;
+
+  char *serialized_data;
+  size_t serialized_size;
+  SymbolResult s = UpdateCacheFile(module, system_info, cache_file,
+                                   &serialized_data, &serialized_size);
+  if (s != FOUND)
+    return s;
+  *symbol_file = cache_file;
+
+  size_t mapped_size = 0;
+  if (serialized_data) {
+    // The cache could not be written; hand out the converted data itself.
+    *symbol_data = serialized_data;
+  } else {
+    *symbol_data = MapCacheFile(cache_file, &mapped_size);
+    if (*symbol_data == NULL)
+      return INTERRUPT;
+  }
+  KeepSymbolBuffer(module->code_file(),
+                   SymbolBuffer(*symbol_data, mapped_size));
+  return FOUND;
+}
+
+void SerializedSymbolSupplier::FreeSymbolData(const CodeModule *module) {
+  if (!module) {
+    BPLOG(INFO) << "Cannot free symbol data buffer for NULL module";
+    return;
+  }
+
+  map<string, SymbolBuffer>::iterator it =
+      memory_buffers_.find(module->code_file());
+  if (it == memory_buffers_.end()) {
+    BPLOG(INFO) << "Cannot find symbol data buffer for module "
+                << module->code_file();
+    return;
+  }
+  ReleaseSymbolBuffer(it->second);
+  memory_buffers_.erase(it);
+}
+
+void SerializedSymbolSupplier::KeepSymbolBuffer(const string &code_file,
+                                                 const SymbolBuffer &buffer) {
+  pair<map<string, SymbolBuffer>::iterator, bool> inserted =
+      memory_buffers_.insert(make_pair(code_file, buffer));
+  if (!inserted.second) {
+    ReleaseSymbolBuffer(inserted.first->second);
+    inserted.first->second = buffer;
+  }
+}
+
+// static
+void SerializedSymbolSupplier::ReleaseSymbolBuffer(const SymbolBuffer &buffer) {
+  if (buffer.mapped_size)
+    munmap(buffer.data, buffer.mapped_size);
+  else
+    delete [] buffer.data;
+}
+
+string SerializedSymbolSupplier::CacheFilePath(
+    const CodeModule *module) const {
+  if (!module)
+    return "";
+
+  string debug_file_name = PathnameStripper::File(module->debug_file());
+  string identifier = module->debug_identifier();
+  if (debug_file_name.empty() || identifier.empty()) {
+    BPLOG(ERROR) << "Can't construct cache file path without debug_file "
+                    "and debug_identifier (code_file = " <<
+                    PathnameStripper::File(module->code_file()) << ")";
+    return "";
+  }
+
+  // Name the file as SimpleSymbolSupplier names the symbol file, but with
+  // a .serialized extension in place of .sym.
+  string path = cache_path_ + "/" + debug_file_name + "/" + identifier + "/";
+  string debug_file_extension;
+  if (debug_file_name.size() > 4)
+    debug_file_extension = debug_file_name.substr(debug_file_name.size() - 4);
+  std::transform(debug_file_extension.begin(), debug_file_extension.end(),
+                 debug_file_extension.begin(), tolower);
+  if (debug_file_extension == ".pdb") {
+    path.append(debug_file_name.substr(0, debug_file_name.size() - 4));
+  } else {
+    path.append(debug_file_name);
+  }
+  path.append(".serialized");
+  return path;
+}
+
+SymbolSupplier::SymbolResult SerializedSymbolSupplier::UpdateCacheFile(
+    const CodeModule *module,
+    const SystemInfo *system_info,
+    const string &cache_file,
+    char **serialized_data,
+    size_t *serialized_size) {
+  *serialized_data = NULL;
+  *serialized_size = 0;
+
+  // Find the text symbol file, to see whether the cached file is older.
+  // If there is no text symbol file any more, a cached file is still good.
+  string text_file;
+  SymbolResult s = text_supplier_->GetSymbolFile(module, system_info,
+                                                 &text_file);
+  if (s == INTERRUPT)
+    return s;
+  time_t text_mtime = 0;
+  struct stat sb;
+  if (s == FOUND && stat(text_file.c_str(), &sb) == 0)
+    text_mtime = sb.st_mtime;
+  if (IsCurrentCacheFile(cache_file, text_mtime))
+    return FOUND;
+  if (s == NOT_FOUND)
+    return s;
+
+  // Convert the text symbol file.
+  BPLOG(INFO) << "Serializing symbols for " << module->code_file() <<
+      " into " << cache_file;
+  char *text_data;
+  s = text_supplier_->GetCStringSymbolData(module, system_info, &text_file,
+                                           &text_data);
+  if (s != FOUND)
+    return s;
+  ModuleSerializer serializer;
+  unsigned int size = 0;
+  scoped_array<char> data(serializer.SerializeSymbolFileData(text_data,
+                                                             &size));
+  text_supplier_->FreeSymbolData(module);
+  if (!data.get()) {
+    BPLOG(ERROR) << "Could not serialize symbol file " << text_file;
+    return NOT_FOUND;
+  }
+  ++conversions_;
+
+  if (!WriteCacheFile(cache_file, data.get(), size)) {
+    *serialized_data = data.release();
+    *serialized_size = size;
+  }
+  return FOUND;
+}
+
+// static
+bool SerializedSymbolSupplier::WriteCacheFile(const string &path,
+                                              const char *data,
+                                              size_t size) {
+  // Create the parent directories, which are below cache_path_.
+  for (string::size_type slash = path.find('/', 1);
+       slash != string::npos;
+       slash = path.find('/', slash + 1)) {
+    string directory = path.substr(0, slash);
+    if (mkdir(directory.c_str(), 0777) == -1 && errno != EEXIST) {
+      string error_string;
+      int error_code = ErrnoString(&error_string);
+      BPLOG(ERROR) << "Could not create " << directory <<
+          ", error " << error_code << ": " << error_string;
+      return false;
+    }
+  }
+
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".%d.tmp", static_cast<int>(getpid()));
+  string temporary_path = path + suffix;
+  FILE *file = fopen(temporary_path.c_str(), "wb");
+  if (!file) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not open " << temporary_path <<
+        ", error " << error_code << ": " << error_string;
+    return false;
+  }
+  bool written = fwrite(data, 1, size, file) == size;
+  if (fclose(file) != 0)
+    written = false;
+  if (!written || rename(temporary_path.c_str(), path.c_str()) == -1) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not write " << path <<
+        ", error " << error_code << ": " << error_string;
+    unlink(temporary_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// static
+bool SerializedSymbolSupplier::IsCurrentCacheFile(const string &path,
+                                                  time_t not_before) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    return false;
+
+  // The file starts with a magic number, a format version, and the sizes
+  // of each of the module's serialized maps, which follow in turn, and ends
+  // with a NUL.
+  size_t header_size = ModuleSerializer::HeaderSize();
+  scoped_array<char> header(new char[header_size]);
+  struct stat sb;
+  bool current =
+      fstat(fd, &sb) == 0 &&
+      sb.st_mtime >= not_before &&
+      read(fd, header.get(), header_size) ==
+          static_cast<ssize_t>(header_size);
+  close(fd);
+  if (!current)
+    return false;
+
+  if (ModuleSerializer::SerializedSize(header.get()) !=
+      static_cast<u_int64_t>(sb.st_size)) {
+    BPLOG(INFO) << "Cached symbol file " << path <<
+        " is incomplete or in an old format";
+    return false;
+  }
+  return true;
+}
+
+// static
+char *SerializedSymbolSupplier::MapCacheFile(const string &path,
+                                             size_t *mapped_size) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not open " << path <<
+        ", error " << error_code << ": " << error_string;
+    return NULL;
+  }
+
+  struct stat sb;
+  if (fstat(fd, &sb) == -1) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not stat " << path <<
+        ", error " << error_code << ": " << error_string;
+    close(fd);
+    return NULL;
+  }
+
+  void *data = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not map " << path <<
+        ", error " << error_code << ": " << error_string;
+    return NULL;
+  }
+
+  *mapped_size = sb.st_size;
+  return static_cast<char *>(data);
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,174 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// serialized_symbol_supplier.h: A SymbolSupplier that keeps a persistent
+// cache of symbols serialized for FastSourceLineResolver.
+//
+// Parsing a text symbol file is most of the cost of processing a minidump
+// whose modules' symbols are not already loaded.  ModuleSerializer converts
+// a parsed module into the flat, pointer-free form that
+// FastSourceLineResolver reads in place, so a module only needs to be parsed
+// once if that form is kept.
+//
+// SerializedSymbolSupplier wraps another SymbolSupplier that provides text
+// symbol files, and keeps the serialized form of each module it supplies in
+// a cache directory, laid out as SimpleSymbolSupplier lays out symbol
+// directories but with a .serialized file in place of each .sym file:
+//
+// cache
+// cache/test_app.pdb/63FE4780728D49379B9D7BB6460CB42A1/test_app.serialized
+//
+// On a cache hit, GetCStringSymbolData maps the cached file read-only and
+// hands out the mapping, which FastSourceLineResolver loads without copying
+// or parsing.  On a miss, or if the text symbol file is newer than the cached
+// file, it obtains the text from the wrapped supplier, serializes it, and
+// writes the result to the cache before handing it out.  Cache files are
+// written under a temporary name and renamed into place, so concurrent
+// processes sharing a cache never see a partial file.
+//
+// The data handed out is in FastSourceLineResolver's format, so this
+// supplier must only be used with a FastSourceLineResolver.  That resolver
+// does not take ownership of the data it loads, so buffers stay valid until
+// FreeSymbolData is called for the module or the supplier is destroyed.
+
+#ifndef PROCESSOR_SERIALIZED_SYMBOL_SUPPLIER_H__
+#define PROCESSOR_SERIALIZED_SYMBOL_SUPPLIER_H__
+
+#include <time.h>
+
+#include <map>
+#include <string>
+
+#include "google_breakpad/processor/symbol_supplier.h"
+
+namespace google_breakpad {
+
+using std::map;
+using std::string;
+
+class CodeModule;
+
+class SerializedSymbolSupplier : public SymbolSupplier {
+ public:
+  // Creates a new SerializedSymbolSupplier that obtains text symbol files
+  // from text_supplier and keeps their serialized form under cache_path.
+  // Does not take ownership of text_supplier.
+  SerializedSymbolSupplier(SymbolSupplier *text_supplier,
+                           const string &cache_path)
+      : text_supplier_(text_supplier), cache_path_(cache_path),
+        conversions_(0) {}
+
+  // Releases any buffers that have not been freed with FreeSymbolData.
+  virtual ~SerializedSymbolSupplier();
+
+  // Places the path to the cached serialized symbols for module in
+  // symbol_file, converting the text symbol file first if needed.
+  virtual SymbolResult GetSymbolFile(const CodeModule *module,
+                                     const SystemInfo *system_info,
+                                     string *symbol_file);
+
+  // Same as above, and also places the serialized symbols in symbol_data.
+  virtual SymbolResult GetSymbolFile(const CodeModule *module,
+                                     const SystemInfo *system_info,
+                                     string *symbol_file,
+                                     string *symbol_data);
+
+  // Same as above, but maps the cached serialized symbols read-only and
+  // places the mapping in symbol_data.  If the cache could not be written,
+  // the serialized symbols are handed out from the heap instead.
+  // Symbol supplier ALWAYS takes ownership of the data buffer.
+  virtual SymbolResult GetCStringSymbolData(const CodeModule *module,
+                                            const SystemInfo *system_info,
+                                            string *symbol_file,
+                                            char **symbol_data);
+
+  // Frees the buffer handed out for module by GetCStringSymbolData.
+  virtual void FreeSymbolData(const CodeModule *module);
+
+  // The number of text symbol files this supplier has serialized, that is,
+  // the number of cache misses.
+  int conversions() const { return conversions_; }
+
+ private:
+  // A buffer handed out by GetCStringSymbolData.  If mapped_size is zero,
+  // data was allocated with new[]; otherwise it is a mapping of that many
+  // bytes.
+  struct SymbolBuffer {
+    SymbolBuffer() : data(NULL), mapped_size(0) {}
+    SymbolBuffer(char *set_data, size_t set_mapped_size)
+        : data(set_data), mapped_size(set_mapped_size) {}
+    char *data;
+    size_t mapped_size;
+  };
+
+  // Records buffer as the one handed out for code_file.  A caller that
+  // asks for a module's symbols again is done with the buffer it was given
+  // before, so any buffer still held for code_file is released first.
+  void KeepSymbolBuffer(const string &code_file, const SymbolBuffer &buffer);
+
+  // Frees or unmaps buffer.
+  static void ReleaseSymbolBuffer(const SymbolBuffer &buffer);
+
+  // Returns the path at which module's serialized symbols are cached, or
+  // an empty string if module lacks the debug_file or debug_identifier
+  // needed to name it.
+  string CacheFilePath(const CodeModule *module) const;
+
+  // Ensures that cache_file holds current serialized symbols for module,
+  // converting the text symbol file from text_supplier_ if it does not.
+  // If the converted symbols could not be written to cache_file, returns
+  // FOUND with them in *serialized_data, which the caller must delete [];
+  // otherwise *serialized_data is set to NULL.
+  SymbolResult UpdateCacheFile(const CodeModule *module,
+                               const SystemInfo *system_info,
+                               const string &cache_file,
+                               char **serialized_data,
+                               size_t *serialized_size);
+
+  // Writes size bytes at data to path, atomically replacing any file
+  // already there, and creating any missing parent directories.
+  static bool WriteCacheFile(const string &path, const char *data,
+                             size_t size);
+
+  // Returns true if the file at path is a complete serialized module whose
+  // modification time is no earlier than not_before.
+  static bool IsCurrentCacheFile(const string &path, time_t not_before);
+
+  // Maps the file at path read-only.  Returns NULL on failure.
+  static char *MapCacheFile(const string &path, size_t *mapped_size);
+
+  SymbolSupplier *text_supplier_;
+  string cache_path_;
+  map<string, SymbolBuffer> memory_buffers_;
+  int conversions_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_SERIALIZED_SYMBOL_SUPPLIER_H__
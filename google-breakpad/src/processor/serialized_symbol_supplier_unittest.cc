@@ -0,0 +1,167 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// serialized_symbol_supplier_unittest.cc: Unit tests for
+// SerializedSymbolSupplier.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/basic_code_module.h"
+#include "processor/serialized_symbol_supplier.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace {
+
+using google_breakpad::BasicCodeModule;
+using google_breakpad::FastSourceLineResolver;
+using google_breakpad::SerializedSymbolSupplier;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::StackFrame;
+using google_breakpad::SymbolSupplier;
+using std::string;
+
+class TestSerializedSymbolSupplier : public ::testing::Test {
+ public:
+  TestSerializedSymbolSupplier()
+      : module(0x400000, 0x2d000, "c:\\test_app.exe", "",
+               "c:\\test_app.pdb", "5A9832E5287241C1838ED98914E9B7FF1", "") {}
+
+  void SetUp() {
+    symbol_path = string(getenv("srcdir") ? getenv("srcdir") : ".") +
+                  "/src/processor/testdata/symbols";
+    char cache_template[] = "/tmp/serialized-symbol-supplier-XXXXXX";
+    ASSERT_TRUE(mkdtemp(cache_template));
+    cache_path = cache_template;
+    cache_file = cache_path +
+        "/test_app.pdb/5A9832E5287241C1838ED98914E9B7FF1/test_app.serialized";
+  }
+
+  void TearDown() {
+    unlink(cache_file.c_str());
+    rmdir((cache_path +
+           "/test_app.pdb/5A9832E5287241C1838ED98914E9B7FF1").c_str());
+    rmdir((cache_path + "/test_app.pdb").c_str());
+    rmdir(cache_path.c_str());
+  }
+
+  // Load module's symbols from supplier and look up an address in them.
+  void CheckLookup(SerializedSymbolSupplier *supplier) {
+    string symbol_file;
+    char *symbol_data;
+    ASSERT_EQ(SymbolSupplier::FOUND,
+              supplier->GetCStringSymbolData(&module, NULL, &symbol_file,
+                                             &symbol_data));
+    EXPECT_EQ(cache_file, symbol_file);
+
+    FastSourceLineResolver resolver;
+    ASSERT_TRUE(resolver.LoadModuleUsingMemoryBuffer(&module, symbol_data));
+    StackFrame frame;
+    frame.instruction = 0x401060;
+    frame.module = &module;
+    resolver.FillSourceLineInfo(&frame);
+    EXPECT_EQ("std::bad_alloc::bad_alloc(char const *)", frame.function_name);
+    EXPECT_EQ(371, frame.source_line);
+    resolver.UnloadModule(&module);
+    supplier->FreeSymbolData(&module);
+  }
+
+  BasicCodeModule module;
+  string symbol_path;
+  string cache_path;
+  string cache_file;
+};
+
+TEST_F(TestSerializedSymbolSupplier, ConvertsOnlyOnMiss) {
+  SimpleSymbolSupplier text_supplier(symbol_path);
+  {
+    SerializedSymbolSupplier supplier(&text_supplier, cache_path);
+    CheckLookup(&supplier);
+    EXPECT_EQ(1, supplier.conversions());
+    CheckLookup(&supplier);
+    EXPECT_EQ(1, supplier.conversions());
+  }
+
+  // A new supplier finds the cached file left by the first.
+  SerializedSymbolSupplier supplier(&text_supplier, cache_path);
+  CheckLookup(&supplier);
+  EXPECT_EQ(0, supplier.conversions());
+}
+
+TEST_F(TestSerializedSymbolSupplier, ReconvertsIncompleteOrStaleFile) {
+  SimpleSymbolSupplier text_supplier(symbol_path);
+  SerializedSymbolSupplier supplier(&text_supplier, cache_path);
+  string symbol_file;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_EQ(1, supplier.conversions());
+
+  struct stat sb;
+  ASSERT_EQ(0, stat(cache_file.c_str(), &sb));
+  ASSERT_EQ(0, truncate(cache_file.c_str(), sb.st_size - 1));
+  CheckLookup(&supplier);
+  EXPECT_EQ(2, supplier.conversions());
+
+  // Make the cached file older than the text symbol file.
+  struct timeval times[2] = { { 1, 0 }, { 1, 0 } };
+  ASSERT_EQ(0, utimes(cache_file.c_str(), times));
+  CheckLookup(&supplier);
+  EXPECT_EQ(3, supplier.conversions());
+}
+
+TEST_F(TestSerializedSymbolSupplier, MissingSymbols) {
+  SimpleSymbolSupplier text_supplier(symbol_path);
+  SerializedSymbolSupplier supplier(&text_supplier, cache_path);
+  BasicCodeModule unknown(0x400000, 0x1000, "c:\\unknown.exe", "",
+                          "c:\\unknown.pdb", "0123456789ABCDEF", "");
+  string symbol_file;
+  char *symbol_data;
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetCStringSymbolData(&unknown, NULL, &symbol_file,
+                                          &symbol_data));
+  EXPECT_EQ(0, supplier.conversions());
+  struct stat sb;
+  EXPECT_NE(0, stat((cache_path + "/unknown.pdb").c_str(), &sb));
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -33,16 +33,34 @@
 //
 // Author: Mark Mentovai
 
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
 #include "processor/simple_symbol_supplier.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif  // HAVE_ZLIB
+
+#ifdef _WIN32
+#include <io.h>
+typedef SSIZE_T ssize_t;
+#else  // _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#define O_BINARY 0
+#endif  // _WIN32
+
 #include <algorithm>
-#include <iostream>
-#include <fstream>
+#include <utility>
 
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/system_info.h"
@@ -51,11 +69,104 @@
 
 namespace google_breakpad {
 
+using std::make_pair;
+using std::pair;
+
 static bool file_exists(const string &file_name) {
   struct stat sb;
   return stat(file_name.c_str(), &sb) == 0;
 }
 
+// The size of the pieces in which ReadSymbolFile reads symbol files.
+static const size_t kReadBufferSize = 128 * 1024;
+
+namespace {
+
+// Collects a symbol file's text in a string.
+class StringSink : public SimpleSymbolSupplier::SymbolDataSink {
+ public:
+  explicit StringSink(string *data) : data_(data) {}
+  virtual bool Append(const char *data, size_t size) {
+    data_->append(data, size);
+    return true;
+  }
+
+ private:
+  string *data_;
+};
+
+// Collects a symbol file's text in a NUL-terminated buffer allocated with
+// new[], which is what GetCStringSymbolData hands out.  The buffer starts
+// out large enough for the expected size of the text, so that, unless the
+// guess is wrong, the text is written once and never copied.
+class CStringSink : public SimpleSymbolSupplier::SymbolDataSink {
+ public:
+  explicit CStringSink(size_t expected_size)
+      : data_(new char[expected_size + 1]),
+        capacity_(expected_size),
+        size_(0) {}
+  virtual ~CStringSink() { delete [] data_; }
+
+  virtual bool Append(const char *data, size_t size) {
+    if (size > capacity_ - size_) {
+      size_t capacity = std::max(capacity_ * 2, size_ + size);
+      char *grown = new char[capacity + 1];
+      memcpy(grown, data_, size_);
+      delete [] data_;
+      data_ = grown;
+      capacity_ = capacity;
+    }
+    memcpy(data_ + size_, data, size);
+    size_ += size;
+    return true;
+  }
+
+  // Returns the NUL-terminated text, which the caller must delete[].
+  char *Release() {
+    data_[size_] = '\0';
+    char *data = data_;
+    data_ = NULL;
+    return data;
+  }
+
+ private:
+  char *data_;
+  size_t capacity_;
+  size_t size_;
+};
+
+}  // namespace
+
+// Returns the size of the text in the symbol file at path, or a guess at
+// it if the file is compressed, or zero if the file can't be examined.
+static size_t ExpectedSymbolDataSize(const string &path, bool compressed) {
+  struct stat sb;
+  if (stat(path.c_str(), &sb) != 0)
+    return 0;
+  if (!compressed)
+    return sb.st_size;
+
+  // A gzip stream ends with the size of its uncompressed data, modulo 2^32,
+  // as a little-endian 32-bit value.  That's exact for the single-stream
+  // files that gzip writes, unless they inflate to 4GB or more.  Deflate
+  // can't compress by more than 1032:1, so don't believe a trailer that
+  // claims otherwise.
+  int fd = open(path.c_str(), O_RDONLY | O_BINARY);
+  if (fd == -1)
+    return 0;
+  unsigned char trailer[4];
+  bool have_trailer = sb.st_size >= static_cast<off_t>(sizeof(trailer)) &&
+      lseek(fd, sb.st_size - sizeof(trailer), SEEK_SET) != -1 &&
+      read(fd, trailer, sizeof(trailer)) ==
+          static_cast<ssize_t>(sizeof(trailer));
+  close(fd);
+  if (!have_trailer)
+    return 0;
+  size_t size = trailer[0] | trailer[1] << 8 | trailer[2] << 16 |
+                static_cast<u_int32_t>(trailer[3]) << 24;
+  return std::min(size, static_cast<size_t>(sb.st_size) * 1032);
+}
+
 SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFile(
     const CodeModule *module, const SystemInfo *system_info,
     string *symbol_file) {
@@ -86,10 +197,11 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFile(
   SymbolSupplier::SymbolResult s = GetSymbolFile(module, system_info, symbol_file);
 
   if (s == FOUND) {
-    std::ifstream in(symbol_file->c_str());
-    std::getline(in, *symbol_data, std::string::traits_type::to_char_type(
-                     std::string::traits_type::eof()));
-    in.close();
+    StringSink sink(symbol_data);
+    if (!ReadSymbolFile(*symbol_file, &sink)) {
+      symbol_data->clear();
+      return NOT_FOUND;
+    }
   }
   return s;
 }
@@ -101,21 +213,33 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetCStringSymbolData(
     char **symbol_data) {
   assert(symbol_data);
 
-  string symbol_data_string;
   SymbolSupplier::SymbolResult s =
-      GetSymbolFile(module, system_info, symbol_file, &symbol_data_string);
+      GetSymbolFile(module, system_info, symbol_file);
+  if (s != FOUND)
+    return s;
 
-  if (s == FOUND) {
-    unsigned int size = symbol_data_string.size() + 1;
-    *symbol_data = new char[size];
-    if (*symbol_data == NULL) {
-      BPLOG(ERROR) << "Memory allocation for size " << size << " failed";
-      return INTERRUPT;
+  bool compressed = IsCompressedSymbolFile(*symbol_file);
+  bool map = map_symbol_files_ && !compressed;
+  if (map) {
+    size_t mapped_size = 0;
+    *symbol_data = MapSymbolFile(*symbol_file, &mapped_size);
+    if (*symbol_data) {
+      KeepSymbolBuffer(module->code_file(),
+                       SymbolBuffer(*symbol_data, mapped_size));
+      return s;
     }
-    memcpy(*symbol_data, symbol_data_string.c_str(), size - 1);
-    (*symbol_data)[size - 1] = '\0';
-    memory_buffers_.insert(make_pair(module->code_file(), *symbol_data));
   }
+
+  // Read the file, decoding it if it is compressed, straight into the
+  // buffer handed to the resolver.  A compressed symbol file can't be
+  // mapped, so it always comes here.  If an uncompressed one couldn't be
+  // mapped, perhaps for lack of address space or file descriptors, it is
+  // read instead, and the walk is only given up on if that fails too.
+  CStringSink sink(ExpectedSymbolDataSize(*symbol_file, compressed));
+  if (!ReadSymbolFile(*symbol_file, &sink))
+    return map ? INTERRUPT : NOT_FOUND;
+  *symbol_data = sink.Release();
+  KeepSymbolBuffer(module->code_file(), SymbolBuffer(*symbol_data, 0));
   return s;
 }
 
@@ -125,16 +249,99 @@ void SimpleSymbolSupplier::FreeSymbolData(const CodeModule *module) {
     return;
   }
 
-  map<string, char *>::iterator it = memory_buffers_.find(module->code_file());
+  map<string, SymbolBuffer>::iterator it =
+      memory_buffers_.find(module->code_file());
   if (it == memory_buffers_.end()) {
     BPLOG(INFO) << "Cannot find symbol data buffer for module "
                 << module->code_file();
     return;
   }
-  delete [] it->second;
+  ReleaseSymbolBuffer(it->second);
   memory_buffers_.erase(it);
 }
 
+void SimpleSymbolSupplier::KeepSymbolBuffer(const string &code_file,
+                                             const SymbolBuffer &buffer) {
+  pair<map<string, SymbolBuffer>::iterator, bool> inserted =
+      memory_buffers_.insert(make_pair(code_file, buffer));
+  if (!inserted.second) {
+    ReleaseSymbolBuffer(inserted.first->second);
+    inserted.first->second = buffer;
+  }
+}
+
+// static
+void SimpleSymbolSupplier::ReleaseSymbolBuffer(const SymbolBuffer &buffer) {
+  if (buffer.mapped_size) {
+#ifndef _WIN32
+    munmap(buffer.data, buffer.mapped_size);
+#endif  // _WIN32
+  } else {
+    delete [] buffer.data;
+  }
+}
+
+// static
+char *SimpleSymbolSupplier::MapSymbolFile(const string &path,
+                                          size_t *mapped_size) {
+#ifdef _WIN32
+  return NULL;
+#else  // _WIN32
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not open " << path <<
+        ", error " << error_code << ": " << error_string;
+    return NULL;
+  }
+
+  struct stat sb;
+  if (fstat(fd, &sb) == -1) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not stat " << path <<
+        ", error " << error_code << ": " << error_string;
+    close(fd);
+    return NULL;
+  }
+  size_t file_size = sb.st_size;
+
+  // Reserve zero-filled anonymous memory for the file plus a terminating
+  // NUL, then map the file over the start of it.  Bytes past the end of the
+  // file in its last page read as zero, and if the file ends exactly on a
+  // page boundary, the terminator comes from the anonymous page after it.
+  size_t page_size = getpagesize();
+  size_t reserved_size = (file_size + 1 + page_size - 1) & ~(page_size - 1);
+  void *base = mmap(NULL, reserved_size, PROT_READ,
+                    MAP_PRIVATE | MAP_ANON, -1, 0);
+  if (base == MAP_FAILED) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not reserve " << reserved_size << " bytes for " <<
+        path << ", error " << error_code << ": " << error_string;
+    close(fd);
+    return NULL;
+  }
+
+  if (file_size > 0 &&
+      mmap(base, file_size, PROT_READ, MAP_PRIVATE | MAP_FIXED,
+           fd, 0) == MAP_FAILED) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not map " << path <<
+        ", error " << error_code << ": " << error_string;
+    munmap(base, reserved_size);
+    close(fd);
+    return NULL;
+  }
+  close(fd);
+
+  *mapped_size = reserved_size;
+  return static_cast<char *>(base);
+#endif  // _WIN32
+}
+
 SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFileAtPathFromRoot(
     const CodeModule *module, const SystemInfo *system_info,
     const string &root_path, string *symbol_file) {
@@ -186,15 +393,132 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFileAtPathFromRoot(
   } else {
     path.append(debug_file_name);
   }
-  path.append(".sym");
 
-  if (!file_exists(path)) {
-    BPLOG(INFO) << "No symbol file at " << path;
-    return NOT_FOUND;
+  // Look for the symbol file in each encoding, in order of preference.
+  string tried_paths;
+  for (unsigned int encoding_index = 0; encoding_index < encodings_.size();
+       ++encoding_index) {
+#ifndef HAVE_ZLIB
+    if (encodings_[encoding_index] == SYMBOL_FILE_GZIP)
+      continue;
+#endif  // HAVE_ZLIB
+    string encoded_path =
+        path + SymbolFileExtension(encodings_[encoding_index]);
+    if (file_exists(encoded_path)) {
+      *symbol_file = encoded_path;
+      return FOUND;
+    }
+    if (!tried_paths.empty())
+      tried_paths.append(" or ");
+    tried_paths.append(encoded_path);
   }
 
-  *symbol_file = path;
-  return FOUND;
+  BPLOG(INFO) << "No symbol file at " << tried_paths;
+  return NOT_FOUND;
+}
+
+// static
+bool SimpleSymbolSupplier::ReadSymbolFile(const string &path,
+                                          SymbolDataSink *sink) {
+  vector<char> buffer(kReadBufferSize);
+
+  if (IsCompressedSymbolFile(path)) {
+#ifdef HAVE_ZLIB
+    gzFile file = gzopen(path.c_str(), "rb");
+    if (file == NULL) {
+      string error_string;
+      int error_code = ErrnoString(&error_string);
+      BPLOG(ERROR) << "Could not open " << path <<
+          ", error " << error_code << ": " << error_string;
+      return false;
+    }
+    gzbuffer(file, kReadBufferSize);
+
+    int bytes_read;
+    while ((bytes_read = gzread(file, &buffer[0], buffer.size())) > 0) {
+      if (!sink->Append(&buffer[0], bytes_read)) {
+        gzclose(file);
+        return false;
+      }
+    }
+
+    // gzread reports a truncated stream only through gzerror.
+    int error_code;
+    const char *error_string = gzerror(file, &error_code);
+    if (bytes_read < 0 || (error_code != Z_OK && error_code != Z_STREAM_END)) {
+      BPLOG(ERROR) << "Could not decompress " << path <<
+          ", error " << error_code << ": " << error_string;
+      gzclose(file);
+      return false;
+    }
+    gzclose(file);
+    return true;
+#else  // HAVE_ZLIB
+    BPLOG(ERROR) << "Could not decompress " << path <<
+        ": built without zlib";
+    return false;
+#endif  // HAVE_ZLIB
+  }
+
+  int fd = open(path.c_str(), O_RDONLY | O_BINARY);
+  if (fd == -1) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not open " << path <<
+        ", error " << error_code << ": " << error_string;
+    return false;
+  }
+
+  ssize_t bytes_read;
+  while ((bytes_read = read(fd, &buffer[0], buffer.size())) != 0) {
+    if (bytes_read == -1) {
+      if (errno == EINTR)
+        continue;
+      string error_string;
+      int error_code = ErrnoString(&error_string);
+      BPLOG(ERROR) << "Could not read " << path <<
+          ", error " << error_code << ": " << error_string;
+      close(fd);
+      return false;
+    }
+    if (!sink->Append(&buffer[0], bytes_read)) {
+      close(fd);
+      return false;
+    }
+  }
+  close(fd);
+  return true;
+}
+
+// static
+const char *SimpleSymbolSupplier::SymbolFileExtension(
+    SymbolFileEncoding encoding) {
+  switch (encoding) {
+    case SYMBOL_FILE_GZIP:
+      return ".sym.gz";
+    case SYMBOL_FILE_PLAIN:
+    default:
+      return ".sym";
+  }
+}
+
+// static
+bool SimpleSymbolSupplier::IsCompressedSymbolFile(const string &path) {
+  const string extension = SymbolFileExtension(SYMBOL_FILE_GZIP);
+  return path.size() > extension.size() &&
+         path.compare(path.size() - extension.size(), extension.size(),
+                      extension) == 0;
+}
+
+// static
+vector<SimpleSymbolSupplier::SymbolFileEncoding>
+SimpleSymbolSupplier::DefaultSymbolFileEncodings() {
+  vector<SymbolFileEncoding> encodings;
+  encodings.push_back(SYMBOL_FILE_PLAIN);
+#ifdef HAVE_ZLIB
+  encodings.push_back(SYMBOL_FILE_GZIP);
+#endif  // HAVE_ZLIB
+  return encodings;
 }
 
 }  // namespace google_breakpad
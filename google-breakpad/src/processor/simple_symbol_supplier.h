@@ -65,6 +65,29 @@
 // SimpleSymbolSupplier will iterate over all root paths searching for
 // a symbol file existing in that path.
 //
+// By default, GetCStringSymbolData reads each symbol file into a heap buffer.
+// After set_map_symbol_files(true), it instead maps the symbol file read-only
+// into memory, so that the resolver can parse it in place without any copy.
+// A file that cannot be mapped, and any file on Windows, is read as usual.
+// The mapping is released by FreeSymbolData, exactly as the heap buffer would
+// be, so the SourceLineResolverInterface::
+// ShouldDeleteMemoryBufferAfterLoadModule contract governs its lifetime.
+//
+// Symbol files may also be stored gzip-compressed, with a .sym.gz
+// extension in place of .sym.  set_symbol_file_encodings selects which
+// encodings are looked for, and in which order.  By default, an
+// uncompressed .sym file is preferred, and a .sym.gz file is used when no
+// .sym file exists.  Compressed files are decoded in memory as they are
+// read, never into a temporary file.  GetCStringSymbolData decodes one
+// straight into the buffer it returns, sized from the file's gzip trailer,
+// so the text is held only once.  Because a compressed file cannot be
+// mapped, that is always a heap buffer, even after
+// set_map_symbol_files(true).  ReadSymbolFile lets other callers pass the
+// decoded text straight on as it is decompressed, for example to a
+// BasicSourceLineResolver::ModuleLoader.  Reading compressed files needs
+// zlib; in a build without it (HAVE_ZLIB undefined), .sym.gz files are
+// never looked for, and ReadSymbolFile fails on them.
+//
 // SimpleSymbolSupplier supports any debugging file which can be identified
 // by a CodeModule object's debug_file and debug_identifier accessors.  The
 // expected ultimate source of these CodeModule objects are MinidumpModule
@@ -94,11 +117,15 @@ class SimpleSymbolSupplier : public SymbolSupplier {
  public:
   // Creates a new SimpleSymbolSupplier, using path as the root path where
   // symbols are stored.
-  explicit SimpleSymbolSupplier(const string &path) : paths_(1, path) {}
+  explicit SimpleSymbolSupplier(const string &path)
+      : paths_(1, path), map_symbol_files_(false),
+        encodings_(DefaultSymbolFileEncodings()) {}
 
   // Creates a new SimpleSymbolSupplier, using paths as a list of root
   // paths where symbols may be stored.
-  explicit SimpleSymbolSupplier(const vector<string> &paths) : paths_(paths) {}
+  explicit SimpleSymbolSupplier(const vector<string> &paths)
+      : paths_(paths), map_symbol_files_(false),
+        encodings_(DefaultSymbolFileEncodings()) {}
 
   virtual ~SimpleSymbolSupplier() {}
 
@@ -113,7 +140,9 @@ class SimpleSymbolSupplier : public SymbolSupplier {
                                      string *symbol_file,
                                      string *symbol_data);
 
-  // Allocates data buffer on heap and writes symbol data into buffer.
+  // Allocates data buffer on heap and writes symbol data into buffer, or,
+  // if map_symbol_files() is true, maps the symbol file read-only.  Either
+  // way, the buffer is NUL-terminated.
   // Symbol supplier ALWAYS takes ownership of the data buffer.
   virtual SymbolResult GetCStringSymbolData(const CodeModule *module,
                                             const SystemInfo *system_info,
@@ -123,6 +152,46 @@ class SimpleSymbolSupplier : public SymbolSupplier {
   // Free the data buffer allocated in the above GetCStringSymbolData();
   virtual void FreeSymbolData(const CodeModule *module);
 
+  // If true, GetCStringSymbolData returns read-only mappings of the symbol
+  // files rather than heap copies.  The resolver loading them must not write
+  // to the buffer; both BasicSourceLineResolver and FastSourceLineResolver
+  // satisfy this.
+  void set_map_symbol_files(bool map_symbol_files) {
+    map_symbol_files_ = map_symbol_files;
+  }
+  bool map_symbol_files() const { return map_symbol_files_; }
+
+  // The ways in which a symbol file may be stored.
+  enum SymbolFileEncoding {
+    SYMBOL_FILE_PLAIN,  // module.sym, plain text
+    SYMBOL_FILE_GZIP    // module.sym.gz, gzip-compressed text
+  };
+
+  // Sets the encodings to look for, in order of preference.  Within each
+  // root path, the first encoding for which a symbol file exists is used.
+  void set_symbol_file_encodings(const vector<SymbolFileEncoding> &encodings) {
+    encodings_ = encodings;
+  }
+  const vector<SymbolFileEncoding> &symbol_file_encodings() const {
+    return encodings_;
+  }
+
+  // Receives the contents of a symbol file from ReadSymbolFile.
+  class SymbolDataSink {
+   public:
+    virtual ~SymbolDataSink() {}
+
+    // Accepts the next size bytes of the symbol file.  Returning false
+    // stops ReadSymbolFile, which then fails.
+    virtual bool Append(const char *data, size_t size) = 0;
+  };
+
+  // Reads the symbol file at path, decompressing it if its name has the
+  // extension of a compressed encoding, and passes its text to sink a
+  // piece at a time.  Returns false if the file cannot be read or decoded,
+  // or if sink rejects some of it.
+  static bool ReadSymbolFile(const string &path, SymbolDataSink *sink);
+
  protected:
   SymbolResult GetSymbolFileAtPathFromRoot(const CodeModule *module,
                                            const SystemInfo *system_info,
@@ -130,8 +199,43 @@ class SimpleSymbolSupplier : public SymbolSupplier {
                                            string *symbol_file);
 
  private:
-  map<string, char *> memory_buffers_;
+  // A buffer handed out by GetCStringSymbolData.  If mapped_size is zero,
+  // data was allocated with new[]; otherwise it is a mapping of that many
+  // bytes.
+  struct SymbolBuffer {
+    SymbolBuffer() : data(NULL), mapped_size(0) {}
+    SymbolBuffer(char *set_data, size_t set_mapped_size)
+        : data(set_data), mapped_size(set_mapped_size) {}
+    char *data;
+    size_t mapped_size;
+  };
+
+  // Records buffer as the one handed out for code_file.  A caller that
+  // asks for a module's symbols again is done with the buffer it was given
+  // before, so any buffer still held for code_file is released first.
+  void KeepSymbolBuffer(const string &code_file, const SymbolBuffer &buffer);
+
+  // Frees or unmaps buffer.
+  static void ReleaseSymbolBuffer(const SymbolBuffer &buffer);
+
+  // Maps the file at path read-only, followed by at least one zero byte.
+  // Returns NULL on failure, and always on Windows.
+  static char *MapSymbolFile(const string &path, size_t *mapped_size);
+
+  // Returns the extension, such as ".sym.gz", of symbol files stored with
+  // encoding.
+  static const char *SymbolFileExtension(SymbolFileEncoding encoding);
+
+  // Returns true if the symbol file at path is stored in an encoding that
+  // must be decoded before use.
+  static bool IsCompressedSymbolFile(const string &path);
+
+  static vector<SymbolFileEncoding> DefaultSymbolFileEncodings();
+
+  map<string, SymbolBuffer> memory_buffers_;
   vector<string> paths_;
+  bool map_symbol_files_;
+  vector<SymbolFileEncoding> encodings_;
 };
 
 }  // namespace google_breakpad
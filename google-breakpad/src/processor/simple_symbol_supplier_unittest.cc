@@ -0,0 +1,283 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// simple_symbol_supplier_unittest.cc: Unit tests for SimpleSymbolSupplier's
+// handling of compressed symbol files.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif  // HAVE_ZLIB
+
+#include <string>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/basic_code_module.h"
+#include "processor/scoped_ptr.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace {
+
+using google_breakpad::BasicCodeModule;
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::scoped_ptr;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::StackFrame;
+using google_breakpad::SymbolSupplier;
+using std::string;
+using std::vector;
+
+// Passes a symbol file on to a ModuleLoader as it is decompressed.
+class LoaderSink : public SimpleSymbolSupplier::SymbolDataSink {
+ public:
+  explicit LoaderSink(BasicSourceLineResolver::ModuleLoader *loader)
+      : loader_(loader) {}
+  virtual bool Append(const char *data, size_t size) {
+    return loader_->Append(data, size);
+  }
+
+ private:
+  BasicSourceLineResolver::ModuleLoader *loader_;
+};
+
+class TestSimpleSymbolSupplier : public ::testing::Test {
+ public:
+  TestSimpleSymbolSupplier()
+      : module(0x400000, 0x2d000, "c:\\test_app.exe", "",
+               "c:\\test_app.pdb", "5A9832E5287241C1838ED98914E9B7FF1", "") {}
+
+  void SetUp() {
+    string testdata_path = string(getenv("srcdir") ? getenv("srcdir") : ".") +
+                           "/src/processor/testdata/symbols";
+    ASSERT_TRUE(ReadFile(testdata_path +
+        "/test_app.pdb/5A9832E5287241C1838ED98914E9B7FF1/test_app.sym",
+        &symbol_text));
+
+    char root_template[] = "/tmp/simple-symbol-supplier-XXXXXX";
+    ASSERT_TRUE(mkdtemp(root_template));
+    root_path = root_template;
+    string directory = root_path + "/test_app.pdb";
+    ASSERT_EQ(0, mkdir(directory.c_str(), 0755));
+    directory += "/5A9832E5287241C1838ED98914E9B7FF1";
+    ASSERT_EQ(0, mkdir(directory.c_str(), 0755));
+    plain_file = directory + "/test_app.sym";
+    gzip_file = directory + "/test_app.sym.gz";
+  }
+
+  void TearDown() {
+    unlink(plain_file.c_str());
+    unlink(gzip_file.c_str());
+    rmdir((root_path +
+           "/test_app.pdb/5A9832E5287241C1838ED98914E9B7FF1").c_str());
+    rmdir((root_path + "/test_app.pdb").c_str());
+    rmdir(root_path.c_str());
+  }
+
+  static bool ReadFile(const string &path, string *contents) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+      return false;
+    char buffer[4096];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+      contents->append(buffer, size);
+    fclose(file);
+    return true;
+  }
+
+  static bool WriteFile(const string &path, const string &contents) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+      return false;
+    bool ok = fwrite(contents.data(), 1, contents.size(), file) ==
+              contents.size();
+    return fclose(file) == 0 && ok;
+  }
+
+#ifdef HAVE_ZLIB
+  static bool WriteGzipFile(const string &path, const string &contents) {
+    gzFile file = gzopen(path.c_str(), "wb");
+    if (!file)
+      return false;
+    bool ok = gzwrite(file, contents.data(), contents.size()) ==
+              static_cast<int>(contents.size());
+    return gzclose(file) == Z_OK && ok;
+  }
+#endif  // HAVE_ZLIB
+
+  // Returns the symbol data that supplier provides for module, or the
+  // empty string if it provides none.
+  string GetSymbolData(SimpleSymbolSupplier *supplier, string *symbol_file) {
+    char *symbol_data;
+    if (supplier->GetCStringSymbolData(&module, NULL, symbol_file,
+                                       &symbol_data) != SymbolSupplier::FOUND)
+      return string();
+    string result(symbol_data);
+    supplier->FreeSymbolData(&module);
+    return result;
+  }
+
+  BasicCodeModule module;
+  string symbol_text;
+  string root_path;
+  string plain_file;
+  string gzip_file;
+};
+
+#ifdef HAVE_ZLIB
+TEST_F(TestSimpleSymbolSupplier, FindsCompressedFile) {
+  ASSERT_TRUE(WriteGzipFile(gzip_file, symbol_text));
+
+  SimpleSymbolSupplier supplier(root_path);
+  string symbol_file;
+  EXPECT_EQ(symbol_text, GetSymbolData(&supplier, &symbol_file));
+  EXPECT_EQ(gzip_file, symbol_file);
+
+  // Compressed files can't be mapped, but are still supplied when mapping
+  // is requested.
+  supplier.set_map_symbol_files(true);
+  EXPECT_EQ(symbol_text, GetSymbolData(&supplier, &symbol_file));
+  EXPECT_EQ(gzip_file, symbol_file);
+
+  string symbol_data;
+  EXPECT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file, &symbol_data));
+  EXPECT_EQ(symbol_text, symbol_data);
+}
+
+TEST_F(TestSimpleSymbolSupplier, EncodingOrder) {
+  // Give the two files different contents, to tell which one was used.
+  ASSERT_TRUE(WriteFile(plain_file, symbol_text));
+  string gzip_text = symbol_text.substr(0, symbol_text.find('\n') + 1);
+  ASSERT_TRUE(WriteGzipFile(gzip_file, gzip_text));
+
+  SimpleSymbolSupplier supplier(root_path);
+  string symbol_file;
+  EXPECT_EQ(symbol_text, GetSymbolData(&supplier, &symbol_file));
+  EXPECT_EQ(plain_file, symbol_file);
+
+  vector<SimpleSymbolSupplier::SymbolFileEncoding> encodings;
+  encodings.push_back(SimpleSymbolSupplier::SYMBOL_FILE_GZIP);
+  encodings.push_back(SimpleSymbolSupplier::SYMBOL_FILE_PLAIN);
+  supplier.set_symbol_file_encodings(encodings);
+  EXPECT_EQ(gzip_text, GetSymbolData(&supplier, &symbol_file));
+  EXPECT_EQ(gzip_file, symbol_file);
+
+  // Encodings left out of the list are not looked for.
+  encodings.resize(1);
+  supplier.set_symbol_file_encodings(encodings);
+  unlink(gzip_file.c_str());
+  EXPECT_EQ("", GetSymbolData(&supplier, &symbol_file));
+}
+
+TEST_F(TestSimpleSymbolSupplier, CorruptCompressedFile) {
+  // A truncated gzip stream must not be supplied as if it were complete.
+  string compressed;
+  ASSERT_TRUE(WriteGzipFile(gzip_file, symbol_text));
+  ASSERT_TRUE(ReadFile(gzip_file, &compressed));
+  ASSERT_TRUE(WriteFile(gzip_file, compressed.substr(0,
+                                                     compressed.size() / 2)));
+
+  SimpleSymbolSupplier supplier(root_path);
+  string symbol_file;
+  EXPECT_EQ("", GetSymbolData(&supplier, &symbol_file));
+}
+
+TEST_F(TestSimpleSymbolSupplier, ConcatenatedCompressedFile) {
+  // The trailer of a file of several gzip streams gives only the last
+  // one's size, so the supplier's buffer must grow to fit the rest.
+  size_t split = symbol_text.size() / 3;
+  string first, second;
+  ASSERT_TRUE(WriteGzipFile(gzip_file, symbol_text.substr(0, split)));
+  ASSERT_TRUE(ReadFile(gzip_file, &first));
+  ASSERT_TRUE(WriteGzipFile(gzip_file, symbol_text.substr(split)));
+  ASSERT_TRUE(ReadFile(gzip_file, &second));
+  ASSERT_TRUE(WriteFile(gzip_file, first + second));
+
+  SimpleSymbolSupplier supplier(root_path);
+  string symbol_file;
+  EXPECT_EQ(symbol_text, GetSymbolData(&supplier, &symbol_file));
+}
+
+TEST_F(TestSimpleSymbolSupplier, StreamIntoResolver) {
+  ASSERT_TRUE(WriteGzipFile(gzip_file, symbol_text));
+
+  BasicSourceLineResolver resolver;
+  scoped_ptr<BasicSourceLineResolver::ModuleLoader> loader(
+      resolver.StartModuleLoad(&module));
+  ASSERT_TRUE(loader.get());
+  LoaderSink sink(loader.get());
+  ASSERT_TRUE(SimpleSymbolSupplier::ReadSymbolFile(gzip_file, &sink));
+  ASSERT_TRUE(loader->Finish());
+
+  StackFrame frame;
+  frame.instruction = 0x401060;
+  frame.module = &module;
+  resolver.FillSourceLineInfo(&frame);
+  EXPECT_EQ("std::bad_alloc::bad_alloc(char const *)", frame.function_name);
+  EXPECT_EQ(371, frame.source_line);
+}
+#else  // HAVE_ZLIB
+TEST_F(TestSimpleSymbolSupplier, IgnoresCompressedFileWithoutZlib) {
+  // Without zlib, a .sym.gz file is never supplied, even when asked for.
+  ASSERT_TRUE(WriteFile(gzip_file, "not really gzip"));
+
+  SimpleSymbolSupplier supplier(root_path);
+  vector<SimpleSymbolSupplier::SymbolFileEncoding> encodings;
+  encodings.push_back(SimpleSymbolSupplier::SYMBOL_FILE_GZIP);
+  supplier.set_symbol_file_encodings(encodings);
+  string symbol_file;
+  EXPECT_EQ("", GetSymbolData(&supplier, &symbol_file));
+
+  ASSERT_TRUE(WriteFile(plain_file, symbol_text));
+  encodings.push_back(SimpleSymbolSupplier::SYMBOL_FILE_PLAIN);
+  supplier.set_symbol_file_encodings(encodings);
+  EXPECT_EQ(symbol_text, GetSymbolData(&supplier, &symbol_file));
+  EXPECT_EQ(plain_file, symbol_file);
+}
+#endif  // HAVE_ZLIB
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
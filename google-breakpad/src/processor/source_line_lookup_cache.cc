@@ -0,0 +1,167 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// source_line_lookup_cache.cc: Implement
+// google_breakpad::SourceLineLookupCache.  See source_line_lookup_cache.h.
+
+#include "processor/source_line_lookup_cache.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/stack_frame.h"
+
+namespace google_breakpad {
+
+// Names are usually a few dozen bytes, and most modules see only a handful
+// of distinct lookups, so use small slabs.
+static const size_t kNameSlabSize = 4096;
+
+// Don't bother rebuilding the names until they fill a few slabs.
+static const size_t kMinNameLimit = 4 * kNameSlabSize;
+
+SourceLineLookupCache::SourceLineLookupCache(size_t capacity)
+    : lock_(),
+      entries_(),
+      shift_(64),
+      arena_(new Arena(kNameSlabSize)),
+      names_(new StringPool(arena_.get())),
+      name_limit_(kMinNameLimit),
+      hits_(0),
+      misses_(0) {
+  size_t rounded = 2;
+  --shift_;
+  while (rounded < capacity) {
+    rounded *= 2;
+    --shift_;
+  }
+  Entry empty = { 0, FIELD_NONE, NULL, NULL, 0, 0, 0 };
+  entries_.assign(rounded, empty);
+}
+
+SourceLineLookupCache::Entry *SourceLineLookupCache::Slot(u_int64_t key) {
+  // Fibonacci hashing: return offsets within a module share their low
+  // bits far less than their high ones, so take the product's top bits.
+  return &entries_[(key * 0x9e3779b97f4a7c15ULL) >> shift_];
+}
+
+bool SourceLineLookupCache::Lookup(StackFrame *frame) {
+  u_int64_t base_address = frame->module->base_address();
+  u_int64_t key = frame->instruction - base_address + 1;
+
+  ScopedMutexLock lock(&lock_);
+  const Entry *entry = Slot(key);
+  if (entry->key != key) {
+    ++misses_;
+    return false;
+  }
+  ++hits_;
+
+  if (entry->filled & FIELD_FUNCTION) {
+    frame->function_name = entry->function_name;
+    frame->function_base = base_address + entry->function_base;
+  }
+  if (entry->filled & FIELD_SOURCE_FILE_NAME)
+    frame->source_file_name = entry->source_file_name;
+  if (entry->filled & FIELD_SOURCE_LINE) {
+    frame->source_line = entry->source_line;
+    frame->source_line_base = base_address + entry->source_line_base;
+  }
+  return true;
+}
+
+void SourceLineLookupCache::Store(const StackFrame &frame, int filled) {
+  u_int64_t base_address = frame.module->base_address();
+  u_int64_t key = frame.instruction - base_address + 1;
+  // The one offset whose key would be zero can't be cached.
+  if (key == 0)
+    return;
+
+  ScopedMutexLock lock(&lock_);
+  Entry *entry = Slot(key);
+  entry->key = key;
+  entry->filled = filled;
+  entry->function_name = NULL;
+  entry->source_file_name = NULL;
+  if (filled & FIELD_FUNCTION) {
+    entry->function_name = names_->Intern(frame.function_name.data(),
+                                          frame.function_name.size());
+    entry->function_base = frame.function_base - base_address;
+  }
+  if (filled & FIELD_SOURCE_FILE_NAME) {
+    entry->source_file_name = names_->Intern(frame.source_file_name.data(),
+                                             frame.source_file_name.size());
+  }
+  if (filled & FIELD_SOURCE_LINE) {
+    entry->source_line = frame.source_line;
+    entry->source_line_base = frame.source_line_base - base_address;
+  }
+
+  if (arena_->slab_bytes() > name_limit_)
+    RebuildNames();
+}
+
+void SourceLineLookupCache::RebuildNames() {
+  scoped_ptr<Arena> arena(new Arena(kNameSlabSize));
+  scoped_ptr<StringPool> names(new StringPool(arena.get()));
+  for (size_t index = 0; index < entries_.size(); ++index) {
+    Entry *entry = &entries_[index];
+    if (entry->function_name) {
+      entry->function_name = names->Intern(entry->function_name,
+                                           strlen(entry->function_name));
+    }
+    if (entry->source_file_name) {
+      entry->source_file_name = names->Intern(entry->source_file_name,
+                                              strlen(entry->source_file_name));
+    }
+  }
+
+  // The old pool and arena are freed on return, the pool first.
+  names_.swap(names);
+  arena_.swap(arena);
+
+  // Let the names grow to twice their current size before the next
+  // rebuild, so that rebuilding costs a constant amount per name stored.
+  name_limit_ = std::max(kMinNameLimit, 2 * arena_->slab_bytes());
+}
+
+size_t SourceLineLookupCache::name_bytes() {
+  ScopedMutexLock lock(&lock_);
+  return arena_->slab_bytes();
+}
+
+void SourceLineLookupCache::AddStats(u_int64_t *hits, u_int64_t *misses) {
+  ScopedMutexLock lock(&lock_);
+  *hits += hits_;
+  *misses += misses_;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,148 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// source_line_lookup_cache.h: A bounded, thread-safe cache of the results
+// of looking up addresses in a module's symbols.
+//
+// The same return addresses (thread entry points, event loops, lock
+// primitives) appear in nearly every thread of every minidump, and each
+// time SourceLineResolverBase::FillSourceLineInfo searches the module's
+// functions and lines for them again.  SourceLineLookupCache remembers the
+// result of each lookup, keyed by the address's offset within the module,
+// so that repeated addresses are answered from a single table probe.
+//
+// The cache is direct-mapped: each offset has exactly one slot it may
+// occupy, and a new result replaces whatever was in its slot, so the
+// cache's size never exceeds the capacity it was created with.  Function
+// and file names are interned, so each distinct name is stored once no
+// matter how many cached results refer to it.  Replaced results leave
+// their names behind, so once the names take up twice the space they did
+// after the last rebuild, the cache copies the ones still in use to fresh
+// storage and frees the rest.  The names held are thus bounded by those
+// of the cached results, not by the number of results ever stored.
+
+#ifndef PROCESSOR_SOURCE_LINE_LOOKUP_CACHE_H__
+#define PROCESSOR_SOURCE_LINE_LOOKUP_CACHE_H__
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "google_breakpad/common/breakpad_types.h"
+#include "processor/arena.h"
+#include "processor/mutex.h"
+#include "processor/scoped_ptr.h"
+
+namespace google_breakpad {
+
+struct StackFrame;
+
+class SourceLineLookupCache {
+ public:
+  // The parts of a StackFrame that a lookup may fill in, as bits of a mask.
+  enum Field {
+    FIELD_NONE = 0,
+    FIELD_FUNCTION = 1,          // function_name and function_base
+    FIELD_SOURCE_FILE_NAME = 2,  // source_file_name
+    FIELD_SOURCE_LINE = 4        // source_line and source_line_base
+  };
+
+  // Creates a cache of at least capacity entries; the capacity is rounded
+  // up to a power of two.
+  explicit SourceLineLookupCache(size_t capacity);
+
+  // If the result of looking up the offset of frame->instruction from
+  // frame->module is cached, fills frame in from it, as the lookup did,
+  // and returns true.  Otherwise, returns false and leaves frame alone.
+  bool Lookup(StackFrame *frame);
+
+  // Caches the result of looking up frame->instruction within
+  // frame->module, which the caller has just filled in to frame.  filled
+  // is a mask of Field values for the parts of frame the lookup filled in;
+  // Lookup fills in only those.
+  void Store(const StackFrame &frame, int filled);
+
+  // Adds the number of calls to Lookup that returned true and false so
+  // far to *hits and *misses.
+  void AddStats(u_int64_t *hits, u_int64_t *misses);
+
+  // Returns the number of bytes held for the cached results' names.
+  size_t name_bytes();
+
+  size_t capacity() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    // The offset of the looked-up address from the module's base address,
+    // plus one, so that zero marks an empty slot.
+    u_int64_t key;
+
+    // A mask of Field values for the parts of the frame the lookup filled
+    // in.  The fields below for the other parts are unused.
+    int filled;
+
+    // What the lookup found.  Bases are offsets within the module, since
+    // the module may be loaded at a different address in the next dump.
+    const char *function_name;
+    const char *source_file_name;
+    u_int64_t function_base;
+    u_int64_t source_line_base;
+    int source_line;
+  };
+
+  // Returns the slot that the result for KEY may occupy.
+  Entry *Slot(u_int64_t key);
+
+  // Moves the names that entries_ refer to into a new arena, and frees
+  // the old one along with the names of replaced results.
+  void RebuildNames();
+
+  // Guards everything below.
+  Mutex lock_;
+
+  std::vector<Entry> entries_;
+  int shift_;
+
+  // names_ interns names in arena_.  Once arena_ holds more than
+  // name_limit_ bytes, Store calls RebuildNames.
+  scoped_ptr<Arena> arena_;
+  scoped_ptr<StringPool> names_;
+  size_t name_limit_;
+
+  u_int64_t hits_;
+  u_int64_t misses_;
+
+  // Disallow copy ctor and assignment operator
+  SourceLineLookupCache(const SourceLineLookupCache&);
+  void operator=(const SourceLineLookupCache&);
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_SOURCE_LINE_LOOKUP_CACHE_H__
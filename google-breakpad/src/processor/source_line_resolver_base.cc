@@ -38,15 +38,19 @@
 #include <string.h>
 #include <sys/stat.h>
 
+#include <algorithm>
 #include <map>
 #include <utility>
 
 #include "google_breakpad/processor/source_line_resolver_base.h"
 #include "processor/source_line_resolver_base_types.h"
 #include "processor/module_factory.h"
+#include "processor/mutex.h"
 
 using std::map;
 using std::make_pair;
+using std::pair;
+using std::sort;
 
 namespace google_breakpad {
 
@@ -54,7 +58,14 @@ SourceLineResolverBase::SourceLineResolverBase(
     ModuleFactory *module_factory)
   : modules_(new ModuleMap),
     memory_buffers_(new MemoryMap),
-    module_factory_(module_factory) {
+    module_factory_(module_factory),
+    modules_lock_(new Mutex),
+    loading_modules_(new set<string>),
+    module_loaded_(new ConditionVariable),
+    use_count_(0),
+    lookup_cache_capacity_(kDefaultLookupCacheCapacity),
+    unloaded_lookup_hits_(0),
+    unloaded_lookup_misses_(0) {
 }
 
 SourceLineResolverBase::~SourceLineResolverBase() {
@@ -75,6 +86,10 @@ SourceLineResolverBase::~SourceLineResolverBase() {
   delete memory_buffers_;
 
   delete module_factory_;
+
+  delete module_loaded_;
+  delete loading_modules_;
+  delete modules_lock_;
 }
 
 bool SourceLineResolverBase::ReadSymbolFile(char **symbol_data,
@@ -144,7 +159,7 @@ bool SourceLineResolverBase::LoadModule(const CodeModule *module,
     return false;
 
   // Make sure we don't already have a module with the given name.
-  if (modules_->find(module->code_file()) != modules_->end()) {
+  if (GetLoadedModule(module->code_file())) {
     BPLOG(INFO) << "Symbols for module " << module->code_file()
                 << " already loaded";
     return false;
@@ -163,6 +178,7 @@ bool SourceLineResolverBase::LoadModule(const CodeModule *module,
 
   if (load_result && !ShouldDeleteMemoryBufferAfterLoadModule()) {
     // memory_buffer has to stay alive as long as the module.
+    ScopedMutexLock lock(modules_lock_);
     memory_buffers_->insert(make_pair(module->code_file(), memory_buffer));
   } else {
     delete [] memory_buffer;
@@ -177,7 +193,7 @@ bool SourceLineResolverBase::LoadModuleUsingMapBuffer(
     return false;
 
   // Make sure we don't already have a module with the given name.
-  if (modules_->find(module->code_file()) != modules_->end()) {
+  if (GetLoadedModule(module->code_file())) {
     BPLOG(INFO) << "Symbols for module " << module->code_file()
                 << " already loaded";
     return false;
@@ -197,6 +213,7 @@ bool SourceLineResolverBase::LoadModuleUsingMapBuffer(
 
   if (load_result && !ShouldDeleteMemoryBufferAfterLoadModule()) {
     // memory_buffer has to stay alive as long as the module.
+    ScopedMutexLock lock(modules_lock_);
     memory_buffers_->insert(make_pair(module->code_file(), memory_buffer));
   } else {
     delete [] memory_buffer;
@@ -210,12 +227,8 @@ bool SourceLineResolverBase::LoadModuleUsingMemoryBuffer(
   if (!module)
     return false;
 
-  // Make sure we don't already have a module with the given name.
-  if (modules_->find(module->code_file()) != modules_->end()) {
-    BPLOG(INFO) << "Symbols for module " << module->code_file()
-                << " already loaded";
+  if (!BeginModuleLoad(module->code_file()))
     return false;
-  }
 
   BPLOG(INFO) << "Loading symbols for module " << module->code_file()
              << " from memory buffer";
@@ -223,15 +236,53 @@ bool SourceLineResolverBase::LoadModuleUsingMemoryBuffer(
   Module *basic_module = module_factory_->CreateModule(module->code_file());
 
   // Ownership of memory is NOT transfered to Module::LoadMapFromMemory().
-  if (!basic_module->LoadMapFromMemory(memory_buffer)) {
+  bool load_result = basic_module->LoadMapFromMemory(memory_buffer);
+  if (!load_result) {
     delete basic_module;
+    basic_module = NULL;
+  }
+
+  EndModuleLoad(module->code_file(), module->debug_identifier(),
+                basic_module);
+  return load_result;
+}
+
+bool SourceLineResolverBase::BeginModuleLoad(const string &code_file) {
+  ScopedMutexLock lock(modules_lock_);
+
+  // If another thread is loading this module, wait for it to finish.
+  while (loading_modules_->find(code_file) != loading_modules_->end())
+    module_loaded_->Wait(modules_lock_);
+
+  // Make sure we don't already have a module with the given name.
+  if (modules_->find(code_file) != modules_->end()) {
+    BPLOG(INFO) << "Symbols for module " << code_file << " already loaded";
     return false;
   }
 
-  modules_->insert(make_pair(module->code_file(), basic_module));
+  // Parse without holding the lock, so that lookups in other modules and
+  // loads of other modules can proceed meanwhile.
+  loading_modules_->insert(code_file);
   return true;
 }
 
+void SourceLineResolverBase::EndModuleLoad(const string &code_file,
+                                           const string &debug_identifier,
+                                           Module *module) {
+  ScopedMutexLock lock(modules_lock_);
+  if (module) {
+    module->last_use_ = ++use_count_;
+    module->debug_identifier_ = debug_identifier;
+    if (lookup_cache_capacity_) {
+      module->lookup_cache_.reset(
+          new SourceLineLookupCache(lookup_cache_capacity_));
+    }
+    modules_->insert(make_pair(code_file, module));
+  }
+  loading_modules_->erase(code_file);
+  module_loaded_->Broadcast();
+}
+
 bool SourceLineResolverBase::ShouldDeleteMemoryBufferAfterLoadModule() {
   return true;
 }
@@ -240,9 +291,22 @@ void SourceLineResolverBase::UnloadModule(const CodeModule *code_module) {
   if (!code_module)
     return;
 
-  ModuleMap::iterator iter = modules_->find(code_module->code_file());
+  ScopedMutexLock lock(modules_lock_);
+  while (loading_modules_->find(code_module->code_file()) !=
+         loading_modules_->end()) {
+    module_loaded_->Wait(modules_lock_);
+  }
+  UnloadModuleLocked(code_module->code_file());
+}
+
+void SourceLineResolverBase::UnloadModuleLocked(const string &code_file) {
+  ModuleMap::iterator iter = modules_->find(code_file);
   if (iter != modules_->end()) {
     Module *symbol_module = iter->second;
+    if (symbol_module->lookup_cache_.get()) {
+      symbol_module->lookup_cache_->AddStats(&unloaded_lookup_hits_,
+                                             &unloaded_lookup_misses_);
+    }
     delete symbol_module;
     modules_->erase(iter);
   }
@@ -251,7 +315,7 @@ void SourceLineResolverBase::UnloadModule(const CodeModule *code_module) {
     // No-op.  Because we never store any memory buffers.
   } else {
     // There may be a buffer stored locally, we need to find and delete it.
-    MemoryMap::iterator iter = memory_buffers_->find(code_module->code_file());
+    MemoryMap::iterator iter = memory_buffers_->find(code_file);
     if (iter != memory_buffers_->end()) {
       delete [] iter->second;
       memory_buffers_->erase(iter);
@@ -259,17 +323,86 @@ void SourceLineResolverBase::UnloadModule(const CodeModule *code_module) {
   }
 }
 
+size_t SourceLineResolverBase::LoadedSymbolDataSize() {
+  ScopedMutexLock lock(modules_lock_);
+  size_t total_size = 0;
+  for (ModuleMap::const_iterator it = modules_->begin();
+       it != modules_->end(); ++it) {
+    total_size += it->second->SymbolDataSize();
+  }
+  return total_size;
+}
+
+void SourceLineResolverBase::UnloadLeastRecentlyUsedModules(
+    size_t max_size, vector<string> *unloaded_code_files) {
+  ScopedMutexLock lock(modules_lock_);
+  size_t total_size = 0;
+  vector<pair<u_int64_t, string> > modules_by_use;
+  for (ModuleMap::const_iterator it = modules_->begin();
+       it != modules_->end(); ++it) {
+    total_size += it->second->SymbolDataSize();
+    modules_by_use.push_back(make_pair(it->second->last_use_, it->first));
+  }
+  if (total_size <= max_size)
+    return;
+
+  sort(modules_by_use.begin(), modules_by_use.end());
+  for (vector<pair<u_int64_t, string> >::const_iterator it =
+           modules_by_use.begin();
+       it != modules_by_use.end() && total_size > max_size; ++it) {
+    const string &code_file = it->second;
+    total_size -= (*modules_)[code_file]->SymbolDataSize();
+    BPLOG(INFO) << "Unloading symbols for module " << code_file;
+    UnloadModuleLocked(code_file);
+    if (unloaded_code_files)
+      unloaded_code_files->push_back(code_file);
+  }
+}
+
+void SourceLineResolverBase::set_lookup_cache_capacity(size_t capacity) {
+  ScopedMutexLock lock(modules_lock_);
+  lookup_cache_capacity_ = capacity;
+}
+
+void SourceLineResolverBase::GetLookupCacheStats(u_int64_t *hits,
+                                                 u_int64_t *misses) {
+  ScopedMutexLock lock(modules_lock_);
+  *hits += unloaded_lookup_hits_;
+  *misses += unloaded_lookup_misses_;
+  for (ModuleMap::const_iterator it = modules_->begin();
+       it != modules_->end(); ++it) {
+    if (it->second->lookup_cache_.get())
+      it->second->lookup_cache_->AddStats(hits, misses);
+  }
+}
+
 bool SourceLineResolverBase::HasModule(const CodeModule *module) {
   if (!module)
     return false;
-  return modules_->find(module->code_file()) != modules_->end();
+  Module *loaded_module = GetLoadedModule(module->code_file());
+  return loaded_module &&
+         loaded_module->debug_identifier_ == module->debug_identifier();
 }
 
 void SourceLineResolverBase::FillSourceLineInfo(StackFrame *frame) {
   if (frame->module) {
-    ModuleMap::const_iterator it = modules_->find(frame->module->code_file());
-    if (it != modules_->end()) {
-      it->second->LookupAddress(frame);
+    Module *module = GetLoadedModule(frame->module->code_file());
+    if (module) {
+      // The cache records the fields a lookup fills in, so it can only
+      // stand in for lookups into frames that have none filled in yet,
+      // which is the usual case.
+      SourceLineLookupCache *cache = module->lookup_cache_.get();
+      bool cacheable = cache &&
+                       frame->function_name.empty() &&
+                       frame->function_base == 0 &&
+                       frame->source_file_name.empty() &&
+                       frame->source_line == 0 &&
+                       frame->source_line_base == 0;
+      if (cacheable && cache->Lookup(frame))
+        return;
+      int filled = module->LookupAddress(frame);
+      if (cacheable)
+        cache->Store(*frame, filled);
     }
   }
 }
@@ -277,9 +410,9 @@ void SourceLineResolverBase::FillSourceLineInfo(StackFrame *frame) {
 WindowsFrameInfo *SourceLineResolverBase::FindWindowsFrameInfo(
     const StackFrame *frame) {
   if (frame->module) {
-    ModuleMap::const_iterator it = modules_->find(frame->module->code_file());
-    if (it != modules_->end()) {
-      return it->second->FindWindowsFrameInfo(frame);
+    Module *module = GetLoadedModule(frame->module->code_file());
+    if (module) {
+      return module->FindWindowsFrameInfo(frame);
     }
   }
   return NULL;
@@ -288,14 +421,27 @@ WindowsFrameInfo *SourceLineResolverBase::FindWindowsFrameInfo(
 CFIFrameInfo *SourceLineResolverBase::FindCFIFrameInfo(
     const StackFrame *frame) {
   if (frame->module) {
-    ModuleMap::const_iterator it = modules_->find(frame->module->code_file());
-    if (it != modules_->end()) {
-      return it->second->FindCFIFrameInfo(frame);
+    Module *module = GetLoadedModule(frame->module->code_file());
+    if (module) {
+      return module->FindCFIFrameInfo(frame);
     }
   }
   return NULL;
 }
 
+SourceLineResolverBase::Module *SourceLineResolverBase::GetLoadedModule(
+    const string &code_file) {
+  ScopedMutexLock lock(modules_lock_);
+  while (loading_modules_->find(code_file) != loading_modules_->end())
+    module_loaded_->Wait(modules_lock_);
+
+  ModuleMap::const_iterator it = modules_->find(code_file);
+  if (it == modules_->end())
+    return NULL;
+  it->second->last_use_ = ++use_count_;
+  return it->second;
+}
+
 bool SourceLineResolverBase::CompareString::operator()(
     const string &s1, const string &s2) const {
   return strcmp(s1.c_str(), s2.c_str()) < 0;
@@ -308,4 +454,26 @@ bool SourceLineResolverBase::Module::ParseCFIRuleSet(
   return parser.Parse(rule_set);
 }
 
+CFIFrameInfo *SourceLineResolverBase::Module::FindCachedCFIFrameInfo(
+    MemAddr key) const {
+  ScopedMutexLock lock(&cache_lock_);
+  CFIFrameInfoCache::const_iterator it = cfi_frame_info_cache_.find(key);
+  if (it == cfi_frame_info_cache_.end())
+    return NULL;
+  return new CFIFrameInfo(it->second.get());
+}
+
+CFIFrameInfo *SourceLineResolverBase::Module::CacheCFIFrameInfo(
+    MemAddr key, CFIFrameInfo *frame_info) const {
+  frame_info->Compile();
+  ScopedMutexLock lock(&cache_lock_);
+  // If another thread cached this rule set first, keep its copy.
+  linked_ptr<CFIFrameInfo> &cached = cfi_frame_info_cache_[key];
+  if (!cached.get())
+    cached = linked_ptr<CFIFrameInfo>(frame_info);
+  else
+    delete frame_info;
+  return new CFIFrameInfo(cached.get());
+}
+
 }  // namespace google_breakpad
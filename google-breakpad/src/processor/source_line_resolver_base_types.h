@@ -46,6 +46,10 @@
 #include "google_breakpad/processor/source_line_resolver_base.h"
 #include "google_breakpad/processor/stack_frame.h"
 #include "processor/cfi_frame_info.h"
+#include "processor/linked_ptr.h"
+#include "processor/mutex.h"
+#include "processor/scoped_ptr.h"
+#include "processor/source_line_lookup_cache.h"
 #include "processor/windows_frame_info.h"
 
 #ifndef PROCESSOR_SOURCE_LINE_RESOLVER_BASE_TYPES_H__
@@ -116,6 +120,7 @@ struct SourceLineResolverBase::PublicSymbol {
 
 class SourceLineResolverBase::Module {
  public:
+  Module() : last_use_(0) { }
   virtual ~Module() { };
   // Loads a map from the given buffer in char* type.
   // Does NOT take ownership of memory_buffer (the caller, source line resolver,
@@ -123,8 +128,9 @@ class SourceLineResolverBase::Module {
   virtual bool LoadMapFromMemory(char *memory_buffer) = 0;
 
   // Looks up the given relative address, and fills the StackFrame struct
-  // with the result.
-  virtual void LookupAddress(StackFrame *frame) const = 0;
+  // with the result.  Returns a mask of SourceLineLookupCache::Field values
+  // for the parts of frame it filled in.
+  virtual int LookupAddress(StackFrame *frame) const = 0;
 
   // If Windows stack walking information is available covering ADDRESS,
   // return a WindowsFrameInfo structure describing it. If the information
@@ -139,9 +145,56 @@ class SourceLineResolverBase::Module {
   // is not available, return NULL. The caller takes ownership of any
   // returned CFIFrameInfo object.
   virtual CFIFrameInfo *FindCFIFrameInfo(const StackFrame *frame) const = 0;
+
+  // Returns the size in bytes of the symbol data the module was loaded
+  // from.
+  virtual size_t SymbolDataSize() const = 0;
+
  protected:
   virtual bool ParseCFIRuleSet(const string &rule_set,
                                CFIFrameInfo *frame_info) const;
+
+  // The STACK CFI rules in effect at an address are those of the covering
+  // STACK CFI INIT record, updated by the delta records up to the address,
+  // so every address sharing the same last-applied record shares a rule set.
+  // FindCFIFrameInfo implementations cache rule sets, compiled, keyed by the
+  // address of that record, so that each is parsed only once.  The cache
+  // holds at most one entry per STACK CFI or STACK CFI INIT record that a
+  // lookup has reached, and lives as long as the module.
+  //
+  // The CFIFrameInfo objects these return are owned by the caller but
+  // refer to the cached rule set instead of copying it, so the caller must
+  // delete them before the module is unloaded.
+
+  // If a rule set is cached under KEY, return a new CFIFrameInfo using it.
+  // Otherwise, return NULL.
+  CFIFrameInfo *FindCachedCFIFrameInfo(MemAddr key) const;
+
+  // Compile FRAME_INFO and cache it under KEY, taking ownership of it.
+  // Return a new CFIFrameInfo using it.
+  CFIFrameInfo *CacheCFIFrameInfo(MemAddr key, CFIFrameInfo *frame_info) const;
+
+  // Lookups may run on several threads at once.  Any state that a const
+  // lookup fills in lazily, such as the caches above or compiled program
+  // strings, must only be touched while holding cache_lock_.
+  mutable Mutex cache_lock_;
+
+ private:
+  typedef map<MemAddr, linked_ptr<CFIFrameInfo> > CFIFrameInfoCache;
+  mutable CFIFrameInfoCache cfi_frame_info_cache_;
+
+  // The resolver's use count when the module was last looked up.
+  u_int64_t last_use_;
+
+  // The debug_identifier of the build whose symbols were loaded.  Set by
+  // SourceLineResolverBase::EndModuleLoad.
+  string debug_identifier_;
+
+  // Remembers the results of LookupAddress, or NULL if the resolver's
+  // lookup cache was disabled when the module was loaded.  Set by
+  // SourceLineResolverBase::EndModuleLoad.
+  scoped_ptr<SourceLineLookupCache> lookup_cache_;
+  friend class SourceLineResolverBase;
 };
 
 }  // namespace google_breakpad
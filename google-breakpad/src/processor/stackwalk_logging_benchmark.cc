@@ -0,0 +1,217 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// stackwalk_logging_benchmark.cc: Measures what INFO logging costs while
+// processing a minidump whose stacks are recovered by scanning.
+//
+// BasicCodeModules::GetModuleForAddress logs "No module at" at INFO
+// severity whenever an address falls outside every module, as instruction
+// addresses do in JIT code and as candidate return addresses do while
+// scanning.  The benchmark times such misses against the module list of
+// the minidump, and then processes the whole minidump repeatedly, without
+// symbols so that frames are found by frame pointers and scanning.  Each
+// is run once with INFO messages enabled and once with
+// LogStream::minimum_severity() raised to SEVERITY_ERROR.  Enabled
+// messages are formatted into a stream that discards them, so the
+// difference is the cost of building and formatting the messages, not of
+// writing them to a terminal or file.  A compile-time threshold
+// (-DBPLOG_MINIMUM_SEVERITY=SEVERITY_ERROR) removes the remaining
+// comparison as well.
+//
+// Usage: stackwalk_logging_benchmark [iterations [minidump-file]]
+// The minidump defaults to src/processor/testdata/stack_exhaustion.dmp.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_state.h"
+#include "processor/logging.h"
+
+namespace {
+
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CodeModules;
+using google_breakpad::LogStream;
+using google_breakpad::MinidumpProcessor;
+using google_breakpad::ProcessState;
+using std::streambuf;
+using std::string;
+
+const int kDefaultIterations = 200;
+const int kLookupCount = 200000;
+
+double Now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+// A stream buffer that counts and discards what is written to it.
+class CountingNullBuffer : public streambuf {
+ public:
+  CountingNullBuffer() : bytes_(0) {}
+  u_int64_t bytes() const { return bytes_; }
+
+ protected:
+  virtual int overflow(int c) {
+    ++bytes_;
+    return c == EOF ? 0 : c;
+  }
+  virtual std::streamsize xsputn(const char *s, std::streamsize n) {
+    bytes_ += n;
+    return n;
+  }
+
+ private:
+  u_int64_t bytes_;
+};
+
+// Sends std::clog and std::cerr to a CountingNullBuffer while in scope.
+class ScopedDiscardLog {
+ public:
+  ScopedDiscardLog()
+      : saved_clog_(std::clog.rdbuf(&buffer_)),
+        saved_cerr_(std::cerr.rdbuf(&buffer_)) {}
+  ~ScopedDiscardLog() {
+    std::clog.rdbuf(saved_clog_);
+    std::cerr.rdbuf(saved_cerr_);
+  }
+  u_int64_t bytes() const { return buffer_.bytes(); }
+
+ private:
+  CountingNullBuffer buffer_;
+  streambuf *saved_clog_;
+  streambuf *saved_cerr_;
+};
+
+// Looks up kLookupCount addresses below every module in |modules|, and
+// prints the time and bytes logged per lookup.
+void RunLookups(const char *label, const CodeModules *modules,
+                u_int64_t lowest_base) {
+  ScopedDiscardLog log;
+  int found = 0;
+  double start = Now();
+  for (int i = 0; i < kLookupCount; ++i) {
+    if (modules->GetModuleForAddress((lowest_base / kLookupCount) * i))
+      ++found;
+  }
+  double elapsed = Now() - start;
+  printf("%-18s %8.1f ns/lookup  %6d found  %9.1f log bytes/lookup\n",
+         label, elapsed / kLookupCount * 1e9, found,
+         static_cast<double>(log.bytes()) / kLookupCount);
+}
+
+// Processes |minidump_file| |iterations| times, and prints the time per
+// pass and the number of bytes logged per pass.  Returns false if the
+// minidump can't be processed.
+bool Run(const char *label, const string &minidump_file, int iterations) {
+  ScopedDiscardLog log;
+
+  // No symbols: every frame after the context frame comes from scanning.
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(NULL, &resolver);
+  ProcessState process_state;
+  size_t frame_count = 0;
+  bool ok = true;
+  double start = Now();
+  for (int i = 0; i < iterations && ok; ++i) {
+    ok = processor.Process(minidump_file, &process_state) ==
+         google_breakpad::PROCESS_OK;
+    if (ok && i == 0) {
+      for (size_t j = 0; j < process_state.threads()->size(); ++j)
+        frame_count += process_state.threads()->at(j)->frames()->size();
+    }
+  }
+  double elapsed = Now() - start;
+
+  if (!ok) {
+    fprintf(stderr, "Could not process %s\n", minidump_file.c_str());
+    return false;
+  }
+  printf("%-18s %8.1f us/process  %6zu frames  %9.0f log bytes/process\n",
+         label, elapsed / iterations * 1e6, frame_count,
+         static_cast<double>(log.bytes()) / iterations);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  BPLOG_INIT(&argc, &argv);
+
+  int iterations = argc > 1 ? atoi(argv[1]) : kDefaultIterations;
+  if (iterations <= 0)
+    iterations = kDefaultIterations;
+  const char *srcdir = getenv("srcdir");
+  string minidump_file = argc > 2 ? argv[2] :
+      string(srcdir ? srcdir : ".") +
+      "/src/processor/testdata/stack_exhaustion.dmp";
+
+  printf("%s, %d iterations\n", minidump_file.c_str(), iterations);
+
+  // Warm the file cache, so that neither run pays for the first read.
+  LogStream::set_minimum_severity(LogStream::SEVERITY_ERROR);
+  if (!Run("warm-up", minidump_file, 1))
+    return 1;
+
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(NULL, &resolver);
+  ProcessState process_state;
+  if (processor.Process(minidump_file, &process_state) !=
+          google_breakpad::PROCESS_OK ||
+      !process_state.modules() ||
+      process_state.modules()->module_count() == 0) {
+    fprintf(stderr, "%s has no modules\n", minidump_file.c_str());
+    return 1;
+  }
+  const CodeModules *modules = process_state.modules();
+  u_int64_t lowest_base = modules->GetModuleAtIndex(0)->base_address();
+  LogStream::set_minimum_severity(LogStream::SEVERITY_INFO);
+  RunLookups("INFO enabled", modules, lowest_base);
+  LogStream::set_minimum_severity(LogStream::SEVERITY_ERROR);
+  RunLookups("INFO disabled", modules, lowest_base);
+
+  LogStream::set_minimum_severity(LogStream::SEVERITY_INFO);
+  if (!Run("INFO enabled", minidump_file, iterations))
+    return 1;
+  LogStream::set_minimum_severity(LogStream::SEVERITY_ERROR);
+  if (!Run("INFO disabled", minidump_file, iterations))
+    return 1;
+  return 0;
+}
@@ -41,9 +41,11 @@
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/code_modules.h"
 #include "google_breakpad/processor/minidump.h"
+#include "google_breakpad/processor/process_stats.h"
 #include "google_breakpad/processor/source_line_resolver_interface.h"
 #include "google_breakpad/processor/stack_frame.h"
 #include "google_breakpad/processor/symbol_supplier.h"
+#include "processor/code_address_filter.h"
 #include "processor/linked_ptr.h"
 #include "processor/logging.h"
 #include "processor/scoped_ptr.h"
@@ -52,6 +54,8 @@
 #include "processor/stackwalker_x86.h"
 #include "processor/stackwalker_amd64.h"
 #include "processor/stackwalker_arm.h"
+#include "processor/stopwatch.h"
+#include "processor/symbol_load_coordinator.h"
 
 namespace google_breakpad {
 
@@ -66,7 +70,18 @@ Stackwalker::Stackwalker(const SystemInfo *system_info,
       memory_(memory),
       modules_(modules),
       resolver_(resolver),
-      supplier_(supplier) {
+      stats_(NULL),
+      supplier_(supplier),
+      coordinator_(NULL),
+      own_coordinator_(new SymbolLoadCoordinator),
+      code_filter_(NULL),
+      address_validity_() {
+  coordinator_ = own_coordinator_;
+}
+
+Stackwalker::~Stackwalker() {
+  delete own_coordinator_;
+  delete code_filter_;
 }
 
 
@@ -75,6 +90,41 @@ bool Stackwalker::Walk(CallStack *stack) {
   assert(stack);
   stack->Clear();
 
+  if (!stats_)
+    return WalkFrames(stack);
+
+  Stopwatch stopwatch;
+  bool completed = WalkFrames(stack);
+  stopwatch.AddElapsed(&stats_->walk);
+
+  for (vector<StackFrame *>::const_iterator iterator =
+           stack->frames()->begin();
+       iterator != stack->frames()->end(); ++iterator) {
+    switch ((*iterator)->trust) {
+      case StackFrame::FRAME_TRUST_CONTEXT:
+        ++stats_->context_frames;
+        break;
+      case StackFrame::FRAME_TRUST_CFI:
+        ++stats_->cfi_frames;
+        break;
+      case StackFrame::FRAME_TRUST_FP:
+        ++stats_->frame_pointer_frames;
+        break;
+      case StackFrame::FRAME_TRUST_CFI_SCAN:
+        ++stats_->cfi_scan_frames;
+        break;
+      case StackFrame::FRAME_TRUST_SCAN:
+        ++stats_->scan_frames;
+        break;
+      default:
+        ++stats_->other_frames;
+        break;
+    }
+  }
+  return completed;
+}
+
+bool Stackwalker::WalkFrames(CallStack *stack) {
   // Begin with the context frame, and keep getting callers until there are
   // no more.
 
@@ -92,34 +142,8 @@ bool Stackwalker::Walk(CallStack *stack) {
           modules_->GetModuleForAddress(frame->instruction);
       if (module) {
         frame->module = module;
-        if (resolver_ &&
-            !resolver_->HasModule(frame->module) &&
-            no_symbol_modules_.find(
-                module->code_file()) == no_symbol_modules_.end() &&
-            supplier_) {
-          string symbol_file;
-          char *symbol_data = NULL;
-          SymbolSupplier::SymbolResult symbol_result =
-              supplier_->GetCStringSymbolData(module,
-                                              system_info_,
-                                              &symbol_file,
-                                              &symbol_data);
-
-          switch (symbol_result) {
-            case SymbolSupplier::FOUND:
-              resolver_->LoadModuleUsingMemoryBuffer(frame->module,
-                                                     symbol_data);
-              break;
-            case SymbolSupplier::NOT_FOUND:
-              no_symbol_modules_.insert(module->code_file());
-              break;  // nothing to do
-            case SymbolSupplier::INTERRUPT:
-              return false;
-          }
-          // Inform symbol supplier to free the unused data memory buffer.
-          if (resolver_->ShouldDeleteMemoryBufferAfterLoadModule())
-            supplier_->FreeSymbolData(module);
-        }
+        if (resolver_ && supplier_ && !LoadSymbolsForModule(module))
+          return false;
         if (resolver_)
           resolver_->FillSourceLineInfo(frame.get());
       }
@@ -141,6 +165,74 @@ bool Stackwalker::Walk(CallStack *stack) {
 }
 
 
+bool Stackwalker::LoadSymbolsForModule(const CodeModule *module) {
+  // Hold the module's lock throughout, so that if another thread is
+  // loading the same module, this one waits and then finds it loaded.
+  SymbolLoadCoordinator::ModuleLock module_lock(coordinator_,
+                                                module->code_file());
+  if (resolver_->HasModule(module) ||
+      coordinator_->HasNoSymbols(module->code_file())) {
+    return true;
+  }
+
+  // A resolver that outlives one minidump may still hold a different build
+  // of this module, loaded for an earlier one.  Unload it, and have the
+  // supplier release any buffer it kept for it, before loading this build.
+  resolver_->UnloadModule(module);
+  if (!resolver_->ShouldDeleteMemoryBufferAfterLoadModule()) {
+    ScopedMutexLock supplier_lock(coordinator_->supplier_lock());
+    supplier_->FreeSymbolData(module);
+  }
+
+  string symbol_file;
+  char *symbol_data = NULL;
+  SymbolSupplier::SymbolResult symbol_result =
+      FetchSymbols(module, &symbol_file, &symbol_data);
+
+  switch (symbol_result) {
+    case SymbolSupplier::FOUND:
+      ParseSymbols(module, symbol_data);
+      break;
+    case SymbolSupplier::NOT_FOUND:
+      coordinator_->SetNoSymbols(module->code_file());
+      break;  // nothing to do
+    case SymbolSupplier::INTERRUPT:
+      return false;
+  }
+  // Inform symbol supplier to free the unused data memory buffer.
+  if (resolver_->ShouldDeleteMemoryBufferAfterLoadModule()) {
+    ScopedMutexLock supplier_lock(coordinator_->supplier_lock());
+    supplier_->FreeSymbolData(module);
+  }
+  return true;
+}
+
+SymbolSupplier::SymbolResult Stackwalker::FetchSymbols(
+    const CodeModule *module, string *symbol_file, char **symbol_data) {
+  ScopedMutexLock supplier_lock(coordinator_->supplier_lock());
+  if (!stats_) {
+    return supplier_->GetCStringSymbolData(module, system_info_,
+                                           symbol_file, symbol_data);
+  }
+
+  Stopwatch stopwatch;
+  SymbolSupplier::SymbolResult symbol_result =
+      supplier_->GetCStringSymbolData(module, system_info_,
+                                      symbol_file, symbol_data);
+  stopwatch.AddElapsed(&stats_->symbol_fetch);
+  return symbol_result;
+}
+
+bool Stackwalker::ParseSymbols(const CodeModule *module, char *symbol_data) {
+  if (!stats_)
+    return resolver_->LoadModuleUsingMemoryBuffer(module, symbol_data);
+
+  Stopwatch stopwatch;
+  bool loaded = resolver_->LoadModuleUsingMemoryBuffer(module, symbol_data);
+  stopwatch.AddElapsed(&stats_->symbol_parse);
+  return loaded;
+}
+
 // static
 Stackwalker* Stackwalker::StackwalkerForCPU(
     const SystemInfo *system_info,
@@ -200,7 +292,25 @@ Stackwalker* Stackwalker::StackwalkerForCPU(
   return cpu_stackwalker;
 }
 
+size_t Stackwalker::FilterCodeAddresses(const u_int64_t *addresses,
+                                       size_t count, bool *in_code) {
+  if (!code_filter_)
+    code_filter_ = new CodeAddressFilter(modules_);
+  return code_filter_->Filter(addresses, count, in_code);
+}
+
 bool Stackwalker::InstructionAddressSeemsValid(u_int64_t address) {
+  std::map<u_int64_t, bool>::const_iterator cached =
+      address_validity_.find(address);
+  if (cached != address_validity_.end())
+    return cached->second;
+
+  bool valid = InstructionAddressSeemsValidUncached(address);
+  address_validity_[address] = valid;
+  return valid;
+}
+
+bool Stackwalker::InstructionAddressSeemsValidUncached(u_int64_t address) {
   const CodeModule *module = modules_->GetModuleForAddress(address);
   if (!module) {
     // not inside any loaded module
@@ -213,19 +323,9 @@ bool Stackwalker::InstructionAddressSeemsValid(u_int64_t address) {
     return true;
   }
 
-  if (!resolver_->HasModule(module)) {
-    string symbol_file;
-    char *symbol_data = NULL;
-    SymbolSupplier::SymbolResult symbol_result =
-      supplier_->GetCStringSymbolData(module, system_info_,
-                                      &symbol_file, &symbol_data);
-
-    if (symbol_result != SymbolSupplier::FOUND ||
-        !resolver_->LoadModuleUsingMemoryBuffer(module,
-                                             symbol_data)) {
-      // we don't have symbols, but we're inside a loaded module
-      return true;
-    }
+  if (!LoadSymbolsForModule(module) || !resolver_->HasModule(module)) {
+    // we don't have symbols, but we're inside a loaded module
+    return true;
   }
 
   StackFrame frame;
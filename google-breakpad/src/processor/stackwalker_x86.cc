@@ -39,6 +39,7 @@
 #include "google_breakpad/processor/call_stack.h"
 #include "google_breakpad/processor/code_modules.h"
 #include "google_breakpad/processor/memory_region.h"
+#include "google_breakpad/processor/process_stats.h"
 #include "google_breakpad/processor/source_line_resolver_interface.h"
 #include "google_breakpad/processor/stack_frame_cpu.h"
 #include "processor/logging.h"
@@ -49,6 +50,15 @@
 
 namespace google_breakpad {
 
+// Program strings for STACK WIN records without one of their own; see
+// GetCallerByWindowsFrameInfo.
+static const char kBasePointerProgramString[] =
+    "$eip .raSearchStart ^ = "
+    "$ebp $esp .cbCalleeParams + .cbSavedRegs + 8 - ^ = "
+    "$esp .raSearchStart 4 + =";
+static const char kNoBasePointerProgramString[] =
+    "$eip .raSearchStart ^ = "
+    "$esp .raSearchStart 4 + =";
 
 const StackwalkerX86::CFIWalker::RegisterSet
 StackwalkerX86::cfi_register_map_[] = {
@@ -95,6 +105,11 @@ StackwalkerX86::StackwalkerX86(const SystemInfo *system_info,
                     HexString(memory_->GetSize());
     memory_ = NULL;
   }
+
+  base_pointer_program_.Compile(kBasePointerProgramString,
+                                &standard_program_slot_names_);
+  no_base_pointer_program_.Compile(kNoBasePointerProgramString,
+                                   &standard_program_slot_names_);
 }
 
 StackFrameX86::~StackFrameX86() {
@@ -217,6 +232,8 @@ StackFrameX86 *StackwalkerX86::GetCallerByWindowsFrameInfo(
   // scanned for these values. The results of program string evaluation
   // will be used to determine whether to scan for better values.
   string program_string;
+  const PostfixProgram *program = NULL;
+  const PostfixProgram::SlotNames *program_slot_names = NULL;
   bool recover_ebp = true;
 
   trust = StackFrame::FRAME_TRUST_CFI;
@@ -227,6 +244,10 @@ StackFrameX86 *StackwalkerX86::GetCallerByWindowsFrameInfo(
     // parameters.  In some cases, particularly with program strings that use
     // .raSearchStart, the stack may need to be scanned afterward.
     program_string = last_frame_info->program_string;
+    if (last_frame_info->CompileProgramString()) {
+      program = &last_frame_info->program;
+      program_slot_names = &last_frame_info->program_slot_names;
+    }
   } else if (last_frame_info->allocates_base_pointer) {
     // The function corresponding to the last frame doesn't use the frame
     // pointer for conventional purposes, but it does allocate a new
@@ -263,9 +284,9 @@ StackFrameX86 *StackwalkerX86::GetCallerByWindowsFrameInfo(
     // %eip_new = *(%esp_old + callee_params + saved_regs + locals)
     // %ebp_new = *(%esp_old + callee_params + saved_regs - 8)
     // %esp_new = %esp_old + callee_params + saved_regs + locals + 4
-    program_string = "$eip .raSearchStart ^ = "
-        "$ebp $esp .cbCalleeParams + .cbSavedRegs + 8 - ^ = "
-        "$esp .raSearchStart 4 + =";
+    program_string = kBasePointerProgramString;
+    program = &base_pointer_program_;
+    program_slot_names = &standard_program_slot_names_;
   } else {
     // The function corresponding to the last frame doesn't use %ebp at
     // all.  The callee frame is located relative to %esp.
@@ -286,17 +307,22 @@ StackFrameX86 *StackwalkerX86::GetCallerByWindowsFrameInfo(
     // %eip_new = *(%esp_old + callee_params + saved_regs + locals)
     // %esp_new = %esp_old + callee_params + saved_regs + locals + 4
     // %ebp_new = %ebp_old
-    program_string = "$eip .raSearchStart ^ = "
-        "$esp .raSearchStart 4 + =";
+    program_string = kNoBasePointerProgramString;
+    program = &no_base_pointer_program_;
+    program_slot_names = &standard_program_slot_names_;
     recover_ebp = false;
   }
 
   // Now crank it out, making sure that the program string set at least the
-  // two required variables.
+  // two required variables.  Use the compiled program if there is one;
+  // program strings that can't be compiled are interpreted instead.
   PostfixEvaluator<u_int32_t> evaluator =
       PostfixEvaluator<u_int32_t>(&dictionary, memory_);
   PostfixEvaluator<u_int32_t>::DictionaryValidityType dictionary_validity;
-  if (!evaluator.Evaluate(program_string, &dictionary_validity) ||
+  bool evaluated = program && program->compiled() ?
+      evaluator.Evaluate(*program, *program_slot_names, &dictionary_validity) :
+      evaluator.Evaluate(program_string, &dictionary_validity);
+  if (!evaluated ||
       dictionary_validity.find("$eip") == dictionary_validity.end() ||
       dictionary_validity.find("$esp") == dictionary_validity.end()) {
     // Program string evaluation failed. It may be that %eip is not somewhere
@@ -535,6 +561,11 @@ StackFrame *StackwalkerX86::GetCallerFrame(const CallStack *stack) {
   if (windows_frame_info)
     new_frame.reset(GetCallerByWindowsFrameInfo(frames, windows_frame_info));
 
+  // GetCallerByWindowsFrameInfo trusts the frames it recovers from STACK
+  // WIN records as much as CFI, and may fall back to scanning.
+  bool from_stack_win = new_frame.get() &&
+                        new_frame->trust == StackFrame::FRAME_TRUST_CFI;
+
   // If the resolver has DWARF CFI information, use that.
   if (!new_frame.get()) {
     CFIFrameInfo *cfi_frame_info = 
@@ -571,6 +602,8 @@ StackFrame *StackwalkerX86::GetCallerFrame(const CallStack *stack) {
   // field of StackFrameX86.
   new_frame->instruction = new_frame->context.eip - 1;
 
+  if (stats_ && from_stack_win)
+    ++stats_->stack_win_frames;
   return new_frame.release();
 }
 
@@ -46,6 +46,7 @@
 #include "google_breakpad/processor/stackwalker.h"
 #include "google_breakpad/processor/stack_frame_cpu.h"
 #include "processor/cfi_frame_info.h"
+#include "processor/postfix_program.h"
 
 namespace google_breakpad {
 
@@ -105,6 +106,13 @@ class StackwalkerX86 : public Stackwalker {
 
   // Our CFI frame walker.
   const CFIWalker cfi_walker_;
+
+  // The program strings GetCallerByWindowsFrameInfo uses for STACK WIN
+  // records that don't supply their own, compiled once per walker, and the
+  // identifiers they use.
+  PostfixProgram::SlotNames standard_program_slot_names_;
+  PostfixProgram base_pointer_program_;
+  PostfixProgram no_base_pointer_program_;
 };
 
 
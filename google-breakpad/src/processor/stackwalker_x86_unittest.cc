@@ -564,6 +564,40 @@ TEST_F(GetCallerFrame, WindowsFrameDataScan) {
   EXPECT_TRUE(frame1->windows_frame_info != NULL);
 }
 
+// When a scan loads a module's symbols to check a candidate return
+// address, it must load them the way walking a frame does, including
+// letting the supplier release the symbol data afterwards.
+TEST_F(GetCallerFrame, ScanFreesSymbolData) {
+  SetModuleSymbols(&module1,
+                   "STACK WIN 4 c8c 111 0 0 4 10 4 0 1 bad program string\n");
+  SetModuleSymbols(&module2,
+                   "FUNC 7c38 accf 0 module2::function\n"
+                   "STACK WIN 4 7c38 accf 0 0 4 10 4 0 1 $eip 0 = $ebp 0 =\n");
+  EXPECT_CALL(supplier, FreeSymbolData(&module1)).Times(1);
+  EXPECT_CALL(supplier, FreeSymbolData(&module2)).Times(1);
+  stack_section.start() = 0x80000000;
+  stack_section
+    // frame 0
+    .Append(16, 0x2a)                   // unused, garbage
+    .D32(0x50007ce9)                    // return address, found by scanning
+    // frame 1
+    .Append(8, 0);                      // empty space
+
+  RegionFromSection();
+  raw_context.eip = 0x40000c9c;
+  raw_context.esp = stack_section.start().Value();
+  raw_context.ebp = 0x2ae314cd;
+
+  StackwalkerX86 walker(&system_info, &raw_context, &stack_region, &modules,
+                        &supplier, &resolver);
+  ASSERT_TRUE(walker.Walk(&call_stack));
+  frames = call_stack.frames();
+  ASSERT_EQ(2U, frames->size());
+  StackFrameX86 *frame1 = static_cast<StackFrameX86 *>(frames->at(1));
+  EXPECT_EQ(StackFrame::FRAME_TRUST_SCAN, frame1->trust);
+  EXPECT_EQ("module2::function", frame1->function_name);
+}
+
 // Use Windows frame data (a "STACK WIN 4" record, from a
 // FrameTypeFrameData DIA record) to walk a stack frame, where the
 // expression yields an $eip that falls outside of any module, and the
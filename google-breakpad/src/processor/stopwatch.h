@@ -0,0 +1,91 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// stopwatch.h: Measure wall and CPU time into a ProcessingTime.
+//
+// CPU time is the calling thread's where the platform can measure it,
+// and the whole process's otherwise.
+
+#ifndef PROCESSOR_STOPWATCH_H__
+#define PROCESSOR_STOPWATCH_H__
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "google_breakpad/processor/process_stats.h"
+
+namespace google_breakpad {
+
+class Stopwatch {
+ public:
+  Stopwatch() { Restart(); }
+
+  void Restart() {
+    wall_start_ = WallNow();
+    cpu_start_ = CPUNow();
+  }
+
+  // Adds the time since the stopwatch was started or last restarted to
+  // *time, and restarts it.
+  void AddElapsed(ProcessingTime *time) {
+    double wall = WallNow();
+    double cpu = CPUNow();
+    time->wall_seconds += wall - wall_start_;
+    time->cpu_seconds += cpu - cpu_start_;
+    wall_start_ = wall;
+    cpu_start_ = cpu;
+  }
+
+ private:
+  static double WallNow() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1e6;
+  }
+
+  static double CPUNow() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec now;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == 0)
+      return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+  }
+
+  double wall_start_;
+  double cpu_start_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_STOPWATCH_H__
@@ -0,0 +1,71 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// symbol_load_coordinator.cc: Symbol loading state shared by Stackwalkers.
+//
+// See symbol_load_coordinator.h for documentation.
+
+#include "processor/symbol_load_coordinator.h"
+
+namespace google_breakpad {
+
+SymbolLoadCoordinator::SymbolLoadCoordinator() {
+}
+
+SymbolLoadCoordinator::~SymbolLoadCoordinator() {
+}
+
+SymbolLoadCoordinator::ModuleLock::ModuleLock(
+    SymbolLoadCoordinator *coordinator, const string &code_file) {
+  {
+    ScopedMutexLock lock(&coordinator->lock_);
+    linked_ptr<Mutex> &mutex = coordinator->module_locks_[code_file];
+    if (!mutex.get())
+      mutex = linked_ptr<Mutex>(new Mutex);
+    // The map never erases entries, so the Mutex outlives this lock.
+    mutex_ = mutex.get();
+  }
+  mutex_->Lock();
+}
+
+SymbolLoadCoordinator::ModuleLock::~ModuleLock() {
+  mutex_->Unlock();
+}
+
+bool SymbolLoadCoordinator::HasNoSymbols(const string &code_file) {
+  ScopedMutexLock lock(&lock_);
+  return no_symbol_modules_.find(code_file) != no_symbol_modules_.end();
+}
+
+void SymbolLoadCoordinator::SetNoSymbols(const string &code_file) {
+  ScopedMutexLock lock(&lock_);
+  no_symbol_modules_.insert(code_file);
+}
+
+}  // namespace google_breakpad
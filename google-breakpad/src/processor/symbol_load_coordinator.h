@@ -0,0 +1,113 @@
+// Copyright (c) 2010, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// symbol_load_coordinator.h: Symbol loading state shared by the
+// Stackwalkers that walk the threads of one minidump.
+//
+// A Stackwalker fetches a module's symbols from its SymbolSupplier the
+// first time it sees an address in the module, and remembers the modules
+// the supplier has no symbols for so that it asks about each only once.
+// When MinidumpProcessor walks several threads concurrently, their
+// Stackwalkers share a SymbolLoadCoordinator, so that:
+//
+// - each module's symbols are fetched and loaded by only one thread,
+//   while the others wait for the result;
+// - calls to the SymbolSupplier are serialized, so that suppliers need
+//   not be thread-safe; and
+// - modules without symbols are remembered across all threads.
+//
+// A Stackwalker with no shared coordinator uses a private one.
+
+#ifndef PROCESSOR_SYMBOL_LOAD_COORDINATOR_H__
+#define PROCESSOR_SYMBOL_LOAD_COORDINATOR_H__
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "processor/linked_ptr.h"
+#include "processor/mutex.h"
+
+namespace google_breakpad {
+
+using std::map;
+using std::set;
+using std::string;
+
+class SymbolLoadCoordinator {
+ public:
+  SymbolLoadCoordinator();
+  ~SymbolLoadCoordinator();
+
+  // While a ModuleLock for a module exists, no other thread can construct
+  // a ModuleLock for the same module.  Hold one while deciding whether to
+  // fetch a module's symbols, and while fetching and loading them.
+  class ModuleLock {
+   public:
+    ModuleLock(SymbolLoadCoordinator *coordinator, const string &code_file);
+    ~ModuleLock();
+
+   private:
+    Mutex *mutex_;
+
+    // Disallow copy constructor and assignment operator.
+    ModuleLock(const ModuleLock &);
+    void operator=(const ModuleLock &);
+  };
+
+  // Hold this lock while calling into the SymbolSupplier.
+  Mutex *supplier_lock() { return &supplier_lock_; }
+
+  // Return true if the SymbolSupplier has reported that it has no symbols
+  // for CODE_FILE.
+  bool HasNoSymbols(const string &code_file);
+
+  // Record that the SymbolSupplier has no symbols for CODE_FILE.
+  void SetNoSymbols(const string &code_file);
+
+ private:
+  // Guards module_locks_ and no_symbol_modules_.
+  Mutex lock_;
+
+  // A mutex for each module that some thread has locked.
+  map<string, linked_ptr<Mutex> > module_locks_;
+
+  // The modules that we haven't found symbols for.
+  set<string> no_symbol_modules_;
+
+  Mutex supplier_lock_;
+
+  // Disallow copy constructor and assignment operator.
+  SymbolLoadCoordinator(const SymbolLoadCoordinator &);
+  void operator=(const SymbolLoadCoordinator &);
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_SYMBOL_LOAD_COORDINATOR_H__
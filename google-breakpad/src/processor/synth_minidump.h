@@ -136,6 +136,7 @@ class String;
 class Section: public test_assembler::Section {
  public:
   explicit Section(const Dump &dump);
+  virtual ~Section() { }
 
   // Append an MDLocationDescriptor referring to this section to SECTION.
   // If 'this' is NULL, append a descriptor with a zero length and MDRVA.
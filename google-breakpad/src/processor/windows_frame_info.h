@@ -46,6 +46,7 @@
 
 #include "google_breakpad/common/breakpad_types.h"
 #include "processor/logging.h"
+#include "processor/postfix_program.h"
 #include "processor/tokenize.h"
 
 namespace google_breakpad {
@@ -80,7 +81,9 @@ struct WindowsFrameInfo {
                      local_size(0),
                      max_stack_size(0),
                      allocates_base_pointer(0),
-                     program_string() {}
+                     program_string(),
+                     program(),
+                     program_slot_names() {}
 
   WindowsFrameInfo(u_int32_t set_prolog_size,
                  u_int32_t set_epilog_size,
@@ -98,7 +101,9 @@ struct WindowsFrameInfo {
         local_size(set_local_size),
         max_stack_size(set_max_stack_size),
         allocates_base_pointer(set_allocates_base_pointer),
-        program_string(set_program_string) {}
+        program_string(set_program_string),
+        program(),
+        program_slot_names() {}
 
   // Parse a textual serialization of a WindowsFrameInfo object from
   // a string. Returns NULL if parsing fails, or a new object
@@ -161,6 +166,8 @@ struct WindowsFrameInfo {
     max_stack_size = that.max_stack_size;
     allocates_base_pointer = that.allocates_base_pointer;
     program_string = that.program_string;
+    program = that.program;
+    program_slot_names = that.program_slot_names;
   }
 
   // Clears the WindowsFrameInfo object so that users will see it as though
@@ -168,6 +175,17 @@ struct WindowsFrameInfo {
   void Clear() {
     valid = VALID_NONE;
     program_string.erase();
+    program = PostfixProgram();
+    program_slot_names.clear();
+  }
+
+  // Compiles program_string into program, unless that has already been
+  // done.  Returns true if program holds a compiled form of program_string.
+  bool CompileProgramString() {
+    if (program.compiled() || program_string.empty())
+      return program.compiled();
+    program_slot_names.clear();
+    return program.Compile(program_string, &program_slot_names);
   }
 
   // Identifies which fields in the structure are valid.  This is of
@@ -188,6 +206,12 @@ struct WindowsFrameInfo {
   // If program_string is empty, use allocates_base_pointer.
   bool allocates_base_pointer;
   std::string program_string;
+
+  // program_string, compiled by CompileProgramString, and the identifiers
+  // it uses.  Resolvers compile the program strings they hold once, so that
+  // stack walkers needn't parse them for every frame.
+  PostfixProgram program;
+  PostfixProgram::SlotNames program_slot_names;
 };
 
 }  // namespace google_breakpad
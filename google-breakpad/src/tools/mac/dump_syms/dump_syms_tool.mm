@@ -40,17 +40,49 @@
 
 #include "common/mac/dump_syms.h"
 #include "common/mac/macho_utilities.h"
+#include "common/module.h"
+#include "processor/module_serializer.h"
+#include "processor/scoped_ptr.h"
 
 using google_breakpad::DumpSymbols;
+using google_breakpad::Module;
+using google_breakpad::ModuleSerializer;
+using google_breakpad::scoped_array;
+using google_breakpad::scoped_ptr;
 using std::vector;
 
 struct Options {
-  Options() : srcPath(), arch(), cfi(true) { }
+  Options() : srcPath(), arch(), cfi(true), serialized(false) { }
   NSString *srcPath;
   const NXArchInfo *arch;
   bool cfi;
+  bool serialized;
 };
 
+//=============================================================================
+// Write the debugging information |dump_symbols| reads to std::cout in the
+// format ModuleSerializer produces, which FastSourceLineResolver loads
+// without parsing.
+static bool WriteSerializedSymbolFile(DumpSymbols *dump_symbols,
+                                      const Options &options) {
+  Module *module = NULL;
+  if (!dump_symbols->ReadSymbolData(&module))
+    return false;
+  scoped_ptr<Module> module_deleter(module);
+
+  ModuleSerializer serializer;
+  unsigned int size = 0;
+  scoped_array<char> data(
+      serializer.SerializeDumpedModule(module, options.cfi, &size));
+  if (!data.get()) {
+    fprintf(stderr, "%s: unable to serialize symbols\n",
+            [options.srcPath fileSystemRepresentation]);
+    return false;
+  }
+  std::cout.write(data.get(), size);
+  return std::cout.good();
+}
+
 //=============================================================================
 static bool Start(const Options &options) {
   DumpSymbols dump_symbols;
@@ -84,17 +116,21 @@ static bool Start(const Options &options) {
     }
   }
 
+  if (options.serialized)
+    return WriteSerializedSymbolFile(&dump_symbols, options);
   return dump_symbols.WriteSymbolFile(std::cout, options.cfi);
 }
 
 //=============================================================================
 static void Usage(int argc, const char *argv[]) {
   fprintf(stderr, "Output a Breakpad symbol file from a Mach-o file.\n");
-  fprintf(stderr, "Usage: %s [-a ARCHITECTURE] [-c] <Mach-o file>\n",
+  fprintf(stderr, "Usage: %s [-a ARCHITECTURE] [-c] [-s] <Mach-o file>\n",
           argv[0]);
   fprintf(stderr, "\t-a: Architecture type [default: native, or whatever is\n");
   fprintf(stderr, "\t    in the file, if it contains only one architecture]\n");
   fprintf(stderr, "\t-c: Do not generate CFI section\n");
+  fprintf(stderr, "\t-s: Write the symbols in the serialized format\n");
+  fprintf(stderr, "\t    FastSourceLineResolver loads, not as text\n");
   fprintf(stderr, "\t-h: Usage\n");
   fprintf(stderr, "\t-?: Usage\n");
 }
@@ -104,7 +140,7 @@ static void SetupOptions(int argc, const char *argv[], Options *options) {
   extern int optind;
   signed char ch;
 
-  while ((ch = getopt(argc, (char * const *)argv, "a:ch?")) != -1) {
+  while ((ch = getopt(argc, (char * const *)argv, "a:csh?")) != -1) {
     switch (ch) {
       case 'a': {
         const NXArchInfo *arch_info = NXGetArchInfoFromName(optarg);
@@ -119,6 +155,9 @@ static void SetupOptions(int argc, const char *argv[], Options *options) {
       case 'c':
         options->cfi = false;
         break;
+      case 's':
+        options->serialized = true;
+        break;
       case '?':
       case 'h':
         Usage(argc, argv);